@@ -0,0 +1,135 @@
+#!/usr/bin/scopy -s
+
+/* How to run this script, against the simulated M2K of a build
+ * configured with -DENABLE_SIMULATOR=ON:
+ * scopy --simulate --script benchmark.js
+ *
+ * Prints the display rate and the CPU use of the tools as JSON, the CPU
+ * use excluding the time spent simulating the device.
+ */
+
+/* Seconds measured per tool */
+var duration = 5
+
+function cpu_time() {
+	return trace.cpuTime() - sim.cpu_time
+}
+
+/* Runs a tool for a while and counts the events it traced */
+function measure(tool, events) {
+	tool.running = true
+
+	/* Let the acquisition settle */
+	sleep(1)
+
+	var cpu = cpu_time()
+	var counts = {}
+	for (var i = 0; i < events.length; i++)
+		counts[events[i]] = { count: 0, total_ms: 0, max_ms: 0 }
+
+	for (var s = 0; s < duration; s++) {
+		sleep(1)
+
+		for (var i = 0; i < events.length; i++) {
+			var st = trace.stats("", events[i], 1)
+			var c = counts[events[i]]
+
+			c.count += st.count
+			c.total_ms += st.total_ms
+			c.max_ms = Math.max(c.max_ms, st.max_ms)
+		}
+	}
+
+	cpu = cpu_time() - cpu
+	tool.running = false
+	msleep(500)
+
+	var result = { cpu_percent: 100 * cpu / duration }
+	for (var i = 0; i < events.length; i++) {
+		var c = counts[events[i]]
+
+		result[events[i] + "_per_s"] = c.count / duration
+		result[events[i] + "_avg_ms"] = c.count ?
+			c.total_ms / c.count : 0
+		result[events[i] + "_max_ms"] = c.max_ms
+	}
+
+	return result
+}
+
+/* Times a whole sweep of the network analyzer */
+function measure_sweep() {
+	network.min_freq = 1e3
+	network.max_freq = 1e6
+	network.samples_count = 100
+
+	var cpu = cpu_time()
+	var renders = trace.renderStats()
+	var start = Date.now()
+
+	network.running = true
+	do {
+		msleep(10)
+	} while (network.running)
+
+	var seconds = (Date.now() - start) / 1000
+	var after = trace.renderStats()
+
+	return {
+		sweep_s: seconds,
+		steps_per_s: network.samples_count / seconds,
+		cpu_percent: 100 * (cpu_time() - cpu) / seconds,
+		replots: after.rendered - renders.rendered,
+		appends: after.appended - renders.appended
+	}
+}
+
+/* Decodes the UART the simulated device plays on DIO0 */
+function setup_decoder() {
+	var group = logic.channel_groups[0]
+
+	group.grouped = true
+	group.decoder = "uart"
+	group.channels[0].role = "rx"
+
+	/* Let the channel list pick the decoder up */
+	msleep(500)
+}
+
+function main() {
+	sim.waveform_type = [0, 1]
+	sim.waveform_frequency = [1e3, 5e3]
+	sim.waveform_amplitude = [1, 0.5]
+	sim.noise = [0.001, 0.001]
+
+	if (!launcher.connect("ip:127.0.0.1")) {
+		print("Failed to connect to the simulated device")
+		exit()
+		return
+	}
+
+	trace.enabled = true
+
+	var results = {}
+
+	/* Frames received, and the replots they led to */
+	var frames = [ "plot", "rendered", "appended", "coalesced", "hidden" ]
+
+	results.oscilloscope = measure(osc, frames)
+	results.spectrum_analyzer = measure(spectrum, frames)
+
+	/* The network analyzer measures a low-pass filter */
+	sim.loopback = true
+	results.network_analyzer = measure_sweep()
+	sim.loopback = false
+
+	setup_decoder()
+	results.logic_analyzer = measure(logic, [ "capture", "decode" ])
+
+	print(JSON.stringify(results, null, "\t"))
+
+	launcher.disconnect()
+	exit()
+}
+
+main()
@@ -22,6 +22,7 @@
 
 #include "DisplayPlot.h"
 #include "osc_scale_engine.h"
+#include "render_scheduler.hpp"
 
 #include <qwt_scale_engine.h>
 #include <qwt_scale_draw.h>
@@ -430,6 +431,12 @@ DisplayPlot::~DisplayPlot()
 	}
 }
 
+void
+DisplayPlot::scheduleReplot()
+{
+  RenderScheduler::instance()->schedule(this);
+}
+
 void
 DisplayPlot::disableLegend()
 {
@@ -275,6 +275,9 @@ public:
 
   virtual void replot() = 0;
 
+  // Replots on the next frame of the RenderScheduler
+  void scheduleReplot();
+
   const QColor getLineColor1 () const;
   const QColor getLineColor2 () const;
   const QColor getLineColor3 () const;
@@ -22,6 +22,7 @@
 #include "signal_generator.hpp"
 #include "average.h"
 #include "spectrum_marker.hpp"
+#include "trace.hpp"
 
 #include <qwt_symbol.h>
 #include <boost/make_shared.hpp>
@@ -172,7 +173,7 @@ void FftDisplayPlot::plotData(const std::vector<double *> pts,
 		findPeaks(i);
 	}
 
-	replot();
+	scheduleReplot();
 }
 
 void FftDisplayPlot::_resetXAxisPoints()
@@ -191,6 +192,17 @@ void FftDisplayPlot::customEvent(QEvent *e)
 {
 	if (e->type() == TimeUpdateEvent::Type()) {
 		TimeUpdateEvent *ev = static_cast<TimeUpdateEvent *>(e);
+		auto iev = dynamic_cast<IdentifiableTimeUpdateEvent *>(ev);
+
+		const char *trace_cat = "plot";
+		if (Tracer::enabled() && iev) {
+			trace_cat = Tracer::intern(iev->senderName());
+			if (iev->postTime())
+				Tracer::complete(trace_cat, "event_delivery",
+						iev->postTime(), Tracer::now());
+		}
+
+		TraceScope trace(trace_cat, "plot");
 
 		this->plotData(ev->getTimeDomainPoints(),
 				ev->getNumTimeDomainDataPoints());
@@ -26,11 +26,11 @@
 #include <qwt_scale_draw.h>
 #include <qwt_legend.h>
 #include <QColor>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <volk/volk.h>
 #include <gnuradio/math.h>
-#include <boost/math/special_functions/round.hpp>
 
 #include "HistogramDisplayPlot.h"
 
@@ -125,7 +125,6 @@ HistogramDisplayPlot::HistogramDisplayPlot(int nplots, QWidget* parent)
   : DisplayPlot(nplots, parent)
 {
   d_bins = 100;
-  d_accum = false;
 
   // Initialize x-axis data array
   d_xdata = new double[d_bins];
@@ -207,50 +206,50 @@ HistogramDisplayPlot::replot()
 }
 
 void
-HistogramDisplayPlot::plotNewData(const std::vector<double*> dataPoints,
-				   const int64_t numDataPoints,
-				   const double timeInterval)
+HistogramDisplayPlot::plotNewBins(const std::vector<double*> bins,
+				  const int64_t numBins,
+				  const double binLeft,
+				  const double binWidth,
+				  const double dataMin,
+				  const double dataMax)
 {
   if(!d_stop) {
-    if((numDataPoints > 0)) {
+    if((numBins > 0)) {
+
+      if(numBins != d_bins)
+        setNumBins(numBins);
+
+      if(binLeft != d_left || binWidth != d_width)
+        _setBinLayout(binLeft, binWidth);
 
       // keep track of the min/max values for when autoscaleX is called.
-      d_xmin = 1e20;
-      d_xmax = -1e20;
-      for(int n = 0; n < d_nplots; n++) {
-        d_xmin = std::min(d_xmin, *std::min_element(dataPoints[n], dataPoints[n]+numDataPoints));
-        d_xmax = std::max(d_xmax, *std::max_element(dataPoints[n], dataPoints[n]+numDataPoints));
-      }
+      d_xmin = dataMin;
+      d_xmax = dataMax;
 
-      // If autoscalex has been clicked, clear the data for the new
-      // bin widths and reset the x-axis.
-      if(d_autoscalex_state) {
+      // If autoscalex has been clicked, clear the data and rebin over
+      // the range of the data. The sink owns the bin layout, so the new
+      // one arrives with its next update.
+      if(d_autoscalex_state && d_xmax > d_xmin) {
         for(int n = 0; n < d_nplots; n++)
           memset(d_ydata[n], 0, d_bins*sizeof(double));
         _resetXAxisPoints(d_xmin, d_xmax);
         d_autoscalex_state = false;
-      }
 
-      int index;
-      for(int n = 0; n < d_nplots; n++) {
-        if(!d_accum)
-          memset(d_ydata[n], 0, d_bins*sizeof(double));
-        for(int64_t point = 0; point < numDataPoints; point++) {
-          index = boost::math::iround(1e-20 + (dataPoints[n][point] - d_left)/d_width);
-          if((index >= 0) && (index < d_bins))
-            d_ydata[n][static_cast<int>(index)] += 1;
-        }
+        Q_EMIT binRangeRequested(d_xmin, d_xmax);
+        scheduleReplot();
+        return;
       }
 
-      double height = *std::max_element(d_ydata[0], d_ydata[0]+d_bins);
-      for(int n = 1; n < d_nplots; n++) {
+      double height = 0;
+      for(int n = 0; n < d_nplots; n++) {
+        memcpy(d_ydata[n], bins[n], d_bins*sizeof(double));
         height = std::max(height, *std::max_element(d_ydata[n], d_ydata[n]+d_bins));
       }
 
       if(d_autoscale_state)
         _autoScaleY(0, height);
 
-      replot();
+      scheduleReplot();
     }
   }
 }
@@ -259,12 +258,13 @@ void
 HistogramDisplayPlot::newData(const QEvent* updateEvent)
 {
   HistogramUpdateEvent *hevent = (HistogramUpdateEvent*)updateEvent;
-  const std::vector<double*> dataPoints = hevent->getDataPoints();
-  const uint64_t numDataPoints = hevent->getNumDataPoints();
 
-  plotNewData(dataPoints,
-		 numDataPoints,
-		 0);
+  plotNewBins(hevent->getBins(),
+		 hevent->getNumBins(),
+		 hevent->getBinLeft(),
+		 hevent->getBinWidth(),
+		 hevent->getDataMin(),
+		 hevent->getDataMax());
 }
 
 void
@@ -282,15 +282,33 @@ HistogramDisplayPlot::setXaxis(double min, double max)
 }
 
 void
-HistogramDisplayPlot::_resetXAxisPoints(double left, double right)
+HistogramDisplayPlot::binLayout(double min, double max, int bins,
+				double& left, double& width)
 {
   // Something's wrong with the data (NaN, Inf, or something else)
-  if((left == right) || (left > right))
-    throw std::runtime_error("HistogramDisplayPlot::_resetXAxisPoints left and/or right values are invalid");
+  if((min == max) || (min > max) || bins <= 0)
+    throw std::runtime_error("HistogramDisplayPlot::binLayout min and/or max values are invalid");
 
-  d_left  = left *(1 - copysign(0.1, left));
-  d_right = right*(1 + copysign(0.1, right));
-  d_width = (d_right - d_left)/(d_bins);
+  left = min*(1 - copysign(0.1, min));
+  double right = max*(1 + copysign(0.1, max));
+  width = (right - left)/bins;
+}
+
+void
+HistogramDisplayPlot::_resetXAxisPoints(double left, double right)
+{
+  double width;
+
+  binLayout(left, right, d_bins, left, width);
+  _setBinLayout(left, width);
+}
+
+void
+HistogramDisplayPlot::_setBinLayout(double left, double width)
+{
+  d_left  = left;
+  d_width = width;
+  d_right = d_left + d_width*d_bins;
   for(long loc = 0; loc < d_bins; loc++){
     d_xdata[loc] = d_left + loc*d_width;
   }
@@ -394,12 +412,6 @@ HistogramDisplayPlot::setSemilogy(bool en)
   }
 }
 
-void
-HistogramDisplayPlot::setAccumulate(bool state)
-{
-  d_accum = state;
-}
-
 void
 HistogramDisplayPlot::setMarkerAlpha(int which, int alpha)
 {
@@ -483,7 +495,7 @@ HistogramDisplayPlot::setNumBins(int bins)
 
   delete [] d_xdata;
   d_xdata = new double[d_bins];
-  _resetXAxisPoints(d_left, d_right);
+  _setBinLayout(d_left, (d_right - d_left)/d_bins);
 
   for(int i = 0; i < d_nplots; i++) {
     delete [] d_ydata[i];
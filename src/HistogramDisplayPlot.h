@@ -44,8 +44,16 @@ public:
   HistogramDisplayPlot(int nplots, QWidget*);
   virtual ~HistogramDisplayPlot();
 
-  void plotNewData(const std::vector<double*> dataPoints,
-		   const int64_t numDataPoints, const double timeInterval);
+  /* The bins are computed by the histogram sink, the plot only
+   * displays them */
+  void plotNewBins(const std::vector<double*> bins,
+		   const int64_t numBins, const double binLeft,
+		   const double binWidth, const double dataMin,
+		   const double dataMax);
+
+  /* Bin layout used for a data range of [min, max] */
+  static void binLayout(double min, double max, int bins,
+		  double& left, double& width);
 
   void replot();
 
@@ -54,7 +62,6 @@ public Q_SLOTS:
   void setAutoScaleX();
   void setSemilogx(bool en);
   void setSemilogy(bool en);
-  void setAccumulate(bool en);
 
   void setMarkerAlpha(int which, int alpha);
   int getMarkerAlpha(int which) const;
@@ -65,18 +72,22 @@ public Q_SLOTS:
 
   void customEvent(QEvent * e);
 
+Q_SIGNALS:
+  /* Autoscale-X asks the sink to rebin over the range of the data */
+  void binRangeRequested(double min, double max);
+
 private Q_SLOTS:
   void newData(const QEvent*);
 
 private:
   void _resetXAxisPoints(double left, double right);
+  void _setBinLayout(double left, double width);
   void _autoScaleY(double bottom, double top);
 
   double* d_xdata;
   std::vector<double*> d_ydata;
 
   int d_bins;
-  bool d_accum;
   double d_xmin, d_xmax, d_left, d_right;
   double d_width;
 
@@ -25,13 +25,17 @@
 
 #include <qwt_scale_draw.h>
 #include <qwt_legend.h>
+#include <qwt_series_data.h>
 #include <QColor>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <volk/volk.h>
 
 #include "TimeDomainDisplayPlot.h"
 #include "osc_scale_engine.h"
+#include "persistence_accumulator.hpp"
+#include "trace.hpp"
 
 using namespace adiscope;
 
@@ -70,6 +74,42 @@ protected:
   }
 };
 
+/*
+ * Curve data of a channel in roll mode. The samples are read in place from
+ * the ring buffer and their time is derived from their age, so appending
+ * new samples never moves the old ones nor rewrites an x-axis array.
+ */
+class RollingSeriesData: public QwtSeriesData<QPointF>
+{
+public:
+  RollingSeriesData(const double *ring, std::shared_ptr<RollState> state)
+    : d_ring(ring), d_state(state)
+  {
+  }
+
+  virtual size_t size() const
+  {
+    return d_state->count;
+  }
+
+  virtual QPointF sample(size_t i) const
+  {
+    const RollState& s = *d_state;
+    size_t idx = (s.head + i) % s.capacity;
+
+    return QPointF(s.x_end - (double)(s.count - 1 - i) * s.dt, d_ring[idx]);
+  }
+
+  virtual QRectF boundingRect() const
+  {
+    return qwtBoundingRect(*this);
+  }
+
+private:
+  const double *d_ring;
+  std::shared_ptr<RollState> d_state;
+};
+
 
 SinkManager::SinkManager()
 {
@@ -159,6 +199,7 @@ TimeDomainDisplayPlot::TimeDomainDisplayPlot(QWidget* parent, unsigned int xNumD
   d_sample_rate = 1;
   d_data_starting_point = 0.0;
   d_curves_hidden = false;
+  d_roll_mode = false;
 
   // Reconfigure the bottom horizontal axis that was created by the base class
   configureAxis(QwtPlot::xBottom, 0);
@@ -206,6 +247,11 @@ TimeDomainDisplayPlot::TimeDomainDisplayPlot(QWidget* parent, unsigned int xNumD
   d_trigger_lines[1]->setRenderHint(QwtPlotItem::RenderAntialiased);
   d_trigger_lines[1]->setXValue(0.0);
   d_trigger_lines[1]->setYValue(0.0);
+
+  d_persistence = std::make_shared<PersistenceAccumulator>();
+  d_persistence_item = new PersistencePlotItem();
+  connect(d_persistence.get(), SIGNAL(imageReady(QImage)),
+	  this, SLOT(onPersistenceImage(QImage)));
 }
 
 
@@ -216,15 +262,102 @@ TimeDomainDisplayPlot::~TimeDomainDisplayPlot()
 		unregisterSink(sink->name());
 	}
 
+	if (!d_persistence->isEnabled())
+		delete d_persistence_item;
+
   // d_zoomer and _panner deleted when parent deleted
 }
 
 void
 TimeDomainDisplayPlot::replot()
 {
+  TRACE_SCOPE("plot", "replot");
+
+  if (d_persistence->isEnabled())
+    _updatePersistenceGeometry();
+
   QwtPlot::replot();
 }
 
+std::shared_ptr<PersistenceAccumulator>
+TimeDomainDisplayPlot::persistence() const
+{
+  return d_persistence;
+}
+
+bool
+TimeDomainDisplayPlot::isPersistenceEnabled() const
+{
+  return d_persistence->isEnabled();
+}
+
+void
+TimeDomainDisplayPlot::setPersistenceEnabled(bool en)
+{
+  if (en == d_persistence->isEnabled())
+    return;
+
+  d_persistence->setEnabled(en);
+
+  if (en) {
+    _updatePersistenceGeometry();
+    d_persistence_item->attach(this);
+  } else {
+    d_persistence_item->detach();
+    d_persistence_item->clearImage();
+  }
+
+  replot();
+}
+
+void
+TimeDomainDisplayPlot::setPersistenceDecay(double seconds)
+{
+  d_persistence->setDecay(seconds);
+}
+
+void
+TimeDomainDisplayPlot::clearPersistence()
+{
+  d_persistence->clear();
+}
+
+void
+TimeDomainDisplayPlot::onPersistenceImage(QImage image)
+{
+  if (!d_persistence->isEnabled())
+    return;
+
+  d_persistence_item->setImage(image);
+  QwtPlot::replot();
+}
+
+void
+TimeDomainDisplayPlot::_updatePersistenceGeometry()
+{
+  PersistenceAccumulator::geometry geom;
+  const QRect rect = canvas()->contentsRect();
+  const QwtScaleMap xMap = canvasMap(QwtAxisId(QwtPlot::xBottom, 0));
+
+  geom.width = rect.width();
+  geom.height = rect.height();
+  geom.sample_rate = d_sample_rate;
+  geom.start_time = d_data_starting_point / d_sample_rate;
+  geom.x_min = xMap.s1();
+  geom.x_max = xMap.s2();
+
+  for (int i = 0; i < d_nplots; i++) {
+    const QwtScaleMap yMap = canvasMap(d_plot_curve[i]->yAxis());
+
+    geom.y_min.push_back(yMap.s1());
+    geom.y_max.push_back(yMap.s2());
+    geom.colors.push_back(getLineColor(i));
+    geom.visible.push_back(d_plot_curve[i]->isVisible());
+  }
+
+  d_persistence->setGeometry(geom);
+}
+
 void
 TimeDomainDisplayPlot::plotNewData(const std::string sender,
 				   const std::vector<double*> dataPoints,
@@ -234,6 +367,10 @@ TimeDomainDisplayPlot::plotNewData(const std::string sender,
 {
   int sinkIndex = d_sinkManager.indexOfSink(sender);
 
+  // Frames still in flight when roll mode was turned on
+  if (d_roll_mode)
+    return;
+
   if(!d_stop) {
     if((numDataPoints > 0) && sinkIndex >= 0) {
       Sink *sink = d_sinkManager.sink((unsigned int)sinkIndex);
@@ -425,7 +562,7 @@ TimeDomainDisplayPlot::plotNewData(const std::string sender,
 //        }
 //      }
 
-      replot();
+      scheduleReplot();
 
       Q_EMIT newData();
 
@@ -441,6 +578,16 @@ void TimeDomainDisplayPlot::newData(const QEvent* updateEvent)
 	const std::vector< std::vector<gr::tag_t> > tags = tevent->getTags();
 	const std::string sender = tevent->senderName();
 
+	const char *trace_cat = "plot";
+	if (Tracer::enabled()) {
+		trace_cat = Tracer::intern(sender);
+		if (tevent->postTime())
+			Tracer::complete(trace_cat, "event_delivery",
+					tevent->postTime(), Tracer::now());
+	}
+
+	TraceScope trace(trace_cat, "plot");
+
 	this->plotNewData(sender,
 			dataPoints,
 			numDataPoints,
@@ -448,13 +595,146 @@ void TimeDomainDisplayPlot::newData(const QEvent* updateEvent)
 			tags);
 }
 
+void TimeDomainDisplayPlot::newRollData(const QEvent* updateEvent)
+{
+	const RollUpdateEvent *revent = static_cast<const RollUpdateEvent *>(
+			updateEvent);
+
+	this->plotRollData(revent->senderName(),
+			revent->getDataPoints(),
+			revent->getNumDataPoints(),
+			revent->getWindowSize());
+}
+
 void TimeDomainDisplayPlot::customEvent(QEvent * e)
 {
   if(e->type() == TimeUpdateEvent::Type()) {
     newData(e);
+  } else if(e->type() == RollUpdateEvent::Type()) {
+    newRollData(e);
   }
 }
 
+void
+TimeDomainDisplayPlot::plotRollData(const std::string sender,
+				    const std::vector<double*> dataPoints,
+				    const int64_t numDataPoints,
+				    const int64_t windowSize)
+{
+  int sinkIndex = d_sinkManager.indexOfSink(sender);
+
+  if (d_stop || !d_roll_mode || sinkIndex < 0 ||
+		  numDataPoints <= 0 || windowSize <= 0)
+    return;
+
+  Sink *sink = d_sinkManager.sink((unsigned int)sinkIndex);
+  int start = d_sinkManager.sinkFirstChannelPos(sender);
+  unsigned int sinkNumChannels = sink->numChannels();
+  RollState& state = *d_roll_states[sinkIndex];
+
+  // The ring only gets reallocated when the time window changes
+  if ((unsigned long long)windowSize != state.capacity) {
+    sink->setChannelsDataLength(windowSize);
+
+    delete[] d_xdata[sinkIndex];
+    d_xdata[sinkIndex] = new double[windowSize];
+    _resetXAxisPoints(d_xdata[sinkIndex], windowSize, d_sample_rate);
+
+    for (int i = start; i < start + sinkNumChannels; i++) {
+      delete[] d_ydata[i];
+      d_ydata[i] = new double[windowSize];
+    }
+
+    state.capacity = windowSize;
+    state.head = 0;
+    state.count = 0;
+    _attachRollSeries(sinkIndex);
+  }
+
+  state.dt = 1.0 / d_sample_rate;
+  state.x_end = axisInterval(QwtAxisId(QwtPlot::xBottom, 0)).maxValue();
+
+  // Only the newest window worth of samples can be displayed
+  int64_t skip = std::max<int64_t>(numDataPoints - windowSize, 0);
+  int64_t n = numDataPoints - skip;
+  unsigned long long tail = (state.head + state.count) % state.capacity;
+  unsigned long long first = std::min<unsigned long long>(n,
+		  state.capacity - tail);
+
+  for (int i = 0; i < sinkNumChannels; i++) {
+    const double *src = dataPoints[i] + skip;
+    double *ring = d_ydata[start + i];
+
+    memcpy(ring + tail, src, first * sizeof(double));
+    memcpy(ring, src + first, (n - first) * sizeof(double));
+
+    rollDataAppended(start + i, src, n);
+  }
+
+  unsigned long long total = state.count + n;
+  if (total > state.capacity) {
+    state.head = (state.head + total - state.capacity) % state.capacity;
+    state.count = state.capacity;
+  } else {
+    state.count = total;
+  }
+
+  for (int i = 0; i < d_plot_curve.size(); i++)
+    d_plot_curve.at(i)->show();
+  d_curves_hidden = false;
+
+  scheduleReplot();
+
+  Q_EMIT newData();
+}
+
+void
+TimeDomainDisplayPlot::_attachRollSeries(int sinkIndex)
+{
+  Sink *sink = d_sinkManager.sink((unsigned int)sinkIndex);
+  int start = d_sinkManager.sinkFirstChannelPos(sink->name());
+
+  for (int i = start; i < start + sink->numChannels(); i++)
+    d_plot_curve[i]->setData(new RollingSeriesData(d_ydata[i],
+				d_roll_states[sinkIndex]));
+}
+
+bool
+TimeDomainDisplayPlot::isRollMode() const
+{
+  return d_roll_mode;
+}
+
+void
+TimeDomainDisplayPlot::setRollMode(bool en)
+{
+  if (en == d_roll_mode)
+    return;
+
+  d_roll_mode = en;
+
+  for (unsigned int s = 0; s < d_sinkManager.sinkListLength(); s++) {
+    Sink *sink = d_sinkManager.sink(s);
+    int start = d_sinkManager.sinkFirstChannelPos(sink->name());
+    unsigned long long length = sink->channelsDataLength();
+    RollState& state = *d_roll_states[s];
+
+    state.capacity = length;
+    state.head = 0;
+    state.count = 0;
+
+    if (en) {
+      _attachRollSeries(s);
+    } else {
+      _resetXAxisPoints(d_xdata[s], length, d_sample_rate);
+      for (int i = start; i < start + sink->numChannels(); i++)
+        d_plot_curve[i]->setRawSamples(d_xdata[s], d_ydata[i], length);
+    }
+  }
+
+  replot();
+}
+
 void
 TimeDomainDisplayPlot::legendEntryChecked(QwtPlotItem* plotItem, bool on)
 {
@@ -816,6 +1096,17 @@ bool TimeDomainDisplayPlot::registerSink(std::string sinkUniqueNme, unsigned int
 		d_tag_markers.resize(d_nplots);
 
 		d_sink_reset_x_axis_pts.push_back(false);
+
+		std::shared_ptr<RollState> state = std::make_shared<RollState>();
+		state->capacity = channelsDataLength;
+		state->head = 0;
+		state->count = 0;
+		state->dt = 1.0 / d_sample_rate;
+		state->x_end = 0.0;
+		d_roll_states.push_back(state);
+
+		if (d_roll_mode)
+			_attachRollSeries(sinkIndex);
 	}
 
 	return ret;
@@ -858,6 +1149,7 @@ bool TimeDomainDisplayPlot::unregisterSink(std::string sinkName)
 
 		d_sink_reset_x_axis_pts.erase(d_sink_reset_x_axis_pts.begin() +
 			sinkIndex);
+		d_roll_states.erase(d_roll_states.begin() + sinkIndex);
 	}
 
 	return ret;
@@ -904,6 +1196,11 @@ void TimeDomainDisplayPlot::cancelZoom()
 	zoomer->cancel();
 }
 
+int TimeDomainDisplayPlot::sinkFirstChannelPos(const std::string& sinkName)
+{
+	return d_sinkManager.sinkFirstChannelPos(sinkName);
+}
+
 long TimeDomainDisplayPlot::dataStartingPoint() const
 {
 	return d_data_starting_point;
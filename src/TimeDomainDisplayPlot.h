@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <cstdio>
 #include <vector>
+#include <memory>
 #include <gnuradio/tags.h>
 
 #include "DisplayPlot.h"
@@ -33,6 +34,9 @@
 
 namespace adiscope {
 
+class PersistenceAccumulator;
+class PersistencePlotItem;
+
 class Sink{
 public:
 	Sink(std::string name, unsigned int numChannels, unsigned long long channelsDataLength):
@@ -50,6 +54,16 @@ private:
 	unsigned long long d_channelsDataLength;
 };
 
+/* Ring buffer of a sink while the plot is in roll mode: the oldest
+ * sample sits at 'head' and the newest one is drawn at 'x_end'. */
+struct RollState {
+	unsigned long long capacity;
+	unsigned long long head;
+	unsigned long long count;
+	double dt;
+	double x_end;
+};
+
 class SinkManager
 {
 public:
@@ -90,6 +104,11 @@ public:
                    const std::vector< std::vector<gr::tag_t> > &tags \
 		   = std::vector< std::vector<gr::tag_t> >());
 
+  void plotRollData(const std::string sender,
+		    const std::vector<double*> dataPoints,
+		    const int64_t numDataPoints,
+		    const int64_t windowSize);
+
   void replot();
 
   void stemPlot(bool en);
@@ -111,9 +130,15 @@ public:
   bool registerSink(std::string sinkUniqueNme, unsigned int numChannels,
 	unsigned long long channelsDataLength, bool curvesAttached = true);
   bool unregisterSink(std::string sinkName);
+  int sinkFirstChannelPos(const std::string& sinkName);
 
   long dataStartingPoint() const;
 
+  std::shared_ptr<PersistenceAccumulator> persistence() const;
+  bool isPersistenceEnabled() const;
+
+  bool isRollMode() const;
+
 Q_SIGNALS:
   void channelAdded(int);
   void newData();
@@ -157,12 +182,24 @@ public Q_SLOTS:
   void resetXaxisOnNextReceivedData();
   void hideCurvesUntilNewData();
 
+  void setPersistenceEnabled(bool en);
+  void setPersistenceDecay(double seconds);
+  void clearPersistence();
+
+  virtual void setRollMode(bool en);
+
 protected:
   virtual void configureAxis(int axisPos, int axisIdx);
   virtual void cleanUpJustBeforeChannelRemoval(int chnIdx);
 
+  /* Called in roll mode for every block of samples appended to a channel */
+  virtual void rollDataAppended(int chnIdx, const double *data,
+		  int64_t numDataPoints) {}
+
 private Q_SLOTS:
   void newData(const QEvent*);
+  void newRollData(const QEvent*);
+  void onPersistenceImage(QImage image);
 
 protected:
   std::vector<double*> d_ydata;
@@ -171,6 +208,8 @@ protected:
 private:
   void _resetXAxisPoints(double*& xAxis, unsigned long long numPoints, double sampleRate);
   void _autoScale(double bottom, double top);
+  void _updatePersistenceGeometry();
+  void _attachRollSeries(int sinkIndex);
 
   double d_sample_rate;
   double d_delay;
@@ -197,6 +236,12 @@ private:
 
   bool d_curves_hidden;
 
+  std::shared_ptr<PersistenceAccumulator> d_persistence;
+  PersistencePlotItem *d_persistence_item;
+
+  bool d_roll_mode;
+  std::vector< std::shared_ptr<RollState> > d_roll_states;
+
   QColor getChannelColor();
 };
 } //adiscope
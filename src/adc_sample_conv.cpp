@@ -18,13 +18,23 @@
  */
 
 #include "adc_sample_conv.hpp"
+#include "trace.hpp"
+
+#include <volk/volk.h>
+
+#include <algorithm>
+
+/* Samples converted at once, so that the offset pass finds them in the
+ * cache */
+#define ADC_SAMPLE_CONV_CHUNK 2048
 
 using namespace gr;
 using namespace adiscope;
 
 adc_sample_conv::adc_sample_conv(int nconnections, bool inverse) :
 	gr::sync_block("adc_sample_conv",
-			gr::io_signature::make(nconnections, nconnections, sizeof(float)),
+			gr::io_signature::make(nconnections, nconnections,
+				inverse ? sizeof(float) : sizeof(short)),
 			gr::io_signature::make(nconnections, nconnections, sizeof(float))),
 	d_nconnections(nconnections),
 	inverse(inverse)
@@ -34,11 +44,39 @@ adc_sample_conv::adc_sample_conv(int nconnections, bool inverse) :
 		d_filter_compensations.push_back(1.0);
 		d_offsets.push_back(0.0);
 		d_hardware_gains.push_back(0.02);
+
+		d_scales.push_back(0.0);
+		d_offset_rows.push_back((float *)volk_malloc(
+				ADC_SAMPLE_CONV_CHUNK * sizeof(float),
+				volk_get_alignment()));
+		updateConversion(i);
 	}
 }
 
 adc_sample_conv::~adc_sample_conv()
 {
+	for (float *row : d_offset_rows)
+		volk_free(row);
+}
+
+void adc_sample_conv::updateConversion(int connection)
+{
+	const float gain = d_correction_gains[connection] *
+		d_filter_compensations[connection];
+	const float full_scale = (1 << 11) * 1.3 *
+		d_hardware_gains[connection] / 0.78;
+	float offset;
+
+	/* Same formulas as convSampleToVolts() and convVoltsToSample() */
+	if (inverse) {
+		d_scales[connection] = full_scale / gain;
+		offset = -d_offsets[connection] * d_scales[connection];
+	} else {
+		d_scales[connection] = gain / full_scale;
+		offset = d_offsets[connection];
+	}
+
+	std::fill_n(d_offset_rows[connection], ADC_SAMPLE_CONV_CHUNK, offset);
 }
 
 float adc_sample_conv::convSampleToVolts(float sample, float correctionGain,
@@ -61,24 +99,33 @@ int adc_sample_conv::work(int noutput_items,
 		gr_vector_const_void_star &input_items,
 		gr_vector_void_star &output_items)
 {
+	TRACE_SCOPE("gr", "adc_sample_conv");
+
 	for (unsigned int i = 0; i < input_items.size(); i++) {
-		const float* in = static_cast<const float *>(input_items[i]);
 		float *out = static_cast<float *>(output_items[i]);
-
-		if (inverse)
-			for (unsigned int j = 0; j < noutput_items; j++)
-				out[j] = convVoltsToSample(in[j],
-						d_correction_gains[i],
-						d_filter_compensations[i],
-						d_offsets[i],
-						d_hardware_gains[i]);
-		else
-			for (unsigned int j = 0; j < noutput_items; j++)
-				out[j] = convSampleToVolts(in[j],
-					d_correction_gains[i],
-					d_filter_compensations[i],
-					d_offsets[i],
-					d_hardware_gains[i]);
+		const float scale = d_scales[i];
+		const float *offsets = d_offset_rows[i];
+		const bool has_offset = offsets[0] != 0.0f;
+
+		for (int j = 0; j < noutput_items; j += ADC_SAMPLE_CONV_CHUNK) {
+			unsigned int n = std::min(noutput_items - j,
+					ADC_SAMPLE_CONV_CHUNK);
+
+			if (inverse)
+				volk_32f_s32f_multiply_32f(out + j,
+					static_cast<const float *>(
+						input_items[i]) + j,
+					scale, n);
+			else
+				volk_16i_s32f_convert_32f(out + j,
+					static_cast<const int16_t *>(
+						input_items[i]) + j,
+					1.0f / scale, n);
+
+			if (has_offset)
+				volk_32f_x2_add_32f(out + j, out + j,
+						offsets, n);
+		}
 	}
 
 	return noutput_items;
@@ -92,6 +139,7 @@ void adc_sample_conv::setCorrectionGain(int connection, float gain)
 	if (d_correction_gains[connection] != gain) {
 		gr::thread::scoped_lock lock(d_setlock);
 		d_correction_gains[connection] = gain;
+		updateConversion(connection);
 	}
 }
 
@@ -111,6 +159,7 @@ void adc_sample_conv::setFilterCompensation(int connection, float val)
 	if (d_filter_compensations[connection] != val) {
 		gr::thread::scoped_lock lock(d_setlock);
 		d_filter_compensations[connection] = val;
+		updateConversion(connection);
 	}
 }
 
@@ -130,6 +179,7 @@ void adc_sample_conv::setOffset(int connection, float offset)
 	if (d_offsets[connection] != offset) {
 		gr::thread::scoped_lock lock(d_setlock);
 		d_offsets[connection] = offset;
+		updateConversion(connection);
 	}
 }
 
@@ -149,6 +199,7 @@ void adc_sample_conv::setHardwareGain(int connection, float gain)
 	if (d_hardware_gains[connection] != gain) {
 		gr::thread::scoped_lock lock(d_setlock);
 		d_hardware_gains[connection] = gain;
+		updateConversion(connection);
 	}
 }
 
@@ -33,7 +33,16 @@ namespace adiscope {
 		std::vector<float> d_offsets;
 		std::vector<float> d_hardware_gains;
 
+		/* The parameters fused per connection, as
+		 * out = in * d_scales + d_offset_rows */
+		std::vector<float> d_scales;
+		std::vector<float *> d_offset_rows;
+
+		void updateConversion(int connection);
+
 	public:
+		/* Converts the raw 16-bit samples of the ADC to volts, or
+		 * volts to samples (as floats) when inverse */
 		explicit adc_sample_conv(int nconnections, bool inverse = false);
 		~adc_sample_conv();
 
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "buffer_policy.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <iio.h>
+
+/* Streaming buffers never hold more than this much data */
+#define MAX_STREAM_LATENCY_MS 100
+
+/* Bounds of the samples held by all the kernel buffers together */
+#define MAX_KERNEL_SAMPLES 0x400000
+
+#define MIN_KERNEL_BUFFERS 2
+#define MAX_KERNEL_BUFFERS 16
+
+/* Frames are displayed as they arrive, deeper queues only add lag */
+#define MAX_FRAME_KERNEL_BUFFERS 4
+
+using namespace adiscope;
+
+BufferPolicy::BufferPolicy(Transport transport) :
+	m_transport(transport)
+{
+}
+
+BufferPolicy::Transport BufferPolicy::transport(
+		const struct iio_context *ctx)
+{
+	const char *name = iio_context_get_name(ctx);
+
+	if (!strcmp(name, "local"))
+		return LOCAL;
+	else if (!strcmp(name, "usb"))
+		return USB;
+	else
+		return NETWORK;
+}
+
+double BufferPolicy::maxRefillRate() const
+{
+	switch (m_transport) {
+	case LOCAL:
+		return 1000.0;
+	case USB:
+		return 250.0;
+	default:
+		return 50.0;
+	}
+}
+
+double BufferPolicy::refillLatencyMs() const
+{
+	switch (m_transport) {
+	case LOCAL:
+		return 5.0;
+	case USB:
+		return 20.0;
+	default:
+		return 100.0;
+	}
+}
+
+BufferPolicy::Settings BufferPolicy::select(double sample_rate,
+		unsigned long requested, bool streaming) const
+{
+	Settings settings;
+	unsigned long size = std::max(requested, 1ul);
+
+	if (streaming && sample_rate > 0) {
+		double wanted = sample_rate / maxRefillRate();
+		double longest = sample_rate * MAX_STREAM_LATENCY_MS / 1000.0;
+
+		wanted = std::min(wanted, longest);
+		wanted = std::min(wanted, (double) MAX_KERNEL_SAMPLES /
+				MIN_KERNEL_BUFFERS);
+
+		/* Keep a whole number of the requested blocks per buffer */
+		if (wanted > size)
+			size *= (unsigned long) std::ceil(wanted / size);
+	}
+
+	unsigned long max_count = streaming ? MAX_KERNEL_BUFFERS :
+		MAX_FRAME_KERNEL_BUFFERS;
+	unsigned long count = MAX_FRAME_KERNEL_BUFFERS;
+
+	if (sample_rate > 0) {
+		double buffer_ms = size * 1000.0 / sample_rate;
+
+		count = (unsigned long) std::ceil(
+				refillLatencyMs() / buffer_ms) + 1;
+	}
+
+	max_count = std::min(max_count, MAX_KERNEL_SAMPLES / size);
+	count = std::min(count, max_count);
+	count = std::max(count, (unsigned long) MIN_KERNEL_BUFFERS);
+
+	settings.buffer_size = size;
+	settings.kernel_buffers = count;
+	return settings;
+}
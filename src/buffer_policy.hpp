@@ -0,0 +1,74 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef BUFFER_POLICY_HPP
+#define BUFFER_POLICY_HPP
+
+extern "C" {
+	struct iio_context;
+}
+
+namespace adiscope {
+	/*
+	 * Chooses how an IIO device streams: the number of samples per
+	 * buffer and the number of buffers queued in the kernel.
+	 *
+	 * Every refill costs a round trip to the device, which is cheap for
+	 * a local context and expensive over the network, so streaming
+	 * clients get buffers large enough to keep the refill rate under
+	 * what the transport sustains, but not so large that a refill holds
+	 * more than a tenth of a second of data. Clients that work on
+	 * whole frames (triggered captures, FFTs) get the size they asked
+	 * for. The kernel queue then holds enough buffers to ride out the
+	 * refill latency of the transport.
+	 */
+	class BufferPolicy
+	{
+	public:
+		enum Transport {
+			LOCAL,
+			USB,
+			NETWORK,
+		};
+
+		struct Settings {
+			unsigned long buffer_size;
+			unsigned int kernel_buffers;
+		};
+
+		explicit BufferPolicy(Transport transport);
+
+		static Transport transport(const struct iio_context *ctx);
+
+		Transport transport() const { return m_transport; }
+
+		/* Select the settings for the given sample rate (0 if not
+		 * known) and the size the clients asked for */
+		Settings select(double sample_rate, unsigned long requested,
+				bool streaming) const;
+
+	private:
+		Transport m_transport;
+
+		double maxRefillRate() const;
+		double refillLatencyMs() const;
+	};
+}
+
+#endif /* BUFFER_POLICY_HPP */
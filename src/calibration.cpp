@@ -19,13 +19,120 @@
 
 #include "calibration.hpp"
 
+#include <QDateTime>
 #include <QDebug>
+#include <QSettings>
+#include <QString>
+#include <QThread>
 #include <QtGlobal>
 #include <iio.h>
-#include <QThread>
+
+#include <cmath>
+
+/* Time the inputs are given to settle after a change, before the captures
+ * are compared. The inputs are settled when the averages of two
+ * consecutive captures differ by less than SETTLE_TOLERANCE LSBs. */
+#define SETTLE_MIN_TIME_MS 50
+#define SETTLE_TOLERANCE 2.0
+#define SETTLE_MAX_CAPTURES 10
+
+/* Width of the temperature bands cached results are valid for, in °C */
+#define CACHE_TEMPERATURE_BAND 5.0
+
+/* Cached results older than this are measured again */
+#define CACHE_MAX_AGE_DAYS 7
+
+#define CACHE_GROUP "Calibration"
 
 using namespace adiscope;
 
+namespace {
+/*
+ * Searches the offset within [lo, hi] at which the measured average is
+ * closest to zero, assuming the average is monotonic in the offset.
+ *
+ * The two ends are measured first. The zero crossing is then bracketed
+ * with secant steps, which land next to it in one or two steps on a
+ * linear response, falling back to bisection whenever a step fails to
+ * halve the bracket.
+ */
+class OffsetSearch
+{
+public:
+	OffsetSearch(int lo, int hi) :
+		lo(lo), hi(hi), avg_lo(0), avg_hi(0), probes(0),
+		use_secant(true), found(false)
+	{
+	}
+
+	bool done() const
+	{
+		return found;
+	}
+
+	int probe() const
+	{
+		if (probes == 0)
+			return lo;
+		if (probes == 1)
+			return hi;
+		if (!use_secant)
+			return lo + (hi - lo) / 2;
+
+		int x = lo + (int)lround(avg_lo * (hi - lo) /
+					(avg_lo - avg_hi));
+		return qBound(lo + 1, x, hi - 1);
+	}
+
+	void report(double avg)
+	{
+		const int x = probe();
+		const int width = hi - lo;
+
+		if (probes++ == 0) {
+			avg_lo = avg;
+			return;
+		}
+
+		if (probes == 2) {
+			avg_hi = avg;
+		} else if (avg == 0) {
+			lo = hi = x;
+			avg_lo = avg_hi = 0;
+		} else if ((avg > 0) == (avg_lo > 0)) {
+			lo = x;
+			avg_lo = avg;
+		} else {
+			hi = x;
+			avg_hi = avg;
+		}
+
+		use_secant = probes == 2 || 2 * (hi - lo) <= width;
+
+		/* Without a zero crossing the best offset is an end */
+		found = hi - lo <= 1 || avg_lo == 0 || avg_hi == 0 ||
+			(avg_lo > 0) == (avg_hi > 0);
+	}
+
+	int best() const
+	{
+		return qAbs(avg_lo) <= qAbs(avg_hi) ? lo : hi;
+	}
+
+private:
+	int lo, hi;
+	double avg_lo, avg_hi;
+	int probes;
+	bool use_secant;
+	bool found;
+};
+
+double capture_average(int16_t *data, size_t numElements)
+{
+	return data ? Calibration::average(data, numElements) : 0.0;
+}
+}
+
 Calibration::Calibration(struct iio_context *ctx):
 	m_ctx(ctx),
 	m_dac_a_buffer(NULL),
@@ -156,14 +263,11 @@ bool Calibration::calibrateADCoffset()
 	iio_channel_attr_write_longlong(m_ad5625_channel2, "raw", 2048);
 	iio_channel_attr_write_longlong(m_ad5625_channel3, "raw", 2048);
 
-	// Allow some time for the voltage to settle
-	QThread::msleep(50);
-
 	const unsigned int num_samples = 1e5;
 	int16_t dataCh0[num_samples];
 	int16_t dataCh1[num_samples];
 
-	bool ret = adc_data_capture(dataCh0, dataCh1, num_samples);
+	bool ret = adc_settled_capture(dataCh0, dataCh1, num_samples);
 		if (!ret) {
 		qDebug() << "failed to get samples";
 		return false;
@@ -398,64 +502,67 @@ bool Calibration::adc_data_capture(int16_t *dataCh0, int16_t *dataCh1,
 	return true;
 }
 
+bool Calibration::adc_settled_capture(int16_t *dataCh0, int16_t *dataCh1,
+	size_t num_sampl_per_chn)
+{
+	double avg0 = 0, avg1 = 0;
+
+	// Wait for the inputs to settle after a change, then capture again
+	// for as long as the average still moves from one capture to the next
+	QThread::msleep(SETTLE_MIN_TIME_MS);
+
+	for (int i = 0; i < SETTLE_MAX_CAPTURES; i++) {
+		if (!adc_data_capture(dataCh0, dataCh1, num_sampl_per_chn))
+			return false;
+
+		const double prev0 = avg0, prev1 = avg1;
+
+		avg0 = capture_average(dataCh0, num_sampl_per_chn);
+		avg1 = capture_average(dataCh1, num_sampl_per_chn);
+
+		if (i > 0 && qAbs(avg0 - prev0) <= SETTLE_TOLERANCE &&
+				qAbs(avg1 - prev1) <= SETTLE_TOLERANCE)
+			return true;
+	}
+
+	qDebug() << "ADC inputs did not settle, using the last capture";
+	return true;
+}
+
 bool Calibration::fine_tune(size_t span, int16_t centerVal0, int16_t centerVal1,
 	size_t num_samples)
 {
-	int16_t *candidateOffsets0 = new int16_t[span + 1];
-	int16_t *candidateOffsets1 = new int16_t[span + 1];
-	double *averagesCh0 = new double[span + 1];
-	double *averagesCh1 = new double[span + 1];
-	double minAvg0, minAvg1;
 	int16_t *dataCh0 = new int16_t[num_samples];
 	int16_t *dataCh1 = new int16_t[num_samples];
-	int16_t offset0, offset1;
-	int i, i0 = 0, i1 = 0;
+	OffsetSearch search0(centerVal0 - span / 2, centerVal0 + span / 2);
+	OffsetSearch search1(centerVal1 - span / 2, centerVal1 + span / 2);
 	bool ret = true;
 
-	offset0 = centerVal0 - span / 2;
-	offset1 = centerVal1 - span / 2;
-	for (i = 0; i < span + 1; i++) {
-		candidateOffsets0[i] = offset0;
-		candidateOffsets1[i] = offset1;
-		iio_channel_attr_write_double(m_ad5625_channel2, "raw",
-			offset0);
-		iio_channel_attr_write_double(m_ad5625_channel3, "raw",
-			offset1);
-		offset0++;
-		offset1++;
+	while (!search0.done() || !search1.done()) {
+		if (!search0.done())
+			iio_channel_attr_write_double(m_ad5625_channel2, "raw",
+				search0.probe());
+		if (!search1.done())
+			iio_channel_attr_write_double(m_ad5625_channel3, "raw",
+				search1.probe());
 
-		// Allow some time for the voltage to settle
-		QThread::msleep(5);
-
-		ret = adc_data_capture(dataCh0, dataCh1, num_samples);
+		ret = adc_settled_capture(dataCh0, dataCh1, num_samples);
 
 		if (!ret) {
 			qDebug() << "failed to get samples";
 			goto out_cleanup;
 		}
 
-		averagesCh0[i] = qAbs(average(dataCh0, num_samples));
-		averagesCh1[i] = qAbs(average(dataCh1, num_samples));
-	}
-
-	minAvg0 = qAbs(averagesCh0[0]);
-	minAvg1 = qAbs(averagesCh1[0]);
-
-	for (int i = 1; i < span + 1; i++) {
-		if (averagesCh0[i] < minAvg0) {
-			minAvg0 = averagesCh0[i];
-			i0 = i;
-		}
-		if (averagesCh1[i] < minAvg1) {
-			minAvg1 = averagesCh1[i];
-			i1 = i;
-		}
+		if (!search0.done())
+			search0.report(average(dataCh0, num_samples));
+		if (!search1.done())
+			search1.report(average(dataCh1, num_samples));
 	}
 
 	iio_device_attr_write(m_m2k_fabric, "calibration_mode", "none");
 
-	m_adc_ch0_offset = candidateOffsets0[i0];
-	m_adc_ch1_offset = candidateOffsets1[i1];
+	m_adc_ch0_offset = search0.best();
+	m_adc_ch1_offset = search1.best();
 
 	qDebug() << "After Fine-Tunning";
 	qDebug() << "ADC channel 0 offset(raw):" << m_adc_ch0_offset;
@@ -467,10 +574,6 @@ bool Calibration::fine_tune(size_t span, int16_t centerVal0, int16_t centerVal1,
 		m_adc_ch1_offset);
 
 out_cleanup:
-	delete[] candidateOffsets0;
-	delete[] candidateOffsets1;
-	delete[] averagesCh0;
-	delete[] averagesCh1;
 	delete[] dataCh0;
 	delete[] dataCh1;
 	return ret;
@@ -517,14 +620,11 @@ bool Calibration::calibrateDACoffset()
 	dacAOutputDC(0);
 	dacBOutputDC(0);
 
-	// Allow some time for the voltage to settle
-	QThread::msleep(50);
-
 	const unsigned int num_samples = 1e5;
 	int16_t dataCh0[num_samples];
 	int16_t dataCh1[num_samples];
 
-	bool ret = adc_data_capture(dataCh0, dataCh1, num_samples);
+	bool ret = adc_settled_capture(dataCh0, dataCh1, num_samples);
 		if (!ret) {
 		qDebug() << "failed to get samples";
 		return false;
@@ -585,14 +685,11 @@ bool Calibration::calibrateDACgain()
 	dacAOutputDC(1024);
 	dacBOutputDC(1024);
 
-	// Allow some time for the voltage to settle
-	QThread::msleep(50);
-
 	const unsigned int num_samples = 1e5;
 	int16_t dataCh0[num_samples];
 	int16_t dataCh1[num_samples];
 
-	bool ret = adc_data_capture(dataCh0, dataCh1, num_samples);
+	bool ret = adc_settled_capture(dataCh0, dataCh1, num_samples);
 		if (!ret) {
 		qDebug() << "failed to get samples";
 		return false;
@@ -704,3 +801,102 @@ bool Calibration::calibrateAll()
 
 	return true;
 }
+
+QString Calibration::cacheGroup() const
+{
+	const char *serial = iio_context_get_attr_value(m_ctx, "hw_serial");
+	if (!serial)
+		return QString();
+
+	// A firmware update may change the analog setup
+	const char *firmware = iio_context_get_attr_value(m_ctx, "fw_version");
+	if (!firmware)
+		firmware = "unknown";
+
+	// The die temperature of the Zynq, in millidegrees
+	struct iio_device *xadc = iio_context_find_device(m_ctx, "xadc");
+	struct iio_channel *temp = xadc ?
+		iio_device_find_channel(xadc, "temp0", false) : NULL;
+	double raw, offset, scale;
+
+	if (!temp || iio_channel_attr_read_double(temp, "raw", &raw) ||
+			iio_channel_attr_read_double(temp, "offset", &offset) ||
+			iio_channel_attr_read_double(temp, "scale", &scale))
+		return QString();
+
+	const double celsius = (raw + offset) * scale / 1000;
+	const int band = (int)floor(celsius / CACHE_TEMPERATURE_BAND);
+
+	return QString(CACHE_GROUP "/%1/%2/%3").arg(serial).arg(firmware)
+		.arg(band);
+}
+
+bool Calibration::loadFromCache(QSettings& settings)
+{
+	if (!m_initialized)
+		return false;
+
+	const QString group = cacheGroup();
+	if (group.isEmpty())
+		return false;
+
+	settings.beginGroup(group);
+	const QDateTime time = settings.value("time").toDateTime();
+	const qint64 age = time.isValid() ?
+		time.secsTo(QDateTime::currentDateTimeUtc()) : -1;
+	const bool found = settings.contains("dac_b_vlsb") && age >= 0 &&
+		age <= CACHE_MAX_AGE_DAYS * 24 * 3600;
+	if (found) {
+		m_adc_ch0_offset = settings.value("adc_ch0_offset").toInt();
+		m_adc_ch1_offset = settings.value("adc_ch1_offset").toInt();
+		m_adc_ch0_gain = settings.value("adc_ch0_gain").toDouble();
+		m_adc_ch1_gain = settings.value("adc_ch1_gain").toDouble();
+		m_dac_a_ch_offset = settings.value("dac_a_offset").toInt();
+		m_dac_b_ch_offset = settings.value("dac_b_offset").toInt();
+		m_dac_a_ch_vlsb = settings.value("dac_a_vlsb").toDouble();
+		m_dac_b_ch_vlsb = settings.value("dac_b_vlsb").toDouble();
+	}
+	settings.endGroup();
+
+	if (!found)
+		return false;
+
+	qDebug() << "Using the cached calibration of" << group;
+
+	iio_device_attr_write(m_m2k_fabric, "calibration_mode", "none");
+
+	iio_channel_attr_write_longlong(m_ad5625_channel2, "raw",
+		m_adc_ch0_offset);
+	iio_channel_attr_write_longlong(m_ad5625_channel3, "raw",
+		m_adc_ch1_offset);
+	iio_channel_attr_write_longlong(m_ad5625_channel0, "raw",
+		m_dac_a_ch_offset);
+	iio_channel_attr_write_longlong(m_ad5625_channel1, "raw",
+		m_dac_b_ch_offset);
+
+	return true;
+}
+
+void Calibration::storeInCache(QSettings& settings) const
+{
+	const QString group = cacheGroup();
+	if (group.isEmpty())
+		return;
+
+	settings.beginGroup(group);
+	settings.setValue("adc_ch0_offset", m_adc_ch0_offset);
+	settings.setValue("adc_ch1_offset", m_adc_ch1_offset);
+	settings.setValue("adc_ch0_gain", m_adc_ch0_gain);
+	settings.setValue("adc_ch1_gain", m_adc_ch1_gain);
+	settings.setValue("dac_a_offset", m_dac_a_ch_offset);
+	settings.setValue("dac_b_offset", m_dac_b_ch_offset);
+	settings.setValue("dac_a_vlsb", m_dac_a_ch_vlsb);
+	settings.setValue("dac_b_vlsb", m_dac_b_ch_vlsb);
+	settings.setValue("time", QDateTime::currentDateTimeUtc());
+	settings.endGroup();
+}
+
+void Calibration::clearCache(QSettings& settings)
+{
+	settings.remove(CACHE_GROUP);
+}
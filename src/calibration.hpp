@@ -24,6 +24,9 @@
 #include <cstdlib>
 #include <string>
 
+class QSettings;
+class QString;
+
 extern "C" {
 	struct iio_context;
 	struct iio_device;
@@ -60,6 +63,16 @@ public:
 	bool resetSettings();
 	void restoreTriggerSetup();
 
+	/*
+	 * Results are cached per device serial number, firmware version and
+	 * temperature band, for a week. loadFromCache() applies a cached
+	 * result to the hardware, and fails if there is none, if it expired
+	 * or if the serial or temperature can't be read.
+	 */
+	bool loadFromCache(QSettings& settings);
+	void storeInCache(QSettings& settings) const;
+	static void clearCache(QSettings& settings);
+
 	static void setChannelEnableState(struct iio_channel *chn, bool en);
 	static double average(int16_t *data, size_t numElements);
 	static float convSampleToVolts(float sample, float correctionGain = 1);
@@ -68,6 +81,9 @@ public:
 private:
 	bool adc_data_capture(int16_t *dataCh0, int16_t *dataCh1,
 		size_t num_sampl_per_chn);
+	bool adc_settled_capture(int16_t *dataCh0, int16_t *dataCh1,
+		size_t num_sampl_per_chn);
+	QString cacheGroup() const;
 	bool fine_tune(size_t span, int16_t centerVal0, int16_t centerVal1,
 		size_t num_samples);
 
@@ -21,13 +21,19 @@
 #include "DisplayPlot.h"
 #include "osc_scale_engine.h"
 #include "osc_scale_zoomer.h"
+#include "render_scheduler.hpp"
 
+#include <qwt_plot_directpainter.h>
 #include <qwt_plot_layout.h>
 
+#include <algorithm>
+
 using namespace adiscope;
 
 dBgraph::dBgraph(QWidget *parent) : QwtPlot(parent),
-	curve("data")
+	curve("data"),
+	painter(new QwtPlotDirectPainter(this)),
+	drawn(0)
 {
 	enableAxis(QwtPlot::xBottom, false);
 	enableAxis(QwtPlot::xTop, true);
@@ -48,6 +54,10 @@ dBgraph::dBgraph(QWidget *parent) : QwtPlot(parent),
 
 	useLogFreq(false);
 
+	/* Keep the backing store of the canvas in sync with what is
+	 * painted directly, or the next expose would wipe it */
+	painter->setAttribute(QwtPlotDirectPainter::CopyBackingStore, true);
+
 	OscScaleEngine *scaleLeft = new OscScaleEngine;
 	scaleLeft->setMajorTicksCount(6);
 	this->setAxisScaleEngine(QwtPlot::yLeft,
@@ -117,14 +127,43 @@ void dBgraph::setAxesTitles(const QString& x, const QString& y)
 
 void dBgraph::plot(double x, double y)
 {
-	if (xdata.size() == numSamples + 1)
+	append(&x, &y, 1);
+}
+
+void dBgraph::append(const double *x, const double *y, int count)
+{
+	count = std::min(count, (int) numSamples + 1 - xdata.size());
+	if (count <= 0)
 		return;
 
-	xdata.push(x);
-	ydata.push(y);
+	for (int i = 0; i < count; i++) {
+		double x_val = x[i], y_val = y[i];
+
+		xdata.push(x_val);
+		ydata.push(y_val);
+	}
 
 	curve.setRawSamples(xdata.data(), ydata.data(), xdata.size());
-	replot();
+	RenderScheduler::instance()->scheduleAppend(this);
+}
+
+void dBgraph::drawAppended()
+{
+	const int size = xdata.size();
+
+	if (drawn >= size)
+		return;
+
+	/* Starting from the last painted point joins the new segments
+	 * to the curve */
+	painter->drawSeries(&curve, std::max(drawn - 1, 0), size - 1);
+	drawn = size;
+}
+
+void dBgraph::replot()
+{
+	drawn = xdata.size();
+	QwtPlot::replot();
 }
 
 int dBgraph::getNumSamples() const
@@ -145,8 +184,15 @@ void dBgraph::setNumSamples(int num)
 
 void dBgraph::reset()
 {
+	/* A scheduled replot must not read the freed samples */
+	curve.setRawSamples(nullptr, nullptr, 0);
+
 	xdata.clear();
 	ydata.clear();
+
+	/* The new points are drawn over an empty curve */
+	drawn = 0;
+	RenderScheduler::instance()->schedule(this);
 }
 
 void dBgraph::setColor(const QColor& color)
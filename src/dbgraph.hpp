@@ -24,13 +24,22 @@
 #include <qwt_plot_curve.h>
 
 #include "customFifo.hpp"
+#include "render_scheduler.hpp"
+
+class QwtPlotDirectPainter;
 
 namespace adiscope {
 	class OscScaleDraw;
 	class PrefixFormatter;
 	class OscScaleZoomer;
 
-	class dBgraph : public QwtPlot
+	/*
+	 * The points of a sweep only ever get appended, so they are drawn
+	 * incrementally: the segments added since the last frame are
+	 * painted over the canvas, and the rest of the plot is left alone
+	 * until a full replot.
+	 */
+	class dBgraph : public QwtPlot, public IncrementalPlot
 	{
 		Q_OBJECT
 
@@ -65,6 +74,11 @@ namespace adiscope {
 				double ymin, double ymax);
 		void setAxesTitles(const QString& x, const QString& y);
 
+		/* Appends a block of points, drawn on the next frame */
+		void append(const double *x, const double *y, int count);
+
+		void drawAppended();
+
 		int getNumSamples() const;
 
 		const QColor& getColor() const;
@@ -91,6 +105,8 @@ namespace adiscope {
 
 		void useLogFreq(bool use_log_freq);
 
+		void replot();
+
 	private:
 		QwtPlotCurve curve;
 		unsigned int numSamples;
@@ -103,6 +119,9 @@ namespace adiscope {
 		OscScaleZoomer *zoomer;
 
 		CustomFifo<double> xdata, ydata;
+
+		QwtPlotDirectPainter *painter;
+		int drawn;	/* points painted so far */
 	};
 }
 
@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
@@ -31,6 +32,14 @@
 //#include "pattern_generator.hpp"
 
 #include "digitalchannel_manager.hpp"
+#include "iio_attr_cache.hpp"
+
+#include <QtConcurrentRun>
+
+/* The pins are sampled at this rate in streaming mode, and a report
+ * covers one buffer */
+#define DIO_STREAM_SAMPLE_RATE 100000
+#define DIO_STREAM_BUFFER_SIZE 1000
 
 using namespace std;
 using namespace adiscope;
@@ -447,24 +456,30 @@ const char *DIOManager::channelNames[] = {
 	"voltage12", "voltage13", "voltage14", "voltage15"
 };
 
-DIOManager::DIOManager(iio_context *ctx, Filter *filt) : ctx(ctx)
+DIOManager::DIOManager(iio_context *ctx, Filter *filt) : ctx(ctx),
+	attrs(IioAttrCache::get_instance(ctx)), stream_stop(false),
+	stream_wanted(false), busy(false)
 {
 	dev = filt->find_device(ctx,TOOL_DIGITALIO);
+	la_dev = filt->find_device(ctx,TOOL_LOGIC_ANALYZER);
 	nrOfChannels = iio_device_get_channels_count(dev);
 	outputEnabled = false;
 
+	connect(&gpi_watcher, SIGNAL(finished()), this, SLOT(gpiRead()));
+
 	for (auto i=0; i<nrOfChannels; i++) {
 		auto ch = getChannel(i);
 		iio_channel_attr_write(ch, "direction", "in");
 		iio_channel_attr_write(ch, "raw", "0");
 	}
 
-	direction = gpo = lockMask = outputEnabled = 0x00;
+	direction = gpo = gpi = lockMask = outputEnabled = 0x00;
 }
 
 DIOManager::~DIOManager()
 {
-
+	setStreaming(false);
+	gpi_watcher.waitForFinished();
 }
 
 iio_channel *DIOManager::getChannel(int ch)
@@ -546,13 +561,198 @@ void DIOManager::setDeviceOutRaw(int ch)
 
 int DIOManager::getGpi()
 {
-	gpi = 0;
+	return gpi;
+}
+
+int DIOManager::readGpi()
+{
+	int value = 0;
 
 	for (auto i=0; i<nrOfChannels; i++) {
-		gpi|= (getInRaw(i) << i);
+		value |= (getInRaw(i) << i);
 	}
 
-	return gpi;
+	return value;
+}
+
+void DIOManager::refreshGpi()
+{
+	/* A read still in flight will report the current state soon
+	 * enough, and the stream reports changes as they happen */
+	if (gpi_watcher.isRunning() || isStreaming()) {
+		return;
+	}
+
+	gpi_watcher.setFuture(attrs->async([this]() {
+		return readGpi();
+	}));
+}
+
+void DIOManager::gpiRead()
+{
+	int value = gpi_watcher.result();
+	int changed = value ^ gpi;
+
+	gpi = value;
+
+	if (changed) {
+		Q_EMIT gpiChanged(gpi, changed);
+	}
+}
+
+void DIOManager::gpiStreamed(int value, int toggled)
+{
+	int changed = (value ^ gpi) | toggled;
+
+	gpi = value;
+
+	if (changed) {
+		Q_EMIT gpiChanged(gpi, changed);
+	}
+}
+
+bool DIOManager::isStreaming()
+{
+	return stream.isRunning();
+}
+
+bool DIOManager::setStreaming(bool enable)
+{
+	stream_wanted = enable;
+
+	return updateStreaming() == enable;
+}
+
+void DIOManager::setBusy(bool busy)
+{
+	this->busy = busy;
+	updateStreaming();
+}
+
+bool DIOManager::updateStreaming()
+{
+	bool enable = stream_wanted && la_dev && !busy && !lockMask;
+
+	if (enable == isStreaming()) {
+		return enable;
+	}
+
+	if (!enable) {
+		stream_stop = true;
+		stream.waitForFinished();
+		return false;
+	}
+
+	stream_stop = false;
+	stream = QtConcurrent::run(this, &DIOManager::streamGpi);
+	return true;
+}
+
+void DIOManager::streamGpi()
+{
+	std::vector<iio_channel *> enabled;
+
+	for (unsigned int i = 0; i < iio_device_get_channels_count(la_dev); i++) {
+		auto chn = iio_device_get_channel(la_dev, i);
+
+		if (iio_channel_is_output(chn) ||
+				!iio_channel_is_scan_element(chn) ||
+				iio_channel_is_enabled(chn)) {
+			continue;
+		}
+
+		iio_channel_enable(chn);
+		enabled.push_back(chn);
+	}
+
+	auto buf = iio_device_create_buffer(la_dev, DIO_STREAM_BUFFER_SIZE,
+			false);
+
+	if (!buf) {
+		qDebug() << "Unable to stream the DIO pins:" << errno;
+
+		for (auto chn : enabled) {
+			iio_channel_disable(chn);
+		}
+
+		return;
+	}
+
+	std::vector<std::pair<iio_channel *, std::string> > triggers;
+
+	/* Any trigger set by the logic analyzer would hold the refills
+	 * back, so they are cleared while streaming */
+	for (unsigned int i = 0; i < iio_device_get_channels_count(la_dev); i++) {
+		auto chn = iio_device_get_channel(la_dev, i);
+
+		if (iio_channel_is_output(chn) ||
+				!iio_channel_is_scan_element(chn)) {
+			continue;
+		}
+
+		char trigger[64];
+
+		if (iio_channel_attr_read(chn, "trigger", trigger,
+				sizeof(trigger)) > 0) {
+			triggers.push_back(std::make_pair(chn,
+					std::string(trigger)));
+			iio_channel_attr_write(chn, "trigger", "none");
+		}
+	}
+
+	long long rate;
+	bool rate_saved = !iio_device_attr_read_longlong(la_dev,
+			"sampling_frequency", &rate);
+
+	iio_device_attr_write_longlong(la_dev, "sampling_frequency",
+			DIO_STREAM_SAMPLE_RATE);
+
+	while (!stream_stop) {
+		if (iio_buffer_refill(buf) < 0) {
+			break;
+		}
+
+		ptrdiff_t step = iio_buffer_step(buf);
+		auto end = (uint8_t *) iio_buffer_end(buf);
+		auto ptr = (uint8_t *) iio_buffer_start(buf);
+
+		if (ptr >= end) {
+			continue;
+		}
+
+		uint16_t last = *(uint16_t *) ptr;
+		uint16_t toggled = 0;
+
+		for (; ptr < end; ptr += step) {
+			uint16_t sample = *(uint16_t *) ptr;
+			toggled |= sample ^ last;
+			last = sample;
+		}
+
+		int mask = (1 << nrOfChannels) - 1;
+
+		QMetaObject::invokeMethod(this, "gpiStreamed",
+				Qt::QueuedConnection,
+				Q_ARG(int, last & mask),
+				Q_ARG(int, toggled & mask));
+	}
+
+	iio_buffer_destroy(buf);
+
+	/* Leave the device as the logic analyzer configured it */
+	if (rate_saved) {
+		iio_device_attr_write_longlong(la_dev, "sampling_frequency",
+				rate);
+	}
+
+	for (auto trigger : triggers) {
+		iio_channel_attr_write(trigger.first, "trigger",
+				trigger.second.c_str());
+	}
+
+	for (auto chn : enabled) {
+		iio_channel_disable(chn);
+	}
 }
 
 bool DIOManager::getInRaw(int ch)
@@ -600,6 +800,8 @@ void DIOManager::setMode(int mask)
 void DIOManager::lock(int mask)
 {
 	lockMask = mask;
+	updateStreaming();
+
 	int i=0;
 
 	while (mask) {
@@ -631,6 +833,7 @@ void DIOManager::unlock()
 		setDeviceDirection(i,false);
 	}
 
+	updateStreaming();
 	Q_EMIT unlocked();
 }
 
@@ -8,6 +8,10 @@
 #include <QIntValidator>
 #include <QtQml/QJSEngine>
 #include <QtUiTools/QUiLoader>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -52,6 +56,7 @@ class PGChannelManager;
 
 namespace adiscope {
 
+class IioAttrCache;
 
 class Channel
 {
@@ -185,6 +190,16 @@ public:
 	ChannelGroup *get_channel_group(int index);
 };
 
+/*
+ * The state of the DIO pins is cached: getGpi() returns what was last
+ * read, and refreshGpi() reads all the channels in one batch on the
+ * attribute cache's worker thread. In streaming mode the pins are
+ * sampled through the buffer of the logic analyzer instead, so changes
+ * shorter than a poll interval are seen too. Either way gpiChanged()
+ * reports which channels changed. The stream is held back for as long
+ * as the pattern generator holds a lock or the logic analyzer runs, and
+ * resumed afterwards.
+ */
 class DIOManager : public QObject
 {
 	Q_OBJECT
@@ -197,6 +212,17 @@ class DIOManager : public QObject
 	static const char *channelNames[];
 	iio_context *ctx;
 	iio_device *dev;
+	iio_device *la_dev;
+	std::shared_ptr<IioAttrCache> attrs;
+	QFutureWatcher<int> gpi_watcher;
+	QFuture<void> stream;
+	std::atomic<bool> stream_stop;
+	bool stream_wanted;
+	bool busy;
+
+	int readGpi();
+	void streamGpi();
+	bool updateStreaming();
 
 public:
 	void init();
@@ -209,6 +235,8 @@ public:
 	bool getOutRaw(int ch);
 	int getGpi();
 	bool getInRaw(int ch);
+	bool isStreaming();
+	bool setStreaming(bool enable);
 	void setDeviceOutRaw(int ch);
 
 	void setOutputMode(int ch, bool mode);
@@ -222,9 +250,23 @@ public:
 	bool isLocked(int ch);
 	void unlock();
 
+public Q_SLOTS:
+	void refreshGpi();
+
+	/* Set while another tool captures from the logic analyzer */
+	void setBusy(bool busy);
+
 Q_SIGNALS:
 	void locked();
 	void unlocked();
+
+	/* changed has a bit set for every channel that changed since
+	 * the last report, even if it changed back in the meantime */
+	void gpiChanged(int gpi, int changed);
+
+private Q_SLOTS:
+	void gpiRead();
+	void gpiStreamed(int gpi, int toggled);
 };
 
 }
@@ -128,6 +128,21 @@ void DigitalIO::setOutput()
 
 	if (diom->getDirection(ch) && diom->getOutputEnabled()) { // only if output
 		setDynamicProperty(findIndividualUi(ch)->second->input,"high",output);
+		shown[ch] = -1;
+	}
+}
+
+bool DigitalIO::isStreaming() const
+{
+	return streaming;
+}
+
+void DigitalIO::setStreaming(bool enable)
+{
+	streaming = enable;
+
+	if (!offline_mode && ui->btnRunStop->isChecked()) {
+		diom->setStreaming(enable);
 	}
 }
 
@@ -137,7 +152,9 @@ DigitalIO::DigitalIO(struct iio_context *ctx, Filter *filt, QPushButton *runBtn,
 	Tool(ctx, runBtn, new DigitalIO_API(this), parent),
 	ui(new Ui::DigitalIO),
 	offline_mode(offline_mode),
-	diom(diom)
+	diom(diom),
+	streaming(false),
+	shown(16, -1)
 {
 
 	// UI
@@ -156,10 +173,14 @@ DigitalIO::DigitalIO(struct iio_context *ctx, Filter *filt, QPushButton *runBtn,
 	if (!offline_mode) {
 		connect(diom,SIGNAL(locked()),this,SLOT(lockUi()));
 		connect(diom,SIGNAL(unlocked()),this,SLOT(lockUi()));
+		connect(diom,SIGNAL(gpiChanged(int,int)),this,SLOT(updateUi()));
 	}
 
 	poll = new QTimer(this);
-	connect(poll,SIGNAL(timeout()),this,SLOT(updateUi()));
+
+	if (!offline_mode) {
+		connect(poll,SIGNAL(timeout()),diom,SLOT(refreshGpi()));
+	}
 
 	api->setObjectName(QString::fromStdString(Filter::tool_name(
 	                               TOOL_DIGITALIO)));
@@ -171,6 +192,7 @@ DigitalIO::DigitalIO(struct iio_context *ctx, Filter *filt, QPushButton *runBtn,
 DigitalIO::~DigitalIO()
 {
 	if (!offline_mode) {
+		diom->setStreaming(false);
 	}
 
 	api->save(*settings);
@@ -204,24 +226,29 @@ void DigitalIO::updateUi()
 		auto gpigrp2 = (gpi & 0xff00) >> 8;
 
 		for (auto i=0; i<16; i++) {
-			Ui::dioChannel *chui = findIndividualUi(i)->second;
 			auto chk = gpi&0x01;
 			gpi >>= 1;
 
-			setDynamicProperty(chui->input,"high",chk);
-
 			auto isLocked = diom->getLockMask() & 1<<i;
 			auto isOutput = diom->getDirection(i);
+			bool isShort = false;
 
-			if (!isLocked && isOutput && diom->getOutputEnabled())
-				if (chk != diom->getOutRaw(i)) {
-					setDynamicProperty(chui->input,"short",true);
-				} else {
-					setDynamicProperty(chui->input,"short",false);
-				}
-			else {
-				setDynamicProperty(chui->input,"short",false);
+			if (!isLocked && isOutput && diom->getOutputEnabled()) {
+				isShort = (chk != diom->getOutRaw(i));
 			}
+
+			// Restyling a widget is what costs, skip the unchanged ones
+			int state = chk | (isShort << 1);
+
+			if (shown[i] == state) {
+				continue;
+			}
+
+			shown[i] = state;
+
+			Ui::dioChannel *chui = findIndividualUi(i)->second;
+			setDynamicProperty(chui->input,"high",chk);
+			setDynamicProperty(chui->input,"short",isShort);
 		}
 
 		if (groups[0]->ui->inout->isChecked()) {
@@ -325,9 +352,12 @@ void adiscope::DigitalIO::on_btnRunStop_clicked()
 		ui->btnRunStop->setText("Stop");
 		poll->start(polling_rate);
 		diom->enableOutput(true);
+		diom->setStreaming(streaming);
+		diom->refreshGpi();
 	} else {
 		ui->btnRunStop->setText("Run");
 		poll->stop();
+		diom->setStreaming(false);
 		diom->enableOutput(false);
 	}
 }
@@ -370,6 +400,16 @@ QList<bool> DigitalIO_API::output() const
 	return list;
 }
 
+bool DigitalIO_API::streaming() const
+{
+	return dio->isStreaming();
+}
+
+void DigitalIO_API::setStreaming(bool enable)
+{
+	dio->setStreaming(enable);
+}
+
 void DigitalIO_API::setOutput(const QList<bool>& list)
 {
 	unsigned int i;
@@ -95,6 +95,10 @@ private:
 	QTimer *poll;
 	DIOManager *diom;
 	int polling_rate = 500; // ms
+	bool streaming;
+
+	/* What each channel shows, to only restyle the ones that change */
+	QVector<int> shown;
 
 	QPair<QWidget *,Ui::dioChannel *>  *findIndividualUi(int ch);
 
@@ -105,6 +109,8 @@ public:
 	~DigitalIO();
 	void setDirection(int ch, int direction);
 	void setOutput(int ch, int out);
+	bool isStreaming() const;
+	void setStreaming(bool enable);
 
 public Q_SLOTS:
 	void updateUi();
@@ -120,6 +126,7 @@ class DigitalIO_API : public ApiObject
 	Q_OBJECT
 	Q_PROPERTY(QList<bool> dir READ direction WRITE setDirection SCRIPTABLE true);
 	Q_PROPERTY(QList<bool> out READ output    WRITE setOutput SCRIPTABLE true);
+	Q_PROPERTY(bool streaming READ streaming WRITE setStreaming);
 
 
 public:
@@ -131,6 +138,8 @@ public:
 	QList<bool> output() const;
 	void setOutput(const QList<bool>& list);
 	void setOutput(int ch, int direction);
+	bool streaming() const;
+	void setStreaming(bool enable);
 
 
 private:
@@ -125,8 +125,8 @@ void DMM::updateValuesList()
 	ui->scaleCh1->setValue(volts_ch1);
 	ui->scaleCh2->setValue(volts_ch2);
 
-	ui->sismograph_ch1->plot(volts_ch1);
-	ui->sismograph_ch2->plot(volts_ch2);
+	ui->sismograph_ch1->append(&volts_ch1, 1);
+	ui->sismograph_ch2->append(&volts_ch2, 1);
 }
 
 void DMM::toggleTimer(bool start)
@@ -158,7 +158,9 @@ iio_manager::port_id DMM::configureMode(bool is_ac, unsigned int ch)
 	/* XXX: hardcoded parameters! */
 	auto avg = gr::blocks::moving_average_ff::make(1e6, 1e-6);
 
-	iio_manager::port_id id = manager->connect(s2f, ch, 0);
+	/* The averages work on a continuous stream of any buffer size */
+	iio_manager::port_id id = manager->connect(s2f, ch, 0, false,
+			IIO_BUFFER_SIZE, true);
 
 	manager->connect(s2f, 0, avg, 0);
 
@@ -303,6 +305,36 @@ double DMM_API::read_ch2() const
 	return dmm->ui->lcdCh2->value();
 }
 
+int DMM_API::buffer_size() const
+{
+	return dmm->manager->get_buffer_stats().buffer_size;
+}
+
+int DMM_API::kernel_buffers() const
+{
+	return dmm->manager->get_buffer_stats().kernel_buffers;
+}
+
+double DMM_API::refill_rate() const
+{
+	return dmm->manager->get_buffer_stats().refill_rate;
+}
+
+double DMM_API::refills() const
+{
+	return dmm->manager->get_buffer_stats().refills;
+}
+
+double DMM_API::overflows() const
+{
+	return dmm->manager->get_buffer_stats().overflows;
+}
+
+void DMM_API::reset_buffer_stats()
+{
+	dmm->manager->reset_buffer_stats();
+}
+
 bool DMM_API::get_histogram_ch1() const
 {
 	return dmm->ui->histogramCh1->isChecked();
@@ -111,6 +111,13 @@ namespace adiscope {
 		Q_PROPERTY(double value_ch1 READ read_ch1);
 		Q_PROPERTY(double value_ch2 READ read_ch2);
 
+		/* Statistics of the buffers the samples are streamed in */
+		Q_PROPERTY(int buffer_size READ buffer_size STORED false);
+		Q_PROPERTY(int kernel_buffers READ kernel_buffers STORED false);
+		Q_PROPERTY(double refill_rate READ refill_rate STORED false);
+		Q_PROPERTY(double refills READ refills STORED false);
+		Q_PROPERTY(double overflows READ overflows STORED false);
+
 	public:
 		bool get_mode_ac_ch1() const { return dmm->mode_ac_ch1; }
 		bool get_mode_ac_ch2() const { return dmm->mode_ac_ch2; }
@@ -133,6 +140,13 @@ namespace adiscope {
 		bool running() const;
 		void run(bool en);
 
+		int buffer_size() const;
+		int kernel_buffers() const;
+		double refill_rate() const;
+		double refills() const;
+		double overflows() const;
+		Q_INVOKABLE void reset_buffer_stats();
+
 		explicit DMM_API(DMM *dmm) : ApiObject(), dmm(dmm) {}
 		~DMM_API() {}
 
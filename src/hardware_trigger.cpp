@@ -1,4 +1,5 @@
 #include "hardware_trigger.hpp"
+#include "iio_attr_cache.hpp"
 #include <QPair>
 
 #include <stdexcept>
@@ -50,6 +51,8 @@ HardwareTrigger::HardwareTrigger(struct iio_device *trigg_dev) :
 		throw std::invalid_argument("trigger_device=NULL");
 	}
 
+	m_attrs = IioAttrCache::get_instance(iio_device_get_context(trigg_dev));
+
 	// Get all channels and sort them ascending by name
 	QList<QPair<struct iio_channel *, QString>> channels;
 	for (uint i = 0; i < iio_device_get_channels_count(trigg_dev); i++) {
@@ -125,16 +128,14 @@ HardwareTrigger::condition HardwareTrigger::analogCondition(uint chnIdx)
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	ssize_t ret;
-	char buf[4096];
+	std::string buf;
 
-	ret = iio_channel_attr_read(m_analog_channels[chnIdx], "trigger", buf,
-		sizeof(buf));
+	int ret = m_attrs->read(m_analog_channels[chnIdx], "trigger", buf);
 	if (ret < 0) {
 		throw std::runtime_error("failed to read attribute: trigger");
 	}
 	auto it = std::find(lut_analog_trigg_cond.begin(),
-		lut_analog_trigg_cond.end(), buf);
+		lut_analog_trigg_cond.end(), QString::fromStdString(buf));
 	if  (it == lut_analog_trigg_cond.end()) {
 		throw std::runtime_error(
 			"unexpected value read from attribute: trigger");
@@ -154,9 +155,8 @@ void HardwareTrigger::setAnalogCondition(uint chnIdx, condition cond)
 		return; //or throw?
 	}
 
-	QByteArray byteArray =  lut_analog_trigg_cond[cond].toLatin1();
-	iio_channel_attr_write(m_analog_channels[chnIdx], "trigger",
-		byteArray.data());
+	m_attrs->write(m_analog_channels[chnIdx], "trigger",
+		lut_analog_trigg_cond[cond].toStdString());
 }
 
 HardwareTrigger::condition HardwareTrigger::digitalCondition(uint chnIdx)
@@ -166,15 +166,13 @@ HardwareTrigger::condition HardwareTrigger::digitalCondition(uint chnIdx)
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	ssize_t ret;
-	char buf[4096];
+	std::string buf;
 
-	ret = iio_channel_attr_read(m_digital_channels[chnIdx], "trigger", buf,
-		sizeof(buf));
+	int ret = m_attrs->read(m_digital_channels[chnIdx], "trigger", buf);
 	if (ret < 0)
 		throw "failed to read attribute: trigger";
 	auto it = std::find(lut_digital_trigg_cond.begin(),
-		lut_digital_trigg_cond.end(), buf);
+		lut_digital_trigg_cond.end(), QString::fromStdString(buf));
 	if  (it == lut_digital_trigg_cond.end()) {
 		throw "unexpected value read from attribute: trigger";
 	}
@@ -188,9 +186,8 @@ void HardwareTrigger::setDigitalCondition(uint chnIdx, condition cond)
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	QByteArray byteArray =  lut_digital_trigg_cond[cond].toLatin1();
-	iio_channel_attr_write(m_digital_channels[chnIdx], "trigger",
-		byteArray.data());
+	m_attrs->write(m_digital_channels[chnIdx], "trigger",
+		lut_digital_trigg_cond[cond].toStdString());
 }
 
 int HardwareTrigger::level(uint chnIdx) const
@@ -199,10 +196,9 @@ int HardwareTrigger::level(uint chnIdx) const
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	long long val;
+	long long val = 0;
 
-	iio_channel_attr_read_longlong(m_analog_channels[chnIdx],
-		"trigger_level", &val);
+	m_attrs->readLongLong(m_analog_channels[chnIdx], "trigger_level", val);
 
 	return static_cast<int>(val);
 }
@@ -213,8 +209,8 @@ void HardwareTrigger::setLevel(uint chnIdx, int level)
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	iio_channel_attr_write_longlong(m_analog_channels[chnIdx],
-		"trigger_level", static_cast<long long> (level));
+	m_attrs->writeLongLong(m_analog_channels[chnIdx], "trigger_level",
+		static_cast<long long> (level));
 }
 
 int HardwareTrigger::hysteresis(uint chnIdx) const
@@ -223,10 +219,9 @@ int HardwareTrigger::hysteresis(uint chnIdx) const
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	long long val;
+	long long val = 0;
 
-	iio_channel_attr_read_longlong(m_analog_channels[chnIdx],
-		"trigger_hysteresis", &val);
+	m_attrs->readLongLong(m_analog_channels[chnIdx], "trigger_hysteresis", val);
 
 	return static_cast<int>(val);
 }
@@ -237,7 +232,7 @@ void HardwareTrigger::setHysteresis(uint chnIdx, int histeresis)
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	iio_channel_attr_write_longlong(m_analog_channels[chnIdx],
+	m_attrs->writeLongLong(m_analog_channels[chnIdx],
 		"trigger_hysteresis", static_cast<long long>(histeresis));
 }
 
@@ -247,16 +242,14 @@ HardwareTrigger::mode HardwareTrigger::triggerMode(uint chnIdx) const
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	ssize_t ret;
-	char buf[4096];
+	std::string buf;
 
-	ret = iio_channel_attr_read(m_logic_channels[chnIdx], "mode", buf,
-		sizeof(buf));
+	int ret = m_attrs->read(m_logic_channels[chnIdx], "mode", buf);
 	if (ret < 0) {
 		throw ("failed to read attribute: mode");
 	}
 	auto it = std::find(lut_trigg_mode.begin(),
-		lut_trigg_mode.end(), buf);
+		lut_trigg_mode.end(), QString::fromStdString(buf));
 	if  (it == lut_trigg_mode.end()) {
 		throw ("unexpected value read from attribute: mode");
 	}
@@ -270,25 +263,22 @@ void HardwareTrigger::setTriggerMode(uint chnIdx, HardwareTrigger::mode mode)
 		throw std::invalid_argument("Channel index is out of range");
 	}
 
-	QByteArray byteArray =  lut_trigg_mode[mode].toLatin1();
-	iio_channel_attr_write(m_logic_channels[chnIdx], "mode",
-		byteArray.data());
+	m_attrs->write(m_logic_channels[chnIdx], "mode",
+		lut_trigg_mode[mode].toStdString());
 }
 
 QString HardwareTrigger::source() const
 {
-	char buf[4096];
+	std::string buf;
 
-	iio_channel_attr_read(m_delay_trigger, "logic_mode", buf, sizeof(buf));
+	m_attrs->read(m_delay_trigger, "logic_mode", buf);
 
-	return QString(buf);
+	return QString::fromStdString(buf);
 }
 
 void HardwareTrigger::setSource(const QString& source)
 {
-	QByteArray byteArray = source.toLatin1();
-	iio_channel_attr_write(m_delay_trigger, "logic_mode",
-			       byteArray.data());
+	m_attrs->write(m_delay_trigger, "logic_mode", source.toStdString());
 }
 
 /*
@@ -329,44 +319,56 @@ void HardwareTrigger::setSourceChannel(uint chnIdx)
 
 int HardwareTrigger::delay() const
 {
-	long long delay;
+	long long delay = 0;
 
-	iio_channel_attr_read_longlong(m_delay_trigger, "delay", &delay);
+	m_attrs->readLongLong(m_delay_trigger, "delay", delay);
 
 	return static_cast<int>(delay);
 }
 
 void HardwareTrigger::setDelay(int delay)
 {
-	iio_channel_attr_write_longlong(m_delay_trigger, "delay", delay);
+	m_attrs->writeLongLong(m_delay_trigger, "delay", delay);
 }
 
 HardwareTrigger::settings_uptr HardwareTrigger::getCurrentHwSettings()
 {
 	settings_uptr settings(new Settings);
 
+	// Refresh the state of every channel in one round trip each
+	for (uint i = 0; i < numChannels(); i++) {
+		m_attrs->prefetch(m_analog_channels[i]);
+		m_attrs->prefetch(m_digital_channels[i]);
+		m_attrs->prefetch(m_logic_channels[i]);
+	}
+	m_attrs->prefetch(m_delay_trigger);
+
 	for (uint i = 0; i < numChannels(); i++) {
 		settings->analog_condition.push_back(analogCondition(i));
 		settings->digital_condition.push_back(digitalCondition(i));
 		settings->level.push_back(level(i));
 		settings->hysteresis.push_back(hysteresis(i));
 		settings->mode.push_back(triggerMode(i));
-		settings->source = source();
-		settings->delay = delay();
 	}
+	settings->source = source();
+	settings->delay = delay();
 
 	return settings;
 }
 
 void HardwareTrigger::setHwTriggerSettings(struct Settings *settings)
 {
+	m_attrs->begin();
+
 	for (uint i = 0; i < numChannels(); i++) {
 		setAnalogCondition(i, settings->analog_condition[i]);
 		setDigitalCondition(i, settings->digital_condition[i]);
 		setLevel(i, settings->level[i]);
 		setHysteresis(i, settings->hysteresis[i]);
 		setTriggerMode(i, settings->mode[i]);
-		setSource(settings->source);
-		setDelay(settings->delay);
 	}
+	setSource(settings->source);
+	setDelay(settings->delay);
+
+	m_attrs->commit();
 }
@@ -14,6 +14,8 @@ extern "C" {
 
 namespace adiscope {
 
+class IioAttrCache;
+
 class HardwareTrigger
 {
 public:
@@ -83,6 +85,7 @@ public:
 	void setHwTriggerSettings(struct Settings *settings);
 
 private:
+	std::shared_ptr<IioAttrCache> m_attrs;
 	struct iio_device *m_trigger_device;
 	QList<struct iio_channel *> m_analog_channels;
 	QList<struct iio_channel *> m_digital_channels;
@@ -28,6 +28,12 @@
 
 namespace adiscope {
 
+    enum histogram_mode {
+      HIST_MODE_FRAME,		// counts of the last frame only
+      HIST_MODE_ACCUMULATE,	// infinite persistence
+      HIST_MODE_WINDOW,		// counts of the last N frames
+    };
+
     /*!
      * \brief A graphical sink to display a histogram.
      * \ingroup instrumentation_blk
@@ -54,6 +60,11 @@ namespace adiscope {
      * accumulates the data between calls to work. When accumulate is
      * activated, the y-axis autoscaling is turned on by default as
      * the values will quickly grow in the this direction.
+     *
+     * The samples are binned by the sink itself as they arrive, so
+     * only the bin counts travel to the plot. Besides showing the
+     * last frame of \p size samples, the counts can be accumulated
+     * indefinitely or over a sliding window of the last frames.
      */
     class histogram_sink_f : virtual public gr::sync_block
     {
@@ -91,6 +102,12 @@ namespace adiscope {
       virtual void set_update_time(double t) = 0;
       virtual void set_nsamps(const int newsize) = 0;
       virtual void set_bins(const int bins) = 0;
+      virtual void set_xaxis(double xmin, double xmax) = 0;
+
+      /* \p window is the number of frames summed in HIST_MODE_WINDOW */
+      virtual void set_mode(histogram_mode mode, int window = 1) = 0;
+      virtual histogram_mode mode() const = 0;
+      virtual int window() const = 0;
     };
 
 } /* namespace adiscope */
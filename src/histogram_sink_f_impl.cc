@@ -27,6 +27,7 @@
 #include "histogram_sink_f_impl.h"
 
 #include <algorithm>
+#include <limits>
 
 #include <gnuradio/io_signature.h>
 #include <gnuradio/prefs.h>
@@ -59,15 +60,13 @@ namespace adiscope {
                    io_signature::make(nconnections, nconnections, sizeof(float)),
                    io_signature::make(0, 0, 0)),
 	d_size(size), d_bins(bins), d_xmin(xmin), d_xmax(xmax), d_name(name),
-	d_nconnections(nconnections)
+	d_nconnections(nconnections), d_mode(HIST_MODE_FRAME), d_window(1)
     {
       d_index = 0;
 
-      for(int i = 0; i < d_nconnections; i++) {
-	d_residbufs.push_back((double*)volk_malloc(d_size*sizeof(double),
-                                                   volk_get_alignment()));
-	memset(d_residbufs[i], 0, d_size*sizeof(double));
-      }
+      HistogramDisplayPlot::binLayout(d_xmin, d_xmax, d_bins,
+                                      d_left, d_width);
+      _reset_bins();
 
       // Set alignment properties for VOLK
       const int alignment_multiple =
@@ -80,9 +79,6 @@ namespace adiscope {
 
     histogram_sink_f_impl::~histogram_sink_f_impl()
     {
-      for(int i = 0; i < d_nconnections; i++) {
-	volk_free(d_residbufs[i]);
-      }
     }
 
     bool
@@ -127,20 +123,10 @@ namespace adiscope {
       gr::thread::scoped_lock lock(d_setlock);
 
       if(newsize != d_size) {
-	// Resize residbuf and replace data
-	for(int i = 0; i < d_nconnections; i++) {
-	  volk_free(d_residbufs[i]);
-	  d_residbufs[i] = (double*)volk_malloc(newsize*sizeof(double),
-                                                volk_get_alignment());
-
-	  memset(d_residbufs[i], 0, newsize*sizeof(double));
-	}
-
 	// Set new size and reset buffer index
 	// (throws away any currently held data, but who cares?)
 	d_size = newsize;
-	d_index = 0;
-
+	_reset_bins();
       }
     }
 
@@ -149,7 +135,40 @@ namespace adiscope {
     {
       gr::thread::scoped_lock lock(d_setlock);
       d_bins = bins;
-      plot->setNumBins(d_bins);
+      HistogramDisplayPlot::binLayout(d_xmin, d_xmax, d_bins,
+                                      d_left, d_width);
+      _reset_bins();
+    }
+
+    void
+    histogram_sink_f_impl::set_xaxis(double xmin, double xmax)
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      HistogramDisplayPlot::binLayout(xmin, xmax, d_bins, d_left, d_width);
+      d_xmin = xmin;
+      d_xmax = xmax;
+      _reset_bins();
+    }
+
+    void
+    histogram_sink_f_impl::set_mode(histogram_mode mode, int window)
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      d_mode = mode;
+      d_window = std::max(window, 1);
+      _reset_bins();
+    }
+
+    histogram_mode
+    histogram_sink_f_impl::mode() const
+    {
+      return d_mode;
+    }
+
+    int
+    histogram_sink_f_impl::window() const
+    {
+      return d_window;
     }
 
     int
@@ -166,8 +185,118 @@ namespace adiscope {
 
     void
     histogram_sink_f_impl::reset()
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      _reset_bins();
+    }
+
+    void
+    histogram_sink_f_impl::_reset_bins()
     {
       d_index = 0;
+
+      d_frame.assign(d_nconnections, std::vector<uint32_t>(d_bins + 2, 0));
+      d_totals.assign(d_nconnections, std::vector<uint64_t>(d_bins, 0));
+      d_out.assign(d_nconnections, std::vector<double>(d_bins, 0.0));
+
+      if(d_mode == HIST_MODE_WINDOW)
+	d_window_frames.assign(d_window, d_frame);
+      else
+	d_window_frames.clear();
+      d_window_pos = 0;
+      d_window_fill = 0;
+
+      d_data_min = std::numeric_limits<float>::max();
+      d_data_max = -std::numeric_limits<float>::max();
+    }
+
+    /*
+     * The bin index of every sample is computed first in a branchless loop
+     * that the compiler vectorizes. Samples outside the range are clamped
+     * into the two guard bins, so the counting loop needs no test either.
+     */
+    void
+    histogram_sink_f_impl::bin_samples(const float *in, int nitems,
+                                       float left, float inv_width, int bins,
+                                       int *indices, uint32_t *hist)
+    {
+      const float offset = 1.5f - left * inv_width;
+      const float last = (float)(bins + 1);
+
+      for(int i = 0; i < nitems; i++) {
+	float pos = in[i] * inv_width + offset;
+	pos = std::max(0.0f, pos);	// also maps NaN to the underflow bin
+	pos = std::min(pos, last);
+	indices[i] = (int)pos;
+      }
+
+      for(int i = 0; i < nitems; i++)
+	hist[indices[i]]++;
+    }
+
+    void
+    histogram_sink_f_impl::_frame_done()
+    {
+      for(int n = 0; n < d_nconnections; n++) {
+	const uint32_t *frame = &d_frame[n][1];
+	uint64_t *totals = d_totals[n].data();
+
+	switch(d_mode) {
+	case HIST_MODE_FRAME:
+	  for(int k = 0; k < d_bins; k++)
+	    totals[k] = frame[k];
+	  break;
+
+	case HIST_MODE_ACCUMULATE:
+	  for(int k = 0; k < d_bins; k++)
+	    totals[k] += frame[k];
+	  break;
+
+	case HIST_MODE_WINDOW: {
+	  // Add the new frame and drop the oldest one from the sums
+	  std::vector<uint32_t>& slot = d_window_frames[d_window_pos][n];
+
+	  if(d_window_fill == d_window) {
+	    for(int k = 0; k < d_bins; k++)
+	      totals[k] -= slot[k + 1];
+	  }
+	  for(int k = 0; k < d_bins; k++)
+	    totals[k] += frame[k];
+
+	  slot.swap(d_frame[n]);
+	  break;
+	}
+	}
+
+	std::fill(d_frame[n].begin(), d_frame[n].end(), 0);
+      }
+
+      if(d_mode == HIST_MODE_WINDOW) {
+	d_window_pos = (d_window_pos + 1) % d_window;
+	d_window_fill = std::min(d_window_fill + 1, d_window);
+      }
+
+      // Update the plot if its time
+      if(gr::high_res_timer_now() - d_last_time > d_update_time) {
+	d_last_time = gr::high_res_timer_now();
+
+	std::vector<double*> out;
+	for(int n = 0; n < d_nconnections; n++) {
+	  for(int k = 0; k < d_bins; k++)
+	    d_out[n][k] = (double)d_totals[n][k];
+	  out.push_back(d_out[n].data());
+	}
+
+	if (d_qApplication)
+	  d_qApplication->postEvent(this->plot,
+				    new HistogramUpdateEvent(out, d_bins,
+							     d_left, d_width,
+							     d_data_min,
+							     d_data_max));
+
+	d_data_min = std::numeric_limits<float>::max();
+	d_data_max = -std::numeric_limits<float>::max();
+      }
     }
 
     int
@@ -175,49 +304,34 @@ namespace adiscope {
 			   gr_vector_const_void_star &input_items,
 			   gr_vector_void_star &output_items)
     {
-      int n=0, j=0, idx=0;
-      const float *in = (const float*)input_items[idx];
+      gr::thread::scoped_lock lock(d_setlock);
 
-      for(int i=0; i < noutput_items; i+=d_size) {
-	unsigned int datasize = noutput_items - i;
-	unsigned int resid = d_size-d_index;
-	idx = 0;
+      int nitems = std::min(noutput_items, d_size - d_index);
+      float inv_width = 1.0 / d_width;
 
-	// If we have enough input for one full plot, do it
-	if(datasize >= resid) {
+      if((int)d_indices.size() < nitems)
+	d_indices.resize(nitems);
 
-	  // Fill up residbufs with d_size number of items
-	  for(n = 0; n < d_nconnections; n++) {
-	    in = (const float*)input_items[idx++];
-	    volk_32f_convert_64f_u(&d_residbufs[n][d_index],
-				   &in[j], resid);
-	  }
+      for(int n = 0; n < d_nconnections; n++) {
+	const float *in = (const float*)input_items[n];
 
-	  // Update the plot if its time
-	  if(gr::high_res_timer_now() - d_last_time > d_update_time) {
-	    d_last_time = gr::high_res_timer_now();
-	    if (d_qApplication)
-	      d_qApplication->postEvent(this->plot,
-				      new HistogramUpdateEvent(d_residbufs, d_size));
-	  }
+	bin_samples(in, nitems, d_left, inv_width, d_bins,
+		    d_indices.data(), d_frame[n].data());
 
-	  d_index = 0;
-	  j += resid;
-	}
-	// Otherwise, copy what we received into the residbufs for next time
-	// because we set the output_multiple, this should never need to be called
-	else {
-	  for(n = 0; n < d_nconnections; n++) {
-	    in = (const float*)input_items[idx++];
-	    volk_32f_convert_64f_u(&d_residbufs[n][d_index],
-				   &in[j], datasize);
-	  }
-	  d_index += datasize;
-	  j += datasize;
+	for(int i = 0; i < nitems; i++) {
+	  d_data_min = std::min(d_data_min, in[i]);
+	  d_data_max = std::max(d_data_max, in[i]);
 	}
       }
 
-      return j;
+      d_index += nitems;
+
+      if(d_index >= d_size) {
+	_frame_done();
+	d_index = 0;
+      }
+
+      return nitems;
     }
 
 } /* namespace adiscope */
@@ -42,13 +42,36 @@ namespace adiscope {
       int d_nconnections;
 
       int d_index;
-      std::vector<double*> d_residbufs;
+
+      histogram_mode d_mode;
+      int d_window;
+      double d_left, d_width;
+
+      // Counts of the frame being received, with an underflow and an
+      // overflow guard bin around the d_bins real ones
+      std::vector< std::vector<uint32_t> > d_frame;
+      std::vector< std::vector<uint64_t> > d_totals;
+
+      // Last d_window frames, for the sliding window mode
+      std::vector< std::vector< std::vector<uint32_t> > > d_window_frames;
+      int d_window_pos, d_window_fill;
+
+      std::vector<int> d_indices;
+      std::vector< std::vector<double> > d_out;
+      float d_data_min, d_data_max;
 
       HistogramDisplayPlot *plot;
 
       gr::high_res_timer_type d_update_time;
       gr::high_res_timer_type d_last_time;
 
+      void _reset_bins();
+      void _frame_done();
+
+      static void bin_samples(const float *in, int nitems,
+                              float left, float inv_width, int bins,
+                              int *indices, uint32_t *hist);
+
     public:
       histogram_sink_f_impl(int size, int bins,
                             double xmin, double xmax,
@@ -64,6 +87,10 @@ namespace adiscope {
       void set_update_time(double t);
       void set_nsamps(const int newsize);
       void set_bins(const int bins);
+      void set_xaxis(double xmin, double xmax);
+      void set_mode(histogram_mode mode, int window);
+      histogram_mode mode() const;
+      int window() const;
 
       int  nsamps() const;
       int  bins() const;
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "hotplug_monitor.hpp"
+
+#include <QSocketNotifier>
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+/* Multicast groups of the uevent netlink family */
+#define UEVENT_GROUP_KERNEL 1
+#define UEVENT_GROUP_UDEV 2
+
+using namespace adiscope;
+
+HotplugMonitor::HotplugMonitor(QObject *parent) :
+	QObject(parent), fd(-1), notifier(nullptr)
+{
+#ifdef __linux__
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+			NETLINK_KOBJECT_UEVENT);
+	if (fd < 0)
+		return;
+
+	/* The kernel announces a device first, udev once its rules (and
+	 * so the permissions of the device node) have been applied; we
+	 * listen to both in case udev isn't running */
+	struct sockaddr_nl addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = UEVENT_GROUP_KERNEL | UEVENT_GROUP_UDEV;
+
+	if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr),
+				sizeof(addr)) < 0) {
+		::close(fd);
+		fd = -1;
+		return;
+	}
+
+	notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+	connect(notifier, SIGNAL(activated(int)), this, SLOT(readEvents()));
+#endif
+}
+
+HotplugMonitor::~HotplugMonitor()
+{
+	delete notifier;
+
+#ifdef __linux__
+	if (fd >= 0)
+		::close(fd);
+#endif
+}
+
+bool HotplugMonitor::isActive() const
+{
+	return fd >= 0;
+}
+
+void HotplugMonitor::readEvents()
+{
+#ifdef __linux__
+	char buf[8192];
+	bool usb_changed = false;
+	ssize_t len;
+
+	/* Drain the socket, a device comes with one event per interface */
+	while ((len = recv(fd, buf, sizeof(buf) - 1, 0)) > 0) {
+		buf[len] = '\0';
+
+		if (isUsbDeviceEvent(buf, len))
+			usb_changed = true;
+	}
+
+	if (usb_changed)
+		Q_EMIT changed();
+#endif
+}
+
+bool HotplugMonitor::isUsbDeviceEvent(const char *msg, size_t len)
+{
+	bool add_remove = false, usb = false, device = false;
+
+	/* Both formats carry the properties as NUL-separated KEY=VALUE
+	 * strings; the binary header of udev messages never matches */
+	for (const char *s = msg; s < msg + len; s += strlen(s) + 1) {
+		if (!strcmp(s, "ACTION=add") || !strcmp(s, "ACTION=remove"))
+			add_remove = true;
+		else if (!strcmp(s, "SUBSYSTEM=usb"))
+			usb = true;
+		else if (!strcmp(s, "DEVTYPE=usb_device"))
+			device = true;
+	}
+
+	return add_remove && usb && device;
+}
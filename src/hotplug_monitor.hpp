@@ -0,0 +1,60 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef SCOPY_HOTPLUG_MONITOR_HPP
+#define SCOPY_HOTPLUG_MONITOR_HPP
+
+#include <QObject>
+
+class QSocketNotifier;
+
+namespace adiscope {
+/**
+ * Reports USB devices being plugged in or out, so that the list of
+ * devices is only rescanned when it may have changed.
+ *
+ * On Linux the uevents of the kernel and of udev are read from a
+ * netlink socket. Elsewhere, or when the socket can't be opened, the
+ * monitor is inactive and the caller has to keep polling.
+ */
+class HotplugMonitor : public QObject
+{
+	Q_OBJECT
+
+Q_SIGNALS:
+	void changed();
+
+public:
+	explicit HotplugMonitor(QObject *parent = Q_NULLPTR);
+	~HotplugMonitor();
+
+	bool isActive() const;
+
+private Q_SLOTS:
+	void readEvents();
+
+private:
+	int fd;
+	QSocketNotifier *notifier;
+
+	static bool isUsbDeviceEvent(const char *msg, size_t len);
+};
+}
+
+#endif /* SCOPY_HOTPLUG_MONITOR_HPP */
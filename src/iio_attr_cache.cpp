@@ -0,0 +1,489 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "iio_attr_cache.hpp"
+
+#include <QString>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <iio.h>
+
+using namespace adiscope;
+
+std::map<const struct iio_context *, std::weak_ptr<IioAttrCache> >
+	IioAttrCache::ctx_map;
+std::mutex IioAttrCache::ctx_map_mutex;
+
+namespace {
+	/* Same formats as the iio_*_attr_write_*() functions */
+	std::string formatLongLong(long long value)
+	{
+		return std::to_string(value);
+	}
+
+	std::string formatDouble(double value)
+	{
+		return QString::number(value, 'f', 6).toStdString();
+	}
+
+	int parseLongLong(const std::string& str, long long &value)
+	{
+		char *end;
+		long long val = strtoll(str.c_str(), &end, 0);
+
+		if (end == str.c_str())
+			return -EINVAL;
+
+		value = val;
+		return 0;
+	}
+
+	int parseDouble(const std::string& str, double &value)
+	{
+		bool ok;
+		double val = QString::fromStdString(str).toDouble(&ok);
+
+		if (!ok)
+			return -EINVAL;
+
+		value = val;
+		return 0;
+	}
+
+	struct write_all_data {
+		const std::vector<std::string> *attrs;
+		const std::vector<std::string> *values;
+	};
+
+	ssize_t fillWriteAll(const char *attr, void *buf, size_t len,
+			void *d)
+	{
+		auto data = static_cast<write_all_data *>(d);
+		auto it = std::find(data->attrs->begin(), data->attrs->end(),
+				attr);
+
+		/* Attributes with a length of zero are left alone */
+		if (it == data->attrs->end())
+			return 0;
+
+		const std::string& value = data->values->at(
+				it - data->attrs->begin());
+		if (value.size() + 1 > len)
+			return -ENOMEM;
+
+		memcpy(buf, value.c_str(), value.size() + 1);
+		return value.size() + 1;
+	}
+
+	ssize_t fillChannelWriteAll(struct iio_channel *, const char *attr,
+			void *buf, size_t len, void *d)
+	{
+		return fillWriteAll(attr, buf, len, d);
+	}
+
+	ssize_t fillDeviceWriteAll(struct iio_device *, const char *attr,
+			void *buf, size_t len, void *d)
+	{
+		return fillWriteAll(attr, buf, len, d);
+	}
+
+	struct read_all_data {
+		const void *chn;
+		std::map<std::pair<const void *, std::string>,
+			std::string> *values;
+	};
+
+	int storeReadAll(struct iio_channel *, const char *attr,
+			const char *value, size_t len, void *d)
+	{
+		auto data = static_cast<read_all_data *>(d);
+
+		(*data->values)[std::make_pair(data->chn, std::string(attr))] =
+			std::string(value, strnlen(value, len));
+		return 0;
+	}
+}
+
+std::shared_ptr<IioAttrCache> IioAttrCache::get_instance(
+		const struct iio_context *ctx)
+{
+	std::lock_guard<std::mutex> lock(ctx_map_mutex);
+
+	auto it = ctx_map.find(ctx);
+	if (it != ctx_map.end()) {
+		auto cache = it->second.lock();
+		if (cache)
+			return cache;
+	}
+
+	std::shared_ptr<IioAttrCache> cache(new IioAttrCache);
+	ctx_map[ctx] = cache;
+
+	return cache;
+}
+
+IioAttrCache::IioAttrCache() :
+	transaction_depth(0)
+{
+	/* A single thread keeps the asynchronous accesses in order */
+	pool.setMaxThreadCount(1);
+}
+
+IioAttrCache::~IioAttrCache()
+{
+	pool.waitForDone();
+}
+
+int IioAttrCache::readAttr(const void *obj, bool is_channel,
+		const char *attr, std::string &value)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	/* Queued writes are read back as if they had been sent */
+	for (auto it = pending.rbegin(); it != pending.rend(); ++it) {
+		if (it->obj == obj && it->attr == attr) {
+			value = it->value;
+			return 0;
+		}
+	}
+
+	const key k(obj, attr);
+	auto it = values.find(k);
+	if (it != values.end()) {
+		value = it->second;
+		return 0;
+	}
+
+	char buf[4096];
+	ssize_t ret;
+
+	if (is_channel)
+		ret = iio_channel_attr_read((struct iio_channel *) obj, attr,
+				buf, sizeof(buf));
+	else
+		ret = iio_device_attr_read((struct iio_device *) obj, attr,
+				buf, sizeof(buf));
+	if (ret < 0)
+		return (int) ret;
+
+	value = buf;
+	values[k] = value;
+	return 0;
+}
+
+int IioAttrCache::writeAttr(const void *obj, bool is_channel,
+		const char *attr, const std::string &value)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	const key k(obj, attr);
+	auto it = values.find(k);
+	const bool unchanged = it != values.end() && it->second == value;
+
+	if (transaction_depth) {
+		auto p = std::find_if(pending.begin(), pending.end(),
+			[&](const pending_write &w) {
+				return w.obj == obj && w.attr == attr;
+			});
+
+		if (unchanged) {
+			if (p != pending.end())
+				pending.erase(p);
+		} else if (p != pending.end()) {
+			p->value = value;
+		} else {
+			pending.push_back({obj, is_channel, attr, value});
+		}
+
+		return 0;
+	}
+
+	if (unchanged)
+		return 0;
+
+	ssize_t ret;
+
+	if (is_channel)
+		ret = iio_channel_attr_write((struct iio_channel *) obj, attr,
+				value.c_str());
+	else
+		ret = iio_device_attr_write((struct iio_device *) obj, attr,
+				value.c_str());
+	if (ret < 0) {
+		values.erase(k);
+		return (int) ret;
+	}
+
+	values[k] = value;
+	return 0;
+}
+
+int IioAttrCache::writeAll(const void *obj, bool is_channel,
+		const std::vector<pending_write *> &writes)
+{
+	std::vector<std::string> attrs, vals;
+
+	for (auto w : writes) {
+		attrs.push_back(w->attr);
+		vals.push_back(w->value);
+	}
+
+	write_all_data data = { &attrs, &vals };
+	int ret;
+
+	if (writes.size() == 1)
+		ret = -ENOSYS;
+	else if (is_channel)
+		ret = iio_channel_attr_write_all((struct iio_channel *) obj,
+				fillChannelWriteAll, &data);
+	else
+		ret = iio_device_attr_write_all((struct iio_device *) obj,
+				fillDeviceWriteAll, &data);
+
+	/* Single writes, and backends without the transaction, go one
+	 * attribute at a time */
+	if (ret < 0) {
+		ret = 0;
+
+		for (auto w : writes) {
+			ssize_t r;
+
+			if (is_channel)
+				r = iio_channel_attr_write(
+					(struct iio_channel *) obj,
+					w->attr.c_str(), w->value.c_str());
+			else
+				r = iio_device_attr_write(
+					(struct iio_device *) obj,
+					w->attr.c_str(), w->value.c_str());
+			if (r < 0) {
+				values.erase(key(obj, w->attr));
+				ret = (int) r;
+			} else {
+				values[key(obj, w->attr)] = w->value;
+			}
+		}
+
+		return ret;
+	}
+
+	for (auto w : writes)
+		values[key(obj, w->attr)] = w->value;
+
+	return 0;
+}
+
+int IioAttrCache::read(struct iio_channel *chn, const char *attr,
+		std::string &value)
+{
+	return readAttr(chn, true, attr, value);
+}
+
+int IioAttrCache::readLongLong(struct iio_channel *chn, const char *attr,
+		long long &value)
+{
+	std::string str;
+	int ret = readAttr(chn, true, attr, str);
+
+	return ret < 0 ? ret : parseLongLong(str, value);
+}
+
+int IioAttrCache::readDouble(struct iio_channel *chn, const char *attr,
+		double &value)
+{
+	std::string str;
+	int ret = readAttr(chn, true, attr, str);
+
+	return ret < 0 ? ret : parseDouble(str, value);
+}
+
+int IioAttrCache::readBool(struct iio_channel *chn, const char *attr,
+		bool &value)
+{
+	long long val;
+	int ret = readLongLong(chn, attr, val);
+
+	if (ret == 0)
+		value = !!val;
+	return ret;
+}
+
+int IioAttrCache::read(struct iio_device *dev, const char *attr,
+		std::string &value)
+{
+	return readAttr(dev, false, attr, value);
+}
+
+int IioAttrCache::readLongLong(struct iio_device *dev, const char *attr,
+		long long &value)
+{
+	std::string str;
+	int ret = readAttr(dev, false, attr, str);
+
+	return ret < 0 ? ret : parseLongLong(str, value);
+}
+
+int IioAttrCache::readDouble(struct iio_device *dev, const char *attr,
+		double &value)
+{
+	std::string str;
+	int ret = readAttr(dev, false, attr, str);
+
+	return ret < 0 ? ret : parseDouble(str, value);
+}
+
+int IioAttrCache::write(struct iio_channel *chn, const char *attr,
+		const std::string &value)
+{
+	return writeAttr(chn, true, attr, value);
+}
+
+int IioAttrCache::writeLongLong(struct iio_channel *chn, const char *attr,
+		long long value)
+{
+	return writeAttr(chn, true, attr, formatLongLong(value));
+}
+
+int IioAttrCache::writeDouble(struct iio_channel *chn, const char *attr,
+		double value)
+{
+	return writeAttr(chn, true, attr, formatDouble(value));
+}
+
+int IioAttrCache::writeBool(struct iio_channel *chn, const char *attr,
+		bool value)
+{
+	return writeAttr(chn, true, attr, value ? "1" : "0");
+}
+
+int IioAttrCache::write(struct iio_device *dev, const char *attr,
+		const std::string &value)
+{
+	return writeAttr(dev, false, attr, value);
+}
+
+int IioAttrCache::writeLongLong(struct iio_device *dev, const char *attr,
+		long long value)
+{
+	return writeAttr(dev, false, attr, formatLongLong(value));
+}
+
+int IioAttrCache::writeDouble(struct iio_device *dev, const char *attr,
+		double value)
+{
+	return writeAttr(dev, false, attr, formatDouble(value));
+}
+
+int IioAttrCache::prefetch(struct iio_channel *chn)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	read_all_data data = { chn, &values };
+
+	return iio_channel_attr_read_all(chn, storeReadAll, &data);
+}
+
+void IioAttrCache::begin()
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	transaction_depth++;
+}
+
+int IioAttrCache::commit()
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	if (!transaction_depth || --transaction_depth)
+		return 0;
+
+	/* One transaction per channel or device, in the order in which
+	 * they were first written to */
+	std::vector<const void *> objs;
+	for (const auto &w : pending)
+		if (std::find(objs.begin(), objs.end(), w.obj) == objs.end())
+			objs.push_back(w.obj);
+
+	int ret = 0;
+
+	for (const void *obj : objs) {
+		std::vector<pending_write *> writes;
+		bool is_channel = false;
+
+		for (auto &w : pending) {
+			if (w.obj == obj) {
+				writes.push_back(&w);
+				is_channel = w.is_channel;
+			}
+		}
+
+		int r = writeAll(obj, is_channel, writes);
+		if (r < 0)
+			ret = r;
+	}
+
+	pending.clear();
+	return ret;
+}
+
+void IioAttrCache::invalidate()
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	values.clear();
+}
+
+void IioAttrCache::invalidate(struct iio_channel *chn, const char *attr)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	values.erase(key(chn, attr));
+}
+
+void IioAttrCache::invalidate(struct iio_device *dev, const char *attr)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	values.erase(key(dev, attr));
+}
+
+QFuture<int> IioAttrCache::writeAsync(struct iio_channel *chn,
+		const char *attr, const std::string &value)
+{
+	const std::string name(attr);
+
+	return async([=]() { return write(chn, name.c_str(), value); });
+}
+
+QFuture<int> IioAttrCache::writeAsync(struct iio_device *dev,
+		const char *attr, const std::string &value)
+{
+	const std::string name(attr);
+
+	return async([=]() { return write(dev, name.c_str(), value); });
+}
+
+void IioAttrCache::waitForAsync()
+{
+	pool.waitForDone();
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef IIO_ATTR_CACHE_HPP
+#define IIO_ATTR_CACHE_HPP
+
+#include <QFuture>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+	struct iio_channel;
+	struct iio_context;
+	struct iio_device;
+}
+
+namespace adiscope {
+	/*
+	 * Shared access to the attributes of the devices of an IIO context.
+	 *
+	 * The cache is write-through: an attribute is read from the hardware
+	 * once, and later reads return the value last read or written.
+	 * Writing the value an attribute already holds is skipped. Between
+	 * begin() and commit(), writes are queued instead, repeated writes
+	 * to an attribute coalesce into the last one, and commit() sends the
+	 * writes to each channel or device in a single *_attr_write_all()
+	 * transaction, which is one round trip over a network context.
+	 *
+	 * Attributes that change on their own (measurements, values rounded
+	 * by the driver) have to be invalidated before they are read, and so
+	 * do attributes written without going through the cache.
+	 *
+	 * All the functions return 0 or a negative error code, like libiio.
+	 */
+	class IioAttrCache : public std::enable_shared_from_this<IioAttrCache>
+	{
+	public:
+		/* Get a shared pointer to the cache of the given context */
+		static std::shared_ptr<IioAttrCache> get_instance(
+				const struct iio_context *ctx);
+
+		~IioAttrCache();
+
+		int read(struct iio_channel *chn, const char *attr,
+				std::string &value);
+		int readLongLong(struct iio_channel *chn, const char *attr,
+				long long &value);
+		int readDouble(struct iio_channel *chn, const char *attr,
+				double &value);
+		int readBool(struct iio_channel *chn, const char *attr,
+				bool &value);
+
+		int read(struct iio_device *dev, const char *attr,
+				std::string &value);
+		int readLongLong(struct iio_device *dev, const char *attr,
+				long long &value);
+		int readDouble(struct iio_device *dev, const char *attr,
+				double &value);
+
+		int write(struct iio_channel *chn, const char *attr,
+				const std::string &value);
+		int writeLongLong(struct iio_channel *chn, const char *attr,
+				long long value);
+		int writeDouble(struct iio_channel *chn, const char *attr,
+				double value);
+		int writeBool(struct iio_channel *chn, const char *attr,
+				bool value);
+
+		int write(struct iio_device *dev, const char *attr,
+				const std::string &value);
+		int writeLongLong(struct iio_device *dev, const char *attr,
+				long long value);
+		int writeDouble(struct iio_device *dev, const char *attr,
+				double value);
+
+		/* Reads all the attributes of a channel in one round trip,
+		 * refreshing what was cached */
+		int prefetch(struct iio_channel *chn);
+
+		/* Transactions can be nested, the writes are sent by the
+		 * outermost commit() */
+		void begin();
+		int commit();
+
+		void invalidate();
+		void invalidate(struct iio_channel *chn, const char *attr);
+		void invalidate(struct iio_device *dev, const char *attr);
+
+		/* Runs a function on the thread that performs the
+		 * asynchronous accesses of this context, in order */
+		template<typename F>
+		auto async(F f) -> QFuture<decltype(f())>
+		{
+			auto self = shared_from_this();
+			return QtConcurrent::run(&pool, [self, f]() {
+				return f();
+			});
+		}
+
+		QFuture<int> writeAsync(struct iio_channel *chn,
+				const char *attr, const std::string &value);
+		QFuture<int> writeAsync(struct iio_device *dev,
+				const char *attr, const std::string &value);
+
+		/* Waits for the asynchronous accesses queued so far */
+		void waitForAsync();
+
+	private:
+		typedef std::pair<const void *, std::string> key;
+
+		struct pending_write {
+			const void *obj;
+			bool is_channel;
+			std::string attr;
+			std::string value;
+		};
+
+		static std::map<const struct iio_context *,
+			std::weak_ptr<IioAttrCache> > ctx_map;
+		static std::mutex ctx_map_mutex;
+
+		std::recursive_mutex mutex;
+		std::map<key, std::string> values;
+		std::vector<pending_write> pending;
+		unsigned int transaction_depth;
+		QThreadPool pool;
+
+		IioAttrCache();
+
+		int readAttr(const void *obj, bool is_channel,
+				const char *attr, std::string &value);
+		int writeAttr(const void *obj, bool is_channel,
+				const char *attr, const std::string &value);
+		int writeAll(const void *obj, bool is_channel,
+				const std::vector<pending_write *> &writes);
+	};
+}
+
+#endif /* IIO_ATTR_CACHE_HPP */
@@ -17,6 +17,7 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include "iio_attr_cache.hpp"
 #include "iio_manager.hpp"
 #include "timeout_block.hpp"
 
@@ -27,6 +28,9 @@
 
 #include <iio.h>
 
+/* What libiio queues when the count is not set */
+#define DEFAULT_KERNEL_BUFFERS 4
+
 using namespace adiscope;
 using namespace gr;
 
@@ -38,15 +42,19 @@ iio_manager::iio_manager(unsigned int block_id,
 		unsigned long _buffer_size) :
 	QObject(nullptr),
 	top_block("IIO Manager " + std::to_string(block_id)),
-	id(block_id), _started(false), buffer_size(_buffer_size)
+	id(block_id), _started(false), buffer_size(_buffer_size),
+	kernel_buffers(DEFAULT_KERNEL_BUFFERS), dev(nullptr),
+	policy(BufferPolicy::LOCAL)
 {
 	if (!ctx)
 		throw std::runtime_error("IIO context not created");
 
-	struct iio_device *dev = iio_context_find_device(ctx, _dev.c_str());
+	dev = iio_context_find_device(ctx, _dev.c_str());
 	if (!dev)
 		throw std::runtime_error("Device not found");
 
+	policy = BufferPolicy(BufferPolicy::transport(ctx));
+
 	unsigned int nb_channels = iio_device_get_channels_count(dev);
 
 	iio_block = iio::device_source::make_from(ctx, _dev,
@@ -64,6 +72,12 @@ iio_manager::iio_manager(unsigned int block_id,
 
 	dummy_copy->set_enabled(true);
 
+	/* Every refill produces a buffer on all the ports, so watching
+	 * the first one is enough */
+	monitor = gnuradio::get_initial_sptr(
+			new refill_monitor(sizeof(short), _dev));
+	hier_block2::connect(iio_block, 0, monitor, 0);
+
 	auto timeout_b = gnuradio::get_initial_sptr(new timeout_block("msg"));
 	hier_block2::msg_connect(iio_block, "msg", timeout_b, "msg");
 
@@ -109,14 +123,14 @@ boost::shared_ptr<iio_manager> iio_manager::get_instance(
 
 iio_manager::port_id iio_manager::connect(basic_block_sptr dst,
 		int src_port, int dst_port, bool use_float,
-		unsigned long _buffer_size)
+		unsigned long _buffer_size, bool streaming)
 {
 	copy_mutex.lock();
 
 	/* The copy block is used as a valve to turn on/off this
 	 * specific channel. */
 	auto copy = blocks::copy::make(sizeof(short));
-	copy_blocks.push_back(std::make_pair(copy, _buffer_size));
+	copy_blocks.push_back({ copy, _buffer_size, streaming });
 
 	/* Disable the valve by default. */
 	copy->set_enabled(false);
@@ -149,7 +163,7 @@ void iio_manager::disconnect(iio_manager::port_id copy)
 	copy->set_enabled(false);
 
 	for (auto it = copy_blocks.begin(); it != copy_blocks.end(); ++it) {
-		if (it->first == copy) {
+		if (it->id == copy) {
 			copy_blocks.erase(it);
 			break;
 		}
@@ -163,16 +177,44 @@ void iio_manager::disconnect(iio_manager::port_id copy)
 void iio_manager::update_buffer_size_unlocked()
 {
 	unsigned long size = 0;
+	bool streaming = true;
 
 	for (auto it = copy_blocks.begin(); it != copy_blocks.end(); ++it) {
-		if (it->first->enabled() && size < it->second)
-			size = it->second;
+		if (!it->id->enabled())
+			continue;
+
+		if (size < it->buffer_size)
+			size = it->buffer_size;
+		streaming &= it->streaming;
 	}
 
-	if (size) {
-		iio_block->set_buffer_size(size);
-		this->buffer_size = size;
+	if (!size)
+		return;
+
+	double rate = 0.0;
+	auto attrs = IioAttrCache::get_instance(iio_device_get_context(dev));
+	if (attrs->readDouble(dev, "sampling_frequency", rate) < 0)
+		rate = 0.0;
+
+	BufferPolicy::Settings settings = policy.select(rate, size, streaming);
+
+	/* Only takes effect when the buffer is created, which happens
+	 * when the flowgraph starts or the buffer size changes */
+	if (settings.kernel_buffers != kernel_buffers) {
+		int ret = iio_device_set_kernel_buffers_count(dev,
+				settings.kernel_buffers);
+		if (ret < 0)
+			qDebug() << "Unable to set the kernel buffer count:"
+				<< ret;
+		else
+			kernel_buffers = settings.kernel_buffers;
 	}
+
+	iio_block->set_buffer_size(settings.buffer_size);
+	this->buffer_size = settings.buffer_size;
+
+	monitor->set_buffers(settings.buffer_size, kernel_buffers, rate,
+			streaming);
 }
 
 void iio_manager::start(iio_manager::port_id copy)
@@ -215,7 +257,7 @@ void iio_manager::stop(iio_manager::port_id copy)
 	/* Verify whether all blocks are disabled */
 	for (auto it = copy_blocks.cbegin();
 			!inuse && it != copy_blocks.cend(); ++it)
-		inuse = it->first->enabled();
+		inuse = it->id->enabled();
 
 	if (!inuse) {
 		qDebug() << "Stopping top block";
@@ -234,7 +276,7 @@ unlock:
 void iio_manager::stop_all()
 {
 	for (auto it = copy_blocks.begin(); it != copy_blocks.end(); ++it)
-		stop(it->first);
+		stop(it->id);
 }
 
 void iio_manager::connect(gr::basic_block_sptr src, int src_port,
@@ -311,8 +353,8 @@ void iio_manager::set_buffer_size(iio_manager::port_id copy, unsigned long size)
 	copy_mutex.lock();
 
 	for (auto it = copy_blocks.begin(); it != copy_blocks.end(); ++it) {
-		if (it->first == copy) {
-			it->second = size;
+		if (it->id == copy) {
+			it->buffer_size = size;
 			break;
 		}
 	}
@@ -321,6 +363,27 @@ void iio_manager::set_buffer_size(iio_manager::port_id copy, unsigned long size)
 	copy_mutex.unlock();
 }
 
+iio_manager::buffer_stats iio_manager::get_buffer_stats()
+{
+	refill_monitor::stats refills = monitor->get_stats();
+	buffer_stats stats;
+
+	copy_mutex.lock();
+	stats.buffer_size = buffer_size;
+	stats.kernel_buffers = kernel_buffers;
+	copy_mutex.unlock();
+
+	stats.refill_rate = refills.refill_rate;
+	stats.refills = refills.refills;
+	stats.overflows = refills.overflows;
+	return stats;
+}
+
+void iio_manager::reset_buffer_stats()
+{
+	monitor->reset();
+}
+
 void iio_manager::got_timeout()
 {
 	Q_EMIT timeout();
@@ -22,6 +22,9 @@
 
 #include <QObject>
 
+#include "buffer_policy.hpp"
+#include "refill_monitor.hpp"
+
 #include <gnuradio/top_block.h>
 #include <gnuradio/iio/device_source.h>
 #include <gnuradio/blocks/copy.h>
@@ -41,6 +44,14 @@ namespace adiscope {
 		typedef boost::weak_ptr<iio_manager> map_entry;
 		typedef gr::blocks::copy::sptr port_id;
 
+		struct buffer_stats {
+			unsigned long buffer_size;
+			unsigned int kernel_buffers;
+			double refill_rate;
+			unsigned long long refills;
+			unsigned long long overflows;
+		};
+
 		const unsigned id;
 
 		/* Get a shared pointer to the instance of iio_manager that
@@ -55,10 +66,14 @@ namespace adiscope {
 		/* Connect a block to one of the channels of the IIO source.
 		 * This function returns the ID, that can later be used with
 		 * start() and stop().
+		 * Streaming clients only need at least buffer_size samples
+		 * per buffer, and may get bigger buffers; the others get
+		 * buffers of the size they asked for.
 		 * Warning: the flowgraph needs to be locked first! */
 		port_id connect(gr::basic_block_sptr dst, int src_port,
 				int dst_port, bool use_float = false,
-				unsigned long buffer_size = IIO_BUFFER_SIZE);
+				unsigned long buffer_size = IIO_BUFFER_SIZE,
+				bool streaming = false);
 
 		/* Connect two regular blocks between themselves. */
 		void connect(gr::basic_block_sptr src, int src_port,
@@ -87,6 +102,11 @@ namespace adiscope {
 		 * Warning: the flowgraph needs to be locked first! */
 		void set_buffer_size(port_id id, unsigned long size);
 
+		/* The buffers in use, how often they are refilled and how
+		 * many refills came too late for a continuous stream */
+		buffer_stats get_buffer_stats();
+		void reset_buffer_stats();
+
 		/* VERY ugly hack. The reconfiguration that happens after
 		 * locking/unlocking the flowgraph is sort of broken; the tags
 		 * are not properly routed to the blocks connected during the
@@ -102,11 +122,21 @@ namespace adiscope {
 		bool _started;
 
 		unsigned long buffer_size;
-		std::vector<unsigned long> buffer_sizes;
+		unsigned int kernel_buffers;
+
+		struct client {
+			port_id id;
+			unsigned long buffer_size;
+			bool streaming;
+		};
+
+		std::vector<client> copy_blocks;
 
-		std::vector<std::pair<port_id, unsigned long> > copy_blocks;
+		struct iio_device *dev;
+		BufferPolicy policy;
 
 		gr::iio::device_source::sptr iio_block;
+		boost::shared_ptr<refill_monitor> monitor;
 
 		struct connection {
 			gr::basic_block_sptr src;
@@ -28,6 +28,7 @@
 #include <QDebug>
 #include <QListView>
 #include <QPushButton>
+#include <QShortcut>
 #include <QTimer>
 
 /* Local includes */
@@ -37,6 +38,8 @@
 #include "pulseview/pv/view/viewport.hpp"
 #include "pulseview/pv/devicemanager.hpp"
 #include "pulseview/pv/session.hpp"
+#include "pulseview/pv/data/decoderstack.hpp"
+#include "pulseview/pv/data/logicsearch.hpp"
 #include "pulseview/pv/view/ruler.hpp"
 #include "streams_to_short.h"
 #include "logic_analyzer.hpp"
@@ -325,6 +328,16 @@ LogicAnalyzer::LogicAnalyzer(struct iio_context *ctx,
 		this, SLOT(refreshTriggerPos(int)));
 	connect(d_hCursorHandle1, SIGNAL(positionChanged(int)),
 		this, SLOT(cursorValueChanged_1(int)));
+
+	/* Step through the matches of the last search */
+	auto find_next = new QShortcut(QKeySequence::FindNext, this);
+	auto find_previous = new QShortcut(QKeySequence::FindPrevious, this);
+	connect(find_next, &QShortcut::activated, [=]() {
+		main_win->view_->jump_to_search_match(true);
+	});
+	connect(find_previous, &QShortcut::activated, [=]() {
+		main_win->view_->jump_to_search_match(false);
+	});
 	connect(d_hCursorHandle2, SIGNAL(positionChanged(int)),
 		this, SLOT(cursorValueChanged_2(int)));
 	connect(ui->boxCursors, SIGNAL(toggled(bool)),
@@ -1378,6 +1391,71 @@ void LogicAnalyzer_API::setInactiveHidden(bool en)
 	lga->ui->btnShowChannels->clicked(en);
 }
 
+int LogicAnalyzer_API::search_pattern(int mask, int value)
+{
+	using pv::data::LogicSearch;
+
+	return lga->main_win->view_->search(LogicSearch::find(
+		LogicSearch::pattern(mask, value)));
+}
+
+int LogicAnalyzer_API::search_edge(int channel, const QString& edge)
+{
+	using pv::data::LogicSearch;
+
+	if (channel < 0 || channel >= 64)
+		return -1;
+
+	LogicSearch::Condition condition;
+	if (edge == "rising")
+		condition = LogicSearch::rising_edge(channel);
+	else if (edge == "falling")
+		condition = LogicSearch::falling_edge(channel);
+	else if (edge == "any")
+		condition = LogicSearch::any_edge(channel);
+	else
+		return -1;
+
+	return lga->main_win->view_->search(LogicSearch::find(condition));
+}
+
+int LogicAnalyzer_API::search_pulse(int mask, int value,
+		double min_width, double max_width)
+{
+	using pv::data::LogicSearch;
+
+	const double rate = lga->main_win->view_->session().get_samplerate();
+	if (rate <= 0)
+		return -1;
+
+	const uint64_t max_samples = max_width > 0 ?
+		(uint64_t)(max_width * rate) : UINT64_MAX;
+
+	return lga->main_win->view_->search(LogicSearch::pulse(
+		LogicSearch::pattern(mask, value),
+		(uint64_t)(min_width * rate), max_samples));
+}
+
+bool LogicAnalyzer_API::search_next()
+{
+	return lga->main_win->view_->jump_to_search_match(true);
+}
+
+bool LogicAnalyzer_API::search_previous()
+{
+	return lga->main_win->view_->jump_to_search_match(false);
+}
+
+bool LogicAnalyzer_API::nativeDecoders() const
+{
+	return pv::data::DecoderStack::native_decode();
+}
+
+void LogicAnalyzer_API::setNativeDecoders(bool en)
+{
+	pv::data::DecoderStack::set_native_decode(en);
+}
+
 
 /*
  * ChannelGroup_API
@@ -1550,8 +1628,15 @@ QString LogicChannel_API::getRole() const
 
 void LogicChannel_API::setRole(QString val)
 {
-	auto ch = lga->chm.get_channel_group(
-		lchg->getIndex())->get_srd_channel_from_name(val.toUtf8());
-	lga->chm.get_channel_group(lchg->getIndex())->getChannelById(
-		getIndex())->setChannel_role(ch);
+	auto chg = lga->chm.get_channel_group(lchg->getIndex());
+	auto ch = chg->get_srd_channel_from_name(val.toUtf8());
+	chg->getChannelById(getIndex())->setChannel_role(ch);
+
+	/* Bind the role to the decoder the way the role combo does; the
+	 * decode trace picks it up once the channel list is rebuilt */
+	if (ch) {
+		chg->setChannelForDecoder(ch, getIndex());
+		QMetaObject::invokeMethod(lga->chm_ui, "triggerUpdateUi",
+				Qt::QueuedConnection);
+	}
 }
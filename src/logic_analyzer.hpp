@@ -258,6 +258,7 @@ class LogicAnalyzer_API : public ApiObject
 	Q_PROPERTY(bool cursors_active READ cursorsActive WRITE setCursorsActive)
 	Q_PROPERTY(bool cursors_locked READ cursorsLocked WRITE setCursorsLocked)
 	Q_PROPERTY(bool inactive_hidden READ inactiveHidden WRITE setInactiveHidden)
+	Q_PROPERTY(bool native_decoders READ nativeDecoders WRITE setNativeDecoders)
 
 public:
 	explicit LogicAnalyzer_API(LogicAnalyzer *lga) :
@@ -290,6 +291,25 @@ public:
 	bool inactiveHidden() const;
 	void setInactiveHidden(bool en);
 
+	/* Decode UART, SPI and I2C natively instead of in Python */
+	bool nativeDecoders() const;
+	void setNativeDecoders(bool en);
+
+	/*
+	 * Search the last capture, returning the number of matches or -1 on
+	 * invalid arguments. Masks and values have a bit per channel, an
+	 * edge is "rising", "falling" or "any" and pulse widths are in
+	 * seconds, a max_width of 0 leaving the width unbounded. The view
+	 * then steps through the matches with search_next() and
+	 * search_previous(), or with the Find Next / Find Previous keys.
+	 */
+	Q_INVOKABLE int search_pattern(int mask, int value);
+	Q_INVOKABLE int search_edge(int channel, const QString& edge);
+	Q_INVOKABLE int search_pulse(int mask, int value,
+			double min_width, double max_width = 0);
+	Q_INVOKABLE bool search_next();
+	Q_INVOKABLE bool search_previous();
+
 private:
 	LogicAnalyzer *lga;
 };
@@ -24,6 +24,17 @@
 
 #include "config.h"
 #include "tool_launcher.hpp"
+#include "trace.hpp"
+
+#ifdef ENABLE_MICROBENCH
+#include "microbench.hpp"
+#endif
+
+#ifdef ENABLE_SIMULATOR
+#include "sim_iiod.hpp"
+#endif
+
+#include <memory>
 
 using namespace adiscope;
 
@@ -60,11 +71,67 @@ int main(int argc, char **argv)
 
 	parser.addOptions({
 		{ {"s", "script"}, "Run given script.", "script" },
+		{ {"t", "trace"}, "Trace the acquisition pipeline and "
+			"write the trace to the given file on exit.", "file" },
+#ifdef ENABLE_SIMULATOR
+		{ "simulate", "Serve a simulated M2K at ip:127.0.0.1." },
+#endif
+#ifdef ENABLE_MICROBENCH
+		{ "microbench", "Run the microbenchmarks and write a JSON "
+			"report to the given file, - for the standard "
+			"output.", "file" },
+		{ "microbench-filter", "Only run the microbenchmarks whose "
+			"name contains the given text.", "text" },
+#endif
 	});
 
 	parser.process(app);
 
+	QString trace = parser.value("trace");
+	if (!trace.isEmpty())
+		Tracer::setEnabled(true);
+
+#ifdef ENABLE_MICROBENCH
+	QString microbench = parser.value("microbench");
+	if (!microbench.isEmpty()) {
+		Microbench bench(parser.value("microbench-filter"));
+		bench.run();
+
+		QFile file(microbench);
+		bool opened = microbench == "-" ?
+			file.open(stdout, QFile::WriteOnly) :
+			file.open(QFile::WriteOnly);
+
+		if (!opened || file.write(bench.json()) < 0) {
+			qCritical() << "Unable to write the microbenchmark report";
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+#endif
+
+#ifdef ENABLE_SIMULATOR
+	/* Outlives the launcher, which stays connected to it until the end */
+	std::unique_ptr<SimIiod> sim;
+	if (parser.isSet("simulate")) {
+		sim.reset(new SimIiod);
+
+		if (!sim->start()) {
+			qCritical() << "Unable to serve the simulated device";
+			return EXIT_FAILURE;
+		}
+	}
+
+	ToolLauncher launcher;
+
+	if (sim)
+		QMetaObject::invokeMethod(&launcher, "addContext",
+				Qt::QueuedConnection,
+				Q_ARG(QString, sim->uri()));
+#else
 	ToolLauncher launcher;
+#endif
 
 	QString script = parser.value("script");
 	if (script.isEmpty()) {
@@ -94,5 +161,10 @@ int main(int argc, char **argv)
 				 Q_ARG(QString, script));
 	}
 
-	return app.exec();
+	int ret = app.exec();
+
+	if (!trace.isEmpty() && !Tracer::exportChrome(trace))
+		qCritical() << "Unable to write the trace file";
+
+	return ret;
 }
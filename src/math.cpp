@@ -19,12 +19,11 @@
 
 #include "dynamicWidget.hpp"
 #include "math.hpp"
+#include "math_expression.hpp"
 
 #include <QLocale>
 #include <QMenu>
 
-#include <gnuradio/iio/math.h>
-
 using namespace adiscope;
 
 Math::Math(QWidget *parent, unsigned int num_inputs) : QWidget(parent),
@@ -168,7 +167,7 @@ void Math::validateFunction()
 	QString function = ui.function->text();
 
 	try {
-		gr::iio::iio_math::make(function.toStdString(), num_inputs);
+		MathExpression expr(function.toStdString(), num_inputs);
 
 		Q_EMIT functionValid(function);
 
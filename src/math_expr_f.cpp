@@ -0,0 +1,90 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "math_expr_f.hpp"
+
+#include <gnuradio/io_signature.h>
+
+#include <cmath>
+
+using namespace gr;
+using namespace adiscope;
+
+math_expr_f::math_expr_f(const std::string& function, int nconnections) :
+	gr::sync_block("math_expr_f",
+			gr::io_signature::make(nconnections, nconnections,
+				sizeof(float)),
+			gr::io_signature::make(1, 1, sizeof(float))),
+	d_expr(function, nconnections),
+	d_inputs(nconnections)
+{
+}
+
+math_expr_f::~math_expr_f()
+{
+}
+
+int math_expr_f::work(int noutput_items,
+		gr_vector_const_void_star &input_items,
+		gr_vector_void_star &output_items)
+{
+	for (unsigned int i = 0; i < input_items.size(); i++)
+		d_inputs[i] = static_cast<const float *>(input_items[i]);
+
+	d_expr.evaluate(d_inputs, static_cast<float *>(output_items[0]),
+			noutput_items);
+
+	return noutput_items;
+}
+
+math_expr_gen_f::math_expr_gen_f(double sampling_freq, double wave_freq,
+		const std::string& function) :
+	gr::sync_block("math_expr_gen_f",
+			gr::io_signature::make(0, 0, 0),
+			gr::io_signature::make(1, 1, sizeof(float))),
+	d_expr(function, 1),
+	d_phase(0.0),
+	d_phase_inc(wave_freq / sampling_freq)
+{
+}
+
+math_expr_gen_f::~math_expr_gen_f()
+{
+}
+
+int math_expr_gen_f::work(int noutput_items,
+		gr_vector_const_void_star &input_items,
+		gr_vector_void_star &output_items)
+{
+	if (d_ramp.size() < (size_t)noutput_items)
+		d_ramp.resize(noutput_items);
+
+	for (int i = 0; i < noutput_items; i++) {
+		d_ramp[i] = d_phase;
+
+		d_phase += d_phase_inc;
+		d_phase -= std::floor(d_phase);
+	}
+
+	std::vector<const float *> inputs(1, d_ramp.data());
+	d_expr.evaluate(inputs, static_cast<float *>(output_items[0]),
+			noutput_items);
+
+	return noutput_items;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MATH_EXPR_F_HPP
+#define MATH_EXPR_F_HPP
+
+#include <gnuradio/sync_block.h>
+
+#include "math_expression.hpp"
+
+namespace adiscope {
+	/*
+	 * Single block computing a math channel from all its inputs, in
+	 * place of the chain of blocks built by gr-iio's iio_math.
+	 */
+	class math_expr_f : public gr::sync_block
+	{
+	private:
+		MathExpression d_expr;
+		std::vector<const float *> d_inputs;
+
+	public:
+		explicit math_expr_f(const std::string& function,
+				int nconnections = 1);
+		~math_expr_f();
+
+		const std::string& function() const
+		{ return d_expr.function(); }
+
+		int work(int noutput_items,
+				gr_vector_const_void_star &input_items,
+				gr_vector_void_star &output_items);
+	};
+
+	/*
+	 * Source evaluating a function of t, a ramp going from 0 to 1 once
+	 * per period, in place of gr-iio's iio_math_gen.
+	 */
+	class math_expr_gen_f : public gr::sync_block
+	{
+	private:
+		MathExpression d_expr;
+		double d_phase, d_phase_inc;
+		std::vector<float> d_ramp;
+
+	public:
+		explicit math_expr_gen_f(double sampling_freq,
+				double wave_freq, const std::string& function);
+		~math_expr_gen_f();
+
+		int work(int noutput_items,
+				gr_vector_const_void_star &input_items,
+				gr_vector_void_star &output_items);
+	};
+}
+
+#endif /* MATH_EXPR_F_HPP */
@@ -0,0 +1,514 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "math_expression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string.h>
+#include <volk/volk.h>
+
+using namespace adiscope;
+
+/* Destination register standing for the output buffer */
+static const unsigned int output_register = UINT_MAX;
+
+/*
+ * Recursive descent parser emitting the program while it goes. Operator
+ * precedence follows gr-iio: unary minus binds looser than '^', which is
+ * right associative, so -2^2 is -4 and 2^3^2 is 2^9.
+ */
+class MathExpression::Parser
+{
+public:
+	Parser(MathExpression *expr, const std::string& str) :
+		expr(expr), str(str), pos(0) {}
+
+	operand parse()
+	{
+		operand op = parseSum();
+
+		skipSpaces();
+		if (pos != str.size())
+			error("unexpected character");
+
+		return op;
+	}
+
+private:
+	void error(const std::string& msg)
+	{
+		throw std::runtime_error("Invalid math expression: " + msg +
+				" at position " + std::to_string(pos));
+	}
+
+	void skipSpaces()
+	{
+		while (pos < str.size() && isspace((unsigned char)str[pos]))
+			pos++;
+	}
+
+	bool accept(char c)
+	{
+		skipSpaces();
+		if (pos < str.size() && str[pos] == c) {
+			pos++;
+			return true;
+		}
+
+		return false;
+	}
+
+	operand parseSum()
+	{
+		operand left = parseProduct();
+
+		for (;;) {
+			if (accept('+'))
+				left = expr->emitBinary(OP_ADD, left,
+						parseProduct());
+			else if (accept('-'))
+				left = expr->emitBinary(OP_SUB, left,
+						parseProduct());
+			else
+				return left;
+		}
+	}
+
+	operand parseProduct()
+	{
+		operand left = parseUnary();
+
+		for (;;) {
+			if (accept('*'))
+				left = expr->emitBinary(OP_MUL, left,
+						parseUnary());
+			else if (accept('/'))
+				left = expr->emitBinary(OP_DIV, left,
+						parseUnary());
+			else
+				return left;
+		}
+	}
+
+	operand parseUnary()
+	{
+		if (accept('-'))
+			return expr->emitUnary(OP_NEG, FN_ABS, parseUnary());
+		if (accept('+'))
+			return parseUnary();
+
+		return parsePower();
+	}
+
+	operand parsePower()
+	{
+		operand base = parsePrimary();
+
+		if (accept('^'))
+			return expr->emitBinary(OP_POW, base, parseUnary());
+
+		return base;
+	}
+
+	operand parseNumber()
+	{
+		std::string num;
+
+		while (pos < str.size() && (isdigit((unsigned char)str[pos]) ||
+					str[pos] == '.' || str[pos] == ',')) {
+			num += str[pos] == ',' ? '.' : str[pos];
+			pos++;
+		}
+
+		/* Only treat 'e' as an exponent when digits follow,
+		 * otherwise it is the constant */
+		if (pos + 1 < str.size() && (str[pos] == 'e' ||
+					str[pos] == 'E')) {
+			size_t p = pos + 1;
+
+			if (p < str.size() && (str[p] == '+' || str[p] == '-'))
+				p++;
+			if (p < str.size() && isdigit((unsigned char)str[p])) {
+				num += str.substr(pos, p - pos);
+				pos = p;
+				while (pos < str.size() &&
+					isdigit((unsigned char)str[pos]))
+					num += str[pos++];
+			}
+		}
+
+		char *end;
+		double value = strtod(num.c_str(), &end);
+		if (num.empty() || *end != '\0')
+			error("malformed number");
+
+		operand op = { OPERAND_CONST, 0, (float)value };
+		return op;
+	}
+
+	operand parsePrimary()
+	{
+		skipSpaces();
+
+		if (pos >= str.size())
+			error("unexpected end of expression");
+
+		if (accept('(')) {
+			operand op = parseSum();
+			if (!accept(')'))
+				error("missing ')'");
+			return op;
+		}
+
+		char c = str[pos];
+		if (isdigit((unsigned char)c) || c == '.' || c == ',')
+			return parseNumber();
+
+		if (!isalpha((unsigned char)c))
+			error("unexpected character");
+
+		std::string ident;
+		while (pos < str.size() && isalnum((unsigned char)str[pos]))
+			ident += str[pos++];
+
+		return parseIdentifier(ident);
+	}
+
+	operand parseIdentifier(const std::string& ident)
+	{
+		static const struct {
+			const char *name;
+			func_type func;
+		} functions[] = {
+			{ "abs", FN_ABS }, { "sqrt", FN_SQRT },
+			{ "exp", FN_EXP }, { "log", FN_LOG },
+			{ "log10", FN_LOG10 },
+			{ "sin", FN_SIN }, { "cos", FN_COS }, { "tan", FN_TAN },
+			{ "asin", FN_ASIN }, { "acos", FN_ACOS },
+			{ "atan", FN_ATAN },
+			{ "sinh", FN_SINH }, { "cosh", FN_COSH },
+			{ "tanh", FN_TANH },
+		};
+
+		for (auto& fn : functions) {
+			if (ident != fn.name)
+				continue;
+
+			if (!accept('('))
+				error("missing '(' after " + ident);
+
+			operand arg = parseSum();
+			if (!accept(')'))
+				error("missing ')'");
+
+			return expr->emitUnary(OP_FUNC, fn.func, arg);
+		}
+
+		if (ident == "pi") {
+			operand op = { OPERAND_CONST, 0, (float)M_PI };
+			return op;
+		}
+
+		if (ident == "e") {
+			operand op = { OPERAND_CONST, 0, (float)M_E };
+			return op;
+		}
+
+		if (ident[0] == 't' || ident[0] == 'x') {
+			unsigned int index = 0;
+			bool valid = true;
+
+			if (ident.size() > 1) {
+				for (size_t i = 1; i < ident.size(); i++)
+					valid &= !!isdigit(
+						(unsigned char)ident[i]);
+				if (valid)
+					index = atoi(ident.c_str() + 1);
+			}
+
+			if (valid) {
+				if (index >= expr->num_inputs)
+					error("no input named " + ident);
+
+				operand op = { OPERAND_INPUT, index, 0.0f };
+				return op;
+			}
+		}
+
+		error("unknown identifier " + ident);
+		return operand();
+	}
+
+	MathExpression *expr;
+	const std::string& str;
+	size_t pos;
+};
+
+MathExpression::MathExpression(const std::string& function,
+		unsigned int num_inputs) :
+	d_function(function),
+	num_inputs(num_inputs),
+	num_registers(0),
+	registers(nullptr)
+{
+	Parser parser(this, function);
+	result = parser.parse();
+
+	/* Write the last result straight into the output buffer */
+	if (result.kind == OPERAND_REG && !program.empty() &&
+			program.back().dst == result.index)
+		program.back().dst = output_register;
+
+	if (num_registers)
+		registers = (float *)volk_malloc(num_registers * block_size *
+				sizeof(float), volk_get_alignment());
+}
+
+MathExpression::~MathExpression()
+{
+	if (registers)
+		volk_free(registers);
+}
+
+bool MathExpression::isConstant() const
+{
+	return result.kind == OPERAND_CONST;
+}
+
+unsigned int MathExpression::allocRegister()
+{
+	if (!free_registers.empty()) {
+		unsigned int reg = free_registers.back();
+		free_registers.pop_back();
+		return reg;
+	}
+
+	return num_registers++;
+}
+
+void MathExpression::releaseRegister(const operand& op)
+{
+	if (op.kind == OPERAND_REG)
+		free_registers.push_back(op.index);
+}
+
+float MathExpression::fold(op_type op, func_type func, float a, float b)
+{
+	switch (op) {
+	case OP_ADD: return a + b;
+	case OP_SUB: return a - b;
+	case OP_MUL: return a * b;
+	case OP_DIV: return a / b;
+	case OP_POW: return std::pow(a, b);
+	case OP_NEG: return -a;
+	case OP_FUNC:
+		switch (func) {
+		case FN_ABS: return std::fabs(a);
+		case FN_SQRT: return std::sqrt(a);
+		case FN_EXP: return std::exp(a);
+		case FN_LOG: return std::log(a);
+		case FN_LOG10: return std::log10(a);
+		case FN_SIN: return std::sin(a);
+		case FN_COS: return std::cos(a);
+		case FN_TAN: return std::tan(a);
+		case FN_ASIN: return std::asin(a);
+		case FN_ACOS: return std::acos(a);
+		case FN_ATAN: return std::atan(a);
+		case FN_SINH: return std::sinh(a);
+		case FN_COSH: return std::cosh(a);
+		case FN_TANH: return std::tanh(a);
+		}
+	}
+
+	return 0.0f;
+}
+
+MathExpression::operand MathExpression::emitBinary(op_type op,
+		const operand& a, const operand& b)
+{
+	if (a.kind == OPERAND_CONST && b.kind == OPERAND_CONST) {
+		operand res = { OPERAND_CONST, 0, fold(op, FN_ABS,
+				a.value, b.value) };
+		return res;
+	}
+
+	/* Division by a constant is a multiplication */
+	if (op == OP_DIV && b.kind == OPERAND_CONST) {
+		operand inv = { OPERAND_CONST, 0, 1.0f / b.value };
+		return emitBinary(OP_MUL, a, inv);
+	}
+
+	releaseRegister(a);
+	releaseRegister(b);
+
+	instruction insn;
+	insn.op = op;
+	insn.func = FN_ABS;
+	insn.dst = allocRegister();
+	insn.a = a;
+	insn.b = b;
+	program.push_back(insn);
+
+	operand res = { OPERAND_REG, insn.dst, 0.0f };
+	return res;
+}
+
+MathExpression::operand MathExpression::emitUnary(op_type op,
+		func_type func, const operand& a)
+{
+	if (a.kind == OPERAND_CONST) {
+		operand res = { OPERAND_CONST, 0, fold(op, func,
+				a.value, 0.0f) };
+		return res;
+	}
+
+	releaseRegister(a);
+
+	instruction insn;
+	insn.op = op;
+	insn.func = func;
+	insn.dst = allocRegister();
+	insn.a = a;
+	insn.b = a;
+	program.push_back(insn);
+
+	operand res = { OPERAND_REG, insn.dst, 0.0f };
+	return res;
+}
+
+const float * MathExpression::source(const operand& op,
+		const std::vector<const float *>& inputs, int offset) const
+{
+	if (op.kind == OPERAND_INPUT)
+		return inputs[op.index] + offset;
+
+	return registers + op.index * block_size;
+}
+
+template <typename F>
+static inline void apply_unary(F f, float *dst, const float *a, int n)
+{
+	for (int i = 0; i < n; i++)
+		dst[i] = f(a[i]);
+}
+
+template <typename F>
+static inline void apply_binary(F f, float *dst, const float *a,
+		float av, bool a_const, const float *b, float bv,
+		bool b_const, int n)
+{
+	if (a_const)
+		for (int i = 0; i < n; i++)
+			dst[i] = f(av, b[i]);
+	else if (b_const)
+		for (int i = 0; i < n; i++)
+			dst[i] = f(a[i], bv);
+	else
+		for (int i = 0; i < n; i++)
+			dst[i] = f(a[i], b[i]);
+}
+
+void MathExpression::run(const instruction& insn, float *dst,
+		const std::vector<const float *>& inputs, int offset, int n)
+{
+	bool a_const = insn.a.kind == OPERAND_CONST;
+	bool b_const = insn.b.kind == OPERAND_CONST;
+	const float *a = a_const ? nullptr : source(insn.a, inputs, offset);
+	const float *b = b_const ? nullptr : source(insn.b, inputs, offset);
+	float av = insn.a.value, bv = insn.b.value;
+
+	switch (insn.op) {
+	case OP_ADD:
+		apply_binary([](float x, float y) { return x + y; },
+				dst, a, av, a_const, b, bv, b_const, n);
+		break;
+	case OP_SUB:
+		apply_binary([](float x, float y) { return x - y; },
+				dst, a, av, a_const, b, bv, b_const, n);
+		break;
+	case OP_MUL:
+		apply_binary([](float x, float y) { return x * y; },
+				dst, a, av, a_const, b, bv, b_const, n);
+		break;
+	case OP_DIV:
+		apply_binary([](float x, float y) { return x / y; },
+				dst, a, av, a_const, b, bv, b_const, n);
+		break;
+	case OP_POW:
+		if (b_const && bv == 2.0f)
+			apply_unary([](float x) { return x * x; }, dst, a, n);
+		else if (b_const && bv == 0.5f)
+			apply_unary([](float x) { return std::sqrt(x); },
+					dst, a, n);
+		else
+			apply_binary([](float x, float y) {
+					return std::pow(x, y); },
+				dst, a, av, a_const, b, bv, b_const, n);
+		break;
+	case OP_NEG:
+		apply_unary([](float x) { return -x; }, dst, a, n);
+		break;
+	case OP_FUNC:
+		switch (insn.func) {
+		case FN_ABS:
+			apply_unary([](float x) { return std::fabs(x); },
+					dst, a, n);
+			break;
+		case FN_SQRT:
+			apply_unary([](float x) { return std::sqrt(x); },
+					dst, a, n);
+			break;
+		default:
+			for (int i = 0; i < n; i++)
+				dst[i] = fold(OP_FUNC, insn.func, a[i], 0.0f);
+			break;
+		}
+		break;
+	}
+}
+
+void MathExpression::evaluate(const std::vector<const float *>& inputs,
+		float *out, int nitems)
+{
+	if (result.kind == OPERAND_CONST) {
+		std::fill(out, out + nitems, result.value);
+		return;
+	}
+
+	if (result.kind == OPERAND_INPUT) {
+		memcpy(out, inputs[result.index], nitems * sizeof(float));
+		return;
+	}
+
+	for (int offset = 0; offset < nitems; offset += block_size) {
+		int n = std::min<int>(block_size, nitems - offset);
+
+		for (auto it = program.begin(); it != program.end(); ++it) {
+			float *dst = it->dst == output_register ? out + offset :
+				registers + (size_t)it->dst * block_size;
+
+			run(*it, dst, inputs, offset, n);
+		}
+	}
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MATH_EXPRESSION_HPP
+#define MATH_EXPRESSION_HPP
+
+#include <string>
+#include <vector>
+
+namespace adiscope {
+
+	/*
+	 * Compiles the functions of the math channels once into a flat
+	 * program operating on blocks of samples.
+	 *
+	 * The grammar is the one accepted by gr-iio's math blocks: numbers,
+	 * the constants e and pi, the inputs (t or x for the first one, tN or
+	 * xN for input N), + - * / ^, parentheses and the functions offered
+	 * by the Math widget. Constant sub-expressions are folded at compile
+	 * time and every remaining operation runs as one tight loop over a
+	 * block of samples, so evaluating the whole expression costs a
+	 * single pass per operator instead of one GNU Radio block each.
+	 *
+	 * Invalid expressions throw std::runtime_error from the constructor.
+	 */
+	class MathExpression
+	{
+	public:
+		static const unsigned int block_size = 512;
+
+		MathExpression(const std::string& function,
+				unsigned int num_inputs);
+		~MathExpression();
+
+		unsigned int numInputs() const { return num_inputs; }
+		unsigned int numRegisters() const { return num_registers; }
+		const std::string& function() const { return d_function; }
+
+		bool isConstant() const;
+
+		/* Evaluates the expression for nitems samples. Inputs that
+		 * the expression does not use may be null. */
+		void evaluate(const std::vector<const float *>& inputs,
+				float *out, int nitems);
+
+	private:
+		enum op_type {
+			OP_ADD,
+			OP_SUB,
+			OP_MUL,
+			OP_DIV,
+			OP_POW,
+			OP_NEG,
+			OP_FUNC,
+		};
+
+		enum func_type {
+			FN_ABS, FN_SQRT, FN_EXP, FN_LOG, FN_LOG10,
+			FN_SIN, FN_COS, FN_TAN, FN_ASIN, FN_ACOS, FN_ATAN,
+			FN_SINH, FN_COSH, FN_TANH,
+		};
+
+		enum operand_kind {
+			OPERAND_CONST,
+			OPERAND_INPUT,
+			OPERAND_REG,
+		};
+
+		struct operand {
+			operand_kind kind;
+			unsigned int index;
+			float value;
+		};
+
+		struct instruction {
+			op_type op;
+			func_type func;
+			unsigned int dst;
+			operand a, b;
+		};
+
+		class Parser;
+
+		operand emitBinary(op_type op, const operand& a,
+				const operand& b);
+		operand emitUnary(op_type op, func_type func,
+				const operand& a);
+		unsigned int allocRegister();
+		void releaseRegister(const operand& op);
+
+		static float fold(op_type op, func_type func, float a, float b);
+		const float *source(const operand& op,
+				const std::vector<const float *>& inputs,
+				int offset) const;
+		void run(const instruction& insn, float *dst,
+				const std::vector<const float *>& inputs,
+				int offset, int n);
+
+		std::string d_function;
+		unsigned int num_inputs;
+		unsigned int num_registers;
+
+		std::vector<instruction> program;
+		std::vector<unsigned int> free_registers;
+		operand result;
+
+		float *registers;
+	};
+}
+
+#endif /* MATH_EXPRESSION_HPP */
@@ -21,6 +21,8 @@
 #include "adc_sample_conv.hpp"
 #include <qmath.h>
 #include <QDebug>
+#include <algorithm>
+#include <limits>
 
 using namespace adiscope;
 
@@ -348,8 +350,11 @@ Measure::Measure(int channel, double *buffer, size_t length):
 	m_sample_rate(1.0),
 	m_adc_bit_count(0),
 	m_cross_level(0),
-	m_hysteresis_span(0)
+	m_hysteresis_span(0),
+	m_stream_count(0),
+	m_stream_window(0)
 {
+	resetStreaming();
 
 	// Create a set of measurements
 	m_measurements.push_back(std::make_shared<MeasurementData>("Period",
@@ -729,6 +734,93 @@ void Measure::measure()
 
 }
 
+void Measure::resetStreaming()
+{
+	m_stream_blocks.clear();
+	m_stream_count = 0;
+}
+
+/*
+ * Number of the most recent samples the streaming statistics cover,
+ * normally the samples visible on the plot. 0 keeps every sample.
+ */
+void Measure::setStreamingWindow(size_t samples)
+{
+	m_stream_window = samples;
+}
+
+void Measure::measureStreaming(const double *data, size_t length)
+{
+	clearMeasurements();
+
+	if (length > 0) {
+		stream_block block;
+		double sum = 0;
+
+		block.count = length;
+		block.min = std::numeric_limits<double>::max();
+		block.max = -std::numeric_limits<double>::max();
+
+		for (size_t i = 0; i < length; i++) {
+			sum += data[i];
+			if (data[i] < block.min)
+				block.min = data[i];
+			if (data[i] > block.max)
+				block.max = data[i];
+		}
+
+		block.mean = sum / length;
+		block.m2 = 0;
+
+		for (size_t i = 0; i < length; i++) {
+			double delta = data[i] - block.mean;
+			block.m2 += delta * delta;
+		}
+
+		m_stream_blocks.push_back(block);
+		m_stream_count += length;
+	}
+
+	/* Drop the blocks that scrolled out of the window, keeping at
+	 * least the newest one */
+	while (m_stream_window && m_stream_blocks.size() > 1 &&
+			m_stream_count - m_stream_blocks.front().count >=
+			m_stream_window) {
+		m_stream_count -= m_stream_blocks.front().count;
+		m_stream_blocks.pop_front();
+	}
+
+	if (m_stream_count == 0)
+		return;
+
+	double n = 0, mean = 0, m2 = 0;
+	double min = std::numeric_limits<double>::max();
+	double max = -std::numeric_limits<double>::max();
+
+	for (auto it = m_stream_blocks.begin(); it != m_stream_blocks.end();
+			++it) {
+		double total = n + it->count;
+		double delta = it->mean - mean;
+
+		mean += delta * it->count / total;
+		m2 += it->m2 + delta * delta * n * it->count / total;
+		n = total;
+
+		min = std::min(min, it->min);
+		max = std::max(max, it->max);
+	}
+
+	double variance = m2 / n;
+
+	m_measurements[MIN]->setValue(min);
+	m_measurements[MAX]->setValue(max);
+	m_measurements[PEAK_PEAK]->setValue(max - min);
+	m_measurements[MEAN]->setValue(mean);
+	m_measurements[RMS]->setValue(sqrt(variance + mean * mean));
+	m_measurements[AC_RMS]->setValue(sqrt(variance));
+	m_measurements[AREA]->setValue(mean * n / m_sample_rate);
+}
+
 double Measure::sampleRate()
 {
 	return m_sample_rate;
@@ -22,6 +22,7 @@
 
 #include <QList>
 #include <QString>
+#include <deque>
 #include <memory>
 
 namespace adiscope {
@@ -103,6 +104,14 @@ namespace adiscope {
 
 		void setDataSource(double *buffer, size_t length);
 		void measure();
+
+		/* Running statistics over the last samples of a continuous
+		 * stream (roll mode). Only the amplitude measurements that can
+		 * be updated incrementally are computed. */
+		void measureStreaming(const double *data, size_t length);
+		void resetStreaming();
+		void setStreamingWindow(size_t samples);
+
 		double sampleRate();
 		void setSampleRate(double);
 		unsigned int adcBitCount();
@@ -135,6 +144,21 @@ namespace adiscope {
 		CrossingDetection *m_cross_detect;
 
 		QList<std::shared_ptr<MeasurementData>> m_measurements;
+
+		/* Statistics of one block of streamed samples. The mean and
+		 * the sum of squared deviations (m2) are combined pairwise, so
+		 * the variance never comes from a difference of large sums. */
+		struct stream_block {
+			size_t count;
+			double mean;
+			double m2;
+			double min;
+			double max;
+		};
+
+		std::deque<stream_block> m_stream_blocks;
+		size_t m_stream_count;
+		size_t m_stream_window;
 	};
 
 	class Statistic
@@ -0,0 +1,460 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "microbench.hpp"
+
+#include "adc_sample_conv.hpp"
+#include "average.h"
+#include "config.h"
+#include "customFifo.hpp"
+#include "FftDisplayPlot.h"
+#include "measure.h"
+#include "pg_channel_manager.hpp"
+#include "pg_patterns.hpp"
+#include "spectrumUpdateEvents.h"
+#include "pulseview/pv/data/logicsegment.hpp"
+#include "pulseview/pv/data/decode/annotation.hpp"
+#include "pulseview/pv/data/decode/labeltable.hpp"
+#include "pulseview/pv/data/decode/rowdata.hpp"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+#include <libsigrokdecode/libsigrokdecode.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+
+/* Every case generates its inputs from this seed */
+#define MICROBENCH_SEED 0x5c0b7
+
+/* A case runs for at least this many seconds and batches */
+#define MICROBENCH_MIN_TIME 0.5
+#define MICROBENCH_MIN_BATCHES 5
+
+/* Seconds a batch of operations is sized to take */
+#define MICROBENCH_BATCH_TIME 0.01
+
+#define MICROBENCH_MEASURE_SAMPLES 0x10000
+#define MICROBENCH_SPECTRUM_BINS 0x4000
+#define MICROBENCH_SPECTRUM_FRAMES 16
+#define MICROBENCH_SPECTRUM_TONES 32
+#define MICROBENCH_AVERAGE_HISTORY 16
+#define MICROBENCH_PEAK_COUNT 5
+#define MICROBENCH_CONV_SAMPLES 0x4000
+#define MICROBENCH_PATTERN_SAMPLES 0x10000
+#define MICROBENCH_LOGIC_SAMPLES 0x400000
+#define MICROBENCH_LOGIC_ZOOM 0x10000
+#define MICROBENCH_ANNOTATIONS 0x100000
+#define MICROBENCH_ANNOTATION_WINDOW 0x10000
+#define MICROBENCH_FIFO_DEPTH 1000
+#define MICROBENCH_FIFO_PUSHES 0x1000
+
+/* Pixels across a plot, for the zoom level of the drawing paths */
+#define MICROBENCH_SCREEN_WIDTH 2000
+
+using namespace adiscope;
+
+namespace {
+	/* Results go through here so that the compiler keeps the work */
+	volatile double sink;
+
+	template <typename T>
+	SpectrumAverage *newAverage()
+	{
+		return new T(MICROBENCH_SPECTRUM_BINS,
+				MICROBENCH_AVERAGE_HISTORY);
+	}
+
+	typedef std::chrono::steady_clock Clock;
+
+	double secondsSince(const Clock::time_point &start)
+	{
+		return std::chrono::duration<double>(
+				Clock::now() - start).count();
+	}
+}
+
+Microbench::Microbench(const QString &filter) :
+	filter(filter)
+{
+}
+
+void Microbench::run()
+{
+	m_results.clear();
+
+	benchMeasure();
+	benchSpectrumAverage();
+	benchFindPeaks();
+	benchSampleConv();
+	benchCommitBuffer();
+	benchSubsampledEdges();
+	benchAnnotationSubset();
+	benchCustomFifo();
+}
+
+const std::vector<Microbench::Result>& Microbench::results() const
+{
+	return m_results;
+}
+
+QByteArray Microbench::json() const
+{
+	QJsonArray cases;
+
+	for (const Result &result : m_results) {
+		QJsonObject obj;
+
+		obj["name"] = result.name;
+		obj["items"] = (double)result.items;
+		obj["iterations"] = (double)result.iterations;
+		obj["median_ns"] = result.median_ns;
+		obj["min_ns"] = result.min_ns;
+		obj["items_per_s"] = result.items * 1e9 / result.median_ns;
+		cases.append(obj);
+	}
+
+	QJsonObject report;
+	report["version"] = QString(SCOPY_VERSION_GIT);
+	report["qt"] = QString(qVersion());
+#ifdef __VERSION__
+	report["compiler"] = QString(__VERSION__);
+#endif
+	report["seed"] = MICROBENCH_SEED;
+	report["min_time_s"] = MICROBENCH_MIN_TIME;
+	report["cases"] = cases;
+
+	return QJsonDocument(report).toJson();
+}
+
+void Microbench::measure(const QString &name, qint64 items,
+		const std::function<void()> &op)
+{
+	if (!filter.isEmpty() && !name.contains(filter))
+		return;
+
+	/* The first call warms the caches up and sizes the batches */
+	Clock::time_point start = Clock::now();
+	op();
+	double once = std::max(secondsSince(start), 1e-9);
+	qint64 batch = std::max<qint64>(1, MICROBENCH_BATCH_TIME / once);
+
+	std::vector<double> per_op;
+	double total = 0;
+
+	while (per_op.size() < MICROBENCH_MIN_BATCHES ||
+			total < MICROBENCH_MIN_TIME) {
+		start = Clock::now();
+		for (qint64 i = 0; i < batch; i++)
+			op();
+
+		double elapsed = secondsSince(start);
+		total += elapsed;
+		per_op.push_back(elapsed * 1e9 / batch);
+	}
+
+	std::sort(per_op.begin(), per_op.end());
+
+	Result result;
+	result.name = name;
+	result.items = items;
+	result.iterations = batch * per_op.size();
+	result.median_ns = per_op[per_op.size() / 2];
+	result.min_ns = per_op.front();
+	m_results.push_back(result);
+
+	qDebug() << name << result.median_ns << "ns";
+}
+
+void Microbench::benchMeasure()
+{
+	std::mt19937 rng(MICROBENCH_SEED);
+	std::uniform_real_distribution<double> noise(-0.01, 0.01);
+
+	/* 1 kHz sine sampled at 1 MHz, with some noise on the edges */
+	std::vector<double> buffer(MICROBENCH_MEASURE_SAMPLES);
+	for (size_t i = 0; i < buffer.size(); i++)
+		buffer[i] = 1.5 * sin(2 * M_PI * i / 1000.0) + 0.2 +
+			noise(rng);
+
+	Measure m(0, buffer.data(), buffer.size());
+	m.setSampleRate(1e6);
+	m.setAdcBitCount(12);
+
+	measure("measure/sine", buffer.size(), [&]() {
+		m.measure();
+	});
+}
+
+void Microbench::benchSpectrumAverage()
+{
+	std::mt19937 rng(MICROBENCH_SEED);
+	std::uniform_real_distribution<double> level(-120, -20);
+
+	std::vector<std::vector<double>> frames(MICROBENCH_SPECTRUM_FRAMES,
+			std::vector<double>(MICROBENCH_SPECTRUM_BINS));
+	for (auto &frame : frames)
+		for (double &bin : frame)
+			bin = level(rng);
+
+	std::vector<double> out(MICROBENCH_SPECTRUM_BINS);
+
+	const std::vector<std::pair<QString, SpectrumAverage *(*)()>> types = {
+		{ "PeakHoldContinuous", &newAverage<PeakHoldContinuous> },
+		{ "MinHoldContinuous", &newAverage<MinHoldContinuous> },
+		{ "ExponentialRMS", &newAverage<ExponentialRMS> },
+		{ "ExponentialAverage", &newAverage<ExponentialAverage> },
+		{ "PeakHold", &newAverage<PeakHold> },
+		{ "MinHold", &newAverage<MinHold> },
+		{ "LinearRMS", &newAverage<LinearRMS> },
+		{ "LinearAverage", &newAverage<LinearAverage> },
+	};
+
+	for (const auto &type : types) {
+		std::unique_ptr<SpectrumAverage> avg(type.second());
+		size_t frame = 0;
+
+		measure("spectrum_average/" + type.first,
+				MICROBENCH_SPECTRUM_BINS, [&]() {
+			avg->pushNewData(frames[frame++ % frames.size()].data());
+			avg->getAverage(out.data(), MICROBENCH_SPECTRUM_BINS);
+			sink = out[0];
+		});
+	}
+}
+
+void Microbench::benchFindPeaks()
+{
+	std::mt19937 rng(MICROBENCH_SEED);
+	std::uniform_real_distribution<double> noise_floor(-110, -90);
+	std::uniform_real_distribution<double> tone(-60, -10);
+	std::uniform_int_distribution<int> bin(1, MICROBENCH_SPECTRUM_BINS - 2);
+
+	/* The plot keeps the first half of the points it gets */
+	std::vector<double> spectrum(2 * MICROBENCH_SPECTRUM_BINS);
+	for (double &value : spectrum)
+		value = noise_floor(rng);
+	for (int i = 0; i < MICROBENCH_SPECTRUM_TONES; i++) {
+		int center = bin(rng);
+		double peak = tone(rng);
+
+		spectrum[center] = peak;
+		spectrum[center - 1] = spectrum[center + 1] = peak - 20;
+	}
+
+	FftDisplayPlot plot(1);
+	plot.setPeakCount(0, MICROBENCH_PEAK_COUNT);
+
+	TimeUpdateEvent event(std::vector<double *>(1, spectrum.data()),
+			spectrum.size(),
+			std::vector<std::vector<gr::tag_t>>(1));
+	plot.customEvent(&event);
+	plot.setSampleRate(1e8, 1, "Hz");
+
+	measure("fft_display_plot/find_peaks", MICROBENCH_SPECTRUM_BINS,
+			[&]() {
+		plot.findPeaks(0);
+	});
+}
+
+void Microbench::benchSampleConv()
+{
+	std::mt19937 rng(MICROBENCH_SEED);
+	std::uniform_int_distribution<int> code(-2048, 2047);
+
+	auto conv = gnuradio::get_initial_sptr(new adc_sample_conv(2));
+
+	std::vector<std::vector<short>> in(2,
+			std::vector<short>(MICROBENCH_CONV_SAMPLES));
+	std::vector<std::vector<float>> out(2,
+			std::vector<float>(MICROBENCH_CONV_SAMPLES));
+	gr_vector_const_void_star in_items;
+	gr_vector_void_star out_items;
+
+	for (int i = 0; i < 2; i++) {
+		conv->setCorrectionGain(i, 1.02);
+		conv->setFilterCompensation(i, 1.05);
+		conv->setOffset(i, 0.1);
+		conv->setHardwareGain(i, 0.02);
+
+		for (short &sample : in[i])
+			sample = code(rng);
+
+		in_items.push_back(in[i].data());
+		out_items.push_back(out[i].data());
+	}
+
+	measure("adc_sample_conv/work", 2 * MICROBENCH_CONV_SAMPLES, [&]() {
+		conv->work(MICROBENCH_CONV_SAMPLES, in_items, out_items);
+	});
+}
+
+void Microbench::benchCommitBuffer()
+{
+	PatternGeneratorChannelManager chm;
+
+	/* A binary counter on a group of eight channels */
+	chm.join({ 0, 1, 2, 3, 4, 5, 6, 7 });
+	PatternGeneratorChannelGroup *chg = chm.get_channel_group(0);
+	delete chg->pattern;
+	chg->pattern = PatternFactory::create(BinaryCounterId);
+	chg->pattern->generate_pattern(1000000, MICROBENCH_PATTERN_SAMPLES,
+			chg->get_channel_count());
+
+	std::vector<short> buffer(MICROBENCH_PATTERN_SAMPLES);
+
+	measure("pattern_generator/commit_buffer", buffer.size(), [&]() {
+		chm.commitBuffer(chg, buffer.data(), buffer.size());
+	});
+
+	chg->pattern->delete_buffer();
+}
+
+void Microbench::benchSubsampledEdges()
+{
+	std::mt19937 rng(MICROBENCH_SEED);
+
+	/* A clock on channel 0, UART-like random bits on channel 1 and
+	 * slowly changing levels on the others */
+	std::vector<uint16_t> samples(MICROBENCH_LOGIC_SAMPLES);
+	uint16_t bit = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (i % 100 == 0)
+			bit = rng() & 1;
+
+		samples[i] = ((i / 5) & 1) | (bit << 1) |
+			(((i >> 12) << 2) & 0xfffc);
+	}
+
+	auto context = sigrok::Context::create();
+	auto packet = context->create_logic_packet(samples.data(),
+			samples.size() * sizeof(uint16_t), sizeof(uint16_t));
+	auto logic = std::dynamic_pointer_cast<sigrok::Logic>(
+			packet->payload());
+
+	pv::data::LogicSegment segment(logic, 100000000, samples.size());
+	std::vector<pv::data::LogicSegment::EdgePair> edges;
+
+	const uint64_t end = samples.size() - 1;
+	const float full = (float)samples.size() / MICROBENCH_SCREEN_WIDTH;
+	const uint64_t zoom_start = samples.size() / 2;
+	const float zoom = (float)MICROBENCH_LOGIC_ZOOM /
+		MICROBENCH_SCREEN_WIDTH;
+
+	measure("logic_segment/subsampled_edges/clock_full", samples.size(),
+			[&]() {
+		edges.clear();
+		segment.get_subsampled_edges(edges, 0, end, full, 0);
+	});
+
+	measure("logic_segment/subsampled_edges/clock_zoomed",
+			MICROBENCH_LOGIC_ZOOM, [&]() {
+		edges.clear();
+		segment.get_subsampled_edges(edges, zoom_start,
+				zoom_start + MICROBENCH_LOGIC_ZOOM, zoom, 0);
+	});
+
+	measure("logic_segment/subsampled_edges/uart_full", samples.size(),
+			[&]() {
+		edges.clear();
+		segment.get_subsampled_edges(edges, 0, end, full, 1);
+	});
+}
+
+void Microbench::benchAnnotationSubset()
+{
+	std::mt19937 rng(MICROBENCH_SEED);
+	std::uniform_int_distribution<int> length(80, 120);
+	std::uniform_int_distribution<int> gap(0, 40);
+
+	char text[] = "Data";
+	char *texts[] = { text, nullptr };
+	srd_proto_data_annotation pda;
+	pda.ann_class = 0;
+	pda.ann_text = texts;
+
+	auto labels = std::make_shared<pv::data::decode::LabelTable>();
+	const uint32_t label = labels->intern(&pda);
+
+	pv::data::decode::RowData row(labels);
+	uint64_t sample = 0;
+	for (int i = 0; i < MICROBENCH_ANNOTATIONS; i++) {
+		uint64_t end = sample + length(rng);
+
+		row.push_annotation(sample, end, label);
+		sample = end + gap(rng);
+	}
+
+	std::uniform_int_distribution<uint64_t> start(0,
+			sample - MICROBENCH_ANNOTATION_WINDOW);
+	std::vector<uint64_t> starts(1024);
+	for (uint64_t &s : starts)
+		s = start(rng);
+
+	std::vector<pv::data::decode::Annotation> dest;
+	size_t window = 0;
+
+	measure("row_data/annotation_subset/window",
+			MICROBENCH_ANNOTATION_WINDOW, [&]() {
+		const uint64_t s = starts[window++ % starts.size()];
+
+		dest.clear();
+		row.get_annotation_subset(dest, s,
+				s + MICROBENCH_ANNOTATION_WINDOW);
+		sink = dest.size();
+	});
+
+	measure("row_data/annotation_subset/full", sample, [&]() {
+		dest.clear();
+		row.get_annotation_subset(dest, 0, sample);
+		sink = dest.size();
+	});
+}
+
+void Microbench::benchCustomFifo()
+{
+	std::mt19937 rng(MICROBENCH_SEED);
+	std::uniform_real_distribution<double> value(-1, 1);
+
+	std::vector<double> samples(MICROBENCH_FIFO_PUSHES);
+	for (double &sample : samples)
+		sample = value(rng);
+
+	/* Used as a bounded history of samples */
+	CustomFifo<double> fifo;
+	fifo.reserve(MICROBENCH_FIFO_DEPTH + 1);
+
+	measure("custom_fifo/push_pop", samples.size(), [&]() {
+		for (double &sample : samples) {
+			if (fifo.size() == MICROBENCH_FIFO_DEPTH + 1)
+				fifo.pop();
+
+			fifo.push(sample);
+		}
+
+		sink = fifo.data()[0];
+	});
+}
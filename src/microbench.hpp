@@ -0,0 +1,77 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MICROBENCH_HPP
+#define MICROBENCH_HPP
+
+#include <QByteArray>
+#include <QString>
+
+#include <functional>
+#include <vector>
+
+namespace adiscope {
+	/*
+	 * Microbenchmarks of the signal processing and data structure hot
+	 * paths, run headless with --microbench.
+	 *
+	 * Every case works on inputs of a fixed size generated from a fixed
+	 * seed, so the reports of two builds can be compared case by case.
+	 * A case is repeated in batches until it ran for the minimum time,
+	 * and is reported by its median batch, which an occasional
+	 * preemption does not move.
+	 */
+	class Microbench
+	{
+	public:
+		struct Result {
+			QString name;
+			qint64 items;		/* processed by one operation */
+			qint64 iterations;
+			double median_ns;	/* per operation */
+			double min_ns;
+		};
+
+		/* Only runs the cases whose name contains the filter */
+		explicit Microbench(const QString &filter = QString());
+
+		void run();
+
+		const std::vector<Result>& results() const;
+		QByteArray json() const;
+
+	private:
+		QString filter;
+		std::vector<Result> m_results;
+
+		void measure(const QString &name, qint64 items,
+				const std::function<void()> &op);
+
+		void benchMeasure();
+		void benchSpectrumAverage();
+		void benchFindPeaks();
+		void benchSampleConv();
+		void benchCommitBuffer();
+		void benchSubsampledEdges();
+		void benchAnnotationSubset();
+		void benchCustomFifo();
+	};
+}
+
+#endif /* MICROBENCH_HPP */
@@ -18,6 +18,7 @@
  */
 
 #include "dynamicWidget.hpp"
+#include "iio_attr_cache.hpp"
 #include "network_analyzer.hpp"
 #include "signal_generator.hpp"
 #include "spinbox_a.hpp"
@@ -44,6 +45,7 @@
 #include <boost/make_shared.hpp>
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QThread>
 
 #include <iio.h>
@@ -53,6 +55,10 @@
 #define INTERP_BY_100_CORR 1.168 // correction value at an interpolation by 100
 #define AMPLITUDE_VOLTS	5.0
 
+/* The measured points are handed to the graphs in blocks, at most this
+ * often */
+#define SWEEP_PLOT_INTERVAL_MS 50
+
 using namespace adiscope;
 using namespace gr;
 
@@ -83,6 +89,8 @@ NetworkAnalyzer::NetworkAnalyzer(struct iio_context *ctx, Filter *filt,
 			[=]() {
 		ui->run_button->setChecked(false);
 	});
+	connect(this, &NetworkAnalyzer::sweepPoints,
+			this, &NetworkAnalyzer::plotPoints);
 
 
 	ui->rightMenu->setMaximumWidth(0);
@@ -170,6 +178,22 @@ void NetworkAnalyzer::run()
 	else
 		step = (max_freq - min_freq) / (double)(steps - 1);
 
+	QVector<double> frequencies, mags, phases;
+	QElapsedTimer plot_timer;
+
+	auto flush = [&]() {
+		if (frequencies.isEmpty())
+			return;
+
+		Q_EMIT sweepPoints(frequencies, mags, phases);
+		frequencies.clear();
+		mags.clear();
+		phases.clear();
+		plot_timer.restart();
+	};
+
+	plot_timer.start();
+
 	for (unsigned int i = 0; !stop && i < steps; i++) {
 		double frequency;
 
@@ -213,7 +237,7 @@ void NetworkAnalyzer::run()
 		}
 
 		adc_rate = get_best_adc_rate(frequency);
-		iio_device_attr_write_longlong(adc,
+		IioAttrCache::get_instance(ctx)->writeLongLong(adc,
 				"sampling_frequency", adc_rate);
 
 		/* Lock the flowgraph if we are already started */
@@ -333,8 +357,10 @@ void NetworkAnalyzer::run()
 		if (buf_dac2)
 			iio_buffer_destroy(buf_dac2);
 
-		if (!got_it) /* Process was cancelled */
+		if (!got_it) { /* Process was cancelled */
+			flush();
 			return;
+		}
 
 		double mag;
 		if (ui->refCh1->isChecked()) {
@@ -348,36 +374,29 @@ void NetworkAnalyzer::run()
 			adc_rate << "SPS," << buffer_size << "samples," <<
 			mag << "Mag," << phase << "Deg, ratio" << ratio;
 
-		double phase_deg = phase * 180.0 / M_PI;
-
-		QMetaObject::invokeMethod(ui->dbgraph,
-				 "plot",
-				 Qt::QueuedConnection,
-				 Q_ARG(double, frequency),
-				 Q_ARG(double, mag));
-
-		QMetaObject::invokeMethod(ui->phasegraph,
-				 "plot",
-				 Qt::QueuedConnection,
-				 Q_ARG(double, frequency),
-				 Q_ARG(double, phase_deg));
-
-		QMetaObject::invokeMethod(ui->xygraph,
-				"plot",
-				Qt::QueuedConnection,
-				Q_ARG(double, phase_deg),
-				Q_ARG(double, mag));
-
-		QMetaObject::invokeMethod(ui->nicholsgraph,
-				 "plot",
-				 Qt::QueuedConnection,
-				 Q_ARG(double, phase_deg),
-				 Q_ARG(double, mag));
+		frequencies.push_back(frequency);
+		mags.push_back(mag);
+		phases.push_back(phase * 180.0 / M_PI);
+
+		if (plot_timer.elapsed() >= SWEEP_PLOT_INTERVAL_MS)
+			flush();
 	}
 
+	flush();
 	Q_EMIT sweepDone();
 }
 
+void NetworkAnalyzer::plotPoints(const QVector<double>& frequency,
+		const QVector<double>& mag, const QVector<double>& phase)
+{
+	const int count = frequency.size();
+
+	ui->dbgraph->append(frequency.data(), mag.data(), count);
+	ui->phasegraph->append(frequency.data(), phase.data(), count);
+	ui->xygraph->append(phase.data(), mag.data(), count);
+	ui->nicholsgraph->append(phase.data(), mag.data(), count);
+}
+
 void NetworkAnalyzer::startStop(bool pressed)
 {
 	stop = !pressed;
@@ -516,6 +535,16 @@ struct iio_buffer * NetworkAnalyzer::generateSinWave(
 	return buf;
 }
 
+bool NetworkAnalyzer_API::running() const
+{
+	return net->ui->run_button->isChecked();
+}
+
+void NetworkAnalyzer_API::run(bool en)
+{
+	net->ui->run_button->setChecked(en);
+}
+
 double NetworkAnalyzer_API::getMinFreq() const
 {
 	return net->ui->minFreq->value();
@@ -25,6 +25,7 @@
 #include "signal_sample.hpp"
 #include "tool.hpp"
 
+#include <QVector>
 #include <QtConcurrentRun>
 
 extern "C" {
@@ -91,15 +92,25 @@ namespace adiscope {
 	private Q_SLOTS:
 		void startStop(bool start);
 		void updateNumSamples();
+		void plotPoints(const QVector<double>& frequency,
+				const QVector<double>& mag,
+				const QVector<double>& phase);
 
 	Q_SIGNALS:
 		void sweepDone();
+
+		/* A block of measured points, in Hz, dB and degrees */
+		void sweepPoints(const QVector<double>& frequency,
+				const QVector<double>& mag,
+				const QVector<double>& phase);
 	};
 
 	class NetworkAnalyzer_API : public ApiObject
 	{
 		Q_OBJECT
 
+		Q_PROPERTY(bool running READ running WRITE run STORED false);
+
 		Q_PROPERTY(double min_freq READ getMinFreq WRITE setMinFreq);
 		Q_PROPERTY(double max_freq READ getMaxFreq WRITE setMaxFreq);
 		Q_PROPERTY(double samples_count READ getSamplesCount
@@ -123,6 +134,9 @@ namespace adiscope {
 			ApiObject(), net(net) {}
 		~NetworkAnalyzer_API() {}
 
+		bool running() const;
+		void run(bool en);
+
 		double getMinFreq() const;
 		double getMaxFreq() const;
 		double getSamplesCount() const;
@@ -34,6 +34,8 @@
 #include <qwt_polar_grid.h>
 #include <qwt_polar_marker.h>
 
+#include <algorithm>
+
 namespace adiscope {
 	class NyquistSamplesArray : public QwtArraySeriesData<QwtPointPolar>
 	{
@@ -140,10 +142,19 @@ void NyquistGraph::setBgColor(const QColor& color)
 
 void NyquistGraph::plot(double azimuth, double radius)
 {
-	if (curve.dataSize() == numSamples + 1)
+	append(&azimuth, &radius, 1);
+}
+
+void NyquistGraph::append(const double *azimuth, const double *radius,
+		int count)
+{
+	count = std::min(count, (int) (numSamples + 1 - curve.dataSize()));
+	if (count <= 0)
 		return;
 
-	samples->addSample(QwtPointPolar(azimuth, radius));
+	for (int i = 0; i < count; i++)
+		samples->addSample(QwtPointPolar(azimuth[i], radius[i]));
+
 	replot();
 }
 
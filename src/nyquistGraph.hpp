@@ -60,6 +60,10 @@ namespace adiscope {
 		QFont getFontAzimuth() const;
 		QFont getFontRadius() const;
 
+		/* Appends a block of points with a single replot */
+		void append(const double *azimuth, const double *radius,
+				int count);
+
 	public Q_SLOTS:
 		void setColor(const QColor& color);
 		void setBgColor(const QColor& color);
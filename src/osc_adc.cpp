@@ -1,5 +1,6 @@
 #include "osc_adc.h"
 #include "hardware_trigger.hpp"
+#include "iio_attr_cache.hpp"
 #include <iio.h>
 #include <QString>
 #include <QDebug>
@@ -65,6 +66,7 @@ QList<struct iio_channel *> IioUtils::pick_channels_with_direction(
  */
 
 GenericAdc::GenericAdc(struct iio_context *ctx, struct iio_device *adc_dev):
+	m_attrs(IioAttrCache::get_instance(ctx)),
 	m_ctx(ctx),
 	m_adc(adc_dev),
 	m_adc_bits(0)
@@ -121,15 +123,16 @@ double GenericAdc::sampleRate() const
 
 double GenericAdc::readSampleRate()
 {
-	iio_device_attr_read_double(m_adc, "sampling_frequency",
-		&m_sample_rate);
+	// The driver rounds to the rates it supports, read the actual one
+	m_attrs->invalidate(m_adc, "sampling_frequency");
+	m_attrs->readDouble(m_adc, "sampling_frequency", m_sample_rate);
 
 	return m_sample_rate;
 }
 
 void GenericAdc::setSampleRate(double sr)
 {
-	iio_device_attr_write_double(m_adc, "sampling_frequency", sr);
+	m_attrs->writeDouble(m_adc, "sampling_frequency", sr);
 	m_sample_rate = sr;
 }
 
@@ -276,7 +279,7 @@ void M2kAdc::setChnHwOffset(uint chnIdx, double offset)
 	int raw_offset = (int)(offset * (1 << numAdcBits()) * hw_chn_gain *
 		gain / 2.693 / vref) + m_chn_corr_offsets[chnIdx];
 
-	iio_channel_attr_write_longlong(m_offset_channels[chnIdx], "raw",
+	m_attrs->writeLongLong(m_offset_channels[chnIdx], "raw",
 		(long long)raw_offset);
 
 	m_chn_hw_offsets[chnIdx] = offset;
@@ -292,8 +295,7 @@ void M2kAdc::setChnHwGainMode(uint chnIdx, GainMode gain_mode)
 	const char *str_gain_mode = (gain_mode == GainMode::HIGH_GAIN_MODE) ?
 		"high" : "low";
 
-	iio_channel_attr_write_raw(m_gain_channels[chnIdx], "gain",
-		str_gain_mode, strlen(str_gain_mode));
+	m_attrs->write(m_gain_channels[chnIdx], "gain", str_gain_mode);
 
 	m_chn_hw_gain_modes[chnIdx] = gain_mode;
 }
@@ -16,6 +16,7 @@ extern "C" {
 namespace adiscope {
 
 class HardwareTrigger;
+class IioAttrCache;
 
 class IioUtils
 {
@@ -65,6 +66,7 @@ public:
 
 protected:
 	std::shared_ptr<HardwareTrigger> m_trigger;
+	std::shared_ptr<IioAttrCache> m_attrs;
 
 private:
 	struct iio_context *m_ctx;
@@ -19,7 +19,7 @@
 
 /* GNU Radio includes */
 #include <gnuradio/blocks/float_to_complex.h>
-#include <gnuradio/iio/math.h>
+#include <volk/volk.h>
 
 /* Qt includes */
 #include <QtWidgets>
@@ -32,6 +32,7 @@
 #include "adc_sample_conv.hpp"
 #include "customPushButton.hpp"
 #include "math.hpp"
+#include "math_expr_f.hpp"
 #include "oscilloscope.hpp"
 #include "dynamicWidget.hpp"
 #include "measurement_gui.h"
@@ -40,6 +41,10 @@
 #include "state_updater.h"
 #include "osc_capture_params.hpp"
 #include "buffer_previewer.hpp"
+#include "waveform_history.hpp"
+#include "persistence_accumulator.hpp"
+#include "iio_attr_cache.hpp"
+#include "trace_overlay.hpp"
 
 /* Generated UI */
 #include "ui_math_panel.h"
@@ -89,7 +94,11 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 	menuOpened(false), current_channel(-1), math_chn_counter(0),
 	channels_group(new QButtonGroup(this)),
 	active_settings_btn(nullptr),
-	last_non_general_settings_btn(nullptr)
+	last_non_general_settings_btn(nullptr),
+	history(make_shared<WaveformHistory>(nb_channels)),
+	history_buffer_size(0),
+	history_frame(-1),
+	roll_mode(false)
 {
 	ui->setupUi(this);
 	int triggers_panel = ui->stackedWidget->insertWidget(-1, &trigger_settings);
@@ -125,6 +134,8 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 			400, "Osc XY", nb_channels / 2, (QObject*)&xy_plot);
 
 	this->qt_time_block->set_trigger_mode(TRIG_MODE_TAG, 0, "buffer_start");
+	this->qt_time_block->set_history(history);
+	this->qt_time_block->set_persistence(plot.persistence());
 	this->qt_fft_block->set_trigger_mode(TRIG_MODE_TAG, 0, "buffer_start");
 
 	// Prevent the application from hanging while waiting for a trigger condition
@@ -138,6 +149,16 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 	gr::hier_block2_sptr hier = iio->to_hier_block2();
 	qDebug() << "Manager created:\n" << gr::dot_graph(hier).c_str();
 
+	auto overlay = new TraceOverlay(&plot);
+	overlay->setFrames(qt_time_block->name());
+	overlay->setRefills(filt->device_name(TOOL_OSCILLOSCOPE));
+	overlay->addStage("Conversion", "gr", "adc_sample_conv");
+	overlay->addStage("Sink", qt_time_block->name(), "scope_sink");
+	overlay->addStage("Delivery", qt_time_block->name(),
+			"event_delivery");
+	overlay->addStage("Plot", qt_time_block->name(), "plot");
+	overlay->addStage("Replot", "plot", "replot");
+
 	auto adc_channels = adc->adcChannelList();
 	for (unsigned int i = 0; i < adc_channels.size(); i++) {
 		const char *id = iio_channel_get_name(adc_channels[i]);
@@ -235,8 +256,9 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 	}
 
 	for (unsigned int i = 0; i < nb_channels; i++) {
+		/* The conversion block reads the raw samples */
 		ids[i] = iio->connect(adc_samp_conv, i, i,
-				true, qt_time_block->nsamps());
+				false, qt_time_block->nsamps());
 
 		iio->connect(adc_samp_conv, i, qt_time_block, i);
 	}
@@ -383,6 +405,19 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 	connect(gsettings_ui->Histogram_view, SIGNAL(toggled(bool)),
 		SLOT(onHistogram_view_toggled(bool)));
 
+	gsettings_ui->histogramMode->hide();
+	gsettings_ui->histogramWindow->hide();
+
+	connect(gsettings_ui->histogramMode, SIGNAL(currentIndexChanged(int)),
+		SLOT(onHistogramSettingsChanged()));
+	connect(gsettings_ui->histogramWindow, SIGNAL(valueChanged(int)),
+		SLOT(onHistogramSettingsChanged()));
+	connect(&hist_plot, &HistogramDisplayPlot::binRangeRequested,
+			[=](double min, double max) {
+				qt_hist_block->set_xaxis(min, max);
+			});
+	onHistogramSettingsChanged();
+
 	connect(ui->btnGeneralSettings, SIGNAL(pressed()),
 				this, SLOT(toggleRightMenu()));
 
@@ -511,6 +546,8 @@ Oscilloscope::Oscilloscope(struct iio_context *ctx, Filter *filt,
 		current_channel = crt_chn_copy;
 	}
 
+	updateHistogramRange();
+
 	api->setObjectName(QString::fromStdString(Filter::tool_name(
 			TOOL_OSCILLOSCOPE)));
 	api->load(*settings);
@@ -546,6 +583,8 @@ Oscilloscope::~Oscilloscope()
 	api->save(*settings);
 	delete api;
 
+	freeHistoryBuffers();
+
 	delete[] xy_ids;
 	delete[] hist_ids;
 	delete[] fft_ids;
@@ -621,7 +660,8 @@ void Oscilloscope::add_math_channel(const std::string& function)
 	if (nb_math_channels == MAX_MATH_CHANNELS)
 		return;
 
-	auto math = iio::iio_math::make(function, nb_channels);
+	auto math = gnuradio::get_initial_sptr(
+			new math_expr_f(function, nb_channels));
 	unsigned int curve_id = nb_channels + nb_math_channels;
 	unsigned int curve_number = find_curve_number();
 
@@ -647,6 +687,7 @@ void Oscilloscope::add_math_channel(const std::string& function)
 		iio->lock();
 
 	math_sink->set_trigger_mode(TRIG_MODE_TAG, 0, "buffer_start");
+	math_sink->set_roll_mode(roll_mode);
 
 	for (unsigned int i = 0; i < nb_channels; i++)
 		iio->connect(adc_samp_conv_block, i, math, i);
@@ -658,6 +699,7 @@ void Oscilloscope::add_math_channel(const std::string& function)
 	plot.registerSink(name, 1,
 			plot.axisInterval(QwtPlot::xBottom).width() *
 			adc->sampleRate());
+	updateMathPersistence();
 
 	QWidget *channel_widget = new QWidget(this);
 	Ui::ChannelMath channel_ui;
@@ -706,7 +748,7 @@ void Oscilloscope::add_math_channel(const std::string& function)
 	plot.Curve(curve_id)->setAxes(
 			QwtAxisId(QwtPlot::xBottom, 0),
 			QwtAxisId(QwtPlot::yLeft, curve_id));
-	plot.replot();
+	plot.scheduleReplot();
 
 	/* We added a Math channel that is enabled by default,
 	 * so enable the Run button */
@@ -755,6 +797,9 @@ void Oscilloscope::del_math_channel()
 	if (started)
 		iio->unlock();
 
+	/* The curves of the next math channels moved down by one */
+	updateMathPersistence();
+
 	/* Exit from group and set another channel as the current channel */
 	QPushButton *name = parent->findChild<QPushButton *>("name");
 	channels_group->removeButton(name);
@@ -801,7 +846,7 @@ void Oscilloscope::del_math_channel()
 	}
 
 	updateRunButton(false);
-	plot.replot();
+	plot.scheduleReplot();
 }
 
 void Oscilloscope::on_actionClose_triggered()
@@ -844,6 +889,10 @@ void Oscilloscope::runStopToggled(bool checked)
 	setDynamicProperty(btn, "running", checked);
 
 	if (checked) {
+		history_frame = -1;
+		if (!history->overwrite())
+			history->clear();
+
 		writeAllSettingsToHardware();
 
 		plot.setSampleRate(active_sample_rate, 1, "");
@@ -890,7 +939,8 @@ void Oscilloscope::onFFT_view_toggled(bool visible)
 			fft_ids[i] = iio->connect(fft, i, 0, true);
 
 			auto ctm = blocks::complex_to_mag::make(1);
-			auto m2dB = iio::iio_math::make(mag2dB_formula);
+			auto m2dB = gnuradio::get_initial_sptr(
+					new math_expr_f(mag2dB_formula));
 
 			iio->connect(fft, 0, ctm, 0);
 			iio->connect(ctm, 0, m2dB, 0);
@@ -939,10 +989,45 @@ void Oscilloscope::onHistogram_view_toggled(bool visible)
 
 	hist_is_visible = visible;
 
+	gsettings_ui->histogramMode->setVisible(visible);
+	gsettings_ui->histogramWindow->setVisible(visible);
+
 	if (started)
 		iio->unlock();
 }
 
+void Oscilloscope::onHistogramSettingsChanged()
+{
+	auto mode = static_cast<histogram_mode>(
+			gsettings_ui->histogramMode->currentIndex());
+
+	gsettings_ui->histogramWindow->setEnabled(mode == HIST_MODE_WINDOW);
+	qt_hist_block->set_mode(mode, gsettings_ui->histogramWindow->value());
+}
+
+/*
+ * The histogram bins cover the voltage range displayed by the channels, so
+ * the samples spread over the bins the same way they spread over the plot.
+ */
+void Oscilloscope::updateHistogramRange()
+{
+	double half_divs = plot.yAxisNumDiv() / 2.0;
+	double min = 0, max = 0;
+
+	for (unsigned int i = 0; i < nb_channels; i++) {
+		double span = plot.VertUnitsPerDiv(i) * half_divs;
+		double offset = plot.VertOffset(i);
+
+		if (i == 0 || offset - span < min)
+			min = offset - span;
+		if (i == 0 || offset + span > max)
+			max = offset + span;
+	}
+
+	if (max > min)
+		qt_hist_block->set_xaxis(min, max);
+}
+
 void Oscilloscope::onXY_view_toggled(bool visible)
 {
 	/* Lock the flowgraph if we are already started */
@@ -1125,7 +1210,7 @@ void adiscope::Oscilloscope::channel_box_toggled(bool checked)
 
 	plot.setOffsetWidgetVisible(id, checked);
 
-	plot.replot();
+	plot.scheduleReplot();
 	updateRunButton(checked);
 }
 
@@ -1161,7 +1246,7 @@ void adiscope::Oscilloscope::onVertScaleValueChanged(double value)
 {
 	if (value != plot.VertUnitsPerDiv(current_channel)) {
 		plot.setVertUnitsPerDiv(value, current_channel);
-		plot.replot();
+		plot.scheduleReplot();
 	}
 	voltsPosition->setStep(value / 10);
 
@@ -1184,6 +1269,8 @@ void adiscope::Oscilloscope::onVertScaleValueChanged(double value)
 			voltsPosition->value());
 		trigger_settings.updateHwVoltLevels(current_channel);
 	}
+
+	updateHistogramRange();
 }
 
 void adiscope::Oscilloscope::onHorizScaleValueChanged(double value)
@@ -1197,7 +1284,7 @@ void adiscope::Oscilloscope::onHorizScaleValueChanged(double value)
 
 	// Realign plot data based on the new sample count and trigger position
 	plot.setHorizUnitsPerDiv(value);
-	plot.replot();
+	plot.scheduleReplot();
 	plot.setDataStartingPoint(active_trig_sample_count);
 	plot.resetXaxisOnNextReceivedData();
 	plot.zoomBaseUpdate();
@@ -1235,7 +1322,7 @@ void adiscope::Oscilloscope::onHorizScaleValueChanged(double value)
 	}
 
 	for (unsigned int i = 0; i < nb_channels; i++)
-		iio->set_buffer_size(ids[i], active_sample_count);
+		iio->set_buffer_size(ids[i], iioBufferSize());
 
 	if (started)
 		iio->unlock();
@@ -1250,7 +1337,7 @@ void adiscope::Oscilloscope::onVertOffsetValueChanged(double value)
 {
 	if (value != -plot.VertOffset(current_channel)) {
 		plot.setVertOffset(-value, current_channel);
-		plot.replot();
+		plot.scheduleReplot();
 	}
 
 	// Switch between high and low gain modes only for the M2K channels
@@ -1266,6 +1353,8 @@ void adiscope::Oscilloscope::onVertOffsetValueChanged(double value)
 		if (ui->pushButtonRunStop->isChecked())
 			toggle_blockchain_flow(true);
 	}
+
+	updateHistogramRange();
 }
 
 void adiscope::Oscilloscope::onTimePositionChanged(double value)
@@ -1282,7 +1371,7 @@ void adiscope::Oscilloscope::onTimePositionChanged(double value)
 
 	// Realign plot data based on the new time position
 	plot.setHorizOffset(value);
-	plot.replot();
+	plot.scheduleReplot();
 	plot.setDataStartingPoint(active_trig_sample_count);
 	plot.resetXaxisOnNextReceivedData();
 
@@ -1313,7 +1402,7 @@ void adiscope::Oscilloscope::onTimePositionChanged(double value)
 	}
 
 	for (unsigned int i = 0; i < nb_channels; i++)
-		iio->set_buffer_size(ids[i], active_sample_count);
+		iio->set_buffer_size(ids[i], iioBufferSize());
 
 	if (started)
 		iio->unlock();
@@ -1908,6 +1997,155 @@ void Oscilloscope::onPlotNewData()
 		triggerUpdater->setInput(CapturePlot::Auto);
 
 	updateBufferPreviewer();
+
+	// A segmented acquisition ends once every segment has been captured
+	if (history_frame < 0 && !history->overwrite() && history->full())
+		ui->pushButtonRunStop->setChecked(false);
+}
+
+void Oscilloscope::setHistorySize(unsigned int count)
+{
+	history->setSegmentCount(count);
+	history_frame = -1;
+}
+
+void Oscilloscope::setSegmentedAcquisition(bool en)
+{
+	history->setOverwrite(!en);
+}
+
+/*
+ * Roll mode streams the samples continuously instead of capturing triggered
+ * frames: the hardware trigger is bypassed, the sinks forward whatever they
+ * received at their update rate and the plot scrolls its time window.
+ */
+void Oscilloscope::setRollMode(bool en)
+{
+	if (en == roll_mode)
+		return;
+
+	roll_mode = en;
+
+	bool started = iio->started();
+	if (started)
+		iio->lock();
+
+	qt_time_block->set_roll_mode(en);
+
+	auto it = math_sinks.constBegin();
+	while (it != math_sinks.constEnd()) {
+		scope_sink_f::sptr math_sink = dynamic_pointer_cast<
+				scope_sink_f>(it.value().second);
+		math_sink->set_roll_mode(en);
+		++it;
+	}
+
+	trigger_settings.setStreamingMode(en);
+	plot.setRollMode(en);
+
+	for (unsigned int i = 0; i < nb_channels; i++)
+		iio->set_buffer_size(ids[i], iioBufferSize());
+
+	if (started)
+		iio->unlock();
+}
+
+unsigned long Oscilloscope::iioBufferSize() const
+{
+	if (!roll_mode)
+		return active_sample_count;
+
+	/* Refill about 50 times per second so the display keeps scrolling
+	 * smoothly on long timebases, where a whole frame takes seconds */
+	unsigned long size = (unsigned long)(active_sample_rate / 50);
+	size = std::max(size, 64ul) & ~3ul;
+
+	return std::min(size, active_sample_count);
+}
+
+void Oscilloscope::updateMathPersistence()
+{
+	for (auto it = math_sinks.constBegin();
+			it != math_sinks.constEnd(); ++it) {
+		scope_sink_f::sptr math_sink = dynamic_pointer_cast<
+				scope_sink_f>(it.value().second);
+		int pos = plot.sinkFirstChannelPos(it.key().toStdString());
+
+		if (pos >= 0)
+			math_sink->set_persistence(plot.persistence(), pos);
+	}
+}
+
+void Oscilloscope::freeHistoryBuffers()
+{
+	for (auto it = history_buffers.begin();
+			it != history_buffers.end(); ++it)
+		delete[] *it;
+	history_buffers.clear();
+	history_buffer_size = 0;
+}
+
+bool Oscilloscope::showHistoryFrame(int index)
+{
+	if (ui->pushButtonRunStop->isChecked() || index < 0 ||
+			index >= (int)history->count())
+		return false;
+
+	unsigned int size = history->segmentSize();
+
+	if (size != history_buffer_size) {
+		freeHistoryBuffers();
+		history_buffer_size = size;
+
+		for (unsigned int i = 0; i < nb_channels; i++)
+			history_buffers.push_back(new double[size]);
+	}
+
+	std::vector< std::vector<gr::tag_t> > tags;
+	if (!history->read(index, history_buffers, &tags))
+		return false;
+
+	history_frame = index;
+
+	// Replayed frames go through the same path as fresh ones, so the
+	// measurements, cursors and statistics all follow the selected frame
+	plot.plotNewData(qt_time_block->name(), history_buffers, size, 0, tags);
+
+	// The math channels are not stored: compute them again from the
+	// replayed inputs, just like their blocks do for live frames
+	if (!math_sinks.isEmpty()) {
+		std::vector<float> inputs((size_t)nb_channels * size);
+		std::vector<const float *> input_ptrs(nb_channels);
+		std::vector<float> output(size);
+		std::vector<double> math_data(size);
+		std::vector<double *> math_buffers(1, math_data.data());
+		std::vector< std::vector<gr::tag_t> > math_tags(1);
+
+		if (!tags.empty())
+			math_tags[0] = tags[0];
+
+		for (unsigned int i = 0; i < nb_channels; i++) {
+			float *in = &inputs[(size_t)i * size];
+
+			volk_64f_convert_32f(in, history_buffers[i], size);
+			input_ptrs[i] = in;
+		}
+
+		for (auto it = math_sinks.constBegin();
+				it != math_sinks.constEnd(); ++it) {
+			auto math = dynamic_pointer_cast<math_expr_f>(
+					it.value().first);
+			MathExpression expr(math->function(), nb_channels);
+
+			expr.evaluate(input_ptrs, output.data(), size);
+			volk_32f_convert_64f(math_data.data(), output.data(),
+					size);
+			plot.plotNewData(it.key().toStdString(), math_buffers,
+					size, 0, math_tags);
+		}
+	}
+
+	return true;
 }
 
 void Oscilloscope::onTriggerModeChanged(int mode)
@@ -2076,6 +2314,10 @@ void Oscilloscope::setAllSinksSampleCount(unsigned long sample_count)
 
 void Oscilloscope::writeAllSettingsToHardware()
 {
+	// Send the settings that changed, one transaction per channel
+	auto attrs = IioAttrCache::get_instance(adc->iio_context());
+	attrs->begin();
+
 	// Sample Rate
 	if (active_sample_rate != adc->sampleRate())
 		adc->setSampleRate(active_sample_rate);
@@ -2093,6 +2335,8 @@ void Oscilloscope::writeAllSettingsToHardware()
 
 	// Writes all trigger settings to hardware
 	trigger_settings.setAdcRunningState(true);
+
+	attrs->commit();
 }
 
 /*
@@ -2443,7 +2687,7 @@ void Oscilloscope::channelLineWidthChanged(int id)
 
 	if (width != plot.getLineWidthF(current_channel)) {
 		plot.setLineWidthF(current_channel, width);
-		plot.replot();
+		plot.scheduleReplot();
 	}
 }
 
@@ -2462,6 +2706,102 @@ void Oscilloscope_API::setCurrentChannel(int chn_id)
 	name->setChecked(true);
 }
 
+int Oscilloscope_API::getHistorySize() const
+{
+	return osc->history->segmentCount();
+}
+
+void Oscilloscope_API::setHistorySize(int count)
+{
+	osc->setHistorySize(std::max(count, 0));
+}
+
+bool Oscilloscope_API::segmentedAcquisition() const
+{
+	return !osc->history->overwrite();
+}
+
+void Oscilloscope_API::setSegmentedAcquisition(bool en)
+{
+	osc->setSegmentedAcquisition(en);
+}
+
+int Oscilloscope_API::getHistoryCount() const
+{
+	return osc->history->count();
+}
+
+int Oscilloscope_API::getHistoryFrame() const
+{
+	return osc->history_frame;
+}
+
+void Oscilloscope_API::setHistoryFrame(int index)
+{
+	osc->showHistoryFrame(index);
+}
+
+bool Oscilloscope_API::persistence() const
+{
+	return osc->plot.isPersistenceEnabled();
+}
+
+void Oscilloscope_API::setPersistence(bool en)
+{
+	osc->plot.setPersistenceEnabled(en);
+}
+
+double Oscilloscope_API::getPersistenceDecay() const
+{
+	return osc->plot.persistence()->decay();
+}
+
+void Oscilloscope_API::setPersistenceDecay(double seconds)
+{
+	osc->plot.setPersistenceDecay(seconds);
+}
+
+bool Oscilloscope_API::rollMode() const
+{
+	return osc->roll_mode;
+}
+
+void Oscilloscope_API::setRollMode(bool en)
+{
+	osc->setRollMode(en);
+}
+
+bool Oscilloscope_API::histogram() const
+{
+	return osc->gsettings_ui->Histogram_view->isChecked();
+}
+
+void Oscilloscope_API::setHistogram(bool en)
+{
+	osc->gsettings_ui->Histogram_view->setChecked(en);
+}
+
+int Oscilloscope_API::getHistogramMode() const
+{
+	return osc->gsettings_ui->histogramMode->currentIndex();
+}
+
+void Oscilloscope_API::setHistogramMode(int mode)
+{
+	if (mode >= 0 && mode < osc->gsettings_ui->histogramMode->count())
+		osc->gsettings_ui->histogramMode->setCurrentIndex(mode);
+}
+
+int Oscilloscope_API::getHistogramWindow() const
+{
+	return osc->gsettings_ui->histogramWindow->value();
+}
+
+void Oscilloscope_API::setHistogramWindow(int frames)
+{
+	osc->gsettings_ui->histogramWindow->setValue(frames);
+}
+
 QVariantList Oscilloscope_API::getChannels()
 {
 	QVariantList list;
@@ -2504,6 +2844,7 @@ void Channel_API::setVoltsPerDiv(double val)
 {
 	int index = osc->channels_api.indexOf(this);
 	osc->plot.setVertUnitsPerDiv(val, index);
+	osc->updateHistogramRange();
 }
 
 double Channel_API::getVOffset() const
@@ -2516,6 +2857,7 @@ void Channel_API::setVOffset(double val)
 {
 	int index = osc->channels_api.indexOf(this);
 	osc->plot.setVertOffset(val, index);
+	osc->updateHistogramRange();
 }
 
 double Channel_API::getLineThickness() const
@@ -75,6 +75,7 @@ namespace adiscope {
 	class MeasureSettings;
 	class StateUpdater;
 	class AnalogBufferPreviewer;
+	class WaveformHistory;
 
 	class Oscilloscope : public Tool
 	{
@@ -104,6 +105,7 @@ namespace adiscope {
 
 		void onFFT_view_toggled(bool visible);
 		void onHistogram_view_toggled(bool visible);
+		void onHistogramSettingsChanged();
 		void onXY_view_toggled(bool visible);
 
 		void onTriggerSourceChanged(int);
@@ -189,6 +191,12 @@ namespace adiscope {
 
 		std::shared_ptr<SymmetricBufferMode> symmBufferMode;
 
+		std::shared_ptr<WaveformHistory> history;
+		std::vector<double *> history_buffers;
+		unsigned int history_buffer_size;
+		int history_frame;
+		bool roll_mode;
+
 		adiscope::scope_sink_f::sptr qt_time_block;
 		adiscope::scope_sink_f::sptr qt_fft_block;
 		adiscope::xy_sink_c::sptr qt_xy_block;
@@ -277,6 +285,16 @@ namespace adiscope {
 		void statisticsUpdateGuiPosIndex();
 
 		void updateBufferPreviewer();
+
+		void setHistorySize(unsigned int count);
+		void setSegmentedAcquisition(bool en);
+		bool showHistoryFrame(int index);
+		void freeHistoryBuffers();
+		void updateMathPersistence();
+		void updateHistogramRange();
+
+		void setRollMode(bool en);
+		unsigned long iioBufferSize() const;
 	};
 
 	class Oscilloscope_API : public ApiObject
@@ -339,6 +357,27 @@ namespace adiscope {
 		Q_PROPERTY(int current_channel READ getCurrentChannel
 				WRITE setCurrentChannel)
 
+		Q_PROPERTY(int history_size
+				READ getHistorySize WRITE setHistorySize)
+		Q_PROPERTY(bool segmented_acquisition READ segmentedAcquisition
+				WRITE setSegmentedAcquisition)
+		Q_PROPERTY(int history_count READ getHistoryCount STORED false)
+		Q_PROPERTY(int history_frame READ getHistoryFrame
+				WRITE setHistoryFrame STORED false)
+
+		Q_PROPERTY(bool persistence
+				READ persistence WRITE setPersistence)
+		Q_PROPERTY(double persistence_decay READ getPersistenceDecay
+				WRITE setPersistenceDecay)
+
+		Q_PROPERTY(bool roll_mode READ rollMode WRITE setRollMode)
+
+		Q_PROPERTY(bool histogram READ histogram WRITE setHistogram)
+		Q_PROPERTY(int histogram_mode READ getHistogramMode
+				WRITE setHistogramMode)
+		Q_PROPERTY(int histogram_window READ getHistogramWindow
+				WRITE setHistogramWindow)
+
 	public:
 		explicit Oscilloscope_API(Oscilloscope *osc) :
 			ApiObject(), osc(osc) {}
@@ -424,6 +463,35 @@ namespace adiscope {
 		int getCurrentChannel() const;
 		void setCurrentChannel(int chn_id);
 
+		int getHistorySize() const;
+		void setHistorySize(int count);
+
+		bool segmentedAcquisition() const;
+		void setSegmentedAcquisition(bool en);
+
+		int getHistoryCount() const;
+
+		int getHistoryFrame() const;
+		void setHistoryFrame(int index);
+
+		bool persistence() const;
+		void setPersistence(bool en);
+
+		double getPersistenceDecay() const;
+		void setPersistenceDecay(double seconds);
+
+		bool rollMode() const;
+		void setRollMode(bool en);
+
+		bool histogram() const;
+		void setHistogram(bool en);
+
+		int getHistogramMode() const;
+		void setHistogramMode(int mode);
+
+		int getHistogramWindow() const;
+		void setHistogramWindow(int frames);
+
 	private:
 		Oscilloscope *osc;
 	};
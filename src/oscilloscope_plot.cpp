@@ -661,6 +661,29 @@ void CapturePlot::cleanUpJustBeforeChannelRemoval(int chnIdx)
 	}
 }
 
+void CapturePlot::rollDataAppended(int chnIdx, const double *data,
+		int64_t numDataPoints)
+{
+	if (!d_measurementsEnabled)
+		return;
+
+	Measure *measure = measureOfChannel(chnIdx);
+	if (measure && measure->activeMeasurementsCount() > 0) {
+		measure->setSampleRate(this->sampleRate());
+		measure->setStreamingWindow(axisInterval(QwtPlot::xBottom)
+				.width() * this->sampleRate());
+		measure->measureStreaming(data, numDataPoints);
+	}
+}
+
+void CapturePlot::setRollMode(bool en)
+{
+	for (int i = 0; i < d_measureObjs.size(); i++)
+		d_measureObjs[i]->resetStreaming();
+
+	TimeDomainDisplayPlot::setRollMode(en);
+}
+
 void CapturePlot::setOffsetWidgetVisible(int chnIdx, bool visible)
 {
 	if (chnIdx < 0 || chnIdx >= d_offsetHandles.size())
@@ -708,6 +731,12 @@ void CapturePlot::onNewDataReceived()
 	if (!d_measurementsEnabled)
 		return;
 
+	/* In roll mode the measurements are updated as the samples arrive */
+	if (isRollMode()) {
+		Q_EMIT measurementsAvailable();
+		return;
+	}
+
 	for (int i = 0; i < d_measureObjs.size(); i++) {
 		Measure *measure = d_measureObjs[i];
 		if (measure->activeMeasurementsCount() > 0) {
@@ -117,9 +117,12 @@ namespace adiscope {
 		void setBufferSizeLabelValue(int numSamples);
 		void setSampleRatelabelValue(double sampleRate);
 		void setTriggerState(int triggerState);
+		virtual void setRollMode(bool en);
 
 	protected:
 		virtual void cleanUpJustBeforeChannelRemoval(int chnIdx);
+		virtual void rollDataAppended(int chnIdx, const double *data,
+				int64_t numDataPoints);
 
 	private:
 		Measure* measureOfChannel(int chnIdx) const;
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "persistence_accumulator.hpp"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+#include <volk/volk.h>
+
+using namespace adiscope;
+
+/* Interval between two rendered images (~30 fps) */
+static const std::chrono::milliseconds render_period(33);
+
+bool PersistenceAccumulator::geometry::operator==(const geometry& other) const
+{
+	return width == other.width && height == other.height &&
+		sample_rate == other.sample_rate &&
+		start_time == other.start_time &&
+		x_min == other.x_min && x_max == other.x_max &&
+		y_min == other.y_min && y_max == other.y_max &&
+		colors == other.colors && visible == other.visible;
+}
+
+PersistenceAccumulator::PersistenceAccumulator(QObject *parent) :
+	QObject(parent),
+	stop_worker(false),
+	enabled(false),
+	frames(nb_frames),
+	geom_changed(false),
+	clear_requested(false),
+	decay_time(0.5),
+	dirty(false),
+	dropped(0),
+	accumulated(0)
+{
+	pending_geom.width = 0;
+	pending_geom.height = 0;
+	pending_geom.sample_rate = 1.0;
+	pending_geom.start_time = 0.0;
+	pending_geom.x_min = 0.0;
+	pending_geom.x_max = 0.0;
+	geom = pending_geom;
+
+	for (unsigned int i = 0; i < nb_frames; i++)
+		free_frames.push_back(i);
+
+	worker = std::thread(&PersistenceAccumulator::run, this);
+}
+
+PersistenceAccumulator::~PersistenceAccumulator()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stop_worker = true;
+	}
+	cond.notify_one();
+	worker.join();
+}
+
+void PersistenceAccumulator::setEnabled(bool en)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		enabled = en;
+	}
+	cond.notify_one();
+
+	if (!en)
+		clear();
+}
+
+bool PersistenceAccumulator::isEnabled() const
+{
+	return enabled;
+}
+
+void PersistenceAccumulator::setGeometry(const geometry& g)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (g == pending_geom)
+		return;
+
+	pending_geom = g;
+	geom_changed = true;
+	cond.notify_one();
+}
+
+void PersistenceAccumulator::setDecay(double seconds)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	decay_time = std::max(seconds, 0.0);
+}
+
+double PersistenceAccumulator::decay() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return decay_time;
+}
+
+void PersistenceAccumulator::clear()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	while (!ready_frames.empty()) {
+		free_frames.push_back(ready_frames.front());
+		ready_frames.pop_front();
+	}
+
+	clear_requested = true;
+	cond.notify_one();
+}
+
+unsigned long long PersistenceAccumulator::droppedFrames() const
+{
+	return dropped;
+}
+
+unsigned long long PersistenceAccumulator::accumulatedFrames() const
+{
+	return accumulated;
+}
+
+bool PersistenceAccumulator::pushFrame(const std::vector<float *>& buffers,
+		int offset, int size, unsigned int first_channel)
+{
+	if (!enabled || size <= 0)
+		return false;
+
+	unsigned int idx;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		if (free_frames.empty()) {
+			dropped++;
+			return false;
+		}
+
+		idx = free_frames.front();
+		free_frames.pop_front();
+	}
+
+	/* The slot is owned by this thread until it is queued, so the copy
+	 * does not need to hold the lock. Storage only grows, hence the
+	 * allocations stop after the first few frames. */
+	frame& f = frames[idx];
+	size_t total = (size_t)buffers.size() * size;
+
+	if (f.data.size() < total)
+		f.data.resize(total);
+
+	for (unsigned int i = 0; i < buffers.size(); i++)
+		memcpy(&f.data[(size_t)i * size], &buffers[i][offset],
+				size * sizeof(float));
+
+	f.nb_channels = buffers.size();
+	f.first_channel = first_channel;
+	f.size = size;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		ready_frames.push_back(idx);
+	}
+	cond.notify_one();
+
+	return true;
+}
+
+void PersistenceAccumulator::resetHistograms()
+{
+	size_t pixels = (size_t)std::max(geom.width, 0) *
+		std::max(geom.height, 0);
+
+	hists.resize(geom.y_min.size());
+	for (auto it = hists.begin(); it != hists.end(); ++it)
+		it->assign(pixels, 0.0f);
+
+	dirty = true;
+}
+
+/*
+ * Accumulates one channel of a frame. The pixel coordinates of all the
+ * samples are computed first in two flat loops the compiler vectorizes,
+ * then every segment between two consecutive samples is drawn as vertical
+ * spans, one per canvas column it crosses.
+ */
+void PersistenceAccumulator::rasterize(const float *in, int size,
+		float x0, float dx, float y0, float dy,
+		int width, int height, float *hist, float *px, float *py)
+{
+	for (int i = 0; i < size; i++)
+		px[i] = x0 + dx * (float)i;
+
+	for (int i = 0; i < size; i++)
+		py[i] = y0 + dy * in[i];
+
+	for (int i = 1; i < size; i++) {
+		float xa = px[i - 1], xb = px[i];
+		float ya = py[i - 1], yb = py[i];
+
+		if (xb < 0.0f || xa >= (float)width)
+			continue;
+
+		int ca = std::max(0, (int)std::floor(xa));
+		int cb = std::min(width - 1, (int)std::floor(xb));
+		float slope = (xb > xa) ? (yb - ya) / (xb - xa) : 0.0f;
+
+		for (int c = ca; c <= cb; c++) {
+			float left = std::max((float)c, xa);
+			float right = std::min((float)(c + 1), xb);
+			float yl = ya + slope * (left - xa);
+			float yr = ya + slope * (right - xa);
+
+			int r0 = (int)std::floor(std::min(yl, yr));
+			int r1 = (int)std::floor(std::max(yl, yr));
+
+			if (r1 < 0 || r0 >= height)
+				continue;
+
+			r0 = std::max(r0, 0);
+			r1 = std::min(r1, height - 1);
+
+			float *col = hist + (size_t)r0 * width + c;
+			for (int r = r0; r <= r1; r++, col += width)
+				*col += 1.0f;
+		}
+	}
+}
+
+void PersistenceAccumulator::accumulate(const frame& f)
+{
+	if (geom.width <= 0 || geom.height <= 0 ||
+			geom.x_max <= geom.x_min || geom.sample_rate <= 0.0)
+		return;
+
+	if (px.size() < (size_t)f.size) {
+		px.resize(f.size);
+		py.resize(f.size);
+	}
+
+	double px_per_sec = geom.width / (geom.x_max - geom.x_min);
+	float x0 = (geom.start_time - geom.x_min) * px_per_sec;
+	float dx = px_per_sec / geom.sample_rate;
+
+	for (unsigned int i = 0; i < f.nb_channels; i++) {
+		unsigned int chn = f.first_channel + i;
+
+		if (chn >= hists.size() || !geom.visible[chn])
+			continue;
+
+		double span = geom.y_max[chn] - geom.y_min[chn];
+		if (span <= 0.0)
+			continue;
+
+		float dy = -geom.height / span;
+		float y0 = geom.y_max[chn] * geom.height / span;
+
+		rasterize(&f.data[(size_t)i * f.size], f.size, x0, dx, y0, dy,
+				geom.width, geom.height, hists[chn].data(),
+				px.data(), py.data());
+	}
+
+	accumulated++;
+	dirty = true;
+}
+
+void PersistenceAccumulator::applyDecay(double elapsed)
+{
+	double tau;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		tau = decay_time;
+	}
+
+	if (tau <= 0.0)
+		return;
+
+	float factor = std::exp(-elapsed / tau);
+
+	for (auto it = hists.begin(); it != hists.end(); ++it)
+		volk_32f_s32f_multiply_32f(it->data(), it->data(), factor,
+				it->size());
+
+	dirty = true;
+}
+
+QImage PersistenceAccumulator::render() const
+{
+	if (geom.width <= 0 || geom.height <= 0)
+		return QImage();
+
+	QImage image(geom.width, geom.height, QImage::Format_ARGB32);
+	image.fill(Qt::transparent);
+
+	size_t pixels = (size_t)geom.width * geom.height;
+	std::vector<float> norm(hists.size(), 0.0f);
+
+	/* Logarithmic grading, so rare events stay visible next to the
+	 * trace that is hit by every single frame */
+	for (unsigned int i = 0; i < hists.size(); i++) {
+		if (!geom.visible[i])
+			continue;
+
+		float max = *std::max_element(hists[i].begin(), hists[i].end());
+		if (max > 0.0f)
+			norm[i] = 1.0f / std::log1p(max);
+	}
+
+	for (int y = 0; y < geom.height; y++) {
+		QRgb *line = (QRgb *)image.scanLine(y);
+
+		for (int x = 0; x < geom.width; x++) {
+			size_t idx = (size_t)y * geom.width + x;
+			float best = 0.0f;
+			int chn = -1;
+
+			for (unsigned int i = 0; i < hists.size(); i++) {
+				if (norm[i] == 0.0f)
+					continue;
+
+				float level = std::log1p(hists[i][idx]) * norm[i];
+				if (level > best) {
+					best = level;
+					chn = i;
+				}
+			}
+
+			if (chn < 0 || idx >= pixels)
+				continue;
+
+			const QColor& c = geom.colors[chn];
+			line[x] = qRgba(c.red(), c.green(), c.blue(),
+					(int)(best * 255.0f));
+		}
+	}
+
+	return image;
+}
+
+void PersistenceAccumulator::run()
+{
+	last_render = std::chrono::steady_clock::now();
+
+	std::unique_lock<std::mutex> guard(lock);
+
+	while (!stop_worker) {
+		/* No frames arrive and nothing decays while disabled, so
+		 * sleep until woken up instead of ticking at the render rate */
+		if (enabled)
+			cond.wait_for(guard, render_period);
+		else
+			cond.wait(guard);
+
+		if (stop_worker)
+			break;
+
+		if (geom_changed || clear_requested) {
+			geom = pending_geom;
+			geom_changed = false;
+			clear_requested = false;
+			resetHistograms();
+		}
+
+		while (!ready_frames.empty()) {
+			unsigned int idx = ready_frames.front();
+			ready_frames.pop_front();
+
+			guard.unlock();
+			accumulate(frames[idx]);
+			guard.lock();
+
+			free_frames.push_back(idx);
+
+			if (geom_changed || clear_requested)
+				break;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		if (!enabled || now - last_render < render_period)
+			continue;
+
+		double elapsed = std::chrono::duration<double>(
+				now - last_render).count();
+		last_render = now;
+
+		guard.unlock();
+		applyDecay(elapsed);
+
+		if (dirty) {
+			dirty = false;
+			Q_EMIT imageReady(render());
+		}
+		guard.lock();
+	}
+}
+
+/*
+ * PersistencePlotItem
+ */
+
+PersistencePlotItem::PersistencePlotItem() :
+	QwtPlotItem(QwtText("Persistence"))
+{
+	setItemAttribute(QwtPlotItem::AutoScale, false);
+	setItemAttribute(QwtPlotItem::Legend, false);
+
+	/* Above the grid, below the curves */
+	setZ(15);
+}
+
+void PersistencePlotItem::setImage(const QImage& image)
+{
+	d_image = image;
+}
+
+void PersistencePlotItem::clearImage()
+{
+	d_image = QImage();
+}
+
+int PersistencePlotItem::rtti() const
+{
+	return Rtti_PersistenceItem;
+}
+
+void PersistencePlotItem::draw(QPainter *painter, const QwtScaleMap&,
+		const QwtScaleMap&, const QRectF& canvasRect) const
+{
+	if (d_image.isNull())
+		return;
+
+	painter->drawImage(canvasRect, d_image);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PERSISTENCE_ACCUMULATOR_HPP
+#define PERSISTENCE_ACCUMULATOR_HPP
+
+#include <QColor>
+#include <QImage>
+#include <QObject>
+
+#include <qwt_plot_item.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace adiscope {
+
+	/*
+	 * Digital phosphor for the time domain plot.
+	 *
+	 * Frames are pushed straight from the scope sink, rasterized into a
+	 * per-channel hit-count histogram at canvas resolution on a worker
+	 * thread, decayed over time and periodically turned into a color
+	 * mapped image that is drawn under the curves.
+	 */
+	class PersistenceAccumulator : public QObject
+	{
+		Q_OBJECT
+
+	public:
+		struct geometry {
+			int width;
+			int height;
+			double sample_rate;
+			double start_time;	// time of the first sample
+			double x_min, x_max;	// visible time interval
+			std::vector<double> y_min, y_max;
+			std::vector<QColor> colors;
+			std::vector<bool> visible;
+
+			bool operator==(const geometry& other) const;
+		};
+
+		explicit PersistenceAccumulator(QObject *parent = nullptr);
+		~PersistenceAccumulator();
+
+		void setEnabled(bool en);
+		bool isEnabled() const;
+
+		void setGeometry(const geometry& geom);
+
+		/* Time constant of the exponential decay, in seconds.
+		 * A value of 0 means infinite persistence. */
+		void setDecay(double seconds);
+		double decay() const;
+
+		void clear();
+
+		/* Can be called from any thread. Returns false when the frame
+		 * was dropped because the worker is lagging behind. The
+		 * buffers are the plot curves starting at first_channel. */
+		bool pushFrame(const std::vector<float *>& buffers, int offset,
+				int size, unsigned int first_channel = 0);
+
+		unsigned long long droppedFrames() const;
+		unsigned long long accumulatedFrames() const;
+
+	Q_SIGNALS:
+		void imageReady(QImage image);
+
+	private:
+		struct frame {
+			std::vector<float> data;
+			unsigned int nb_channels;
+			unsigned int first_channel;
+			int size;
+		};
+
+		void run();
+		void resetHistograms();
+		void accumulate(const frame& f);
+		void applyDecay(double elapsed);
+		QImage render() const;
+
+		static void rasterize(const float *in, int size,
+				float x0, float dx, float y0, float dy,
+				int width, int height, float *hist,
+				float *px, float *py);
+
+		static const unsigned int nb_frames = 8;
+
+		mutable std::mutex lock;
+		std::condition_variable cond;
+		std::thread worker;
+		bool stop_worker;
+		std::atomic<bool> enabled;
+
+		std::vector<frame> frames;
+		std::deque<unsigned int> free_frames, ready_frames;
+
+		geometry pending_geom;
+		bool geom_changed;
+		bool clear_requested;
+		double decay_time;
+
+		/* Owned by the worker thread */
+		geometry geom;
+		std::vector< std::vector<float> > hists;
+		std::vector<float> px, py;
+		bool dirty;
+		std::chrono::steady_clock::time_point last_render;
+
+		std::atomic<unsigned long long> dropped;
+		std::atomic<unsigned long long> accumulated;
+	};
+
+	class PersistencePlotItem : public QwtPlotItem
+	{
+	public:
+		PersistencePlotItem();
+
+		void setImage(const QImage& image);
+		void clearImage();
+
+		virtual int rtti() const;
+		virtual void draw(QPainter *painter, const QwtScaleMap& xMap,
+				const QwtScaleMap& yMap,
+				const QRectF& canvasRect) const;
+
+		static const int Rtti_PersistenceItem =
+			QwtPlotItem::Rtti_PlotUserItem + 10;
+
+	private:
+		QImage d_image;
+	};
+}
+
+#endif /* PERSISTENCE_ACCUMULATOR_HPP */
@@ -19,6 +19,7 @@
 
 #include "dynamicWidget.hpp"
 #include "power_controller.hpp"
+#include "iio_attr_cache.hpp"
 #include "filter.hpp"
 
 #include "ui_powercontrol.h"
@@ -49,15 +50,19 @@ PowerController::PowerController(struct iio_context *ctx,
 	if (!ch1w || !ch2w || !ch1r || !ch2r)
 		throw std::runtime_error("Unable to find channels\n");
 
+	attrs = IioAttrCache::get_instance(ctx);
+
 	/* Power down DACs by default */
-	iio_channel_attr_write_bool(ch1w, "powerdown", true);
-	iio_channel_attr_write_bool(ch2w, "powerdown", true);
+	attrs->writeBool(ch1w, "powerdown", true);
+	attrs->writeBool(ch2w, "powerdown", true);
 
 	/* Set the default values */
-	iio_channel_attr_write_longlong(ch1w, "raw", 0LL);
-	iio_channel_attr_write_longlong(ch2w, "raw", 0LL);
+	attrs->writeLongLong(ch1w, "raw", 0LL);
+	attrs->writeLongLong(ch2w, "raw", 0LL);
 
 	connect(&this->timer, SIGNAL(timeout()), this, SLOT(update_lcd()));
+	connect(&lcd_watcher, SIGNAL(finished()),
+			this, SLOT(lcd_values_read()));
 
 	connect(ui->dac1, SIGNAL(toggled(bool)), this,
 			SLOT(dac1_set_enabled(bool)));
@@ -82,9 +87,11 @@ PowerController::PowerController(struct iio_context *ctx,
 
 PowerController::~PowerController()
 {
-	/* Power down DACs */
-	iio_channel_attr_write_bool(ch1w, "powerdown", true);
-	iio_channel_attr_write_bool(ch2w, "powerdown", true);
+	/* Power down DACs, after the changes still on their way */
+	lcd_watcher.waitForFinished();
+	attrs->waitForAsync();
+	attrs->writeBool(ch1w, "powerdown", true);
+	attrs->writeBool(ch2w, "powerdown", true);
 
 	api->save(*settings);
 	delete api;
@@ -106,7 +113,7 @@ void PowerController::dac1_set_value(double value)
 {
 	long long val = value * 4095.0 / (5.02 * 1.2);
 
-	iio_channel_attr_write_longlong(ch1w, "raw", val);
+	attrs->writeAsync(ch1w, "raw", std::to_string(val));
 
 	if (in_sync) {
 		value = -value * ui->trackingRatio->value() / 100.0;
@@ -119,12 +126,12 @@ void PowerController::dac2_set_value(double value)
 {
 	long long val = value * 4095.0 / (-5.1 * 1.2);
 
-	iio_channel_attr_write_longlong(ch2w, "raw", val);
+	attrs->writeAsync(ch2w, "raw", std::to_string(val));
 }
 
 void PowerController::dac1_set_enabled(bool enabled)
 {
-	iio_channel_attr_write_bool(ch1w, "powerdown", !enabled);
+	attrs->writeAsync(ch1w, "powerdown", enabled ? "0" : "1");
 
 	if (in_sync)
 		dac2_set_enabled(enabled);
@@ -139,7 +146,7 @@ void PowerController::dac1_set_enabled(bool enabled)
 
 void PowerController::dac2_set_enabled(bool enabled)
 {
-	iio_channel_attr_write_bool(ch2w, "powerdown", !enabled);
+	attrs->writeAsync(ch2w, "powerdown", enabled ? "0" : "1");
 
 	if (enabled)
 		run_button->setChecked(true);
@@ -170,10 +177,30 @@ void PowerController::ratioChanged(int percent)
 
 void PowerController::update_lcd()
 {
-	long long val1 = 0, val2 = 0;
+	/* The readback is measured, so it bypasses the cache. It is read
+	 * in the background, after the writes queued before it. */
+	auto cache = attrs;
+	struct iio_channel *r1 = ch1r, *r2 = ch2r;
+
+	/* Polled again once these values are in */
+	timer.stop();
 
-	iio_channel_attr_read_longlong(ch1r, "raw", &val1);
-	iio_channel_attr_read_longlong(ch2r, "raw", &val2);
+	lcd_watcher.setFuture(attrs->async([cache, r1, r2]() {
+		QPair<long long, long long> values(0, 0);
+
+		cache->invalidate(r1, "raw");
+		cache->invalidate(r2, "raw");
+		cache->readLongLong(r1, "raw", values.first);
+		cache->readLongLong(r2, "raw", values.second);
+
+		return values;
+	}));
+}
+
+void PowerController::lcd_values_read()
+{
+	const QPair<long long, long long> values = lcd_watcher.result();
+	long long val1 = values.first, val2 = values.second;
 
 	double value1 = (double) val1 * 6.4 / 4095.0;
 	ui->lcd1->display(value1);
@@ -183,7 +210,8 @@ void PowerController::update_lcd()
 	ui->lcd2->display(value2);
 	ui->scale_dac2->setValue(value2);
 
-	timer.start(TIMER_TIMEOUT_MS);
+	if (isVisible())
+		timer.start(TIMER_TIMEOUT_MS);
 }
 
 void PowerController::startStop(bool start)
@@ -20,9 +20,13 @@
 #ifndef POWER_CONTROLLER_HPP
 #define POWER_CONTROLLER_HPP
 
+#include <QFutureWatcher>
+#include <QPair>
 #include <QPushButton>
 #include <QTimer>
 
+#include <memory>
+
 #include "apiObject.hpp"
 #include "spinbox_a.hpp"
 #include "tool.hpp"
@@ -41,6 +45,7 @@ class QShowEvent;
 class QHideEvent;
 
 namespace adiscope {
+	class IioAttrCache;
 	class PowerController_API;
 
 	class PowerController : public Tool
@@ -67,10 +72,13 @@ namespace adiscope {
 	private Q_SLOTS:
 		void startStop(bool start);
 		void ratioChanged(int percent);
+		void lcd_values_read();
 
 	private:
 		Ui::PowerController *ui;
+		std::shared_ptr<IioAttrCache> attrs;
 		struct iio_channel *ch1w, *ch2w, *ch1r, *ch2r;
+		QFutureWatcher<QPair<long long, long long> > lcd_watcher;
 		QTimer timer;
 		bool in_sync;
 
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include <QByteArray>
+
+#include "capturefile.hpp"
+
+using std::make_pair;
+using std::string;
+using std::vector;
+
+namespace pv {
+namespace capturefile {
+
+const char Magic[8] = {'S', 'C', 'O', 'P', 'Y', 'C', 'A', 'P'};
+const uint32_t Version = 1;
+const char *const Extension = "scap";
+const size_t ChunkHeaderSize = 16;
+
+namespace {
+
+void append_u32(string &out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		out.push_back((char)(value >> (8 * i)));
+}
+
+void append_u64(string &out, uint64_t value)
+{
+	for (int i = 0; i < 8; i++)
+		out.push_back((char)(value >> (8 * i)));
+}
+
+void append_name(string &out, const string &name)
+{
+	append_u32(out, name.size());
+	out.append(name);
+}
+
+/// Reads from a bounded buffer, failing once it runs out.
+class Reader
+{
+public:
+	Reader(const uint8_t *data, size_t size) :
+		data_(data),
+		size_(size),
+		pos_(0)
+	{
+	}
+
+	size_t pos() const { return pos_; }
+
+	bool u32(uint32_t &value)
+	{
+		uint64_t v;
+		if (!read(v, 4))
+			return false;
+		value = v;
+		return true;
+	}
+
+	bool u64(uint64_t &value)
+	{
+		return read(value, 8);
+	}
+
+	bool name(string &value)
+	{
+		uint32_t length;
+		if (!u32(length) || length > size_ - pos_)
+			return false;
+		value.assign((const char*)data_ + pos_, length);
+		pos_ += length;
+		return true;
+	}
+
+private:
+	bool read(uint64_t &value, unsigned int bytes)
+	{
+		if (bytes > size_ - pos_)
+			return false;
+		value = 0;
+		for (unsigned int i = 0; i < bytes; i++)
+			value |= (uint64_t)data_[pos_ + i] << (8 * i);
+		pos_ += bytes;
+		return true;
+	}
+
+	const uint8_t *const data_;
+	const size_t size_;
+	size_t pos_;
+};
+
+}
+
+string encode_header(const Header &header)
+{
+	string out(Magic, sizeof(Magic));
+	append_u32(out, Version);
+	append_u32(out, header.flags);
+	append_u64(out, header.samplerate);
+	append_u64(out, header.sample_count);
+	append_u32(out, header.logic_unit_size);
+	append_u32(out, header.logic_channels.size());
+	append_u32(out, header.analog_channels.size());
+
+	for (const auto &channel : header.logic_channels) {
+		append_u32(out, channel.first);
+		append_name(out, channel.second);
+	}
+
+	for (const string &name : header.analog_channels)
+		append_name(out, name);
+
+	return out;
+}
+
+size_t decode_header(const uint8_t *data, size_t size, Header &header)
+{
+	if (size < sizeof(Magic) || memcmp(data, Magic, sizeof(Magic)))
+		return 0;
+
+	Reader reader(data + sizeof(Magic), size - sizeof(Magic));
+
+	uint32_t version, logic_count, analog_count;
+	if (!reader.u32(version) || version != Version ||
+			!reader.u32(header.flags) ||
+			!reader.u64(header.samplerate) ||
+			!reader.u64(header.sample_count) ||
+			!reader.u32(header.logic_unit_size) ||
+			!reader.u32(logic_count) ||
+			!reader.u32(analog_count))
+		return 0;
+
+	if (header.logic_unit_size > 8)
+		return 0;
+
+	header.logic_channels.clear();
+	for (uint32_t i = 0; i < logic_count; i++) {
+		uint32_t index;
+		string name;
+		if (!reader.u32(index) || !reader.name(name))
+			return 0;
+		header.logic_channels.push_back(make_pair(index, name));
+	}
+
+	header.analog_channels.clear();
+	for (uint32_t i = 0; i < analog_count; i++) {
+		string name;
+		if (!reader.name(name))
+			return 0;
+		header.analog_channels.push_back(name);
+	}
+
+	return sizeof(Magic) + reader.pos();
+}
+
+string encode_chunk(const Header &header, uint64_t start, uint32_t length,
+	const uint8_t *logic, const vector<const float*> &analog)
+{
+	assert(analog.size() == header.analog_channels.size());
+
+	const size_t logic_size = logic ?
+		(size_t)length * header.logic_unit_size : 0;
+	const size_t analog_size = (size_t)length * sizeof(float);
+
+	string payload;
+	payload.reserve(logic_size + analog.size() * analog_size);
+	if (logic)
+		payload.append((const char*)logic, logic_size);
+	for (const float *samples : analog)
+		payload.append((const char*)samples, analog_size);
+
+	if (header.flags & Compressed) {
+		const QByteArray packed = qCompress(
+			(const uchar*)payload.data(), payload.size());
+		payload.assign(packed.constData(), packed.size());
+	}
+
+	string out;
+	out.reserve(ChunkHeaderSize + payload.size());
+	append_u64(out, start);
+	append_u32(out, length);
+	append_u32(out, payload.size());
+	out.append(payload);
+
+	return out;
+}
+
+bool decode_chunk_header(const uint8_t *data, size_t size,
+	uint64_t &start, uint32_t &length, uint32_t &payload_size)
+{
+	Reader reader(data, size);
+	return reader.u64(start) && reader.u32(length) &&
+		reader.u32(payload_size);
+}
+
+size_t payload_size(const Header &header, uint32_t length)
+{
+	return (size_t)length * (header.logic_unit_size +
+		header.analog_channels.size() * sizeof(float));
+}
+
+} // namespace capturefile
+} // namespace pv
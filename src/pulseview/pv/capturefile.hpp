@@ -0,0 +1,107 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PULSEVIEW_PV_CAPTUREFILE_HPP
+#define PULSEVIEW_PV_CAPTUREFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pv {
+
+/**
+ * The native binary capture format.
+ *
+ * A file is a header followed by chunks of consecutive samples, so it
+ * can be written by encoding the chunks in parallel and read back one
+ * chunk at a time. Integers are little-endian.
+ *
+ *   header: "SCOPYCAP", u32 version, u32 flags, u64 samplerate,
+ *           u64 sample count, u32 logic unit size, u32 logic channel
+ *           count, u32 analog channel count, then the logic channels as
+ *           u32 index and name, and the analog channels as name. Names
+ *           are u32 length followed by UTF-8.
+ *   chunk:  u64 first sample, u32 sample count, u32 payload size and
+ *           the payload: the packed logic samples followed by the float
+ *           samples of every analog channel. With the Compressed flag
+ *           the payload is qCompress()ed.
+ */
+namespace capturefile {
+
+extern const char Magic[8];
+extern const uint32_t Version;
+
+/// The extension of native capture files, without the dot.
+extern const char *const Extension;
+
+enum Flags {
+	Compressed = 1
+};
+
+struct Header
+{
+	uint32_t flags;
+	uint64_t samplerate;
+	uint64_t sample_count;
+	uint32_t logic_unit_size;
+	std::vector< std::pair<uint32_t, std::string> > logic_channels;
+	std::vector<std::string> analog_channels;
+};
+
+/// The size of the fixed part of a chunk, before its payload.
+extern const size_t ChunkHeaderSize;
+
+std::string encode_header(const Header &header);
+
+/**
+ * Decodes the header at the start of a file.
+ * @return the size of the header, or 0 if it is not a valid header of
+ * a version this build can read.
+ */
+size_t decode_header(const uint8_t *data, size_t size, Header &header);
+
+/**
+ * Encodes one chunk.
+ * @param logic The packed logic samples, or nullptr without logic
+ * channels.
+ * @param analog The samples of every analog channel of the header.
+ */
+std::string encode_chunk(const Header &header, uint64_t start,
+	uint32_t length, const uint8_t *logic,
+	const std::vector<const float*> &analog);
+
+/**
+ * Decodes the fixed part of a chunk.
+ * @return false if fewer than ChunkHeaderSize bytes are left.
+ */
+bool decode_chunk_header(const uint8_t *data, size_t size,
+	uint64_t &start, uint32_t &length, uint32_t &payload_size);
+
+/**
+ * Gets the size of the payload of a chunk once uncompressed.
+ */
+size_t payload_size(const Header &header, uint32_t length);
+
+} // namespace capturefile
+} // namespace pv
+
+#endif // PULSEVIEW_PV_CAPTUREFILE_HPP
@@ -18,12 +18,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
  */
 
-extern "C" {
-#include <libsigrokdecode/libsigrokdecode.h>
-}
-
 #include <cassert>
-#include <vector>
 
 #include "annotation.hpp"
 
@@ -31,22 +26,13 @@ namespace pv {
 namespace data {
 namespace decode {
 
-Annotation::Annotation(const srd_proto_data *const pdata) :
-	start_sample_(pdata->start_sample),
-	end_sample_(pdata->end_sample)
+Annotation::Annotation(uint64_t start_sample, uint64_t end_sample,
+	const AnnotationLabels *labels) :
+	start_sample_(start_sample),
+	end_sample_(end_sample),
+	labels_(labels)
 {
-	assert(pdata);
-	const srd_proto_data_annotation *const pda =
-		(const srd_proto_data_annotation*)pdata->data;
-	assert(pda);
-
-	format_ = pda->ann_class;
-
-	const char *const *annotations = (char**)pda->ann_text;
-	while (*annotations) {
-		annotations_.push_back(QString::fromUtf8(*annotations));
-		annotations++;
-	}
+	assert(labels);
 }
 
 uint64_t Annotation::start_sample() const
@@ -61,12 +47,12 @@ uint64_t Annotation::end_sample() const
 
 int Annotation::format() const
 {
-	return format_;
+	return labels_->format;
 }
 
 const std::vector<QString>& Annotation::annotations() const
 {
-	return annotations_;
+	return labels_->texts;
 }
 
 } // namespace decode
@@ -22,19 +22,34 @@
 #define PULSEVIEW_PV_VIEW_DECODE_ANNOTATION_HPP
 
 #include <stdint.h>
+#include <vector>
 
 #include <QString>
 
-struct srd_proto_data;
-
 namespace pv {
 namespace data {
 namespace decode {
 
+/**
+ * Class and labels of an annotation, shared by every annotation of a
+ * decoder that carries the same ones.
+ */
+struct AnnotationLabels
+{
+	int format;
+	std::vector<QString> texts;
+};
+
+/**
+ * Lightweight view of one stored annotation. The labels are owned by the
+ * LabelTable of the decoder, which outlives the views handed out while
+ * the decoder stack is not cleared.
+ */
 class Annotation
 {
 public:
-	Annotation(const srd_proto_data *const pdata);
+	Annotation(uint64_t start_sample, uint64_t end_sample,
+		const AnnotationLabels *labels);
 
 	uint64_t start_sample() const;
 	uint64_t end_sample() const;
@@ -44,8 +59,7 @@ public:
 private:
 	uint64_t start_sample_;
 	uint64_t end_sample_;
-	int format_;
-	std::vector<QString> annotations_;
+	const AnnotationLabels *labels_;
 };
 
 } // namespace decode
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+extern "C" {
+#include <libsigrokdecode/libsigrokdecode.h>
+}
+
+#include <cassert>
+#include <cstring>
+
+#include "labeltable.hpp"
+
+namespace pv {
+namespace data {
+namespace decode {
+
+LabelTable::LabelTable()
+{
+}
+
+uint32_t LabelTable::intern(const srd_proto_data_annotation *pda)
+{
+	assert(pda);
+
+	// The key is the class followed by the NUL separated raw labels,
+	// so a label set is only decoded from UTF-8 the first time it is seen
+	key_.assign((const char*)&pda->ann_class, sizeof(pda->ann_class));
+	for (char **text = pda->ann_text; *text; text++)
+		key_.append(*text, strlen(*text) + 1);
+
+	const auto iter = ids_.find(key_);
+	if (iter != ids_.end())
+		return (*iter).second;
+
+	AnnotationLabels entry;
+	entry.format = pda->ann_class;
+	for (char **text = pda->ann_text; *text; text++)
+		entry.texts.push_back(QString::fromUtf8(*text));
+
+	const uint32_t id = entries_.size();
+	entries_.push_back(entry);
+	ids_[key_] = id;
+
+	return id;
+}
+
+const AnnotationLabels& LabelTable::labels(uint32_t id) const
+{
+	assert(id < entries_.size());
+	return entries_[id];
+}
+
+size_t LabelTable::size() const
+{
+	return entries_.size();
+}
+
+} // namespace decode
+} // namespace data
+} // namespace pv
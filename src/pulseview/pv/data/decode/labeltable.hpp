@@ -0,0 +1,65 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_DECODE_LABELTABLE_HPP
+#define PULSEVIEW_PV_DATA_DECODE_LABELTABLE_HPP
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "annotation.hpp"
+
+struct srd_proto_data_annotation;
+
+namespace pv {
+namespace data {
+namespace decode {
+
+/**
+ * Interns the labels of the annotations emitted by one decoder.
+ *
+ * Decoders emit the same few label sets over and over ("Start bit",
+ * hex bytes, ...), so every distinct (class, labels) pair is converted
+ * and stored once, and annotations only keep its 32-bit id. Entries are
+ * never moved, so references to them stay valid until the table is
+ * destroyed.
+ */
+class LabelTable
+{
+public:
+	LabelTable();
+
+	uint32_t intern(const srd_proto_data_annotation *pda);
+
+	const AnnotationLabels& labels(uint32_t id) const;
+
+	size_t size() const;
+
+private:
+	std::unordered_map<std::string, uint32_t> ids_;
+	std::deque<AnnotationLabels> entries_;
+	std::string key_;
+};
+
+} // namespace decode
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_DECODE_LABELTABLE_HPP
@@ -0,0 +1,915 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+#include <libsigrokdecode/libsigrokdecode.h>
+
+#include "nativedecoder.hpp"
+#include "decoder.hpp"
+
+#include "../logicsegment.hpp"
+#include "../../view/logicsignal.hpp"
+
+using std::initializer_list;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace pv {
+namespace data {
+namespace decode {
+
+namespace {
+
+/**
+ * Reads the channels and options of a decoder. Options the user did not
+ * set take the default declared by the Python decoder.
+ */
+class Config
+{
+public:
+	explicit Config(const Decoder &decoder) :
+		decoder_(decoder)
+	{
+	}
+
+	/**
+	 * Gets the bit of the samples that carries a channel, or -1 if the
+	 * channel is not assigned.
+	 */
+	int channel(const char *id) const
+	{
+		for (const auto &c : decoder_.channels())
+			if (c.second && !strcmp(c.first->id, id))
+				return c.second->channel()->index();
+		return -1;
+	}
+
+	/**
+	 * Returns true if every option set by the user is one of @c known.
+	 */
+	bool only(initializer_list<const char*> known) const
+	{
+		for (const auto &option : decoder_.options()) {
+			bool found = false;
+			for (const char *id : known)
+				found = found || option.first == id;
+			if (!found)
+				return false;
+		}
+
+		return true;
+	}
+
+	string str(const char *id) const
+	{
+		GVariant *const v = value(id);
+		if (v && g_variant_is_of_type(v, G_VARIANT_TYPE_STRING))
+			return g_variant_get_string(v, nullptr);
+		return string();
+	}
+
+	double number(const char *id) const
+	{
+		GVariant *const v = value(id);
+		if (!v)
+			return NAN;
+		if (g_variant_is_of_type(v, G_VARIANT_TYPE_INT64))
+			return g_variant_get_int64(v);
+		if (g_variant_is_of_type(v, G_VARIANT_TYPE_DOUBLE))
+			return g_variant_get_double(v);
+		if (g_variant_is_of_type(v, G_VARIANT_TYPE_STRING)) {
+			const char *const s = g_variant_get_string(v, nullptr);
+			char *end;
+			const double d = strtod(s, &end);
+			return (end != s && !*end) ? d : NAN;
+		}
+		return NAN;
+	}
+
+private:
+	GVariant* value(const char *id) const
+	{
+		const auto iter = decoder_.options().find(id);
+		if (iter != decoder_.options().end())
+			return (*iter).second;
+
+		for (const GSList *l = decoder_.decoder()->options; l;
+				l = l->next) {
+			const srd_decoder_option *const opt =
+				(const srd_decoder_option*)l->data;
+			if (!strcmp(opt->id, id))
+				return opt->def;
+		}
+
+		return nullptr;
+	}
+
+	const Decoder &decoder_;
+};
+
+inline bool level(uint64_t sample, int bit)
+{
+	return (sample >> bit) & 1;
+}
+
+/**
+ * Asynchronous serial, after the "uart" decoder: the lines are sampled
+ * in the middle of each bit and only the first stop bit is checked.
+ */
+class UartDecoder : public NativeDecoder
+{
+private:
+	enum { RX, TX };
+
+	enum Parity { ParityNone, ParityOdd, ParityEven, ParityZero,
+		ParityOne };
+
+	enum Format { FormatAscii, FormatDec, FormatHex, FormatOct,
+		FormatBin };
+
+	struct Line
+	{
+		int bit;
+		bool invert;
+		bool wait_idle;
+		uint64_t pos;
+	};
+
+public:
+	static unique_ptr<NativeDecoder> create(const Config &config,
+		double samplerate, AnnotationSink sink);
+
+	void decode(const LogicSegment &segment, uint64_t end);
+
+private:
+	explicit UartDecoder(AnnotationSink sink);
+
+	uint64_t sample_point(uint64_t frame_start, unsigned int bitnum) const;
+
+	void put_bit(uint64_t sample_point, int ann_class, const char *text0,
+		const char *text1 = nullptr, const char *text2 = nullptr);
+
+	void decode_line(const LogicSegment &segment, int rxtx, uint64_t end);
+
+	uint64_t decode_frame(const LogicSegment &segment, int rxtx,
+		uint64_t frame_start);
+
+	bool parity_ok(bool parity_bit, unsigned int ones) const;
+
+	void format_value(unsigned int value, char *text, size_t size) const;
+
+private:
+	double bit_width_;
+	unsigned int data_bits_;
+	Parity parity_;
+	bool check_parity_;
+	bool msb_first_;
+	Format format_;
+	Line lines_[2];
+};
+
+UartDecoder::UartDecoder(AnnotationSink sink) :
+	NativeDecoder(sink)
+{
+}
+
+unique_ptr<NativeDecoder> UartDecoder::create(const Config &config,
+	double samplerate, AnnotationSink sink)
+{
+	if (!config.only({"baudrate", "num_data_bits", "parity_type",
+			"parity_check", "num_stop_bits", "bit_order", "format",
+			"invert_rx", "invert_tx"}))
+		return nullptr;
+
+	unique_ptr<UartDecoder> d(new UartDecoder(sink));
+
+	const double baudrate = config.number("baudrate");
+	const double data_bits = config.number("num_data_bits");
+	if (!(baudrate > 0) || !(data_bits >= 1 && data_bits <= 16))
+		return nullptr;
+
+	d->bit_width_ = samplerate / baudrate;
+	d->data_bits_ = data_bits;
+	if (d->bit_width_ < 1)
+		return nullptr;
+
+	const string parity = config.str("parity_type");
+	if (parity == "none")
+		d->parity_ = ParityNone;
+	else if (parity == "odd")
+		d->parity_ = ParityOdd;
+	else if (parity == "even")
+		d->parity_ = ParityEven;
+	else if (parity == "zero")
+		d->parity_ = ParityZero;
+	else if (parity == "one")
+		d->parity_ = ParityOne;
+	else
+		return nullptr;
+
+	d->check_parity_ = config.str("parity_check") != "no";
+
+	const string bit_order = config.str("bit_order");
+	if (bit_order != "lsb-first" && bit_order != "msb-first")
+		return nullptr;
+	d->msb_first_ = bit_order == "msb-first";
+
+	const string format = config.str("format");
+	if (format == "ascii")
+		d->format_ = FormatAscii;
+	else if (format == "dec")
+		d->format_ = FormatDec;
+	else if (format == "hex")
+		d->format_ = FormatHex;
+	else if (format == "oct")
+		d->format_ = FormatOct;
+	else if (format == "bin")
+		d->format_ = FormatBin;
+	else
+		return nullptr;
+
+	const char *const channels[] = {"rx", "tx"};
+	const char *const inverts[] = {"invert_rx", "invert_tx"};
+	for (int rxtx = RX; rxtx <= TX; rxtx++) {
+		Line &line = d->lines_[rxtx];
+		line.bit = config.channel(channels[rxtx]);
+		line.invert = config.str(inverts[rxtx]) == "yes";
+		line.wait_idle = false;
+		line.pos = 0;
+	}
+
+	if (d->lines_[RX].bit < 0 && d->lines_[TX].bit < 0)
+		return nullptr;
+
+	return unique_ptr<NativeDecoder>(d.release());
+}
+
+void UartDecoder::decode(const LogicSegment &segment, uint64_t end)
+{
+	for (int rxtx = RX; rxtx <= TX; rxtx++)
+		if (lines_[rxtx].bit >= 0)
+			decode_line(segment, rxtx, end);
+}
+
+uint64_t UartDecoder::sample_point(uint64_t frame_start,
+	unsigned int bitnum) const
+{
+	// The samples of a bit are 0 .. bit_width - 1, the sample point
+	// is the first one at or after the middle
+	return (uint64_t)ceil(frame_start + (bit_width_ - 1) / 2.0 +
+		bitnum * bit_width_);
+}
+
+void UartDecoder::put_bit(uint64_t sample_point, int ann_class,
+	const char *text0, const char *text1, const char *text2)
+{
+	const double half_bit = bit_width_ / 2.0;
+	put(sample_point - (uint64_t)floor(half_bit),
+		sample_point + (uint64_t)ceil(half_bit),
+		ann_class, text0, text1, text2);
+}
+
+void UartDecoder::decode_line(const LogicSegment &segment, int rxtx,
+	uint64_t end)
+{
+	Line &line = lines_[rxtx];
+	const uint64_t mask = 1ULL << line.bit;
+	const uint64_t idle = line.invert ? 0 : mask;
+	const unsigned int last_bit = 1 + data_bits_ +
+		(parity_ != ParityNone ? 1 : 0);
+
+	while (line.pos < end) {
+		// A start bit begins with a falling edge, so after a frame
+		// the line has to return to idle first
+		if (line.wait_idle) {
+			line.pos = segment.find_change(line.pos, end,
+				mask, idle ^ mask);
+			if (line.pos >= end)
+				break;
+			line.wait_idle = false;
+		}
+
+		const uint64_t frame_start = segment.find_change(
+			line.pos, end, mask, idle);
+		if (frame_start >= end) {
+			line.pos = end;
+			break;
+		}
+
+		// Leave the frame for the next call until all of it arrived
+		if (sample_point(frame_start, last_bit) >= end) {
+			line.pos = frame_start;
+			break;
+		}
+
+		line.pos = decode_frame(segment, rxtx, frame_start);
+		line.wait_idle = true;
+	}
+}
+
+uint64_t UartDecoder::decode_frame(const LogicSegment &segment, int rxtx,
+	uint64_t frame_start)
+{
+	const Line &line = lines_[rxtx];
+	const auto bit = [&](uint64_t sample) {
+		return level(segment.get_sample_value(sample), line.bit) !=
+			line.invert;
+	};
+
+	uint64_t sp = sample_point(frame_start, 0);
+	if (bit(sp)) {
+		put_bit(sp, rxtx + 10, "Frame error", "Frame err", "FE");
+		return sp;
+	}
+	put_bit(sp, rxtx + 2, "Start bit", "Start", "S");
+
+	const uint64_t data_start = sample_point(frame_start, 1);
+	unsigned int value = 0, ones = 0;
+	for (unsigned int i = 0; i < data_bits_; i++) {
+		sp = sample_point(frame_start, 1 + i);
+		const bool b = bit(sp);
+		put_bit(sp, rxtx + 12, b ? "1" : "0");
+
+		if (b) {
+			ones++;
+			value |= 1U << (msb_first_ ? data_bits_ - 1 - i : i);
+		}
+	}
+
+	char text[24];
+	format_value(value, text, sizeof(text));
+	put(data_start - (uint64_t)floor(bit_width_ / 2.0),
+		sp + (uint64_t)ceil(bit_width_ / 2.0), rxtx, text);
+
+	unsigned int bitnum = 1 + data_bits_;
+	if (parity_ != ParityNone) {
+		sp = sample_point(frame_start, bitnum++);
+		if (parity_ok(bit(sp), ones))
+			put_bit(sp, rxtx + 4, "Parity bit", "Parity", "P");
+		else
+			put_bit(sp, rxtx + 6, "Parity error", "Parity err",
+				"PE");
+	}
+
+	sp = sample_point(frame_start, bitnum);
+	if (!bit(sp))
+		put_bit(sp, rxtx + 10, "Frame error", "Frame err", "FE");
+	put_bit(sp, rxtx + 8, "Stop bit", "Stop", "T");
+
+	return sp;
+}
+
+bool UartDecoder::parity_ok(bool parity_bit, unsigned int ones) const
+{
+	if (!check_parity_)
+		return true;
+
+	switch (parity_) {
+	case ParityZero:
+		return !parity_bit;
+	case ParityOne:
+		return parity_bit;
+	case ParityOdd:
+		return (ones + parity_bit) % 2 == 1;
+	case ParityEven:
+		return (ones + parity_bit) % 2 == 0;
+	default:
+		return true;
+	}
+}
+
+void UartDecoder::format_value(unsigned int value, char *text,
+	size_t size) const
+{
+	switch (format_) {
+	case FormatAscii:
+		if (value >= 32 && value <= 126)
+			snprintf(text, size, "%c", value);
+		else
+			snprintf(text, size, data_bits_ <= 8 ?
+				"[%02X]" : "[%03X]", value);
+		break;
+	case FormatDec:
+		snprintf(text, size, "%u", value);
+		break;
+	case FormatHex:
+		snprintf(text, size, "%0*X", (int)(data_bits_ + 3) / 4, value);
+		break;
+	case FormatOct:
+		snprintf(text, size, "%0*o", (int)(data_bits_ + 2) / 3, value);
+		break;
+	case FormatBin:
+		for (unsigned int i = 0; i < data_bits_; i++)
+			text[i] = (value >> (data_bits_ - 1 - i)) & 1 ? '1' : '0';
+		text[data_bits_] = '\0';
+		break;
+	}
+}
+
+/**
+ * Serial Peripheral Interface, after the "spi" decoder: the data lines
+ * are sampled on the clock edge selected by the mode, and only while
+ * CS# is asserted if it is assigned.
+ */
+class SpiDecoder : public NativeDecoder
+{
+private:
+	struct Bit
+	{
+		bool miso, mosi;
+		uint64_t start, end;
+	};
+
+public:
+	static unique_ptr<NativeDecoder> create(const Config &config,
+		AnnotationSink sink);
+
+	void decode(const LogicSegment &segment, uint64_t end);
+
+private:
+	explicit SpiDecoder(AnnotationSink sink);
+
+	bool cs_asserted(uint64_t sample) const;
+
+	void handle_bit(uint64_t sample_num, uint64_t sample);
+
+	void put_data();
+
+private:
+	int clk_, miso_, mosi_, cs_;
+	bool cs_active_high_;
+	bool sample_rising_;
+	bool msb_first_;
+	unsigned int wordsize_;
+
+	uint64_t pos_;
+	bool old_clk_, old_cs_;
+
+	vector<Bit> bits_;
+	uint64_t miso_data_, mosi_data_;
+};
+
+SpiDecoder::SpiDecoder(AnnotationSink sink) :
+	NativeDecoder(sink),
+	pos_(0),
+	old_clk_(false),
+	old_cs_(false),
+	miso_data_(0),
+	mosi_data_(0)
+{
+}
+
+unique_ptr<NativeDecoder> SpiDecoder::create(const Config &config,
+	AnnotationSink sink)
+{
+	if (!config.only({"cs_polarity", "cpol", "cpha", "bitorder",
+			"wordsize"}))
+		return nullptr;
+
+	unique_ptr<SpiDecoder> d(new SpiDecoder(sink));
+
+	d->clk_ = config.channel("clk");
+	d->miso_ = config.channel("miso");
+	d->mosi_ = config.channel("mosi");
+	d->cs_ = config.channel("cs");
+	if (d->clk_ < 0 || (d->miso_ < 0 && d->mosi_ < 0))
+		return nullptr;
+
+	const string cs_polarity = config.str("cs_polarity");
+	if (cs_polarity != "active-low" && cs_polarity != "active-high")
+		return nullptr;
+	d->cs_active_high_ = cs_polarity == "active-high";
+
+	const double cpol = config.number("cpol");
+	const double cpha = config.number("cpha");
+	if ((cpol != 0 && cpol != 1) || (cpha != 0 && cpha != 1))
+		return nullptr;
+
+	// Modes 0 and 3 sample on the rising edge, modes 1 and 2 on the
+	// falling edge
+	d->sample_rising_ = cpol == cpha;
+
+	const string bitorder = config.str("bitorder");
+	if (bitorder != "msb-first" && bitorder != "lsb-first")
+		return nullptr;
+	d->msb_first_ = bitorder == "msb-first";
+
+	const double wordsize = config.number("wordsize");
+	if (!(wordsize >= 1 && wordsize <= 64))
+		return nullptr;
+	d->wordsize_ = wordsize;
+
+	d->bits_.reserve(d->wordsize_);
+
+	return unique_ptr<NativeDecoder>(d.release());
+}
+
+bool SpiDecoder::cs_asserted(uint64_t sample) const
+{
+	return cs_ < 0 || level(sample, cs_) == cs_active_high_;
+}
+
+void SpiDecoder::decode(const LogicSegment &segment, uint64_t end)
+{
+	const uint64_t clk_mask = 1ULL << clk_;
+	const uint64_t cs_mask = cs_ < 0 ? 0 : 1ULL << cs_;
+
+	if (pos_ == 0 && end > 0) {
+		// The clock has no previous level on the first sample, so
+		// it is taken as an edge
+		const uint64_t sample = segment.get_sample_value(0);
+		old_cs_ = cs_mask && level(sample, cs_);
+		if (cs_asserted(sample)) {
+			old_clk_ = level(sample, clk_);
+			if (old_clk_ == sample_rising_)
+				handle_bit(0, sample);
+		}
+		pos_ = 1;
+	}
+
+	while (pos_ < end) {
+		// Outside of a transfer only CS# can change anything; the
+		// clock level is kept from the last sample inside of one
+		const bool active = cs_asserted(old_cs_ ? cs_mask : 0);
+		const uint64_t mask = active ? (clk_mask | cs_mask) : cs_mask;
+
+		const uint64_t s = segment.find_change(pos_, end, mask,
+			(old_clk_ ? clk_mask : 0) | (old_cs_ ? cs_mask : 0));
+		if (s >= end) {
+			pos_ = end;
+			break;
+		}
+		pos_ = s + 1;
+
+		const uint64_t sample = segment.get_sample_value(s);
+
+		if (cs_mask && level(sample, cs_) != old_cs_) {
+			old_cs_ = level(sample, cs_);
+			bits_.clear();
+			miso_data_ = mosi_data_ = 0;
+		}
+
+		if (!cs_asserted(sample))
+			continue;
+
+		const bool clk = level(sample, clk_);
+		if (clk == old_clk_)
+			continue;
+		old_clk_ = clk;
+
+		if (clk == sample_rising_)
+			handle_bit(s, sample);
+	}
+}
+
+void SpiDecoder::handle_bit(uint64_t sample_num, uint64_t sample)
+{
+	const unsigned int bitcount = bits_.size();
+	const unsigned int shift = msb_first_ ?
+		wordsize_ - 1 - bitcount : bitcount;
+
+	Bit b;
+	b.miso = miso_ >= 0 && level(sample, miso_);
+	b.mosi = mosi_ >= 0 && level(sample, mosi_);
+	b.start = sample_num;
+
+	// Guess the end of the bit from the previous one until the next
+	// one arrives
+	b.end = sample_num;
+	if (bitcount > 0) {
+		b.end += sample_num - bits_.back().start;
+		bits_.back().end = sample_num;
+	}
+
+	miso_data_ |= (uint64_t)b.miso << shift;
+	mosi_data_ |= (uint64_t)b.mosi << shift;
+	bits_.push_back(b);
+
+	if (bits_.size() != wordsize_)
+		return;
+
+	put_data();
+
+	bits_.clear();
+	miso_data_ = mosi_data_ = 0;
+}
+
+void SpiDecoder::put_data()
+{
+	const uint64_t ss = bits_.front().start, es = bits_.back().end;
+
+	if (miso_ >= 0)
+		for (const Bit &b : bits_)
+			put(b.start, b.end, 2, b.miso ? "1" : "0");
+	if (mosi_ >= 0)
+		for (const Bit &b : bits_)
+			put(b.start, b.end, 3, b.mosi ? "1" : "0");
+
+	char text[24];
+	if (miso_ >= 0) {
+		snprintf(text, sizeof(text), "%02llX",
+			(unsigned long long)miso_data_);
+		put(ss, es, 0, text);
+	}
+	if (mosi_ >= 0) {
+		snprintf(text, sizeof(text), "%02llX",
+			(unsigned long long)mosi_data_);
+		put(ss, es, 1, text);
+	}
+}
+
+/**
+ * Inter-Integrated Circuit, after the "i2c" decoder.
+ */
+class I2cDecoder : public NativeDecoder
+{
+private:
+	enum State { FindStart, FindAddress, FindData, FindAck };
+
+	enum {
+		AnnStart, AnnRepeatStart, AnnStop, AnnAck, AnnNack, AnnBit,
+		AnnAddressRead, AnnAddressWrite, AnnDataRead, AnnDataWrite
+	};
+
+	struct Bit
+	{
+		bool value;
+		uint64_t start, end;
+	};
+
+public:
+	static unique_ptr<NativeDecoder> create(const Config &config,
+		AnnotationSink sink);
+
+	void decode(const LogicSegment &segment, uint64_t end);
+
+private:
+	explicit I2cDecoder(AnnotationSink sink);
+
+	void handle_start(uint64_t sample_num);
+	void handle_address_or_data(uint64_t sample_num, bool sda);
+	void handle_ack(uint64_t sample_num, bool sda);
+	void handle_stop(uint64_t sample_num);
+
+private:
+	int scl_, sda_;
+	bool shifted_;
+
+	uint64_t pos_;
+	bool old_scl_, old_sda_;
+
+	State state_;
+	bool repeat_start_;
+	bool write_;
+	unsigned int databyte_;
+	uint64_t bitwidth_;
+	vector<Bit> bits_;
+};
+
+I2cDecoder::I2cDecoder(AnnotationSink sink) :
+	NativeDecoder(sink),
+	pos_(0),
+	old_scl_(true),
+	old_sda_(true),
+	state_(FindStart),
+	repeat_start_(false),
+	write_(false),
+	databyte_(0),
+	bitwidth_(0)
+{
+}
+
+unique_ptr<NativeDecoder> I2cDecoder::create(const Config &config,
+	AnnotationSink sink)
+{
+	if (!config.only({"address_format"}))
+		return nullptr;
+
+	unique_ptr<I2cDecoder> d(new I2cDecoder(sink));
+
+	d->scl_ = config.channel("scl");
+	d->sda_ = config.channel("sda");
+	if (d->scl_ < 0 || d->sda_ < 0)
+		return nullptr;
+
+	const string address_format = config.str("address_format");
+	if (address_format != "shifted" && address_format != "unshifted")
+		return nullptr;
+	d->shifted_ = address_format == "shifted";
+
+	d->bits_.reserve(8);
+
+	return unique_ptr<NativeDecoder>(d.release());
+}
+
+void I2cDecoder::decode(const LogicSegment &segment, uint64_t end)
+{
+	const uint64_t scl_mask = 1ULL << scl_;
+	const uint64_t sda_mask = 1ULL << sda_;
+
+	while (pos_ < end) {
+		const uint64_t s = segment.find_change(pos_, end,
+			scl_mask | sda_mask, (old_scl_ ? scl_mask : 0) |
+			(old_sda_ ? sda_mask : 0));
+		if (s >= end) {
+			pos_ = end;
+			break;
+		}
+		pos_ = s + 1;
+
+		const uint64_t sample = segment.get_sample_value(s);
+		const bool scl = level(sample, scl_);
+		const bool sda = level(sample, sda_);
+
+		const bool data_bit = !old_scl_ && scl;
+		const bool start = old_sda_ && !sda && scl;
+		const bool stop = !old_sda_ && sda && scl;
+
+		switch (state_) {
+		case FindStart:
+			if (start)
+				handle_start(s);
+			break;
+		case FindAddress:
+			if (data_bit)
+				handle_address_or_data(s, sda);
+			else if (start)
+				handle_start(s);
+			break;
+		case FindData:
+			if (data_bit)
+				handle_address_or_data(s, sda);
+			else if (start)
+				handle_start(s);
+			else if (stop)
+				handle_stop(s);
+			break;
+		case FindAck:
+			if (data_bit)
+				handle_ack(s, sda);
+			break;
+		}
+
+		old_scl_ = scl;
+		old_sda_ = sda;
+	}
+}
+
+void I2cDecoder::handle_start(uint64_t sample_num)
+{
+	if (repeat_start_)
+		put(sample_num, sample_num, AnnRepeatStart, "Start repeat",
+			"Sr");
+	else
+		put(sample_num, sample_num, AnnStart, "Start", "S");
+
+	state_ = FindAddress;
+	repeat_start_ = true;
+	databyte_ = 0;
+	bits_.clear();
+}
+
+void I2cDecoder::handle_address_or_data(uint64_t sample_num, bool sda)
+{
+	// Address and data are transmitted MSB-first
+	databyte_ = (databyte_ << 1) | sda;
+
+	if (!bits_.empty())
+		bits_.back().end = sample_num;
+
+	Bit b = {sda, sample_num, sample_num};
+	bits_.push_back(b);
+
+	if (bits_.size() < 8)
+		return;
+
+	bitwidth_ = bits_[7].start - bits_[6].start;
+	bits_.back().end += bitwidth_;
+
+	unsigned int d = databyte_;
+	int ann_class;
+	const char *name, *abbr;
+
+	if (state_ == FindAddress) {
+		// The R/W bit is only in address bytes
+		write_ = !(databyte_ & 1);
+		if (shifted_)
+			d >>= 1;
+		ann_class = write_ ? AnnAddressWrite : AnnAddressRead;
+		name = write_ ? "Address write" : "Address read";
+		abbr = write_ ? "AW" : "AR";
+	} else {
+		ann_class = write_ ? AnnDataWrite : AnnDataRead;
+		name = write_ ? "Data write" : "Data read";
+		abbr = write_ ? "DW" : "DR";
+	}
+
+	for (const Bit &bit : bits_)
+		put(bit.start, bit.end, AnnBit, bit.value ? "1" : "0");
+
+	uint64_t es = sample_num + bitwidth_;
+	if (state_ == FindAddress) {
+		if (write_)
+			put(sample_num, es, ann_class, "Write", "Wr", "W");
+		else
+			put(sample_num, es, ann_class, "Read", "Rd", "R");
+		es = sample_num;
+	}
+
+	char long_text[32], short_text[16], text[8];
+	snprintf(long_text, sizeof(long_text), "%s: %02X", name, d);
+	snprintf(short_text, sizeof(short_text), "%s: %02X", abbr, d);
+	snprintf(text, sizeof(text), "%02X", d);
+	put(bits_.front().start, es, ann_class, long_text, short_text, text);
+
+	databyte_ = 0;
+	bits_.clear();
+	state_ = FindAck;
+}
+
+void I2cDecoder::handle_ack(uint64_t sample_num, bool sda)
+{
+	if (sda)
+		put(sample_num, sample_num + bitwidth_, AnnNack, "NACK", "N");
+	else
+		put(sample_num, sample_num + bitwidth_, AnnAck, "ACK", "A");
+
+	state_ = FindData;
+}
+
+void I2cDecoder::handle_stop(uint64_t sample_num)
+{
+	put(sample_num, sample_num, AnnStop, "Stop", "P");
+
+	state_ = FindStart;
+	repeat_start_ = false;
+	bits_.clear();
+}
+
+} // anonymous namespace
+
+NativeDecoder::NativeDecoder(AnnotationSink sink) :
+	sink_(sink)
+{
+	assert(sink_);
+}
+
+NativeDecoder::~NativeDecoder()
+{
+}
+
+unique_ptr<NativeDecoder> NativeDecoder::create(const Decoder &decoder,
+	double samplerate, AnnotationSink sink)
+{
+	const srd_decoder *const dec = decoder.decoder();
+	assert(dec);
+
+	const Config config(decoder);
+
+	if (!strcmp(dec->id, "uart"))
+		return UartDecoder::create(config, samplerate, sink);
+	if (!strcmp(dec->id, "spi"))
+		return SpiDecoder::create(config, sink);
+	if (!strcmp(dec->id, "i2c"))
+		return I2cDecoder::create(config, sink);
+
+	return nullptr;
+}
+
+void NativeDecoder::put(uint64_t start_sample, uint64_t end_sample,
+	int ann_class, const char *text0, const char *text1,
+	const char *text2, const char *text3)
+{
+	char *texts[] = {(char*)text0, (char*)text1, (char*)text2,
+		(char*)text3, nullptr};
+	sink_(start_sample, end_sample, ann_class, texts);
+}
+
+} // namespace decode
+} // namespace data
+} // namespace pv
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_DECODE_NATIVEDECODER_HPP
+#define PULSEVIEW_PV_DATA_DECODE_NATIVEDECODER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace pv {
+namespace data {
+
+class LogicSegment;
+
+namespace decode {
+
+class Decoder;
+
+/**
+ * Decodes one of the common protocols (uart, spi, i2c) in C++ instead
+ * of going through the Python decoder of libsigrokdecode.
+ *
+ * The annotations use the classes and labels of the Python decoder they
+ * replace, so rows, label tables and the views work unchanged. Idle
+ * stretches of the bus are skipped through LogicSegment::find_change()
+ * without looking at their samples.
+ */
+class NativeDecoder
+{
+public:
+	/**
+	 * Receives an annotation: its span, its class and the NULL
+	 * terminated list of its labels, longest first.
+	 */
+	typedef std::function<void(uint64_t start_sample,
+		uint64_t end_sample, int ann_class, char **texts)>
+		AnnotationSink;
+
+public:
+	/**
+	 * Creates the native implementation of a decoder.
+	 * @return the decoder, or nullptr if the protocol or one of its
+	 * options has no native implementation, in which case the Python
+	 * decoder has to be used.
+	 */
+	static std::unique_ptr<NativeDecoder> create(const Decoder &decoder,
+		double samplerate, AnnotationSink sink);
+
+	virtual ~NativeDecoder();
+
+	/**
+	 * Decodes the samples up to @c end. Frames that are not complete
+	 * by then are decoded by the next call.
+	 */
+	virtual void decode(const LogicSegment &segment, uint64_t end) = 0;
+
+protected:
+	explicit NativeDecoder(AnnotationSink sink);
+
+	void put(uint64_t start_sample, uint64_t end_sample, int ann_class,
+		const char *text0, const char *text1 = nullptr,
+		const char *text2 = nullptr, const char *text3 = nullptr);
+
+private:
+	AnnotationSink sink_;
+};
+
+} // namespace decode
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_DECODE_NATIVEDECODER_HPP
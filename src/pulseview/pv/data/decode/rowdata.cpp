@@ -18,38 +18,105 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
  */
 
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "labeltable.hpp"
 #include "rowdata.hpp"
 
+using std::shared_ptr;
 using std::vector;
 
 namespace pv {
 namespace data {
 namespace decode {
 
-RowData::RowData()
+const size_t RowData::BlockSize = 4096;
+const uint32_t RowData::LongLength = std::numeric_limits<uint32_t>::max();
+
+RowData::RowData() :
+	max_sample_(0),
+	size_(0)
+{
+}
+
+RowData::RowData(shared_ptr<LabelTable> labels) :
+	labels_(labels),
+	max_sample_(0),
+	size_(0)
 {
 }
 
 uint64_t RowData::get_max_sample() const
 {
-	if (annotations_.empty())
-		return 0;
-	return annotations_.back().end_sample();
+	return max_sample_;
+}
+
+uint64_t RowData::size() const
+{
+	return size_;
 }
 
 void RowData::get_annotation_subset(
 	vector<pv::data::decode::Annotation> &dest,
 	uint64_t start_sample, uint64_t end_sample) const
 {
-	for (const auto& annotation : annotations_)
-		if (annotation.end_sample() > start_sample &&
-			annotation.start_sample() <= end_sample)
-			dest.push_back(annotation);
+	for (const Block &b : blocks_) {
+		// Skip the blocks that do not overlap the period
+		if (b.max_end <= start_sample || b.min_start > end_sample)
+			continue;
+
+		for (size_t i = 0; i < b.label.size(); i++) {
+			const uint64_t start = b.base + b.start_delta[i];
+			const uint64_t length = (b.length[i] == LongLength) ?
+				b.long_lengths.at(i) : b.length[i];
+			const uint64_t end = start + length;
+
+			if (end > start_sample && start <= end_sample)
+				dest.push_back(Annotation(start, end,
+					&labels_->labels(b.label[i])));
+		}
+	}
 }
 
-void RowData::push_annotation(const Annotation &a)
+void RowData::push_annotation(uint64_t start_sample, uint64_t end_sample,
+	uint32_t label_id)
 {
-	annotations_.push_back(a);
+	assert(labels_);
+	assert(end_sample >= start_sample);
+
+	const int64_t delta = blocks_.empty() ? 0 :
+		(int64_t)(start_sample - blocks_.back().base);
+
+	if (blocks_.empty() || blocks_.back().label.size() == BlockSize ||
+		delta < std::numeric_limits<int32_t>::min() ||
+		delta > std::numeric_limits<int32_t>::max()) {
+		Block b;
+		b.base = start_sample;
+		b.min_start = start_sample;
+		b.max_end = end_sample;
+		b.start_delta.reserve(BlockSize);
+		b.length.reserve(BlockSize);
+		b.label.reserve(BlockSize);
+		blocks_.push_back(b);
+	}
+
+	Block &b = blocks_.back();
+	const uint64_t length = end_sample - start_sample;
+
+	if (length >= LongLength)
+		b.long_lengths[b.label.size()] = length;
+
+	b.start_delta.push_back((int32_t)(start_sample - b.base));
+	b.length.push_back(length >= LongLength ? LongLength : length);
+	b.label.push_back(label_id);
+
+	b.min_start = std::min(b.min_start, start_sample);
+	b.max_end = std::max(b.max_end, end_sample);
+
+	max_sample_ = end_sample;
+	size_++;
 }
 
 } // decode
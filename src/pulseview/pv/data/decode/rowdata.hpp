@@ -21,6 +21,8 @@
 #ifndef PULSEVIEW_PV_DATA_DECODE_ROWDATA_HPP
 #define PULSEVIEW_PV_DATA_DECODE_ROWDATA_HPP
 
+#include <map>
+#include <memory>
 #include <vector>
 
 #include "annotation.hpp"
@@ -29,14 +31,25 @@ namespace pv {
 namespace data {
 namespace decode {
 
+class LabelTable;
+
+/**
+ * Annotations of one row, packed in structure-of-arrays blocks. Every
+ * annotation takes 12 bytes: its start as a signed 32-bit delta from the
+ * first start of the block, its length and the id of its labels in the
+ * LabelTable of the decoder.
+ */
 class RowData
 {
 public:
 	RowData();
+	explicit RowData(std::shared_ptr<LabelTable> labels);
 
 public:
 	uint64_t get_max_sample() const;
 
+	uint64_t size() const;
+
 	/**
 	 * Extracts sorted annotations between two period into a vector.
 	 */
@@ -44,10 +57,29 @@ public:
 		std::vector<pv::data::decode::Annotation> &dest,
 		uint64_t start_sample, uint64_t end_sample) const;
 
-	void push_annotation(const Annotation &a);
+	void push_annotation(uint64_t start_sample, uint64_t end_sample,
+		uint32_t label_id);
 
 private:
-	std::vector<Annotation> annotations_;
+	struct Block
+	{
+		uint64_t base;
+		uint64_t min_start, max_end;
+		std::vector<int32_t> start_delta;
+		std::vector<uint32_t> length;
+		std::vector<uint32_t> label;
+
+		// Lengths that do not fit in 32 bits, by index in the block
+		std::map<uint32_t, uint64_t> long_lengths;
+	};
+
+	static const size_t BlockSize;
+	static const uint32_t LongLength;
+
+	std::vector<Block> blocks_;
+	std::shared_ptr<LabelTable> labels_;
+	uint64_t max_sample_;
+	uint64_t size_;
 };
 
 }
@@ -30,8 +30,11 @@
 #include "../data/logicsegment.hpp"
 #include "../data/decode/decoder.hpp"
 #include "../data/decode/annotation.hpp"
+#include "../data/decode/labeltable.hpp"
+#include "../data/decode/nativedecoder.hpp"
 #include "../session.hpp"
 #include "../view/logicsignal.hpp"
+#include "../../../trace.hpp"
 
 using std::lock_guard;
 using std::mutex;
@@ -39,12 +42,14 @@ using boost::optional;
 using std::unique_lock;
 using std::deque;
 using std::make_pair;
+using std::make_shared;
 using std::max;
 using std::min;
 using std::list;
 using std::map;
 using std::pair;
 using std::shared_ptr;
+using std::unique_ptr;
 using std::vector;
 
 using namespace pv::data::decode;
@@ -57,6 +62,8 @@ const double DecoderStack::DecodeThreshold = 0.2;
 const int64_t DecoderStack::DecodeChunkLength = 1000000;
 const unsigned int DecoderStack::DecodeNotifyPeriod = 1024;
 
+std::atomic<bool> DecoderStack::native_decode_(false);
+
 mutex DecoderStack::global_srd_mutex_;
 
 DecoderStack::DecoderStack(pv::Session &session,
@@ -99,6 +106,16 @@ QString DecoderStack::name()
 	return name_;
 }
 
+void DecoderStack::set_native_decode(bool enable)
+{
+	native_decode_ = enable;
+}
+
+bool DecoderStack::native_decode()
+{
+	return native_decode_;
+}
+
 const std::list< std::shared_ptr<decode::Decoder> >&
 DecoderStack::stack() const
 {
@@ -214,6 +231,7 @@ void DecoderStack::clear()
 	error_message_ = QString();
 	rows_.clear();
 	class_rows_.clear();
+	label_tables_.clear();
 }
 
 void DecoderStack::begin_decode()
@@ -243,9 +261,14 @@ void DecoderStack::begin_decode()
 		const srd_decoder *const decc = dec->decoder();
 		assert(dec->decoder());
 
+		// All the rows of a decoder share its interned labels
+		shared_ptr<decode::LabelTable> &labels = label_tables_[decc];
+		if (!labels)
+			labels = make_shared<decode::LabelTable>();
+
 		// Add a row for the decoder if it doesn't have a row list
 		if (!decc->annotation_rows)
-			rows_[Row(decc)] = decode::RowData();
+			rows_[Row(decc)] = decode::RowData(labels);
 
 		// Add the decoder rows
 		for (const GSList *l = decc->annotation_rows; l; l = l->next) {
@@ -256,7 +279,7 @@ void DecoderStack::begin_decode()
 			const Row row(decc, ann_row);
 
 			// Add a new empty row data object
-			rows_[row] = decode::RowData();
+			rows_[row] = decode::RowData(labels);
 
 			// Map out all the classes
 			for (const GSList *ll = ann_row->ann_classes;
@@ -332,6 +355,8 @@ void DecoderStack::decode_data(
 	const int64_t sample_count, const unsigned int unit_size,
 	srd_session *const session)
 {
+	TRACE_SCOPE("decode", "decode");
+
 	uint8_t chunk[DecodeChunkLength];
 
 	const unsigned int chunk_sample_count =
@@ -370,6 +395,9 @@ void DecoderStack::decode_proc()
 
 	assert(segment_);
 
+	if (decode_native())
+		return;
+
 	// Prevent any other decode threads from accessing libsigrokdecode
 	lock_guard<mutex> srd_lock(global_srd_mutex_);
 
@@ -418,45 +446,110 @@ void DecoderStack::decode_proc()
 	srd_session_destroy(session);
 }
 
-void DecoderStack::annotation_callback(srd_proto_data *pdata, void *decoder)
+bool DecoderStack::decode_native()
 {
-	assert(pdata);
-	assert(decoder);
+	// A decoder stacked on top needs the Python output of the one below
+	if (!native_decode_ || stack_.size() != 1)
+		return false;
 
-	DecoderStack *const d = (DecoderStack*)decoder;
-	assert(d);
+	const shared_ptr<decode::Decoder> &dec = stack_.front();
+	const srd_decoder *const decc = dec->decoder();
 
-	lock_guard<mutex> lock(d->output_mutex_);
+	unique_ptr<decode::NativeDecoder> native =
+		decode::NativeDecoder::create(*dec, samplerate_,
+			[this, decc](uint64_t start_sample, uint64_t end_sample,
+				int ann_class, char **texts) {
+			srd_proto_data_annotation pda;
+			pda.ann_class = ann_class;
+			pda.ann_text = texts;
 
-	const Annotation a(pdata);
+			lock_guard<mutex> lock(output_mutex_);
+			push_annotation(decc, start_sample, end_sample, &pda);
+		});
+	if (!native)
+		return false;
 
-	// Find the row
-	assert(pdata->pdo);
-	assert(pdata->pdo->di);
-	const srd_decoder *const decc = pdata->pdo->di->decoder;
-	assert(decc);
+	optional<int64_t> sample_count;
+	{
+		unique_lock<mutex> input_lock(input_mutex_);
+		sample_count = sample_count_ = segment_->get_sample_count();
+	}
+
+	do {
+		TRACE_SCOPE("decode", "decode");
 
-	auto row_iter = d->rows_.end();
+		for (int64_t i = samples_decoded_; !interrupt_ &&
+				i < *sample_count; i += DecodeChunkLength) {
+			const int64_t chunk_end = min(
+				i + DecodeChunkLength, *sample_count);
+			native->decode(*segment_, chunk_end);
+
+			{
+				lock_guard<mutex> lock(output_mutex_);
+				samples_decoded_ = chunk_end;
+			}
+
+			new_decode_data();
+		}
+	} while ((sample_count = wait_for_data()));
+
+	return true;
+}
+
+void DecoderStack::push_annotation(const srd_decoder *decc,
+	uint64_t start_sample, uint64_t end_sample,
+	const srd_proto_data_annotation *pda)
+{
+	const auto table_iter = label_tables_.find(decc);
+	assert(table_iter != label_tables_.end());
+	if (table_iter == label_tables_.end())
+		return;
+
+	const uint32_t label_id = (*table_iter).second->intern(pda);
+	const int format = pda->ann_class;
+
+	auto row_iter = rows_.end();
 
 	// Try looking up the sub-row of this class
-	const auto r = d->class_rows_.find(make_pair(decc, a.format()));
-	if (r != d->class_rows_.end())
-		row_iter = d->rows_.find((*r).second);
+	const auto r = class_rows_.find(make_pair(decc, format));
+	if (r != class_rows_.end())
+		row_iter = rows_.find((*r).second);
 	else {
 		// Failing that, use the decoder as a key
-		row_iter = d->rows_.find(Row(decc));	
+		row_iter = rows_.find(Row(decc));	
 	}
 
-	assert(row_iter != d->rows_.end());
-	if (row_iter == d->rows_.end()) {
+	assert(row_iter != rows_.end());
+	if (row_iter == rows_.end()) {
 		qDebug() << "Unexpected annotation: decoder = " << decc <<
-			", format = " << a.format();
+			", format = " << format;
 		assert(0);
 		return;
 	}
 
 	// Add the annotation
-	(*row_iter).second.push_annotation(a);
+	(*row_iter).second.push_annotation(start_sample, end_sample,
+		label_id);
+}
+
+void DecoderStack::annotation_callback(srd_proto_data *pdata, void *decoder)
+{
+	assert(pdata);
+	assert(decoder);
+
+	DecoderStack *const d = (DecoderStack*)decoder;
+	assert(d);
+
+	lock_guard<mutex> lock(d->output_mutex_);
+
+	// Find the row
+	assert(pdata->pdo);
+	assert(pdata->pdo->di);
+	const srd_decoder *const decc = pdata->pdo->di->decoder;
+	assert(decc);
+
+	d->push_annotation(decc, pdata->start_sample, pdata->end_sample,
+		(const srd_proto_data_annotation*)pdata->data);
 }
 
 void DecoderStack::on_new_frame()
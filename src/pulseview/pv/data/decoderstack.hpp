@@ -43,6 +43,7 @@ struct srd_decoder;
 struct srd_decoder_annotation_row;
 struct srd_channel;
 struct srd_proto_data;
+struct srd_proto_data_annotation;
 struct srd_session;
 
 namespace DecoderStackTest {
@@ -64,6 +65,7 @@ class LogicSegment;
 namespace decode {
 class Annotation;
 class Decoder;
+class LabelTable;
 }
 
 class Logic;
@@ -78,7 +80,17 @@ private:
 	static const int64_t DecodeChunkLength;
 	static const unsigned int DecodeNotifyPeriod;
 
+	static std::atomic<bool> native_decode_;
+
 public:
+	/**
+	 * Enables the native UART, SPI and I2C decoders in place of the
+	 * Python ones. Off by default until their output is verified
+	 * against the Python decoders.
+	 */
+	static void set_native_decode(bool enable);
+	static bool native_decode();
+
 	DecoderStack(pv::Session &session,
 		const srd_decoder *const dec = NULL);
 
@@ -124,6 +136,11 @@ private:
 
 	void decode_proc();
 
+	bool decode_native();
+
+	void push_annotation(const srd_decoder *decc, uint64_t start_sample,
+		uint64_t end_sample, const srd_proto_data_annotation *pda);
+
 	static void annotation_callback(srd_proto_data *pdata,
 		void *decoder);
 
@@ -167,6 +184,9 @@ private:
 
 	std::map<std::pair<const srd_decoder*, int>, decode::Row> class_rows_;
 
+	std::map<const srd_decoder*, std::shared_ptr<decode::LabelTable> >
+		label_tables_;
+
 	QString error_message_;
 
 	std::thread decode_thread_;
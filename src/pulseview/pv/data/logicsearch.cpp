@@ -0,0 +1,275 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+
+#include "logicsearch.hpp"
+#include "logicsegment.hpp"
+
+using std::min;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+const size_t LogicSearch::MaxMatches = 1 << 20;
+const uint64_t LogicSearch::BufferSamples = 4096;
+
+namespace {
+
+inline bool level_holds(const LogicSearch::Condition &c, uint64_t sample)
+{
+	return (sample & c.mask) == c.value;
+}
+
+inline bool holds(const LogicSearch::Condition &c, uint64_t prev,
+	uint64_t cur)
+{
+	return level_holds(c, cur) &&
+		(~prev & cur & c.rising) == c.rising &&
+		(prev & ~cur & c.falling) == c.falling &&
+		((prev ^ cur) & c.toggle) == c.toggle;
+}
+
+inline bool has_edges(const LogicSearch::Condition &c)
+{
+	return c.rising | c.falling | c.toggle;
+}
+
+/// Returns true if the condition starts to hold on the sample @c cur.
+inline bool starts(const LogicSearch::Condition &c, uint64_t prev,
+	uint64_t cur)
+{
+	return holds(c, prev, cur) && (has_edges(c) || !level_holds(c, prev));
+}
+
+/**
+ * Calls @c step on every sample in [index, end) of a buffer on which the
+ * masked value differs from the previous sample.
+ * @return the masked value of the last sample.
+ */
+template<typename Unpack, typename Step>
+uint64_t scan(const uint8_t *ptr, uint64_t index, uint64_t end,
+	unsigned int unit_size, uint64_t mask, uint64_t prev,
+	Unpack unpack, Step &step)
+{
+	for (; index < end; index++, ptr += unit_size) {
+		const uint64_t cur = unpack(ptr) & mask;
+		if (cur != prev) {
+			step(index, prev, cur);
+			prev = cur;
+		}
+	}
+
+	return prev;
+}
+
+}
+
+LogicSearch::LogicSearch(Type type, const Condition &first,
+	const Condition &second) :
+	type_(type),
+	first_(first),
+	second_(second),
+	min_width_(0),
+	max_width_(UINT64_MAX),
+	window_(0)
+{
+}
+
+LogicSearch::Condition LogicSearch::pattern(uint64_t mask, uint64_t value)
+{
+	const Condition c = {mask, value & mask, 0, 0, 0};
+	return c;
+}
+
+LogicSearch::Condition LogicSearch::rising_edge(int channel)
+{
+	const Condition c = {0, 0, 1ULL << channel, 0, 0};
+	return c;
+}
+
+LogicSearch::Condition LogicSearch::falling_edge(int channel)
+{
+	const Condition c = {0, 0, 0, 1ULL << channel, 0};
+	return c;
+}
+
+LogicSearch::Condition LogicSearch::any_edge(int channel)
+{
+	const Condition c = {0, 0, 0, 0, 1ULL << channel};
+	return c;
+}
+
+LogicSearch LogicSearch::find(const Condition &condition)
+{
+	return LogicSearch(Find, condition, condition);
+}
+
+LogicSearch LogicSearch::pulse(const Condition &condition,
+	uint64_t min_width, uint64_t max_width)
+{
+	// A pulse is a level, its edges are implied
+	const Condition level = pattern(condition.mask, condition.value);
+
+	LogicSearch search(Pulse, level, level);
+	search.min_width_ = min_width;
+	search.max_width_ = max_width;
+	return search;
+}
+
+LogicSearch LogicSearch::sequence(const Condition &first,
+	const Condition &second, uint64_t window)
+{
+	LogicSearch search(Sequence, first, second);
+	search.window_ = window;
+	return search;
+}
+
+uint64_t LogicSearch::channels(const Condition &condition)
+{
+	return condition.mask | condition.rising | condition.falling |
+		condition.toggle;
+}
+
+vector<LogicSearch::Match> LogicSearch::run(const LogicSegment &segment,
+	uint64_t start, uint64_t end) const
+{
+	vector<Match> matches;
+
+	end = min(end, segment.get_sample_count());
+	if (start >= end)
+		return matches;
+
+	const uint64_t mask = channels(first_) | channels(second_);
+	if (!mask)
+		return matches;
+
+	// An open match or pulse, and the last start of the first condition
+	// of a sequence
+	bool open = false, have_first = false;
+	uint64_t open_start = 0, first_start = 0;
+
+	// Called on every sample where a searched channel changes, which
+	// are the only samples where a condition can start or stop holding
+	const auto step = [&](uint64_t index, uint64_t prev, uint64_t cur) {
+		switch (type_) {
+		case Find:
+			if (open && !level_holds(first_, cur)) {
+				matches.push_back({open_start, index});
+				open = false;
+			}
+			if (starts(first_, prev, cur)) {
+				if (has_edges(first_))
+					matches.push_back({index, index + 1});
+				else {
+					open = true;
+					open_start = index;
+				}
+			}
+			break;
+
+		case Pulse:
+			if (open && !level_holds(first_, cur)) {
+				const uint64_t width = index - open_start;
+				if (width >= min_width_ && width <= max_width_)
+					matches.push_back({open_start, index});
+				open = false;
+			} else if (!open && level_holds(first_, cur)) {
+				open = true;
+				open_start = index;
+			}
+			break;
+
+		case Sequence:
+			// The second condition is checked first so that it only
+			// pairs with an earlier occurrence of the first one
+			if (have_first && index - first_start > window_)
+				have_first = false;
+			if (have_first && starts(second_, prev, cur)) {
+				matches.push_back({first_start, index + 1});
+				have_first = false;
+			}
+			if (starts(first_, prev, cur)) {
+				have_first = true;
+				first_start = index;
+			}
+			break;
+		}
+	};
+
+	const unsigned int unit_size = segment.unit_size();
+	vector<uint8_t> buffer(BufferSamples * unit_size + sizeof(uint64_t));
+
+	uint64_t prev = segment.get_sample_value(start) & mask;
+	uint64_t index = start + 1;
+
+	// A level that already holds on the first sample starts there
+	if (!has_edges(first_) && level_holds(first_, prev)) {
+		if (type_ == Find) {
+			open = true;
+			open_start = start;
+		} else if (type_ == Sequence) {
+			have_first = true;
+			first_start = start;
+		}
+	}
+
+	while (index < end && matches.size() < MaxMatches) {
+		// Skip the stretch in which the searched channels are constant
+		index = segment.find_change(index, end, mask, prev);
+		if (index >= end)
+			break;
+
+		// Scan the following samples from a buffer rather than
+		// looking each transition up separately
+		const uint64_t buffer_end = min(end, index + BufferSamples);
+		segment.get_samples(buffer.data(), index, buffer_end);
+
+		// The usual 8 and 16 channel layouts are read inline
+		const uint8_t *const ptr = buffer.data();
+		if (unit_size == 1)
+			prev = scan(ptr, index, buffer_end, 1, mask, prev,
+				[](const uint8_t *p) { return (uint64_t)p[0]; },
+				step);
+		else if (unit_size == 2)
+			prev = scan(ptr, index, buffer_end, 2, mask, prev,
+				[](const uint8_t *p) {
+					return (uint64_t)(p[0] | (p[1] << 8));
+				}, step);
+		else
+			prev = scan(ptr, index, buffer_end, unit_size, mask, prev,
+				[&segment](const uint8_t *p) {
+					return segment.unpack_sample(p);
+				}, step);
+
+		index = buffer_end;
+	}
+
+	if (type_ == Find && open && matches.size() < MaxMatches)
+		matches.push_back({open_start, end});
+
+	if (matches.size() > MaxMatches)
+		matches.resize(MaxMatches);
+
+	return matches;
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_LOGICSEARCH_HPP
+#define PULSEVIEW_PV_DATA_LOGICSEARCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pv {
+namespace data {
+
+class LogicSegment;
+
+/**
+ * Searches a logic segment for a multi-channel pattern, an edge, a pulse
+ * width or a sequence of two conditions.
+ *
+ * A query is compiled into masks over the packed samples. Stretches in
+ * which none of the searched channels change are skipped through
+ * LogicSegment::find_change(), and busy stretches are fetched a buffer
+ * at a time and scanned in a tight loop, so the cost follows the number
+ * of transitions on the searched channels rather than the capture length.
+ */
+class LogicSearch
+{
+public:
+	/**
+	 * What a sample has to show. A condition holds on a sample when the
+	 * channels in @c mask are at @c value, the channels in @c rising and
+	 * @c falling have that edge into the sample and the channels in
+	 * @c toggle changed on it.
+	 */
+	struct Condition
+	{
+		uint64_t mask, value;
+		uint64_t rising, falling, toggle;
+	};
+
+	/// A match, as the sample range [start, end).
+	struct Match
+	{
+		uint64_t start, end;
+	};
+
+	/// Searches stop after this many matches.
+	static const size_t MaxMatches;
+
+private:
+	enum Type {
+		Find,
+		Pulse,
+		Sequence
+	};
+
+	static const uint64_t BufferSamples;
+
+public:
+	static Condition pattern(uint64_t mask, uint64_t value);
+	static Condition rising_edge(int channel);
+	static Condition falling_edge(int channel);
+	static Condition any_edge(int channel);
+
+	/**
+	 * Matches where a condition starts to hold. Level patterns match
+	 * for as long as they hold, including one that already holds at the
+	 * start of the searched range, edges on a single sample.
+	 */
+	static LogicSearch find(const Condition &condition);
+
+	/**
+	 * Matches the pulses during which a level pattern holds for at
+	 * least @c min_width and at most @c max_width samples. Pulses cut
+	 * by the ends of the searched range are not reported.
+	 */
+	static LogicSearch pulse(const Condition &condition,
+		uint64_t min_width, uint64_t max_width = UINT64_MAX);
+
+	/**
+	 * Matches a condition followed by a second one at most @c window
+	 * samples later. Every occurrence of the first condition pairs with
+	 * the next occurrence of the second one.
+	 */
+	static LogicSearch sequence(const Condition &first,
+		const Condition &second, uint64_t window);
+
+	/**
+	 * Searches the samples in [start, end) of a segment.
+	 * @return the matches, sorted by start.
+	 */
+	std::vector<Match> run(const LogicSegment &segment,
+		uint64_t start = 0, uint64_t end = UINT64_MAX) const;
+
+private:
+	LogicSearch(Type type, const Condition &first,
+		const Condition &second);
+
+	static uint64_t channels(const Condition &condition);
+
+private:
+	Type type_;
+	Condition first_, second_;
+	uint64_t min_width_, max_width_;
+	uint64_t window_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_LOGICSEARCH_HPP
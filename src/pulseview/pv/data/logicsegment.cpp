@@ -23,7 +23,7 @@
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
-#include <cmath>
+#include <algorithm>
 
 #include "logicsegment.hpp"
 
@@ -35,40 +35,40 @@ using std::max;
 using std::min;
 using std::pair;
 using std::shared_ptr;
+using std::upper_bound;
+using std::vector;
 
 using sigrok::Logic;
 
 namespace pv {
 namespace data {
 
-const int LogicSegment::MipMapScalePower = 4;
-const int LogicSegment::MipMapScaleFactor = 1 << MipMapScalePower;
-const float LogicSegment::LogMipMapScaleFactor = logf(MipMapScaleFactor);
-const uint64_t LogicSegment::MipMapDataUnit = 64*1024;	// bytes
+const uint64_t LogicSegment::BlockSamples = 1 << 16;
+const uint64_t LogicSegment::ChunkSamples = 1 << 8;
 
 LogicSegment::LogicSegment(shared_ptr<Logic> logic, uint64_t samplerate,
 				const uint64_t expected_num_samples) :
 	Segment(samplerate, logic->unit_size()),
-	last_append_sample_(0)
+	sample_mask_(unit_size_ >= sizeof(uint64_t) ? ~0ULL :
+		(1ULL << (8 * unit_size_)) - 1),
+	last_append_sample_(0),
+	cursor_block_(0),
+	cursor_run_(0)
 {
-	set_capacity(expected_num_samples);
-
 	lock_guard<recursive_mutex> lock(mutex_);
-	memset(mip_map_, 0, sizeof(mip_map_));
+	blocks_.reserve(expected_num_samples / BlockSamples + 1);
 	append_payload(logic);
 }
 
 LogicSegment::~LogicSegment()
 {
 	lock_guard<recursive_mutex> lock(mutex_);
-	for (MipMapLevel &l : mip_map_)
-		free(l.data);
 }
 
 uint64_t LogicSegment::unpack_sample(const uint8_t *ptr) const
 {
 #ifdef HAVE_UNALIGNED_LITTLE_ENDIAN_ACCESS
-	return *(uint64_t*)ptr;
+	return *(uint64_t*)ptr & sample_mask_;
 #else
 	uint64_t value = 0;
 	switch (unit_size_) {
@@ -103,42 +103,6 @@ uint64_t LogicSegment::unpack_sample(const uint8_t *ptr) const
 #endif
 }
 
-void LogicSegment::pack_sample(uint8_t *ptr, uint64_t value)
-{
-#ifdef HAVE_UNALIGNED_LITTLE_ENDIAN_ACCESS
-	*(uint64_t*)ptr = value;
-#else
-	switch (unit_size_) {
-	default:
-		ptr[7] = value >> 56;
-		/* FALLTHRU */
-	case 7:
-		ptr[6] = value >> 48;
-		/* FALLTHRU */
-	case 6:
-		ptr[5] = value >> 40;
-		/* FALLTHRU */
-	case 5:
-		ptr[4] = value >> 32;
-		/* FALLTHRU */
-	case 4:
-		ptr[3] = value >> 24;
-		/* FALLTHRU */
-	case 3:
-		ptr[2] = value >> 16;
-		/* FALLTHRU */
-	case 2:
-		ptr[1] = value >> 8;
-		/* FALLTHRU */
-	case 1:
-		ptr[0] = value;
-		/* FALLTHRU */
-	case 0:
-		break;
-	}
-#endif
-}
-
 void LogicSegment::append_payload(shared_ptr<Logic> logic)
 {
 	assert(unit_size_ == logic->unit_size());
@@ -146,11 +110,8 @@ void LogicSegment::append_payload(shared_ptr<Logic> logic)
 
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	append_data(logic->data_pointer(),
+	append_samples((const uint8_t*)logic->data_pointer(),
 		logic->data_length() / unit_size_);
-
-	// Generate the first mip-map from the data
-	append_payload_to_mipmap();
 }
 
 void LogicSegment::add_payload(shared_ptr<Logic> logic, size_t buffersize)
@@ -160,13 +121,151 @@ void LogicSegment::add_payload(shared_ptr<Logic> logic, size_t buffersize)
 
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	add_data(logic->data_pointer(),
-		logic->data_length() / unit_size_, buffersize);
+	// In buffer mode a full buffer starts over
+	if (sample_count_ == buffersize)
+		clear_blocks();
+
+	append_samples((const uint8_t*)logic->data_pointer(),
+		logic->data_length() / unit_size_);
+}
+
+void LogicSegment::clear_blocks()
+{
+	blocks_.clear();
+	sample_count_ = 0;
+	last_append_sample_ = 0;
+	cursor_block_ = 0;
+	cursor_run_ = 0;
+}
+
+void LogicSegment::append_samples(const uint8_t *data, uint64_t samples)
+{
+	while (samples > 0) {
+		if (blocks_.empty() || blocks_.back().length == BlockSamples) {
+			if (!blocks_.empty())
+				seal_block(blocks_.back());
+
+			blocks_.push_back(Block());
+			Block &b = blocks_.back();
+			b.length = 0;
+			b.change_mask = 0;
+			b.rle = false;
+			b.data.reserve(BlockSamples * unit_size_ + sizeof(uint64_t));
+			b.chunk_masks.reserve(BlockSamples / ChunkSamples);
+		}
+
+		// The open block is kept raw until it is full
+		Block &b = blocks_.back();
+		const uint64_t count = min(samples, BlockSamples - b.length);
+		const size_t prev_size = b.length * unit_size_;
+
+		b.data.resize(prev_size + count * unit_size_ + sizeof(uint64_t));
+		memcpy(b.data.data() + prev_size, data, count * unit_size_);
+
+		const uint8_t *ptr = b.data.data() + prev_size;
+		for (uint64_t i = 0; i < count; i++, ptr += unit_size_) {
+			const uint64_t offset = b.length + i;
+			const uint64_t sample = unpack_sample(ptr);
+
+			// A chunk also records the change into its first sample,
+			// except for the first chunk of the block
+			const uint64_t change = (offset == 0) ? 0 :
+				last_append_sample_ ^ sample;
+			if (offset % ChunkSamples == 0)
+				b.chunk_masks.push_back(change);
+			else
+				b.chunk_masks.back() |= change;
+			last_append_sample_ = sample;
+		}
+
+		for (uint64_t c = prev_size / unit_size_ / ChunkSamples;
+				c < b.chunk_masks.size(); c++)
+			b.change_mask |= b.chunk_masks[c];
 
-	// Generate the first mip-map from the data
-	append_payload_to_mipmap();
+		b.length += count;
+		sample_count_ += count;
+		data += count * unit_size_;
+		samples -= count;
+	}
 }
 
+void LogicSegment::seal_block(Block &block)
+{
+	assert(!block.rle);
+
+	// Count the runs to see whether encoding pays off
+	size_t runs = 1;
+	const uint8_t *ptr = block.data.data();
+	uint64_t prev = unpack_sample(ptr);
+	for (uint64_t i = 1; i < block.length; i++) {
+		ptr += unit_size_;
+		const uint64_t sample = unpack_sample(ptr);
+		runs += (sample != prev);
+		prev = sample;
+	}
+
+	if (runs * (sizeof(uint16_t) + unit_size_) >=
+			block.length * unit_size_) {
+		block.data.shrink_to_fit();
+		return;
+	}
+
+	vector<uint16_t> offsets;
+	vector<uint8_t> values;
+	offsets.reserve(runs);
+	values.reserve(runs * unit_size_ + sizeof(uint64_t));
+
+	ptr = block.data.data();
+	for (uint64_t i = 0; i < block.length; i++, ptr += unit_size_) {
+		const uint64_t sample = unpack_sample(ptr);
+		if (i == 0 || sample != prev) {
+			offsets.push_back(i);
+			values.insert(values.end(), ptr, ptr + unit_size_);
+		}
+		prev = sample;
+	}
+	values.resize(values.size() + sizeof(uint64_t));
+
+	block.rle = true;
+	block.run_offsets.swap(offsets);
+	block.data.swap(values);
+	vector<uint64_t>().swap(block.chunk_masks);
+}
+
+uint64_t LogicSegment::storage_size() const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	uint64_t size = blocks_.capacity() * sizeof(Block);
+	for (const Block &b : blocks_)
+		size += b.data.capacity() +
+			b.run_offsets.capacity() * sizeof(uint16_t) +
+			b.chunk_masks.capacity() * sizeof(uint64_t);
+	return size;
+}
+
+size_t LogicSegment::find_run(uint64_t block_index, uint64_t offset) const
+{
+	const vector<uint16_t> &offsets = blocks_[block_index].run_offsets;
+
+	// Sequential reads find their run at or just after the last one
+	if (cursor_block_ == block_index && cursor_run_ < offsets.size() &&
+			offsets[cursor_run_] <= offset) {
+		size_t r = cursor_run_;
+		while (r + 1 < offsets.size() && offsets[r + 1] <= offset &&
+				r < cursor_run_ + 4)
+			r++;
+		if (r + 1 == offsets.size() || offsets[r + 1] > offset) {
+			cursor_run_ = r;
+			return r;
+		}
+	}
+
+	cursor_block_ = block_index;
+	cursor_run_ = upper_bound(offsets.begin(), offsets.end(), offset) -
+		offsets.begin() - 1;
+	return cursor_run_;
+}
 
 void LogicSegment::get_samples(uint8_t *const data,
 	int64_t start_sample, int64_t end_sample) const
@@ -180,105 +279,134 @@ void LogicSegment::get_samples(uint8_t *const data,
 
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	const size_t size = (end_sample - start_sample) * unit_size_;
-	memcpy(data, (const uint8_t*)data_.data() + start_sample * unit_size_, size);
-}
+	uint8_t *dest = data;
+	uint64_t index = start_sample;
+	while (index < (uint64_t)end_sample) {
+		const uint64_t b = index / BlockSamples;
+		const Block &block = blocks_[b];
+		const uint64_t offset = index - b * BlockSamples;
+		const uint64_t count = min<uint64_t>(end_sample - index,
+			block.length - offset);
+
+		if (!block.rle) {
+			memcpy(dest, block.data.data() + offset * unit_size_,
+				count * unit_size_);
+			dest += count * unit_size_;
+		} else {
+			// Expand the runs covering the requested range
+			size_t r = find_run(b, offset);
+			const uint64_t stop = offset + count;
+			for (uint64_t i = offset; i < stop; r++) {
+				const uint64_t run_end = (r + 1 < block.run_offsets.size()) ?
+					block.run_offsets[r + 1] : block.length;
+				const uint8_t *const value =
+					block.data.data() + r * unit_size_;
+				const uint64_t n = min(run_end, stop) - i;
+				if (unit_size_ == 1)
+					memset(dest, *value, n);
+				else
+					for (uint64_t j = 0; j < n; j++)
+						memcpy(dest + j * unit_size_, value,
+							unit_size_);
+				dest += n * unit_size_;
+				i += n;
+			}
+		}
 
-void LogicSegment::reallocate_mipmap_level(MipMapLevel &m)
-{
-	const uint64_t new_data_length = ((m.length + MipMapDataUnit - 1) /
-		MipMapDataUnit) * MipMapDataUnit;
-	if (new_data_length > m.data_length) {
-		m.data_length = new_data_length;
-
-		// Padding is added to allow for the uint64_t write word
-		m.data = realloc(m.data, new_data_length * unit_size_ +
-			sizeof(uint64_t));
+		index += count;
 	}
 }
 
-void LogicSegment::append_payload_to_mipmap()
+uint64_t LogicSegment::get_sample(uint64_t index) const
 {
-	MipMapLevel &m0 = mip_map_[0];
-	uint64_t prev_length;
-	const uint8_t *src_ptr;
-	uint8_t *dest_ptr;
-	uint64_t accumulator;
-	unsigned int diff_counter;
-
-	// Expand the data buffer to fit the new samples
-	prev_length = m0.length;
-	m0.length = sample_count_ / MipMapScaleFactor;
-
-	// Break off if there are no new samples to compute
-	if (m0.length == prev_length)
-		return;
+	assert(index < sample_count_);
 
-	reallocate_mipmap_level(m0);
-
-	dest_ptr = (uint8_t*)m0.data + prev_length * unit_size_;
-
-	// Iterate through the samples to populate the first level mipmap
-	const uint8_t *const end_src_ptr = (uint8_t*)data_.data() +
-		m0.length * unit_size_ * MipMapScaleFactor;
-	for (src_ptr = (uint8_t*)data_.data() +
-			prev_length * unit_size_ * MipMapScaleFactor;
-			src_ptr < end_src_ptr;) {
-		// Accumulate transitions which have occurred in this sample
-		accumulator = 0;
-		diff_counter = MipMapScaleFactor;
-		while (diff_counter-- > 0) {
-			const uint64_t sample = unpack_sample(src_ptr);
-			accumulator |= last_append_sample_ ^ sample;
-			last_append_sample_ = sample;
-			src_ptr += unit_size_;
-		}
+	const uint64_t b = index / BlockSamples;
+	const Block &block = blocks_[b];
+	const uint64_t offset = index - b * BlockSamples;
 
-		pack_sample(dest_ptr, accumulator);
-		dest_ptr += unit_size_;
-	}
+	if (!block.rle)
+		return unpack_sample(block.data.data() + offset * unit_size_);
 
-	// Compute higher level mipmaps
-	for (unsigned int level = 1; level < ScaleStepCount; level++) {
-		MipMapLevel &m = mip_map_[level];
-		const MipMapLevel &ml = mip_map_[level-1];
+	return unpack_sample(block.data.data() +
+		find_run(b, offset) * unit_size_);
+}
 
-		// Expand the data buffer to fit the new samples
-		prev_length = m.length;
-		m.length = ml.length / MipMapScaleFactor;
+uint64_t LogicSegment::get_sample_value(uint64_t index) const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+	return get_sample(index);
+}
 
-		// Break off if there are no more samples to computed
-		if (m.length == prev_length)
-			break;
+uint64_t LogicSegment::find_change(uint64_t start, uint64_t end,
+	uint64_t mask, uint64_t value) const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	uint64_t index = start;
+	end = min(end, sample_count_);
+	value &= mask;
+
+	while (index < end) {
+		const uint64_t b = index / BlockSamples;
+		const Block &block = blocks_[b];
+		const uint64_t block_start = b * BlockSamples;
+		const uint64_t block_end = min(end, block_start + block.length);
+
+		// The change into the first sample of a block is not part of
+		// its change mask
+		if ((get_sample(index) & mask) != value)
+			return index;
+
+		if (!(block.change_mask & mask)) {
+			// The channels are constant across the block
+			index = block_end;
+			continue;
+		}
+
+		if (block.rle) {
+			// Only run boundaries can carry a change
+			const size_t runs = block.run_offsets.size();
+			for (size_t r = find_run(b, index - block_start) + 1;
+					r < runs; r++) {
+				const uint64_t run_start =
+					block_start + block.run_offsets[r];
+				if (run_start >= block_end)
+					break;
 
-		reallocate_mipmap_level(m);
-
-		// Subsample the level lower level
-		src_ptr = (uint8_t*)ml.data +
-			unit_size_ * prev_length * MipMapScaleFactor;
-		const uint8_t *const end_dest_ptr =
-			(uint8_t*)m.data + unit_size_ * m.length;
-		for (dest_ptr = (uint8_t*)m.data +
-				unit_size_ * prev_length;
-				dest_ptr < end_dest_ptr;
-				dest_ptr += unit_size_) {
-			accumulator = 0;
-			diff_counter = MipMapScaleFactor;
-			while (diff_counter-- > 0) {
-				accumulator |= unpack_sample(src_ptr);
-				src_ptr += unit_size_;
+				const uint64_t sample = unpack_sample(
+					block.data.data() + r * unit_size_);
+				if ((sample & mask) != value)
+					return run_start;
 			}
+		} else {
+			uint64_t offset = index - block_start;
+			while (block_start + offset < block_end) {
+				const uint64_t chunk = offset / ChunkSamples;
+				const uint64_t chunk_end = min(
+					(chunk + 1) * ChunkSamples,
+					block_end - block_start);
+
+				// Skip the chunks in which the channels are
+				// constant
+				if (block.chunk_masks[chunk] & mask) {
+					const uint8_t *ptr = block.data.data() +
+						offset * unit_size_;
+					for (; offset < chunk_end;
+							offset++, ptr += unit_size_)
+						if ((unpack_sample(ptr) & mask) !=
+								value)
+							return block_start + offset;
+				}
 
-			pack_sample(dest_ptr, accumulator);
+				offset = chunk_end;
+			}
 		}
-	}
-}
 
-uint64_t LogicSegment::get_sample(uint64_t index) const
-{
-	assert(index < sample_count_);
+		index = block_end;
+	}
 
-	return unpack_sample((uint8_t*)data_.data() + index * unit_size_);
+	return end;
 }
 
 void LogicSegment::get_subsampled_edges(
@@ -286,11 +414,6 @@ void LogicSegment::get_subsampled_edges(
 	uint64_t start, uint64_t end,
 	float min_length, int sig_index)
 {
-	uint64_t index = start;
-	unsigned int level;
-	bool last_sample;
-	bool fast_forward;
-
 	assert(end <= get_sample_count());
 	assert(start <= end);
 	assert(min_length > 0);
@@ -300,156 +423,27 @@ void LogicSegment::get_subsampled_edges(
 	lock_guard<recursive_mutex> lock(mutex_);
 
 	const uint64_t block_length = (uint64_t)max(min_length, 1.0f);
-	const unsigned int min_level = max((int)floorf(logf(min_length) /
-		LogMipMapScaleFactor) - 1, 0);
 	const uint64_t sig_mask = 1ULL << sig_index;
 
 	// Store the initial state
-	last_sample = (get_sample(start) & sig_mask) != 0;
-	edges.push_back(pair<int64_t, bool>(index++, last_sample));
+	bool last_sample = (get_sample(start) & sig_mask) != 0;
+	edges.push_back(pair<int64_t, bool>(start, last_sample));
 
+	uint64_t index = start + 1;
 	while (index + block_length <= end) {
-		//----- Continue to search -----//
-		level = min_level;
-
-		// We cannot fast-forward if there is no mip-map data at
-		// at the minimum level.
-		fast_forward = (mip_map_[level].data != nullptr);
-
-		if (min_length < MipMapScaleFactor) {
-			// Search individual samples up to the beginning of
-			// the next first level mip map block
-			const uint64_t final_index = min(end,
-				pow2_ceil(index, MipMapScalePower));
-
-			for (; index < final_index &&
-					(index & ~((uint64_t)(~0) << MipMapScalePower)) != 0;
-					index++) {
-				const bool sample =
-					(get_sample(index) & sig_mask) != 0;
-
-				// If there was a change we cannot fast forward
-				if (sample != last_sample) {
-					fast_forward = false;
-					break;
-				}
-			}
-		} else {
-			// If resolution is less than a mip map block,
-			// round up to the beginning of the mip-map block
-			// for this level of detail
-			const int min_level_scale_power =
-				(level + 1) * MipMapScalePower;
-			index = pow2_ceil(index, min_level_scale_power);
-			if (index >= end)
-				break;
-
-			// We can fast forward only if there was no change
-			const bool sample =
-				(get_sample(index) & sig_mask) != 0;
-			if (last_sample != sample)
-				fast_forward = false;
-		}
-
-		if (fast_forward) {
-
-			// Fast forward: This involves zooming out to higher
-			// levels of the mip map searching for changes, then
-			// zooming in on them to find the point where the edge
-			// begins.
-
-			// Slide right and zoom out at the beginnings of mip-map
-			// blocks until we encounter a change
-			while (1) {
-				const int level_scale_power =
-					(level + 1) * MipMapScalePower;
-				const uint64_t offset =
-					index >> level_scale_power;
-
-				// Check if we reached the last block at this
-				// level, or if there was a change in this block
-				if (offset >= mip_map_[level].length ||
-					(get_subsample(level, offset) &
-						sig_mask))
-					break;
-
-				if ((offset & ~((uint64_t)(~0) << MipMapScalePower)) == 0) {
-					// If we are now at the beginning of a
-					// higher level mip-map block ascend one
-					// level
-					if (level + 1 >= ScaleStepCount ||
-						!mip_map_[level + 1].data)
-						break;
-
-					level++;
-				} else {
-					// Slide right to the beginning of the
-					// next mip map block
-					index = pow2_ceil(index + 1,
-						level_scale_power);
-				}
-			}
-
-			// Zoom in, and slide right until we encounter a change,
-			// and repeat until we reach min_level
-			while (1) {
-				assert(mip_map_[level].data);
-
-				const int level_scale_power =
-					(level + 1) * MipMapScalePower;
-				const uint64_t offset =
-					index >> level_scale_power;
-
-				// Check if we reached the last block at this
-				// level, or if there was a change in this block
-				if (offset >= mip_map_[level].length ||
-						(get_subsample(level, offset) &
-						sig_mask)) {
-					// Zoom in unless we reached the minimum
-					// zoom
-					if (level == min_level)
-						break;
-
-					level--;
-				} else {
-					// Slide right to the beginning of the
-					// next mip map block
-					index = pow2_ceil(index + 1,
-						level_scale_power);
-				}
-			}
-
-			// If individual samples within the limit of resolution,
-			// do a linear search for the next transition within the
-			// block
-			if (min_length < MipMapScaleFactor) {
-				for (; index < end; index++) {
-					const bool sample = (get_sample(index) &
-						sig_mask) != 0;
-					if (sample != last_sample)
-						break;
-				}
-			}
-		}
-
-		//----- Store the edge -----//
+		// Jump to the next transition, skipping idle blocks, chunks
+		// and runs
+		index = find_change(index, end, sig_mask,
+			last_sample ? sig_mask : 0);
 
 		// Take the last sample of the quanization block
-		const int64_t final_index = index + block_length;
-		if (index + block_length > end)
+		const uint64_t final_index = index + block_length;
+		if (final_index > end)
 			break;
 
 		// Store the final state
-		bool final_sample;
-		if( final_index - 1 < sample_count_ - 1 )
-		{
-			final_sample =
-				(get_sample(final_index - 1) & sig_mask) != 0;
-		}
-		else {
-			final_sample =
-				(get_sample(sample_count_ - 1) & sig_mask) != 0;
-		}
+		const bool final_sample = (get_sample(
+			min(final_index - 1, sample_count_ - 1)) & sig_mask) != 0;
 		edges.push_back(pair<int64_t, bool>(index, final_sample));
 
 		index = final_index;
@@ -463,19 +457,5 @@ void LogicSegment::get_subsampled_edges(
 	edges.push_back(pair<int64_t, bool>(end + 1, end_sample));
 }
 
-uint64_t LogicSegment::get_subsample(int level, uint64_t offset) const
-{
-	assert(level >= 0);
-	assert(mip_map_[level].data);
-	return unpack_sample((uint8_t*)mip_map_[level].data +
-		unit_size_ * offset);
-}
-
-uint64_t LogicSegment::pow2_ceil(uint64_t x, unsigned int power)
-{
-	const uint64_t p = 1 << power;
-	return (x + p - 1) / p * p;
-}
-
 } // namespace data
 } // namespace pv
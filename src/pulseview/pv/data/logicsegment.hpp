@@ -23,6 +23,7 @@
 
 #include "segment.hpp"
 
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -41,22 +42,44 @@ struct LongPulses;
 namespace pv {
 namespace data {
 
+/**
+ * Logic samples stored in blocks of BlockSamples samples.
+ *
+ * Full blocks are run-length encoded when that is smaller than the raw
+ * samples, which is the case for buses that are idle most of the time, and
+ * are kept raw otherwise. The block index gives random access, each block
+ * records which channels toggle inside it (and raw blocks do so for every
+ * chunk of ChunkSamples samples), so edge searches skip idle stretches and
+ * walk run boundaries instead of individual samples.
+ */
 class LogicSegment : public Segment
 {
 private:
-	struct MipMapLevel
+	struct Block
 	{
+		/// Number of samples in the block
 		uint64_t length;
-		uint64_t data_length;
-		void *data;
+
+		/// Channels that change value inside the block
+		uint64_t change_mask;
+
+		/// True if the block is stored as runs
+		bool rle;
+
+		/// Offsets of the first sample of each run (RLE only)
+		std::vector<uint16_t> run_offsets;
+
+		/// One value per run (RLE) or per sample (raw), followed by
+		/// padding for the uint64_t read word
+		std::vector<uint8_t> data;
+
+		/// Channels changing value inside each chunk (raw only)
+		std::vector<uint64_t> chunk_masks;
 	};
 
 private:
-	static const unsigned int ScaleStepCount = 10;
-	static const int MipMapScalePower;
-	static const int MipMapScaleFactor;
-	static const float LogMipMapScaleFactor;
-	static const uint64_t MipMapDataUnit;
+	static const uint64_t BlockSamples;
+	static const uint64_t ChunkSamples;
 
 public:
 	typedef std::pair<int64_t, bool> EdgePair;
@@ -73,15 +96,38 @@ public:
 	void get_samples(uint8_t *const data,
 		int64_t start_sample, int64_t end_sample) const;
 
-private:
+	/**
+	 * Gets the number of bytes used to store the samples.
+	 */
+	uint64_t storage_size() const;
+
+	/**
+	 * Gets a single sample, with one bit per channel.
+	 */
+	uint64_t get_sample_value(uint64_t index) const;
+
+	/**
+	 * Finds the first sample in [start, end) on which the channels
+	 * selected by @c mask differ from @c value. Idle blocks, chunks and
+	 * runs are skipped without looking at their samples.
+	 * @return the index of that sample, or @c end if there is none.
+	 */
+	uint64_t find_change(uint64_t start, uint64_t end,
+		uint64_t mask, uint64_t value) const;
+
+	/**
+	 * Reads one sample from a buffer filled by get_samples(). The buffer
+	 * has to stay readable for 8 bytes past the sample.
+	 */
 	uint64_t unpack_sample(const uint8_t *ptr) const;
-	void pack_sample(uint8_t *ptr, uint64_t value);
-	
-	void reallocate_mipmap_level(MipMapLevel &m);
 
-	void append_payload_to_mipmap();
+private:
+	void append_samples(const uint8_t *data, uint64_t samples);
+	void seal_block(Block &block);
+	void clear_blocks();
 
 	uint64_t get_sample(uint64_t index) const;
+	size_t find_run(uint64_t block_index, uint64_t offset) const;
 
 public:
 	/**
@@ -99,14 +145,14 @@ public:
 		float min_length, int sig_index);
 
 private:
-	uint64_t get_subsample(int level, uint64_t offset) const;
-
-	static uint64_t pow2_ceil(uint64_t x, unsigned int power);
-
-private:
-	struct MipMapLevel mip_map_[ScaleStepCount];
+	std::vector<Block> blocks_;
+	uint64_t sample_mask_;
 	uint64_t last_append_sample_;
 
+	// Run lookup cursor, sequential reads resume from here
+	mutable uint64_t cursor_block_;
+	mutable size_t cursor_run_;
+
 	friend struct LogicSegmentTest::Pow2;
 	friend struct LogicSegmentTest::Basic;
 	friend struct LogicSegmentTest::LargeData;
@@ -26,6 +26,7 @@
 #include <iio.h>
 #include <iostream>
 #include "logic_analyzer.hpp"
+#include "../../../trace.hpp"
 
 using std::recursive_mutex;
 using std::lock_guard;
@@ -137,6 +138,7 @@ void BinaryStream::run()
 			nbytes_rx = iio_buffer_refill(data_);
 		nrx += nbytes_rx / 2;
 		if( nbytes_rx > 0 ) {
+			adiscope::Tracer::instant("logic", "capture");
 
 			la->set_triggered_status("running");
 			input_->send(iio_buffer_start(data_), (size_t)(nbytes_rx));
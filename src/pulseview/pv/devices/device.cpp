@@ -76,6 +76,14 @@ T Device::read_config(const ConfigKey *key, const T default_value)
 		device_->config_get(ConfigKey::SAMPLERATE)).get();
 }
 
+void Device::add_datafeed_callback(std::function<void(
+	std::shared_ptr<sigrok::Device>,
+	std::shared_ptr<sigrok::Packet>)> callback)
+{
+	assert(session_);
+	session_->add_datafeed_callback(callback);
+}
+
 void Device::start()
 {
 	assert(session_);
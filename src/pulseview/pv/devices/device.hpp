@@ -21,12 +21,14 @@
 #ifndef PULSEVIEW_PV_DEVICES_DEVICE_HPP
 #define PULSEVIEW_PV_DEVICES_DEVICE_HPP
 
+#include <functional>
 #include <memory>
 #include <string>
 
 namespace sigrok {
 class ConfigKey;
 class Device;
+class Packet;
 class Session;
 } // namespace sigrok
 
@@ -68,6 +70,15 @@ public:
 
 	virtual void close() = 0;
 
+	/**
+	 * Registers the callback that receives the packets of a capture.
+	 * Devices that produce their packets themselves rather than through
+	 * the sigrok session override this.
+	 */
+	virtual void add_datafeed_callback(std::function<void(
+		std::shared_ptr<sigrok::Device>,
+		std::shared_ptr<sigrok::Packet>)> callback);
+
 	virtual void start();
 
 	virtual void run();
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <QByteArray>
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+
+#include "nativefile.hpp"
+
+using std::max;
+using std::shared_ptr;
+using std::vector;
+
+using sigrok::ChannelType;
+using sigrok::ConfigKey;
+using sigrok::Packet;
+using sigrok::Quantity;
+using sigrok::Unit;
+
+namespace pv {
+namespace devices {
+
+NativeFile::NativeFile(const std::shared_ptr<sigrok::Context> &context,
+	const std::string &file_name) :
+	File(file_name),
+	context_(context),
+	map_(nullptr),
+	map_size_(0),
+	interrupt_(false)
+{
+}
+
+NativeFile::~NativeFile()
+{
+	close();
+}
+
+void NativeFile::open()
+{
+	if (session_)
+		close();
+	else
+		session_ = context_->create_session();
+
+	file_.setFileName(QString::fromStdString(file_name_));
+	if (!file_.open(QIODevice::ReadOnly))
+		throw file_.errorString();
+
+	map_size_ = file_.size();
+	map_ = map_size_ ? file_.map(0, map_size_) : nullptr;
+	if (!map_)
+		throw QString("Failed to map the file");
+
+	const size_t header_size = capturefile::decode_header(
+		map_, map_size_, header_);
+	if (!header_size)
+		throw QString("Not a Scopy capture or an unsupported version");
+
+	index_chunks(header_size);
+
+	const auto device = context_->create_user_device(
+		"Scopy", "Capture", "");
+
+	uint32_t index = 0;
+	for (const auto &channel : header_.logic_channels) {
+		device->add_channel(channel.first, ChannelType::LOGIC,
+			channel.second);
+		index = max(index, channel.first + 1);
+	}
+
+	analog_channels_.clear();
+	for (const std::string &name : header_.analog_channels)
+		analog_channels_.push_back(device->add_channel(
+			index++, ChannelType::ANALOG, name));
+
+	device_ = device;
+	session_->add_device(device_);
+}
+
+void NativeFile::close()
+{
+	if (session_)
+		session_->remove_devices();
+
+	chunks_.clear();
+	analog_channels_.clear();
+
+	if (map_) {
+		file_.unmap(const_cast<uint8_t*>(map_));
+		map_ = nullptr;
+	}
+	file_.close();
+}
+
+void NativeFile::add_datafeed_callback(Callback callback)
+{
+	callbacks_.push_back(callback);
+}
+
+void NativeFile::start()
+{
+}
+
+void NativeFile::run()
+{
+	assert(device_);
+
+	interrupt_ = false;
+
+	send(context_->create_header_packet(Glib::TimeVal()));
+	send(context_->create_meta_packet({{ConfigKey::SAMPLERATE,
+		Glib::Variant<guint64>::create(header_.samplerate)}}));
+
+	const unsigned int unit_size = header_.logic_unit_size;
+	QByteArray unpacked;
+	vector<float> aligned;
+
+	for (const Chunk &chunk : chunks_) {
+		if (interrupt_)
+			break;
+
+		const uint8_t *payload = map_ + chunk.offset;
+		if (header_.flags & capturefile::Compressed) {
+			unpacked = qUncompress(payload, chunk.size);
+			if ((size_t)unpacked.size() != capturefile::payload_size(
+					header_, chunk.length))
+				break;
+			payload = (const uint8_t*)unpacked.constData();
+		}
+
+		if (unit_size) {
+			send(context_->create_logic_packet(
+				const_cast<uint8_t*>(payload),
+				(size_t)chunk.length * unit_size, unit_size));
+			payload += (size_t)chunk.length * unit_size;
+		}
+
+		for (const shared_ptr<sigrok::Channel> &channel :
+				analog_channels_) {
+			// The floats follow the logic bytes and are only aligned
+			// when the unit size happens to allow it
+			const float *samples = (const float*)payload;
+			if ((uintptr_t)payload % alignof(float)) {
+				aligned.resize(chunk.length);
+				memcpy(aligned.data(), payload,
+					chunk.length * sizeof(float));
+				samples = aligned.data();
+			}
+
+			send(context_->create_analog_packet({channel},
+				const_cast<float*>(samples), chunk.length,
+				Quantity::VOLTAGE, Unit::VOLT, {}));
+			payload += chunk.length * sizeof(float);
+		}
+	}
+
+	send(context_->create_end_packet());
+}
+
+void NativeFile::stop()
+{
+	interrupt_ = true;
+}
+
+void NativeFile::index_chunks(size_t header_size)
+{
+	const bool compressed = header_.flags & capturefile::Compressed;
+
+	chunks_.clear();
+
+	// Only the chunk headers are touched, so indexing faults in a page
+	// per chunk rather than the samples. A truncated last chunk, as left
+	// by an interrupted export, ends the capture.
+	size_t offset = header_size;
+	while (offset < map_size_) {
+		Chunk chunk;
+		if (!capturefile::decode_chunk_header(map_ + offset,
+				map_size_ - offset, chunk.start, chunk.length,
+				chunk.size))
+			break;
+
+		chunk.offset = offset + capturefile::ChunkHeaderSize;
+		if (chunk.size > map_size_ - chunk.offset)
+			break;
+		if (!compressed && chunk.size != capturefile::payload_size(
+				header_, chunk.length))
+			break;
+
+		chunks_.push_back(chunk);
+		offset = chunk.offset + chunk.size;
+	}
+}
+
+void NativeFile::send(shared_ptr<Packet> packet)
+{
+	for (const Callback &callback : callbacks_)
+		callback(device_, packet);
+}
+
+} // namespace devices
+} // namespace pv
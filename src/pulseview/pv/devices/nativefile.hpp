@@ -0,0 +1,108 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PULSEVIEW_PV_DEVICES_NATIVEFILE_HPP
+#define PULSEVIEW_PV_DEVICES_NATIVEFILE_HPP
+
+#include <atomic>
+#include <vector>
+
+#include <QFile>
+
+#include "file.hpp"
+#include "../capturefile.hpp"
+
+namespace sigrok {
+class Channel;
+class Context;
+} // sigrok
+
+namespace pv {
+namespace devices {
+
+/**
+ * A capture stored in the native format of capturefile.
+ *
+ * The file is memory-mapped rather than read, and open() only decodes
+ * the header and indexes the chunks, so a session of any size opens
+ * at once. run() then feeds the chunks to the session in order, so the
+ * signals appear immediately and fill in as the rest of the file is
+ * paged in. Uncompressed sample data is passed on straight from the
+ * mapping without an intermediate copy.
+ */
+class NativeFile final : public File
+{
+private:
+	typedef std::function<void(std::shared_ptr<sigrok::Device>,
+		std::shared_ptr<sigrok::Packet>)> Callback;
+
+	struct Chunk
+	{
+		uint64_t start;
+		uint32_t length;
+		uint64_t offset;
+		uint32_t size;
+	};
+
+public:
+	NativeFile(const std::shared_ptr<sigrok::Context> &context,
+		const std::string &file_name);
+
+	~NativeFile();
+
+	/**
+	 * Maps the file and indexes its chunks.
+	 * @throws QString if the file can't be read or isn't a capture.
+	 */
+	void open();
+
+	void close();
+
+	void add_datafeed_callback(Callback callback);
+
+	void start();
+
+	void run();
+
+	void stop();
+
+private:
+	void index_chunks(size_t header_size);
+
+	void send(std::shared_ptr<sigrok::Packet> packet);
+
+private:
+	const std::shared_ptr<sigrok::Context> context_;
+
+	QFile file_;
+	const uint8_t *map_;
+	size_t map_size_;
+
+	capturefile::Header header_;
+	std::vector<Chunk> chunks_;
+	std::vector< std::shared_ptr<sigrok::Channel> > analog_channels_;
+
+	std::vector<Callback> callbacks_;
+	std::atomic<bool> interrupt_;
+};
+
+} // namespace devices
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DEVICES_NATIVEFILE_HPP
@@ -42,11 +42,13 @@
 
 #include "mainwindow.hpp"
 
+#include "capturefile.hpp"
 #include "devicemanager.hpp"
 #include "util.hpp"
 #include "data/segment.hpp"
 #include "devices/hardwaredevice.hpp"
 #include "devices/inputfile.hpp"
+#include "devices/nativefile.hpp"
 #include "devices/sessionfile.hpp"
 #include "dialogs/about.hpp"
 #include "dialogs/connect.hpp"
@@ -272,7 +274,16 @@ QString MainWindow::export_file()
 	std::pair<uint64_t, uint64_t> sample_range;
 	sample_range = std::make_pair(0, 0);
 
-	// Construct the filter for file dialog
+	// Construct the filter for file dialog, starting with the native
+	// capture format
+	const QString native_filter = tr("Scopy capture files (*.%1)").arg(
+		capturefile::Extension);
+	const QString compressed_filter =
+		tr("Compressed Scopy capture files (*.%1)").arg(
+		capturefile::Extension);
+	exts.push_back(capturefile::Extension);
+	filter += native_filter + ";;" + compressed_filter + ";;";
+
 	const map<string, shared_ptr<sigrok::OutputFormat> > formats =
 		device_manager_.context()->output_formats();
 	for( const pair<string, shared_ptr<sigrok::OutputFormat>> &f : formats) {
@@ -305,14 +316,21 @@ QString MainWindow::export_file()
 	const QString abs_path = QFileInfo(file_name).absolutePath();
 	settings.setValue(SettingSaveDirectory, abs_path);
 
-	if(selectedFilter != "")
-		outputFormat = get_output_format_from_string(selectedFilter);
-	if(!outputFormat)
-		return "";
+	map<string, Glib::VariantBase> options;
+	if (selectedFilter == native_filter ||
+			selectedFilter == compressed_filter) {
+		// The native format is written without a sigrok output
+		options["compress"] = Glib::Variant<bool>::create(
+			selectedFilter == compressed_filter);
+	} else {
+		if(selectedFilter != "")
+			outputFormat = get_output_format_from_string(selectedFilter);
+		if(!outputFormat)
+			return "";
+	}
 
 	// Show the options dialog
-	map<string, Glib::VariantBase> options;
-	if (!outputFormat->options().empty()) {
+	if (outputFormat && !outputFormat->options().empty()) {
 		dialogs::InputOutputOptions dlg(
 			tr("Export %1").arg(QString::fromStdString(
 				outputFormat->description())),
@@ -760,6 +778,12 @@ void MainWindow::load_file(QString file_name,
 					device_manager_.context(),
 					file_name.toStdString(),
 					format, options)));
+		else if (QFileInfo(file_name).suffix() ==
+				capturefile::Extension)
+			session_.set_device(shared_ptr<devices::Device>(
+				new devices::NativeFile(
+					device_manager_.context(),
+					file_name.toStdString())));
 		else
 			session_.set_device(shared_ptr<devices::Device>(
 				new devices::SessionFile(
@@ -770,6 +794,11 @@ void MainWindow::load_file(QString file_name,
 		session_.set_default_device();
 		update_device_list();
 		return;
+	} catch (QString e) {
+		show_session_error(tr("Failed to load ") + file_name, e);
+		session_.set_default_device();
+		update_device_list();
+		return;
 	}
 
 	update_device_list();
@@ -809,6 +838,7 @@ void MainWindow::on_actionOpen_triggered()
 	const QString file_name = QFileDialog::getOpenFileName(
 		this, tr("Open File"), dir, tr(
 			"Sigrok Sessions (*.sr);;"
+			"Scopy capture files (*.scap);;"
 			"All Files (*.*)"));
 
 	if (!file_name.isEmpty()) {
@@ -156,7 +156,7 @@ void Session::set_device(shared_ptr<devices::Device> device)
 
 	device_ = std::move(device);
 	device_->open();
-	device_->session()->add_datafeed_callback([=]
+	device_->add_datafeed_callback([=]
 		(shared_ptr<sigrok::Device> device, shared_ptr<Packet> packet) {
 			data_feed_in(device, packet);
 		});
@@ -18,7 +18,11 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
  */
 
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <utility>
 
 #ifdef _WIN32
 // Windows: Avoid boost/thread namespace pollution (which includes windows.h).
@@ -44,19 +48,25 @@
 using boost::shared_lock;
 using boost::shared_mutex;
 
+using std::condition_variable;
 using std::deque;
 using std::dynamic_pointer_cast;
 using std::ios_base;
 using std::lock_guard;
 using std::make_pair;
 using std::map;
+using std::max;
 using std::min;
+using std::move;
 using std::mutex;
 using std::pair;
 using std::set;
 using std::shared_ptr;
+using std::sort;
 using std::string;
 using std::thread;
+using std::unique_lock;
+using std::unique_ptr;
 using std::unordered_set;
 using std::vector;
 
@@ -69,7 +79,86 @@ using sigrok::OutputFlag;
 
 namespace pv {
 
+namespace {
+
+/**
+ * A bounded FIFO between two stages of the store pipeline. Closing it
+ * wakes up both sides; the consumers still drain what was queued.
+ */
+template<typename T>
+class BlockingQueue
+{
+public:
+	explicit BlockingQueue(size_t capacity) :
+		capacity_(capacity),
+		closed_(false)
+	{
+	}
+
+	bool push(T item)
+	{
+		unique_lock<mutex> lock(mutex_);
+		not_full_.wait(lock, [this]() {
+			return closed_ || items_.size() < capacity_; });
+		if (closed_)
+			return false;
+
+		items_.push_back(move(item));
+		not_empty_.notify_one();
+		return true;
+	}
+
+	bool pop(T &item)
+	{
+		unique_lock<mutex> lock(mutex_);
+		not_empty_.wait(lock, [this]() {
+			return closed_ || !items_.empty(); });
+		if (items_.empty())
+			return false;
+
+		item = move(items_.front());
+		items_.pop_front();
+		not_full_.notify_one();
+		return true;
+	}
+
+	void close()
+	{
+		lock_guard<mutex> lock(mutex_);
+		closed_ = true;
+		not_empty_.notify_all();
+		not_full_.notify_all();
+	}
+
+private:
+	const size_t capacity_;
+	bool closed_;
+	deque<T> items_;
+	mutex mutex_;
+	condition_variable not_empty_, not_full_;
+};
+
+/// A formatted chunk on its way to the writer.
+struct Formatted
+{
+	uint64_t index;
+	uint64_t length;
+	string data;
+};
+
+}
+
+/// A block of samples read from the segments.
+struct StoreSession::Chunk
+{
+	uint64_t index;
+	uint64_t start, length;
+	vector<uint8_t> logic;
+	vector< unique_ptr<float[]> > analog;
+};
+
 const size_t StoreSession::BlockSize = 1024 * 1024;
+const size_t StoreSession::QueueDepth = 4;
 
 StoreSession::StoreSession(const std::string &file_name,
 	const shared_ptr<OutputFormat> &output_format,
@@ -132,6 +221,9 @@ bool StoreSession::start()
 
 			lsegment = lsegments.front();
 			any_segment = lsegment;
+
+			native_header_.logic_channels.push_back(make_pair(
+				signal->channel()->index(), signal->channel()->name()));
 		}
 
 		if (dynamic_pointer_cast<data::Analog>(data)) {
@@ -151,9 +243,14 @@ bool StoreSession::start()
 			any_segment = asegments.front();
 
 			achannel_list.push_back(signal->channel());
+			native_header_.analog_channels.push_back(
+				signal->channel()->name());
 		}
 	}
 
+	sort(native_header_.logic_channels.begin(),
+		native_header_.logic_channels.end());
+
 	if (!any_segment) {
 		error_ = tr("No channels enabled.");
 		return false;
@@ -178,7 +275,26 @@ bool StoreSession::start()
 	}
 
 	// Begin storing
-	try {
+	if (!output_format_) {
+		const auto compress = options_.find("compress");
+		native_header_.flags = (compress != options_.end() &&
+			VariantBase::cast_dynamic< Glib::Variant<bool> >(
+				(*compress).second).get()) ?
+			capturefile::Compressed : 0;
+		native_header_.samplerate = any_segment->samplerate();
+		native_header_.sample_count = sample_count_;
+		native_header_.logic_unit_size =
+			lsegment ? lsegment->unit_size() : 0;
+
+		output_stream_.open(file_name_, ios_base::binary |
+			ios_base::trunc | ios_base::out);
+		output_stream_ << capturefile::encode_header(native_header_);
+		if (!output_stream_) {
+			error_ = tr("Error while saving: can't write %1").arg(
+				QString::fromStdString(file_name_));
+			return false;
+		}
+	} else try {
 		const auto context = session_.device_manager().context();
 		auto device = session_.device()->device();
 
@@ -214,16 +330,20 @@ void StoreSession::cancel()
 	interrupt_ = true;
 }
 
+void StoreSession::fail(const QString &message)
+{
+	lock_guard<mutex> lock(mutex_);
+	if (error_.isEmpty())
+		error_ = message;
+	interrupt_ = true;
+}
+
 void StoreSession::store_proc(vector< shared_ptr<sigrok::Channel> > achannel_list,
 	vector< shared_ptr<data::AnalogSegment> > asegment_list,
 	shared_ptr<data::LogicSegment> lsegment)
 {
 	unsigned progress_scale = 0;
 
-	/// TODO: Wrap this in a std::unique_ptr when we transition to C++11
-	uint8_t *const ldata = new uint8_t[BlockSize];
-	assert(ldata);
-
 	int aunit_size = 0;
 	int lunit_size = 0;
 	unsigned int lsamples_per_block = INT_MAX;
@@ -245,60 +365,145 @@ void StoreSession::store_proc(vector< shared_ptr<sigrok::Channel> > achannel_lis
 		progress_scale ++;
 
 	unit_count_ = sample_count_ >> progress_scale;
+	progress_updated();
 
 	const unsigned int samples_per_block =
 		std::min(asamples_per_block, lsamples_per_block);
 
-	while (!interrupt_ && sample_count_) {
-		progress_updated();
-
-		const uint64_t packet_len =
-			std::min((uint64_t)samples_per_block, sample_count_);
-
-		try {
-			const auto context = session_.device_manager().context();
+	// The store runs as a pipeline: a reader fetches the blocks, the
+	// formatters turn them into file contents and a writer streams those
+	// to disk in order. The sigrok output modules keep state from one
+	// packet to the next, so they get a single formatter, while the
+	// chunks of the native format are encoded by a pool of them.
+	const bool native = !output_format_;
+	const unsigned int formatter_count = native ?
+		max(2U, thread::hardware_concurrency()) - 1 : 1;
+
+	BlockingQueue< unique_ptr<Chunk> > read_queue(
+		QueueDepth + formatter_count);
+	BlockingQueue<Formatted> write_queue(QueueDepth + formatter_count);
+
+	thread reader([&]() {
+		uint64_t start = start_sample_, remaining = sample_count_;
+
+		for (uint64_t index = 0; !interrupt_ && remaining; index++) {
+			unique_ptr<Chunk> chunk(new Chunk);
+			chunk->index = index;
+			chunk->start = start;
+			chunk->length = min((uint64_t)samples_per_block, remaining);
+
+			const uint64_t end = start + chunk->length;
+			for (const auto &asegment : asegment_list)
+				chunk->analog.emplace_back(
+					asegment->get_samples(start, end));
 
-			for (unsigned int i = 0; i < achannel_list.size(); i++) {
-				shared_ptr<sigrok::Channel> achannel = achannel_list.at(i);
-				shared_ptr<data::AnalogSegment> asegment = asegment_list.at(i);
-
-				const float *adata =
-					asegment->get_samples(start_sample_, start_sample_ + packet_len);
+			if (lsegment) {
+				chunk->logic.resize(chunk->length * lunit_size);
+				lsegment->get_samples(chunk->logic.data(), start, end);
+			}
 
-				// The srzip format currently only supports packets with one
-				// analog channel. See zip_append_analog() in srzip.c
-				auto analog = context->create_analog_packet(
-					vector<shared_ptr<sigrok::Channel> >{achannel},
-					(float *)adata, packet_len,
-					sigrok::Quantity::VOLTAGE, sigrok::Unit::VOLT,
-					vector<const sigrok::QuantityFlag *>());
-				const string adata_str = output_->receive(analog);
+			start = end;
+			remaining -= chunk->length;
 
-				if (output_stream_.is_open())
-					output_stream_ << adata_str;
+			if (!read_queue.push(move(chunk)))
+				break;
+		}
 
-				delete[] adata;
+		read_queue.close();
+	});
+
+	thread writer([&]() {
+		// Chunks may arrive out of order from the native formatters
+		map<uint64_t, Formatted> pending;
+		uint64_t next = 0, stored = 0;
+
+		Formatted formatted;
+		while (write_queue.pop(formatted)) {
+			const uint64_t index = formatted.index;
+			pending[index] = move(formatted);
+
+			for (auto iter = pending.find(next); iter != pending.end();
+					iter = pending.find(next)) {
+				if (!interrupt_ && output_stream_.is_open()) {
+					const string &data = (*iter).second.data;
+					output_stream_.write(data.data(), data.size());
+					if (!output_stream_)
+						fail(tr("Error while saving: can't write %1")
+							.arg(QString::fromStdString(file_name_)));
+				}
+
+				stored += (*iter).second.length;
+				units_stored_ = stored >> progress_scale;
+				progress_updated();
+
+				pending.erase(iter);
+				next++;
 			}
+		}
+	});
 
-			if (lsegment) {
-				lsegment->get_samples(ldata, start_sample_, start_sample_ + packet_len);
-
-				const size_t length = packet_len * lunit_size;
-				auto logic = context->create_logic_packet(ldata, length, lunit_size);
-				const string ldata_str = output_->receive(logic);
+	const auto format = [&]() {
+		const auto context = session_.device_manager().context();
 
-				if (output_stream_.is_open())
-					output_stream_ << ldata_str;
+		unique_ptr<Chunk> chunk;
+		while (read_queue.pop(chunk)) {
+			if (interrupt_)
+				continue;
+
+			Formatted formatted;
+			formatted.index = chunk->index;
+			formatted.length = chunk->length;
+
+			try {
+				if (native) {
+					vector<const float*> analog;
+					for (const auto &samples : chunk->analog)
+						analog.push_back(samples.get());
+
+					formatted.data = capturefile::encode_chunk(
+						native_header_, chunk->start, chunk->length,
+						lsegment ? chunk->logic.data() : nullptr,
+						analog);
+				} else {
+					for (unsigned int i = 0; i < achannel_list.size(); i++) {
+						// The srzip format currently only supports packets
+						// with one analog channel. See zip_append_analog()
+						// in srzip.c
+						auto analog = context->create_analog_packet(
+							vector<shared_ptr<sigrok::Channel> >{
+								achannel_list.at(i)},
+							chunk->analog.at(i).get(), chunk->length,
+							sigrok::Quantity::VOLTAGE, sigrok::Unit::VOLT,
+							vector<const sigrok::QuantityFlag *>());
+						formatted.data += output_->receive(analog);
+					}
+
+					if (lsegment) {
+						auto logic = context->create_logic_packet(
+							chunk->logic.data(), chunk->logic.size(),
+							lunit_size);
+						formatted.data += output_->receive(logic);
+					}
+				}
+			} catch (Error error) {
+				fail(tr("Error while saving: ") + error.what());
+				continue;
 			}
-		} catch (Error error) {
-			error_ = tr("Error while saving: ") + error.what();
-			break;
+
+			write_queue.push(move(formatted));
 		}
+	};
 
-		sample_count_ -= packet_len;
-		start_sample_ += packet_len;
-		units_stored_ = unit_count_ - (sample_count_ >> progress_scale);
-	}
+	vector<thread> formatters;
+	for (unsigned int i = 1; i < formatter_count; i++)
+		formatters.emplace_back(format);
+	format();
+	for (thread &t : formatters)
+		t.join();
+
+	write_queue.close();
+	reader.join();
+	writer.join();
 
 	// Zeroing the progress variables indicates completion
 	units_stored_ = unit_count_ = 0;
@@ -307,8 +512,6 @@ void StoreSession::store_proc(vector< shared_ptr<sigrok::Channel> > achannel_lis
 
 	output_.reset();
 	output_stream_.close();
-
-	delete[] ldata;
 }
 
 } // pv
@@ -35,6 +35,8 @@
 
 #include <QObject>
 
+#include "capturefile.hpp"
+
 namespace sigrok {
 class Channel;
 class Output;
@@ -56,8 +58,16 @@ class StoreSession : public QObject
 
 private:
 	static const size_t BlockSize;
+	static const size_t QueueDepth;
+
+	struct Chunk;
 
 public:
+	/**
+	 * Stores the selected channels. A null @c output_format stores
+	 * them in the native capture format, compressed if @c options
+	 * holds "compress" set to true.
+	 */
 	StoreSession(const std::string &file_name,
 		const std::shared_ptr<sigrok::OutputFormat> &output_format,
 		const std::map<std::string, Glib::VariantBase> &options,
@@ -77,6 +87,8 @@ public:
 	void cancel();
 
 private:
+	void fail(const QString &message);
+
 	void store_proc(std::vector< std::shared_ptr<sigrok::Channel> > achannel_list,
 		std::vector< std::shared_ptr<pv::data::AnalogSegment> > asegment_list,
 		std::shared_ptr<pv::data::LogicSegment> lsegment);
@@ -94,6 +106,8 @@ private:
 	std::shared_ptr<sigrok::Output> output_;
 	std::ofstream output_stream_;
 
+	capturefile::Header native_header_;
+
 	std::thread thread_;
 
 	std::atomic<bool> interrupt_;
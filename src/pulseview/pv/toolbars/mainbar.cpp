@@ -520,7 +520,8 @@ bool MainBar::eventFilter(QObject *watched, QEvent *event)
 	if (sample_count_supported_ && (watched == &sample_count_ ||
 			watched == &sample_rate_) &&
 			(event->type() == QEvent::ToolTip)) {
-		auto sec = pv::util::Timestamp(sample_count_.value()) / sample_rate_.value();
+		auto sec = pv::util::Timestamp::from_samples(
+			sample_count_.value(), sample_rate_.value());
 		QHelpEvent *help_event = static_cast<QHelpEvent*>(event);
 
 		QString str = tr("Total sampling time: %1").arg(
@@ -25,7 +25,8 @@
 #include <assert.h>
 
 #include <algorithm>
-#include <sstream>
+#include <climits>
+#include <stdexcept>
 
 #include <QTextStream>
 #include <QDebug>
@@ -59,38 +60,334 @@ static SIPrefix successor(SIPrefix prefix)
 	return static_cast<SIPrefix>(static_cast<int>(prefix) + 1);
 }
 
-// Insert the timestamp value into the stream in fixed-point notation
-// (and honor the precision)
-static QTextStream& operator<<(QTextStream& stream, const Timestamp& t)
+typedef Timestamp::rep rep;
+
+static const int RepBits = sizeof(rep) * CHAR_BIT;
+static const rep RepMax = ~((rep)1 << (RepBits - 1));
+
+// Largest power of ten that fits into a rep
+static const int MaxPow10 = (RepBits == 128) ? 38 : 18;
+
+static const int ScaleDigits = Timestamp::ScaleDigits;
+
+// Returns 10^n for 0 <= n <= MaxPow10
+static rep pow10(int n)
+{
+	assert(n >= 0 && n <= MaxPow10);
+
+	rep r = 1;
+	while (n-- > 0)
+		r *= 10;
+	return r;
+}
+
+static rep magnitude(rep v)
+{
+	return v < 0 ? -v : v;
+}
+
+static rep gcd(rep a, rep b)
+{
+	while (b) {
+		const rep r = a % b;
+		a = b;
+		b = r;
+	}
+	return magnitude(a);
+}
+
+// True if a * b fits into a rep
+static bool mul_fits(rep a, rep b)
+{
+	return b == 0 || magnitude(a) <= RepMax / magnitude(b);
+}
+
+static std::string to_decimal(rep v)
+{
+	assert(v >= 0);
+
+	char buf[48];
+	char *p = buf + sizeof(buf);
+	*--p = '\0';
+	do {
+		*--p = '0' + (int)(v % 10);
+		v /= 10;
+	} while (v);
+
+	return std::string(p);
+}
+
+// Formats 'v' (a non-negative tick count) in units of 10^unit_exp
+// seconds with 'precision' decimal places, rounding half away from zero.
+static std::string to_fixed(rep v, int unit_exp, unsigned precision)
+{
+	const int frac_digits = ScaleDigits + unit_exp;
+	assert(frac_digits >= 0);
+
+	// Digits past the tick resolution are always zero
+	const unsigned exact = std::min<unsigned>(precision, frac_digits);
+	const rep n = Timestamp::round_div(v, pow10(frac_digits - exact));
+
+	std::string str = to_decimal(n);
+	if (str.size() <= exact)
+		str.insert(0, exact + 1 - str.size(), '0');
+	if (precision > 0) {
+		str.insert(str.size() - exact, 1, '.');
+		str.append(precision - exact, '0');
+	}
+
+	return str;
+}
+
+Timestamp::Timestamp(const std::string& str) :
+	Timestamp(str.c_str())
+{
+}
+
+Timestamp::Timestamp(const char *str) :
+	ticks_(0)
 {
-	// The multiprecision types already have a function and a stream insertion
-	// operator to convert them to a string, however these functions abuse a
-	// precision value of zero to print all available decimal places instead of
-	// none, and the boost authors refuse to fix this because they don't want
-	// to break buggy code that relies on this bug.
-	// (https://svn.boost.org/trac/boost/ticket/10103)
-	// Therefore we have to work around the case where precision is zero.
+	const char *p = str;
+	bool negative = false;
+
+	if (*p == '+' || *p == '-')
+		negative = (*p++ == '-');
+
+	// Collect the significant digits and the decimal exponent
+	rep mantissa = 0;
+	int exp = 0, digits = 0;
+	bool dropped = false, round_up = false;
+
+	for (bool seen_point = false; ; p++) {
+		if (*p == '.' && !seen_point) {
+			seen_point = true;
+			continue;
+		}
+		if (*p < '0' || *p > '9')
+			break;
+
+		digits++;
+		if (mantissa < pow10(MaxPow10 - 2)) {
+			mantissa = mantissa * 10 + (*p - '0');
+			if (seen_point)
+				exp--;
+		} else {
+			if (!dropped)
+				round_up = (*p >= '5');
+			dropped = true;
+			if (!seen_point)
+				exp++;
+		}
+	}
+
+	if (digits == 0)
+		throw std::runtime_error("Invalid timestamp: " + std::string(str));
+
+	if (*p == 'e' || *p == 'E') {
+		p++;
+		bool exp_negative = false;
+		if (*p == '+' || *p == '-')
+			exp_negative = (*p++ == '-');
+		if (*p < '0' || *p > '9')
+			throw std::runtime_error("Invalid timestamp: " +
+				std::string(str));
+
+		int e = 0;
+		for (; *p >= '0' && *p <= '9'; p++)
+			e = std::min(e * 10 + (*p - '0'), 10000);
+		exp += exp_negative ? -e : e;
+	}
+
+	if (*p != '\0')
+		throw std::runtime_error("Invalid timestamp: " + std::string(str));
+
+	if (round_up)
+		mantissa++;
+
+	// Scale the mantissa to ticks
+	exp += ScaleDigits;
+	if (exp >= 0) {
+		if (exp > MaxPow10 || (mantissa && mantissa >
+				(((rep)1 << (RepBits - 2)) / pow10(exp))))
+			throw std::runtime_error("Timestamp out of range: " +
+				std::string(str));
+		ticks_ = mantissa * pow10(exp);
+	} else {
+		ticks_ = (-exp > MaxPow10) ? 0 :
+			round_div(mantissa, pow10(-exp));
+	}
 
-	int precision = stream.realNumberPrecision();
+	if (negative)
+		ticks_ = -ticks_;
+}
+
+// Reduces samplerate / Scale for the exact sample index computations.
+// Returns false if the rate is not integral or the product would overflow.
+static bool sample_ratio(rep ticks, double samplerate, rep& num, rep& den)
+{
+	// Integral sample rates, which is what hardware reports, allow the
+	// index to be computed exactly in integer arithmetic.
+	if (samplerate != std::floor(samplerate) || samplerate <= 0 ||
+			samplerate >= 9.0e15)
+		return false;
 
-	std::ostringstream ss;
-	ss << std::fixed;
+	num = (rep)samplerate;
+	den = Timestamp::Scale;
 
-	if (stream.numberFlags() & QTextStream::ForceSign)
-		ss << std::showpos;
+	const rep g = gcd(num, den);
+	num /= g;
+	den /= g;
 
-	if (0 == precision)
-		ss << std::setprecision(1) << round(t);
-	else
-		ss << std::setprecision(precision) << t;
+	return magnitude(ticks) <= RepMax / num;
+}
 
-	std::string str(ss.str());
-	if (0 == precision) {
-		// remove the separator and the unwanted decimal place
-		str.resize(str.size() - 2);
+Timestamp Timestamp::from_samples(int64_t index, double samplerate)
+{
+	// index * Scale / samplerate, with the common factors of Scale and
+	// an integral sample rate cancelled
+	if (samplerate == std::floor(samplerate) && samplerate > 0 &&
+			samplerate < 9.0e15) {
+		const rep rate = (rep)samplerate;
+		const rep g = gcd(Scale, rate);
+
+		if (mul_fits(index, Scale / g))
+			return from_ticks(round_div(index * (Scale / g),
+				rate / g));
 	}
 
-	return stream << QString::fromStdString(str);
+	return from_ticks(from_real((long double)index * Scale / samplerate));
+}
+
+int64_t Timestamp::floor_samples(double samplerate) const
+{
+	rep num, den;
+
+	if (sample_ratio(ticks_, samplerate, num, den)) {
+		const rep n = ticks_ * num;
+		rep q = n / den;
+		if (n % den < 0)
+			q--;
+		return (int64_t)q;
+	}
+
+	return (int64_t)std::floor((long double)ticks_ * samplerate / Scale);
+}
+
+int64_t Timestamp::ceil_samples(double samplerate) const
+{
+	rep num, den;
+
+	if (sample_ratio(ticks_, samplerate, num, den)) {
+		const rep n = ticks_ * num;
+		rep q = n / den;
+		if (n % den > 0)
+			q++;
+		return (int64_t)q;
+	}
+
+	return (int64_t)std::ceil((long double)ticks_ * samplerate / Scale);
+}
+
+std::string Timestamp::str() const
+{
+	const rep v = magnitude(ticks_);
+	std::string s = to_decimal(v / Scale);
+
+	rep frac = v % Scale;
+	if (frac) {
+		int digits = ScaleDigits;
+		while (frac % 10 == 0) {
+			frac /= 10;
+			digits--;
+		}
+
+		std::string f = to_decimal(frac);
+		s += '.' + std::string(digits - f.size(), '0') + f;
+	}
+
+	return (ticks_ < 0) ? '-' + s : s;
+}
+
+Timestamp Timestamp::mul(const Timestamp& a, const Timestamp& b)
+{
+	// Exact if the product of the tick counts cannot overflow or if one
+	// operand is a whole number, which covers the common powers of ten.
+	if (mul_fits(a.ticks_, b.ticks_))
+		return from_ticks(round_div(a.ticks_ * b.ticks_, Scale));
+	if (b.ticks_ % Scale == 0 && mul_fits(a.ticks_, b.ticks_ / Scale))
+		return from_ticks(a.ticks_ * (b.ticks_ / Scale));
+	if (a.ticks_ % Scale == 0 && mul_fits(b.ticks_, a.ticks_ / Scale))
+		return from_ticks(b.ticks_ * (a.ticks_ / Scale));
+
+	return from_ticks(from_real(
+		(long double)a.ticks_ * b.ticks_ / Scale));
+}
+
+Timestamp Timestamp::div(const Timestamp& a, const Timestamp& b)
+{
+	if (b.ticks_ == 0)
+		return from_ticks(a.ticks_ < 0 ? -RepMax : RepMax);
+
+	// a * Scale / b, with the common factors of Scale and b cancelled
+	const rep g = gcd(Scale, b.ticks_);
+	const rep num = Scale / g, den = b.ticks_ / g;
+
+	if (mul_fits(a.ticks_, num))
+		return from_ticks(round_div(a.ticks_ * num, den));
+
+	return from_ticks(from_real(
+		(long double)a.ticks_ * Scale / b.ticks_));
+}
+
+Timestamp floor(const Timestamp& t)
+{
+	const rep ticks = t.ticks();
+	rep q = ticks / Timestamp::Scale;
+	if (ticks % Timestamp::Scale < 0)
+		q--;
+	return Timestamp::from_ticks(q * Timestamp::Scale);
+}
+
+Timestamp ceil(const Timestamp& t)
+{
+	const rep ticks = t.ticks();
+	rep q = ticks / Timestamp::Scale;
+	if (ticks % Timestamp::Scale > 0)
+		q++;
+	return Timestamp::from_ticks(q * Timestamp::Scale);
+}
+
+Timestamp round(const Timestamp& t)
+{
+	return Timestamp::from_ticks(Timestamp::round_div(
+		t.ticks(), Timestamp::Scale) * Timestamp::Scale);
+}
+
+Timestamp fmod(const Timestamp& t, const Timestamp& d)
+{
+	if (d.is_zero())
+		return Timestamp();
+	return Timestamp::from_ticks(t.ticks() % d.ticks());
+}
+
+Timestamp pow(const Timestamp& base, int exp)
+{
+	// Negative powers are built from the reciprocal, so that small values
+	// such as 10^-12 never go through an out of range intermediate
+	Timestamp r(1), b(exp < 0 ? Timestamp(1) / base : base);
+	for (unsigned int e = std::abs(exp); e; e >>= 1) {
+		if (e & 1)
+			r *= b;
+		if (e > 1)
+			b *= b;
+	}
+
+	return r;
+}
+
+Timestamp log10(const Timestamp& t)
+{
+	return Timestamp(std::log10(t.convert_to<long double>()));
 }
 
 QString format_time_si(
@@ -106,9 +403,11 @@ QString format_time_si(
 		if (v.is_zero()) {
 			prefix = SIPrefix::none;
 		} else {
+			// Same as comparing |v| * 10^exp with 999, in integers
+			const rep ticks = magnitude(v.ticks());
 			int exp = exponent(SIPrefix::milli);
 			prefix = SIPrefix::pico;
-			while ((fabs(v) * pow(Timestamp(10), exp)) > 999 &&
+			while (ticks > 999 * pow10(ScaleDigits - exp) &&
 					prefix < SIPrefix::milli) {
 				prefix = successor(prefix);
 				exp -= 3;
@@ -119,15 +418,15 @@ QString format_time_si(
     assert(prefix >= SIPrefix::pico);
     assert(prefix <= SIPrefix::kilo);
 
-	const Timestamp multiplier = pow(Timestamp(10), -exponent(prefix));
-
 	QString s;
 	QTextStream ts(&s);
-	if (sign && !v.is_zero())
-		ts << forcesign;
+	if (v < 0)
+		ts << '-';
+	else if (sign && !v.is_zero())
+		ts << '+';
 	ts
-		<< qSetRealNumberPrecision(precision)
-		<< (v * multiplier)
+		<< QString::fromStdString(to_fixed(magnitude(v.ticks()),
+			exponent(prefix), precision))
 		<< ' '
 		<< prefix
 		<< unit;
@@ -162,11 +461,12 @@ static QString pad_number(unsigned int number, int length)
 
 QString format_time_minutes(const Timestamp& t, signed precision, bool sign)
 {
-	const Timestamp whole_seconds = floor(abs(t));
-	const Timestamp days = floor(whole_seconds / (60 * 60 * 24));
-	const unsigned int hours = fmod(whole_seconds / (60 * 60), 24).convert_to<uint>();
-	const unsigned int minutes = fmod(whole_seconds / 60, 60).convert_to<uint>();
-	const unsigned int seconds = fmod(whole_seconds, 60).convert_to<uint>();
+	const rep ticks = magnitude(t.ticks());
+	const rep whole_seconds = ticks / Timestamp::Scale;
+	const rep days = whole_seconds / (60 * 60 * 24);
+	const unsigned int hours = (whole_seconds / (60 * 60)) % 24;
+	const unsigned int minutes = (whole_seconds / 60) % 60;
+	const unsigned int seconds = whole_seconds % 60;
 
 	QString s;
 	QTextStream ts(&s);
@@ -180,7 +480,7 @@ QString format_time_minutes(const Timestamp& t, signed precision, bool sign)
 
 	// DD
 	if (days) {
-		ts << days.str().c_str() << ":";
+		ts << to_decimal(days).c_str() << ":";
 		use_padding = true;
 	}
 
@@ -198,23 +498,16 @@ QString format_time_minutes(const Timestamp& t, signed precision, bool sign)
 	// SS
 	ts << pad_number(seconds, 2);
 
-	if (precision) {
+	if (precision > 0) {
 		ts << ".";
 
-		const Timestamp fraction = fabs(t) - whole_seconds;
-
-		std::ostringstream ss;
-		ss
-			<< std::fixed
-			<< std::setprecision(precision)
-			<< std::setfill('0')
-			<< fraction;
-		std::string fs = ss.str();
+		const std::string frac_str = to_fixed(ticks % Timestamp::Scale, 0,
+			precision);
 
 		// Copy all digits, inserting spaces as unit separators
 		for (int i = 1; i <= precision; i++) {
 			// Start at index 2 to skip the "0." at the beginning
-			ts << fs.at(1 + i);
+			ts << frac_str.at(1 + i);
 
 			if ((i > 0) && (i % 3 == 0) && (i != precision))
 				ts << " ";
@@ -21,11 +21,11 @@
 #ifndef PULSEVIEW_UTIL_HPP
 #define PULSEVIEW_UTIL_HPP
 
+#include <climits>
 #include <cmath>
-
-#ifndef Q_MOC_RUN
-#include <boost/multiprecision/cpp_dec_float.hpp>
-#endif
+#include <cstdint>
+#include <string>
+#include <type_traits>
 
 #include <QMetaType>
 #include <QString>
@@ -47,10 +47,340 @@ enum class SIPrefix {
 /// Returns the exponent that corresponds to a given prefix.
 int exponent(SIPrefix prefix);
 
-/// Timestamp type providing picosecond resolution.
-typedef boost::multiprecision::number<
-	boost::multiprecision::cpp_dec_float<12>,
-	boost::multiprecision::et_off> Timestamp;
+/**
+ * Fixed-point timestamp type.
+ *
+ * The value is held as a signed count of ticks. Where the compiler offers a
+ * 128-bit integer a tick is one femtosecond, which covers more than 10^23
+ * seconds. Elsewhere (32-bit targets, MSVC) the count is a 64-bit number of
+ * picoseconds, which still spans more than 100 days. Addition, subtraction,
+ * comparison and scaling by integers are exact integer operations, products
+ * and ratios of two timestamps are exact as long as the intermediate result
+ * fits into the representation and only scaling by floating point values
+ * goes through a long double. Conversions from and scaling by integers
+ * saturate rather than wrap around when the result is out of range, and
+ * from_samples() converts a sample index without the intermediate number
+ * of seconds.
+ *
+ * The interface mirrors the subset of boost::multiprecision that the view
+ * code used before, so timestamps can still be mixed freely with integers
+ * and doubles.
+ */
+class Timestamp
+{
+public:
+#ifdef __SIZEOF_INT128__
+	__extension__ typedef __int128 rep;
+
+	/// Number of ticks (femtoseconds) per second.
+	static const int64_t Scale = 1000000000000000LL;
+	static const int ScaleDigits = 15;
+#else
+	typedef int64_t rep;
+
+	/// Number of ticks (picoseconds) per second.
+	static const int64_t Scale = 1000000000000LL;
+	static const int ScaleDigits = 12;
+#endif
+
+	Timestamp() :
+		ticks_(0)
+	{}
+
+	template<typename T, typename std::enable_if<
+		std::is_integral<T>::value, int>::type = 0>
+	Timestamp(T v) :
+		ticks_(mul_sat(to_rep_sat(v), Scale))
+	{}
+
+	template<typename T, typename std::enable_if<
+		std::is_floating_point<T>::value, int>::type = 0>
+	Timestamp(T v) :
+		ticks_(from_real((long double)v * Scale))
+	{}
+
+	/**
+	 * Parses a decimal number such as "1.5", "-2" or "100e-12".
+	 * Throws std::runtime_error if the string is not a valid number.
+	 */
+	explicit Timestamp(const std::string& str);
+	explicit Timestamp(const char *str);
+
+	static Timestamp from_ticks(rep ticks)
+	{
+		Timestamp t;
+		t.ticks_ = ticks;
+		return t;
+	}
+
+	rep ticks() const { return ticks_; }
+
+	/// Returns the time of the given sample, i.e. index / samplerate. The
+	/// result is exact for integral sample rates.
+	static Timestamp from_samples(int64_t index, double samplerate);
+
+	/// Converts to an integer (truncating toward zero) or a floating
+	/// point type.
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value, T>::type
+	convert_to() const
+	{
+		return (T)(ticks_ / Scale);
+	}
+
+	template<typename T>
+	typename std::enable_if<std::is_floating_point<T>::value, T>::type
+	convert_to() const
+	{
+		return (T)((long double)ticks_ / Scale);
+	}
+
+	/**
+	 * Returns the index of the sample at or before this time for the given
+	 * sample rate, i.e. floor(t * samplerate). The result is exact for
+	 * integral sample rates.
+	 */
+	int64_t floor_samples(double samplerate) const;
+
+	/// Like floor_samples() but rounding up, i.e. ceil(t * samplerate).
+	int64_t ceil_samples(double samplerate) const;
+
+	bool is_zero() const { return ticks_ == 0; }
+	int sign() const { return (ticks_ > 0) - (ticks_ < 0); }
+
+	explicit operator bool() const { return ticks_ != 0; }
+
+	/// Returns the shortest exact decimal representation of the value.
+	std::string str() const;
+
+	Timestamp operator-() const { return from_ticks(-ticks_); }
+	Timestamp operator+() const { return *this; }
+
+	Timestamp& operator+=(const Timestamp& o) { ticks_ += o.ticks_; return *this; }
+	Timestamp& operator-=(const Timestamp& o) { ticks_ -= o.ticks_; return *this; }
+	Timestamp& operator*=(const Timestamp& o) { return *this = mul(*this, o); }
+	Timestamp& operator/=(const Timestamp& o) { return *this = div(*this, o); }
+
+	template<typename T>
+	Timestamp& operator*=(T v) { return *this = *this * v; }
+
+	template<typename T>
+	Timestamp& operator/=(T v) { return *this = *this / v; }
+
+	friend Timestamp operator+(const Timestamp& a, const Timestamp& b)
+	{
+		return from_ticks(a.ticks_ + b.ticks_);
+	}
+
+	friend Timestamp operator-(const Timestamp& a, const Timestamp& b)
+	{
+		return from_ticks(a.ticks_ - b.ticks_);
+	}
+
+	friend Timestamp operator*(const Timestamp& a, const Timestamp& b)
+	{
+		return mul(a, b);
+	}
+
+	friend Timestamp operator/(const Timestamp& a, const Timestamp& b)
+	{
+		return div(a, b);
+	}
+
+	template<typename T, typename std::enable_if<
+		std::is_integral<T>::value, int>::type = 0>
+	friend Timestamp operator*(const Timestamp& a, T v)
+	{
+		return from_ticks(mul_sat(a.ticks_, to_rep_sat(v)));
+	}
+
+	template<typename T, typename std::enable_if<
+		std::is_floating_point<T>::value, int>::type = 0>
+	friend Timestamp operator*(const Timestamp& a, T v)
+	{
+		return from_ticks(from_real((long double)a.ticks_ * v));
+	}
+
+	template<typename T, typename std::enable_if<
+		std::is_integral<T>::value, int>::type = 0>
+	friend Timestamp operator/(const Timestamp& a, T v)
+	{
+		return from_ticks(round_div(a.ticks_, to_rep_sat(v)));
+	}
+
+	template<typename T, typename std::enable_if<
+		std::is_floating_point<T>::value, int>::type = 0>
+	friend Timestamp operator/(const Timestamp& a, T v)
+	{
+		return from_ticks(from_real((long double)a.ticks_ / v));
+	}
+
+	friend bool operator==(const Timestamp& a, const Timestamp& b)
+	{
+		return a.ticks_ == b.ticks_;
+	}
+
+	friend bool operator!=(const Timestamp& a, const Timestamp& b)
+	{
+		return a.ticks_ != b.ticks_;
+	}
+
+	friend bool operator<(const Timestamp& a, const Timestamp& b)
+	{
+		return a.ticks_ < b.ticks_;
+	}
+
+	friend bool operator>(const Timestamp& a, const Timestamp& b)
+	{
+		return a.ticks_ > b.ticks_;
+	}
+
+	friend bool operator<=(const Timestamp& a, const Timestamp& b)
+	{
+		return a.ticks_ <= b.ticks_;
+	}
+
+	friend bool operator>=(const Timestamp& a, const Timestamp& b)
+	{
+		return a.ticks_ >= b.ticks_;
+	}
+
+	/// Integer division rounding half away from zero.
+	static rep round_div(rep n, rep d)
+	{
+		const rep q = n / d, r = n % d;
+		const rep twice = (r < 0 ? -r : r) * 2;
+		if (twice >= (d < 0 ? -d : d))
+			return ((n < 0) != (d < 0)) ? q - 1 : q + 1;
+		return q;
+	}
+
+private:
+	static rep max_ticks()
+	{
+		return ~((rep)1 << (sizeof(rep) * CHAR_BIT - 1));
+	}
+
+	static rep from_real(long double ticks)
+	{
+		if (ticks >= (long double)max_ticks())
+			return max_ticks();
+		if (ticks <= -(long double)max_ticks())
+			return -max_ticks();
+		return (rep)(ticks < 0 ? ticks - 0.5L : ticks + 0.5L);
+	}
+
+	/// Converts an integer, clamping unsigned values above the range.
+	template<typename T>
+	static rep to_rep_sat(T v)
+	{
+		if (std::is_unsigned<T>::value &&
+				sizeof(T) >= sizeof(rep) && v > (T)max_ticks())
+			return max_ticks();
+		return (rep)v;
+	}
+
+	/// Multiplies, saturating to the largest tick count of the right sign.
+	static rep mul_sat(rep a, rep b)
+	{
+		if (a == 0 || b == 0)
+			return 0;
+
+		const bool negative = (a < 0) != (b < 0);
+		const rep ma = a < 0 ? -a : a, mb = b < 0 ? -b : b;
+
+		if (ma > max_ticks() / mb)
+			return negative ? -max_ticks() : max_ticks();
+		return a * b;
+	}
+
+	static Timestamp mul(const Timestamp& a, const Timestamp& b);
+	static Timestamp div(const Timestamp& a, const Timestamp& b);
+
+	rep ticks_;
+};
+
+// Mixed operations with built-in arithmetic types. Integral operands of
+// '*' and '/' are handled by the exact overloads inside the class.
+
+template<typename T> using EnableArithmetic = typename std::enable_if<
+	std::is_arithmetic<T>::value, Timestamp>::type;
+template<typename T> using EnableCompare = typename std::enable_if<
+	std::is_arithmetic<T>::value, bool>::type;
+
+template<typename T>
+inline EnableArithmetic<T> operator+(const Timestamp& a, T b)
+{
+	return a + Timestamp(b);
+}
+
+template<typename T>
+inline EnableArithmetic<T> operator+(T a, const Timestamp& b)
+{
+	return Timestamp(a) + b;
+}
+
+template<typename T>
+inline EnableArithmetic<T> operator-(const Timestamp& a, T b)
+{
+	return a - Timestamp(b);
+}
+
+template<typename T>
+inline EnableArithmetic<T> operator-(T a, const Timestamp& b)
+{
+	return Timestamp(a) - b;
+}
+
+template<typename T>
+inline EnableArithmetic<T> operator*(T a, const Timestamp& b)
+{
+	return b * a;
+}
+
+template<typename T>
+inline EnableArithmetic<T> operator/(T a, const Timestamp& b)
+{
+	return Timestamp(a) / b;
+}
+
+#define PV_TIMESTAMP_COMPARE(op) \
+	template<typename T> \
+	inline EnableCompare<T> operator op(const Timestamp& a, T b) \
+	{ return a op Timestamp(b); } \
+	template<typename T> \
+	inline EnableCompare<T> operator op(T a, const Timestamp& b) \
+	{ return Timestamp(a) op b; }
+
+PV_TIMESTAMP_COMPARE(==)
+PV_TIMESTAMP_COMPARE(!=)
+PV_TIMESTAMP_COMPARE(<)
+PV_TIMESTAMP_COMPARE(>)
+PV_TIMESTAMP_COMPARE(<=)
+PV_TIMESTAMP_COMPARE(>=)
+
+#undef PV_TIMESTAMP_COMPARE
+
+// Rounding and math functions, found through argument dependent lookup.
+
+Timestamp floor(const Timestamp& t);
+Timestamp ceil(const Timestamp& t);
+Timestamp round(const Timestamp& t);
+
+inline Timestamp abs(const Timestamp& t)
+{
+	return t.sign() < 0 ? -t : t;
+}
+
+inline Timestamp fabs(const Timestamp& t)
+{
+	return abs(t);
+}
+
+/// Remainder of t / d with the sign of t, like std::fmod().
+Timestamp fmod(const Timestamp& t, const Timestamp& d);
+Timestamp pow(const Timestamp& base, int exp);
+Timestamp log10(const Timestamp& t);
 
 /**
  * Formats a given timestamp with the specified SI prefix.
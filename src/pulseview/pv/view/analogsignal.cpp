@@ -159,12 +159,12 @@ void AnalogSignal::paint_mid(QPainter &p, const ViewItemPaintParams &pp)
 	const pv::util::Timestamp& start_time = segment->start_time();
 	const int64_t last_sample = segment->get_sample_count() - 1;
 	const double samples_per_pixel = samplerate * pp.scale();
-	const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
-	const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
+	const pv::util::Timestamp start = pp.offset() - start_time;
+	const pv::util::Timestamp end = start + pp.scale() * pp.width();
 
-	const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
+	const int64_t start_sample = min(max(start.floor_samples(samplerate),
 		(int64_t)0), last_sample);
-	const int64_t end_sample = min(max((ceil(end) + 1).convert_to<int64_t>(),
+	const int64_t end_sample = min(max(end.ceil_samples(samplerate) + 1,
 		(int64_t)0), last_sample);
 
 	if (samples_per_pixel < EnvelopeThreshold)
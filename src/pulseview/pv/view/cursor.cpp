@@ -69,7 +69,7 @@ QRectF Cursor::label_rect(const QRectF &rect) const
 	const shared_ptr<Cursor> other(get_other_cursor());
 	assert(other);
 	double scale = view_.scale() /(view_.viewport()->size().width() / view_.divisionCount());
-	const float x = ((time_ - view_.offset())/ scale).convert_to<float>();
+	const float x = (time_ - view_.offset()).convert_to<double>() / scale;
 
 	QFontMetrics m(QApplication::font());
 	QSize text_size = m.boundingRect(get_text()).size();
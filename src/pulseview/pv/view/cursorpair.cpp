@@ -190,8 +190,8 @@ pair<float, float> CursorPair::get_cursor_offsets() const
 	double scale = view_.scale() /(view_.viewport()->size().width() / view_.divisionCount());
 
 	return pair<float, float>(
-		((first_->time() - view_.offset()) / scale).convert_to<float>(),
-		((second_->time() - view_.offset()) / scale).convert_to<float>());
+		(first_->time() - view_.offset()).convert_to<double>() / scale,
+		(second_->time() - view_.offset()).convert_to<double>() / scale);
 }
 
 } // namespace view
@@ -157,6 +157,19 @@ std::pair<int, int> LogicSignal::v_extents() const
 	return make_pair(-signal_height_ - signal_margin, signal_margin);
 }
 
+shared_ptr<pv::data::Segment> LogicSignal::tile_segment() const
+{
+	if (!channel_->enabled())
+		return nullptr;
+
+	const deque< shared_ptr<pv::data::LogicSegment> > &segments =
+		data_->logic_segments();
+	if (segments.empty())
+		return nullptr;
+
+	return segments.front();
+}
+
 int LogicSignal::scale_handle_offset() const
 {
 	return -signal_height_;
@@ -206,13 +219,12 @@ void LogicSignal::paint_mid(QPainter &p, const ViewItemPaintParams &pp)
 	const pv::util::Timestamp& start_time = segment->start_time();
 	const int64_t last_sample = segment->get_sample_count() - 1;
 	const double samples_per_pixel = samplerate * pp.scale();
-	const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
-//	const pv::util::Timestamp start = samplerate * start_time;
-	const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
+	const pv::util::Timestamp start = pp.offset() - start_time;
+	const pv::util::Timestamp end = start + pp.scale() * pp.width();
 
-	const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
+	const int64_t start_sample = min(max(start.floor_samples(samplerate),
 		(int64_t)0), last_sample);
-	const uint64_t end_sample = min(max(ceil(end).convert_to<int64_t>(),
+	const uint64_t end_sample = min(max(end.ceil_samples(samplerate),
 		(int64_t)0), last_sample);
 
 	segment->get_subsampled_edges(edges, start_sample, end_sample,
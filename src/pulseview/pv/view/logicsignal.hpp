@@ -88,6 +88,11 @@ public:
 	 */
 	std::pair<int, int> v_extents() const;
 
+	/**
+	 * Gets the segment painted by the mid-layer.
+	 */
+	std::shared_ptr<pv::data::Segment> tile_segment() const;
+
 	/**
 	 * Returns the offset to show the drag handle.
 	 */
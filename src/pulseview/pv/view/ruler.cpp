@@ -304,7 +304,7 @@ Ruler::TickPositions Ruler::calculate_tick_positions(
 	double width_division = width / divisionCount_;
 	do {
 		pv::util::Timestamp t = t0 + division * minor_period;
-		x = ((t - offset) * width_division / scale).convert_to<double>();
+		x = (t - offset).convert_to<double>() * width_division / scale;
 
 		if (division % MinorTickSubdivision == 0) {
 			// Recalculate 't' without using 'minor_period' which is a fraction
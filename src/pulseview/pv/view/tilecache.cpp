@@ -0,0 +1,252 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+#include <QPainter>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include "tilecache.hpp"
+#include "tracetreeitem.hpp"
+#include "viewitempaintparams.hpp"
+
+#include "../data/segment.hpp"
+
+using std::dynamic_pointer_cast;
+using std::lock_guard;
+using std::make_shared;
+using std::min;
+using std::mutex;
+using std::pair;
+using std::shared_ptr;
+using std::tie;
+using std::vector;
+
+namespace pv {
+namespace view {
+
+const int TileCache::TileWidth = 256;
+const unsigned int TileCache::MaxTiles = 512;
+
+bool TileCache::Key::operator<(const Key &other) const
+{
+	return tie(item, segment, sample_count, samplerate, scale, index,
+			top, height, generation) <
+		tie(other.item, other.segment, other.sample_count,
+			other.samplerate, other.scale, other.index,
+			other.top, other.height, other.generation);
+}
+
+TileCache::TileCache(QObject *parent) :
+	QObject(parent),
+	inbox_(make_shared<Inbox>()),
+	frame_(0),
+	generation_(0)
+{
+	inbox_->owner = this;
+}
+
+TileCache::~TileCache()
+{
+	lock_guard<mutex> lock(inbox_->mutex);
+	inbox_->owner = nullptr;
+}
+
+bool TileCache::paint(QPainter &p, const ViewItemPaintParams &pp,
+	const shared_ptr<RowItem> &row)
+{
+	const shared_ptr<TraceTreeItem> item =
+		dynamic_pointer_cast<TraceTreeItem>(row);
+	if (!item)
+		return false;
+
+	const shared_ptr<pv::data::Segment> segment = item->tile_segment();
+	if (!segment)
+		return false;
+
+	const pair<int, int> extents = item->v_extents();
+
+	Key key;
+	key.item = item.get();
+	key.segment = segment.get();
+	key.samplerate = segment->samplerate();
+	key.scale = pp.scale();
+	key.top = item->get_visual_y() + extents.first;
+	key.height = extents.second - extents.first + 1;
+	key.generation = generation_;
+
+	if (key.height <= 0)
+		return true;
+
+	const uint64_t sample_count = segment->get_sample_count();
+	const double samplerate = key.samplerate > 0 ? key.samplerate : 1.0;
+	const pv::util::Timestamp tile_period =
+		pv::util::Timestamp(key.scale) * TileWidth;
+
+	// A tile only depends on the samples up to its right edge, so tiles
+	// left of the acquisition front stay valid while data is appended.
+	auto tile_key = [&](int64_t index) {
+		const pv::util::Timestamp end =
+			tile_period * (index + 1) - segment->start_time();
+		key.index = index;
+		key.sample_count = min<uint64_t>(sample_count,
+			std::max<int64_t>(end.ceil_samples(samplerate) + 2, 0));
+		return key;
+	};
+
+	const double pixels_offset = pp.pixels_offset();
+	const int64_t first = (int64_t)std::floor(pixels_offset / TileWidth);
+	const int64_t last = (int64_t)std::floor(
+		(pixels_offset + pp.width()) / TileWidth);
+
+	frame_++;
+
+	// Render the visible tiles that are missing on the thread pool and
+	// wait for them, they are needed for this frame.
+	struct Job {
+		Key key;
+		QImage image;
+	};
+	vector<Job> missing;
+	for (int64_t i = first; i <= last; i++) {
+		const Key k = tile_key(i);
+		if (tiles_.find(k) == tiles_.end())
+			missing.push_back(Job{k, QImage()});
+	}
+
+	if (!missing.empty())
+		QtConcurrent::blockingMap(missing, [&item](Job &job) {
+			job.image = render(item, job.key); });
+
+	for (Job &job : missing) {
+		tiles_[job.key] = Tile{job.image, frame_};
+		pending_.erase(job.key);
+	}
+
+	for (int64_t i = first; i <= last; i++) {
+		Tile &tile = tiles_[tile_key(i)];
+		tile.last_used = frame_;
+		p.drawImage(QPointF(pp.left() + i * TileWidth - pixels_offset,
+			key.top), tile.image);
+	}
+
+	// Prefetch the neighbours so that panning finds them ready
+	prefetch(item, tile_key(first - 1));
+	prefetch(item, tile_key(last + 1));
+
+	evict();
+
+	return true;
+}
+
+void TileCache::clear()
+{
+	tiles_.clear();
+	pending_.clear();
+	generation_++;
+}
+
+QImage TileCache::render(const shared_ptr<TraceTreeItem> &item,
+	const Key &key)
+{
+	QImage image(TileWidth, key.height,
+		QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+
+	QPainter p(&image);
+	p.setRenderHint(QPainter::Antialiasing);
+	p.translate(0, -key.top);
+
+	const ViewItemPaintParams pp(QRect(0, key.top, TileWidth, key.height),
+		key.scale, pv::util::Timestamp(key.scale) *
+			(key.index * TileWidth));
+	item->paint_mid(p, pp);
+
+	return image;
+}
+
+void TileCache::prefetch(const shared_ptr<TraceTreeItem> &item,
+	const Key &key)
+{
+	if (tiles_.find(key) != tiles_.end() ||
+		pending_.find(key) != pending_.end())
+		return;
+
+	pending_.insert(key);
+
+	const shared_ptr<Inbox> inbox = inbox_;
+	QtConcurrent::run([inbox, item, key]() {
+		const QImage image = render(item, key);
+
+		lock_guard<mutex> lock(inbox->mutex);
+		if (!inbox->owner)
+			return;
+
+		inbox->tiles.emplace_back(key, image);
+		if (inbox->tiles.size() == 1)
+			QMetaObject::invokeMethod(inbox->owner,
+				"collect_rendered", Qt::QueuedConnection);
+	});
+}
+
+void TileCache::collect_rendered()
+{
+	vector< pair<Key, QImage> > rendered;
+	{
+		lock_guard<mutex> lock(inbox_->mutex);
+		rendered.swap(inbox_->tiles);
+	}
+
+	for (auto &r : rendered) {
+		// Tiles rendered before a clear() are stale
+		if (pending_.erase(r.first))
+			tiles_[r.first] = Tile{r.second, frame_};
+	}
+
+	evict();
+}
+
+void TileCache::evict()
+{
+	if (tiles_.size() <= MaxTiles)
+		return;
+
+	// Drop the least recently drawn quarter of the cache
+	vector<uint64_t> ages;
+	ages.reserve(tiles_.size());
+	for (const auto &t : tiles_)
+		ages.push_back(t.second.last_used);
+
+	const size_t drop = tiles_.size() - MaxTiles * 3 / 4;
+	std::nth_element(ages.begin(), ages.begin() + drop - 1, ages.end());
+	const uint64_t threshold = ages[drop - 1];
+
+	for (auto i = tiles_.begin(); i != tiles_.end();)
+		if (i->second.last_used <= threshold &&
+			i->second.last_used != frame_)
+			i = tiles_.erase(i);
+		else
+			++i;
+}
+
+} // namespace view
+} // namespace pv
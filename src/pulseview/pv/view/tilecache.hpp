@@ -0,0 +1,135 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PULSEVIEW_PV_VIEW_TILECACHE_HPP
+#define PULSEVIEW_PV_VIEW_TILECACHE_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <QImage>
+#include <QObject>
+
+class QPainter;
+
+namespace pv {
+
+namespace data {
+class Segment;
+}
+
+namespace view {
+
+class RowItem;
+class TraceTreeItem;
+class ViewItemPaintParams;
+
+/**
+ * Caches the mid-layer of the traces as QImage tiles.
+ *
+ * Each tile covers TileWidth pixels of one trace at one zoom level. Tiles
+ * are keyed by the trace, the segment it draws, the zoom level and the
+ * tile position on the time axis, so panning and repaints caused by
+ * cursors or markers only blit images. Visible tiles that are missing are
+ * rendered in parallel on the worker thread pool before being drawn, the
+ * tiles next to the visible ones are prefetched in the background.
+ */
+class TileCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	static const int TileWidth;
+	static const unsigned int MaxTiles;
+
+public:
+	explicit TileCache(QObject *parent = nullptr);
+	~TileCache();
+
+	/**
+	 * Paints the mid-layer of a row item from the cached tiles.
+	 * @return false if the item can not be cached, in which case the
+	 *   caller has to paint it directly.
+	 */
+	bool paint(QPainter &p, const ViewItemPaintParams &pp,
+		const std::shared_ptr<RowItem> &row);
+
+	/**
+	 * Drops all the tiles, for instance when the appearance of the
+	 * traces changed.
+	 */
+	void clear();
+
+private:
+	struct Key
+	{
+		const TraceTreeItem *item;
+		const pv::data::Segment *segment;
+		uint64_t sample_count;
+		double samplerate;
+		double scale;
+		int64_t index;
+		int top;
+		int height;
+		unsigned int generation;
+
+		bool operator<(const Key &other) const;
+	};
+
+	struct Tile
+	{
+		QImage image;
+		uint64_t last_used;
+	};
+
+	/* Shared with the background jobs, so that they can outlive the
+	 * cache. */
+	struct Inbox
+	{
+		std::mutex mutex;
+		TileCache *owner;
+		std::vector< std::pair<Key, QImage> > tiles;
+	};
+
+	static QImage render(const std::shared_ptr<TraceTreeItem> &item,
+		const Key &key);
+
+	void prefetch(const std::shared_ptr<TraceTreeItem> &item,
+		const Key &key);
+	void evict();
+
+private Q_SLOTS:
+	void collect_rendered();
+
+private:
+	std::map<Key, Tile> tiles_;
+	std::set<Key> pending_;
+	std::shared_ptr<Inbox> inbox_;
+	uint64_t frame_;
+	unsigned int generation_;
+};
+
+} // namespace view
+} // namespace pv
+
+#endif // PULSEVIEW_PV_VIEW_TILECACHE_HPP
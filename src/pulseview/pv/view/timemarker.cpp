@@ -73,7 +73,7 @@ void TimeMarker::set_time(const pv::util::Timestamp& time)
 
 float TimeMarker::get_x() const
 {
-	return ((time_ - view_.offset()) / view_.scale()).convert_to<float>();
+	return (time_ - view_.offset()).convert_to<double>() / view_.scale();
 }
 
 QPoint TimeMarker::point(const QRect &rect) const
@@ -107,7 +107,7 @@ void TimeMarker::paint_label(QPainter &p, const QRect &rect, bool hover)
 	if (!enabled())
 		return;
 
-	const qreal x = ((time_ - view_.offset()) / view_.scale()).convert_to<qreal>();
+	const qreal x = (time_ - view_.offset()).convert_to<qreal>() / view_.scale();
 	const QRectF r(label_rect(rect));
 
 	const QPointF points[] = {
@@ -320,16 +320,25 @@ QColor Trace::lowcolour() const
 void Trace::setEdgecolour(const QColor &edgecolour)
 {
 	edgecolour_ = edgecolour;
+
+	if (owner_)
+		owner_->row_item_appearance_changed(false, true);
 }
 
 void Trace::setHighcolour(const QColor &highcolour)
 {
 	highcolour_ = highcolour;
+
+	if (owner_)
+		owner_->row_item_appearance_changed(false, true);
 }
 
 void Trace::setLowcolour(const QColor &lowcolour)
 {
 	lowcolour_ = lowcolour;
+
+	if (owner_)
+		owner_->row_item_appearance_changed(false, true);
 }
 
 } // namespace view
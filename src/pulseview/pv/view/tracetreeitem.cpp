@@ -174,6 +174,14 @@ qreal TraceTreeItem::getCh_thickness() const
 void TraceTreeItem::setCh_thickness(qreal value)
 {
 	ch_thickness = value;
+
+	if (owner_)
+		owner_->row_item_appearance_changed(false, true);
+}
+
+std::shared_ptr<pv::data::Segment> TraceTreeItem::tile_segment() const
+{
+	return nullptr;
 }
 
 
@@ -29,6 +29,11 @@
 #include "rowitem.hpp"
 
 namespace pv {
+
+namespace data {
+class Segment;
+}
+
 namespace view {
 
 class TraceTreeItemOwner;
@@ -125,6 +130,15 @@ public:
 	 */
 	virtual std::pair<int, int> v_extents() const = 0;
 
+	/**
+	 * Gets the segment painted by @c paint_mid() when the mid-layer
+	 * depends on nothing but that segment, the scale and the offset.
+	 * @return the segment, or @c nullptr if the mid-layer must be painted
+	 *   on every update instead of being cached in tiles.
+	 * @remarks @c paint_mid() may then be called from worker threads.
+	 */
+	virtual std::shared_ptr<pv::data::Segment> tile_segment() const;
+
 	bool get_highlight();
 	void set_highlight(bool check);
 	virtual void setSignal_height(int height);
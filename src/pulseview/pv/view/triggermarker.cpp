@@ -57,7 +57,7 @@ void TriggerMarker::set_time(const pv::util::Timestamp& time)
 
 float TriggerMarker::get_x() const
 {
-	return ((time_ - view_.offset()) / view_.scale()).convert_to<float>();
+	return (time_ - view_.offset()).convert_to<double>() / view_.scale();
 }
 
 QPoint TriggerMarker::point(const QRect &rect) const
@@ -520,6 +520,87 @@ vector< std::shared_ptr<Flag> > View::flags() const
 	return flags;
 }
 
+void View::set_search_matches(shared_ptr<data::LogicSegment> segment,
+	vector<data::LogicSearch::Match> matches)
+{
+	search_segment_ = segment;
+	search_matches_.swap(matches);
+}
+
+size_t View::search(const data::LogicSearch &search)
+{
+	shared_ptr<data::LogicSegment> segment;
+
+	for (const shared_ptr<SignalData> d : session_.get_data()) {
+		const shared_ptr<data::Logic> logic =
+			dynamic_pointer_cast<data::Logic>(d);
+
+		// All logic channels share the same data segments
+		if (logic && !logic->logic_segments().empty()) {
+			segment = logic->logic_segments().back();
+			break;
+		}
+	}
+
+	vector<data::LogicSearch::Match> matches;
+	if (segment)
+		matches = search.run(*segment);
+
+	const size_t count = matches.size();
+	set_search_matches(segment, std::move(matches));
+	return count;
+}
+
+bool View::jump_to_search_match(bool forward)
+{
+	if (!search_segment_ || search_matches_.empty())
+		return false;
+
+	const double samplerate = search_segment_->samplerate();
+	if (samplerate <= 0)
+		return false;
+
+	const Timestamp &start_time = search_segment_->start_time();
+	const Timestamp half_width = scale_ * viewport_->width() / 2;
+
+	// Half a sample of slack, so that the match the view is centred on
+	// is not found again
+	const double centre = (offset_ + half_width - start_time)
+		.convert_to<double>() * samplerate;
+
+	typedef data::LogicSearch::Match Match;
+	vector<Match>::const_iterator iter;
+	if (forward) {
+		iter = upper_bound(search_matches_.cbegin(),
+			search_matches_.cend(), centre + 0.5,
+			[](double s, const Match &m) { return s < m.start; });
+		if (iter == search_matches_.cend())
+			return false;
+	} else {
+		iter = lower_bound(search_matches_.cbegin(),
+			search_matches_.cend(), centre - 0.5,
+			[](const Match &m, double s) { return m.start < s; });
+		if (iter == search_matches_.cbegin())
+			return false;
+		--iter;
+	}
+
+	const Timestamp match_start = start_time +
+		Timestamp::from_samples((*iter).start, samplerate);
+	set_scale_offset(scale_, match_start - half_width);
+
+	if (show_cursors_) {
+		cursors_->first()->set_time(match_start);
+		cursors_->second()->set_time(
+			start_time + Timestamp::from_samples((*iter).end,
+				samplerate));
+		ruler_->update();
+		viewport_->update();
+	}
+
+	return true;
+}
+
 const QPoint& View::hover_point() const
 {
 	return hover_point_;
@@ -685,8 +766,10 @@ void View::update_scroll()
 		horizontalScrollBar()->setSliderPosition(offset.convert_to<double>());
 	} else {
 		horizontalScrollBar()->setRange(0, MaxScrollValue);
+		// The ratio is taken first, offset_ * MaxScrollValue would
+		// not fit into a timestamp
 		horizontalScrollBar()->setSliderPosition(
-			(offset_ * MaxScrollValue / ((scale_  / (viewport_->width() / DivisionCount)) * length)).convert_to<double>());
+			(offset_ / ((scale_  / (viewport_->width() / DivisionCount)) * length)).convert_to<double>() * MaxScrollValue);
 	}
 
 	updating_scroll_ = false;
@@ -890,8 +973,10 @@ void View::row_item_appearance_changed(bool label, bool content)
 {
 //	if (label)
 //		header_->update();
-	if (content)
+	if (content) {
+		viewport_->invalidate_tiles();
 		viewport_->update();
+	}
 }
 
 void View::time_item_appearance_changed(bool label, bool content)
@@ -929,7 +1014,7 @@ void View::h_scroll_value_changed(int value)
 		double length = 0;
 		Timestamp offset;
 		get_scroll_layout(length, offset);
-		set_offset((scale_  / (viewport_->width() / DivisionCount)) * length * value / MaxScrollValue);
+		set_offset((scale_  / (viewport_->width() / DivisionCount)) * length * ((double)value / MaxScrollValue));
 	}
 
 	ruler_->update();
@@ -1091,6 +1176,7 @@ void View::signals_changed()
 	update_layout();
 
 //	header_->update();
+	viewport_->invalidate_tiles();
 	viewport_->update();
 
 	if (reset_scrollbar)
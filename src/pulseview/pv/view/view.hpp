@@ -34,6 +34,7 @@
 #include <QTimer>
 #include <QLabel>
 
+#include "../data/logicsearch.hpp"
 #include "../data/signaldata.hpp"
 #include "../util.hpp"
 
@@ -49,6 +50,10 @@ namespace pv {
 
 class Session;
 
+namespace data {
+class LogicSegment;
+}
+
 namespace view {
 
 class CursorHeader;
@@ -214,6 +219,28 @@ public:
 	 */
 	std::vector< std::shared_ptr<Flag> > flags() const;
 
+	/**
+	 * Sets the matches of a logic search to step through with
+	 * jump_to_search_match().
+	 */
+	void set_search_matches(std::shared_ptr<pv::data::LogicSegment> segment,
+		std::vector<pv::data::LogicSearch::Match> matches);
+
+	/**
+	 * Runs a search over the latest logic capture and keeps its matches
+	 * to step through with jump_to_search_match().
+	 * @return the number of matches.
+	 */
+	size_t search(const pv::data::LogicSearch &search);
+
+	/**
+	 * Centres the view on the next or previous search match relative to
+	 * the centre of the view. The cursors are moved around the match
+	 * when they are shown.
+	 * @return false if there is no match in that direction.
+	 */
+	bool jump_to_search_match(bool forward);
+
 	const QPoint& hover_point() const;
 
 	void restack_all_trace_tree_items();
@@ -412,6 +439,9 @@ private:
 
 	std::vector< std::shared_ptr<TriggerMarker> > trigger_markers_;
 
+	std::shared_ptr<pv::data::LogicSegment> search_segment_;
+	std::vector<pv::data::LogicSearch::Match> search_matches_;
+
 	QPoint hover_point_;
 
 	unsigned int sticky_events_;
@@ -39,6 +39,16 @@ ViewItemPaintParams::ViewItemPaintParams(
 	assert(scale > 0.0);
 }
 
+ViewItemPaintParams::ViewItemPaintParams(
+		const QRect &rect, double pixel_scale,
+		const pv::util::Timestamp& offset):
+	rect_(rect),
+	scale_(pixel_scale),
+	offset_(offset)
+{
+	assert(pixel_scale > 0.0);
+}
+
 QFont ViewItemPaintParams::font()
 {
 	return QApplication::font();
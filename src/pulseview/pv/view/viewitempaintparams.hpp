@@ -37,6 +37,14 @@ public:
 		const pv::util::Timestamp& offset,
 		int divisionCount);
 
+	/**
+	 * Constructs the parameters from a scale that is already given in
+	 * seconds per pixel.
+	 */
+	ViewItemPaintParams(
+		const QRect &rect, double pixel_scale,
+		const pv::util::Timestamp& offset);
+
 	QRect rect() const {
 		return rect_;
 	}
@@ -101,6 +101,11 @@ boost::optional<pv::util::Timestamp>  Viewport::getDragOffset()
 	return drag_offset_;
 }
 
+void Viewport::invalidate_tiles()
+{
+	tiles_.clear();
+}
+
 void Viewport::item_hover(const shared_ptr<ViewItem> &item)
 {
 	if (item && item->is_draggable())
@@ -225,7 +230,7 @@ void Viewport::paintEvent(QPaintEvent*)
 	for (const shared_ptr<TimeItem> t : time_items)
 		t->paint_mid(p, pp);
 	for (const shared_ptr<RowItem> r : row_items)
-		if (r->isVisible())
+		if (r->isVisible() && !tiles_.paint(p, pp, r))
 			r->paint_mid(p, pp);
 
 	paint_grid(p, pp);
@@ -27,6 +27,7 @@
 #include <QTouchEvent>
 
 #include "../util.hpp"
+#include "tilecache.hpp"
 #include "viewwidget.hpp"
 
 class QPainter;
@@ -76,6 +77,12 @@ public:
 	void cursorValueChanged_1(int);
 	void cursorValueChanged_2(int);
 	boost::optional<pv::util::Timestamp> getDragOffset();
+
+	/**
+	 * Drops the cached trace tiles, to be called when the appearance of
+	 * the traces changed.
+	 */
+	void invalidate_tiles();
 private:
 	/**
      * Indicates when a view item is being hovered over.
@@ -152,6 +159,8 @@ private:
 
 	bool cursorsActive;
 	std::pair<int, int> cursorsPixelValues;
+
+	TileCache tiles_;
 };
 
 } // namespace view
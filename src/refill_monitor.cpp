@@ -0,0 +1,153 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "refill_monitor.hpp"
+#include "trace.hpp"
+
+/* Weight of the newest interval in the average refill interval */
+#define REFILL_AVERAGE_WEIGHT 0.1
+
+using namespace adiscope;
+
+refill_monitor::refill_monitor(size_t item_size, const std::string &name) :
+	gr::sync_block("refill_monitor",
+			gr::io_signature::make(1, 1, item_size),
+			gr::io_signature::make(0, 0, 0)),
+	trace_cat(Tracer::intern(name)),
+	buffer_size(0), kernel_buffers(0), sample_rate(0.0),
+	continuous(false), pending(0), have_last(false),
+	avg_interval(0.0), refills(0), overflows(0)
+{
+}
+
+refill_monitor::~refill_monitor()
+{
+}
+
+void refill_monitor::set_buffers(unsigned long buffer_size,
+		unsigned int kernel_buffers, double sample_rate,
+		bool continuous)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	this->buffer_size = buffer_size;
+	this->kernel_buffers = kernel_buffers;
+	this->sample_rate = sample_rate;
+	this->continuous = continuous;
+
+	/* The buffers are recreated, count from the next one */
+	pending = 0;
+	have_last = false;
+}
+
+refill_monitor::stats refill_monitor::get_stats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stats s;
+
+	s.refills = refills;
+	s.overflows = overflows;
+	s.refill_rate = avg_interval > 0.0 ? 1.0 / avg_interval : 0.0;
+	return s;
+}
+
+void refill_monitor::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	refills = 0;
+	overflows = 0;
+	avg_interval = 0.0;
+	pending = 0;
+	have_last = false;
+}
+
+bool refill_monitor::start()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	/* The time spent stopped is not a late refill */
+	pending = 0;
+	have_last = false;
+	return gr::sync_block::start();
+}
+
+void refill_monitor::refilled(clock::time_point now)
+{
+	refills++;
+	Tracer::instant(trace_cat, "refill");
+
+	if (have_last) {
+		double interval = std::chrono::duration<double>(
+				now - last).count();
+
+		/* The part of the interval not covered by the samples of
+		 * the buffer */
+		if (Tracer::enabled() && sample_rate > 0.0) {
+			double dead = interval - buffer_size / sample_rate;
+
+			if (dead > 0.0) {
+				uint64_t end = Tracer::now();
+				Tracer::complete(trace_cat, "refill_dead_time",
+						end - (uint64_t) (dead * 1e9),
+						end);
+			}
+		}
+
+		if (avg_interval > 0.0)
+			avg_interval += REFILL_AVERAGE_WEIGHT *
+				(interval - avg_interval);
+		else
+			avg_interval = interval;
+
+		/* The kernel queue plus the buffer being read cover
+		 * this long of the stream */
+		if (continuous && sample_rate > 0.0) {
+			double covered = (kernel_buffers + 1) *
+				buffer_size / sample_rate;
+
+			if (interval > covered)
+				overflows++;
+		}
+	}
+
+	last = now;
+	have_last = true;
+}
+
+int refill_monitor::work(int noutput_items,
+		gr_vector_const_void_star &input_items,
+		gr_vector_void_star &output_items)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (buffer_size) {
+		/* The source hands out each buffer in one or more calls,
+		 * a buffer is complete once all its samples went by */
+		auto now = clock::now();
+
+		pending += noutput_items;
+		while (pending >= buffer_size) {
+			pending -= buffer_size;
+			refilled(now);
+		}
+	}
+
+	return noutput_items;
+}
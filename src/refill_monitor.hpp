@@ -0,0 +1,89 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef REFILL_MONITOR_HPP
+#define REFILL_MONITOR_HPP
+
+#include <gnuradio/sync_block.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+namespace adiscope {
+	/*
+	 * Counts the buffers coming out of an IIO source, on one of its
+	 * output ports.
+	 *
+	 * A buffer that arrives later than the kernel queue could cover is
+	 * counted as an overflow: the DMA had nowhere to write in the
+	 * meantime, so on a free running stream samples were lost. Gaps
+	 * between triggered captures are expected, so overflows are only
+	 * counted while the stream is marked continuous.
+	 */
+	class refill_monitor : public gr::sync_block
+	{
+	public:
+		struct stats {
+			unsigned long long refills;
+			unsigned long long overflows;
+			double refill_rate;
+		};
+
+		/* The refills are traced under the given name */
+		refill_monitor(size_t item_size, const std::string &name);
+		~refill_monitor();
+
+		/* Set the layout of the buffers being counted */
+		void set_buffers(unsigned long buffer_size,
+				unsigned int kernel_buffers,
+				double sample_rate, bool continuous);
+
+		stats get_stats();
+		void reset();
+
+		bool start();
+
+		int work(int noutput_items,
+				gr_vector_const_void_star &input_items,
+				gr_vector_void_star &output_items);
+
+	private:
+		typedef std::chrono::steady_clock clock;
+
+		std::mutex mutex;
+		const char *trace_cat;
+
+		unsigned long buffer_size;
+		unsigned int kernel_buffers;
+		double sample_rate;
+		bool continuous;
+
+		unsigned long pending;
+		bool have_last;
+		clock::time_point last;
+		double avg_interval;
+
+		unsigned long long refills, overflows;
+
+		void refilled(clock::time_point now);
+	};
+}
+
+#endif /* REFILL_MONITOR_HPP */
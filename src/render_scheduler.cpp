@@ -0,0 +1,177 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "render_scheduler.hpp"
+#include "trace.hpp"
+
+#include <QApplication>
+#include <QEvent>
+#include <QScreen>
+
+#include <qwt_plot.h>
+
+/* Frame rate used when the display does not report its own */
+#define RENDER_SCHEDULER_DEFAULT_HZ 60.0
+
+using namespace adiscope;
+
+RenderScheduler *RenderScheduler::instance()
+{
+	static RenderScheduler *scheduler = new RenderScheduler();
+
+	return scheduler;
+}
+
+RenderScheduler::RenderScheduler() :
+	QObject(qApp),
+	m_stats()
+{
+	double hz = RENDER_SCHEDULER_DEFAULT_HZ;
+	QScreen *screen = QGuiApplication::primaryScreen();
+
+	if (screen && screen->refreshRate() > 0)
+		hz = screen->refreshRate();
+
+	timer.setTimerType(Qt::PreciseTimer);
+	timer.setInterval(qRound(1000.0 / hz));
+	connect(&timer, SIGNAL(timeout()), this, SLOT(frame()));
+}
+
+void RenderScheduler::schedule(QwtPlot *plot)
+{
+	if (dirty.contains(plot)) {
+		m_stats.coalesced++;
+		Tracer::instant("render", "coalesced");
+		return;
+	}
+
+	dirty.push_back(plot);
+
+	if (!timer.isActive())
+		timer.start();
+}
+
+void RenderScheduler::scheduleAppend(QwtPlot *plot)
+{
+	if (appended.contains(plot) || dirty.contains(plot)) {
+		m_stats.coalesced++;
+		Tracer::instant("render", "coalesced");
+		return;
+	}
+
+	appended.push_back(plot);
+
+	if (!timer.isActive())
+		timer.start();
+}
+
+RenderScheduler::Stats RenderScheduler::stats() const
+{
+	return m_stats;
+}
+
+bool RenderScheduler::isShown(QwtPlot *plot)
+{
+	return plot->isVisible() && !plot->window()->isMinimized();
+}
+
+void RenderScheduler::frame()
+{
+	/* The timer runs until a frame finds nothing to draw */
+	if (dirty.isEmpty() && appended.isEmpty()) {
+		timer.stop();
+		return;
+	}
+
+	/* Plots scheduled while drawing wait for the next frame */
+	QVector<QPointer<QwtPlot>> plots, appends;
+	plots.swap(dirty);
+	appends.swap(appended);
+
+	for (const QPointer<QwtPlot> &plot : plots) {
+		if (!plot || !checkShown(plot))
+			continue;
+
+		plot->replot();
+
+		m_stats.rendered++;
+		Tracer::instant("render", "rendered");
+	}
+
+	for (const QPointer<QwtPlot> &plot : appends) {
+		/* A replot drew the appended points already */
+		if (!plot || plots.contains(plot) || !checkShown(plot))
+			continue;
+
+		IncrementalPlot *incremental =
+			dynamic_cast<IncrementalPlot *>(plot.data());
+
+		if (incremental) {
+			incremental->drawAppended();
+
+			m_stats.appended++;
+			Tracer::instant("render", "appended");
+		} else {
+			plot->replot();
+
+			m_stats.rendered++;
+			Tracer::instant("render", "rendered");
+		}
+	}
+}
+
+bool RenderScheduler::checkShown(QwtPlot *plot)
+{
+	if (isShown(plot))
+		return true;
+
+	m_stats.hidden++;
+	Tracer::instant("render", "hidden");
+
+	if (!stale.contains(plot)) {
+		stale.push_back(plot);
+
+		/* Both see the plot being shown again: the plot when its
+		 * tool is, the window when it is restored */
+		plot->installEventFilter(this);
+		plot->window()->installEventFilter(this);
+	}
+
+	return false;
+}
+
+bool RenderScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+	if (!stale.isEmpty() && (event->type() == QEvent::Show ||
+			event->type() == QEvent::WindowStateChange)) {
+		/* They are replotted in full, as they missed what was
+		 * appended while hidden; the ones still hidden on the
+		 * next frame go back to the stale ones */
+		for (const QPointer<QwtPlot> &plot : stale)
+			if (plot && !dirty.contains(plot))
+				dirty.push_back(plot);
+
+		stale.clear();
+
+		if (!timer.isActive())
+			timer.start();
+	}
+
+	return QObject::eventFilter(watched, event);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef RENDER_SCHEDULER_HPP
+#define RENDER_SCHEDULER_HPP
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+class QwtPlot;
+
+namespace adiscope {
+	/*
+	 * A plot that can draw the points appended since its last frame
+	 * without a full replot
+	 */
+	class IncrementalPlot
+	{
+	public:
+		virtual ~IncrementalPlot() {}
+
+		virtual void drawAppended() = 0;
+	};
+
+	/*
+	 * Paces the replots of all the plots to the refresh rate of the
+	 * display.
+	 *
+	 * schedule() only marks a plot dirty; dirty plots are replotted
+	 * once on the next frame, however many times they were scheduled
+	 * in between. scheduleAppend() does the same for an
+	 * IncrementalPlot, which then only draws what was appended to it,
+	 * unless it is replotted on that frame anyway. A plot that is
+	 * hidden, or in a minimized window as a detached tool can be, is
+	 * not replotted until it is shown again. Every outcome is counted,
+	 * and recorded as "rendered", "appended", "coalesced" and "hidden"
+	 * instants of the "render" category while tracing.
+	 */
+	class RenderScheduler : public QObject
+	{
+		Q_OBJECT
+
+	public:
+		struct Stats {
+			quint64 rendered;
+			quint64 appended;	/* drawn incrementally */
+			quint64 coalesced;	/* scheduled while already dirty */
+			quint64 hidden;		/* skipped while not visible */
+		};
+
+		static RenderScheduler *instance();
+
+		void schedule(QwtPlot *plot);
+		void scheduleAppend(QwtPlot *plot);
+
+		Stats stats() const;
+
+	protected:
+		bool eventFilter(QObject *watched, QEvent *event);
+
+	private Q_SLOTS:
+		void frame();
+
+	private:
+		RenderScheduler();
+
+		static bool isShown(QwtPlot *plot);
+
+		/* Counts and tracks the plot as stale if it is not shown */
+		bool checkShown(QwtPlot *plot);
+
+		QTimer timer;
+		QVector<QPointer<QwtPlot>> dirty;
+		QVector<QPointer<QwtPlot>> appended;
+
+		/* Skipped while hidden, replotted when shown again */
+		QVector<QPointer<QwtPlot>> stale;
+
+		Stats m_stats;
+	};
+}
+
+#endif /* RENDER_SCHEDULER_HPP */
@@ -30,9 +30,13 @@
 #include "trigger_mode.h"
 #include <gnuradio/sync_block.h>
 #include <qapplication.h>
+#include <memory>
 
 namespace adiscope {
 
+    class WaveformHistory;
+    class PersistenceAccumulator;
+
     class scope_sink_f : virtual public gr::sync_block
     {
     public:
@@ -53,6 +57,21 @@ namespace adiscope {
       virtual void set_trigger_mode(trigger_mode mode, int channel,
 				    const std::string &tag_key="") = 0;
 
+      /* Every triggered frame is also stored in the given history,
+       * independently of the plot update rate. */
+      virtual void set_history(std::shared_ptr<WaveformHistory> history) = 0;
+      /* The frames go to the persistence curves starting at
+       * first_channel, where the plot draws this sink. */
+      virtual void set_persistence(
+		std::shared_ptr<PersistenceAccumulator> persistence,
+		unsigned int first_channel = 0) = 0;
+
+      /* In roll mode the sink ignores the trigger and streams the new
+       * samples to the plot at the update rate, instead of waiting for a
+       * complete frame of nsamps() samples. */
+      virtual void set_roll_mode(bool en) = 0;
+      virtual bool roll_mode() const = 0;
+
       virtual int nsamps() const = 0;
       virtual std::string name() const = 0;
       virtual void reset() = 0;
@@ -34,6 +34,9 @@
 #include <qwt_symbol.h>
 
 #include "scope_sink_f_impl.h"
+#include "waveform_history.hpp"
+#include "persistence_accumulator.hpp"
+#include "trace.hpp"
 
 using namespace gr;
 
@@ -57,7 +60,8 @@ namespace adiscope {
                    io_signature::make(nconnections, nconnections, sizeof(float)),
                    io_signature::make(0, 0, 0)),
 	d_size(size), d_buffer_size(2*size), d_samp_rate(samp_rate), d_name(name),
-	d_nconnections(nconnections), d_index(0), d_start(0), d_end(size)
+	d_trace_cat(Tracer::intern(name)), d_nconnections(nconnections), d_index(0), d_start(0), d_end(size),
+	d_roll_mode(false), d_persistence_channel(0)
     {
 
 
@@ -169,10 +173,48 @@ namespace adiscope {
 	  memset(d_fbuffers[n], 0, d_buffer_size*sizeof(float));
 	}
 
+        if (d_history)
+          d_history->setSegmentSize(d_size);
+
         _reset();
       }
     }
 
+    void
+    scope_sink_f_impl::set_history(std::shared_ptr<WaveformHistory> history)
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      d_history = history;
+
+      if (d_history)
+        d_history->setSegmentSize(d_size);
+    }
+
+    void
+    scope_sink_f_impl::set_persistence(std::shared_ptr<PersistenceAccumulator> persistence,
+                                       unsigned int first_channel)
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      d_persistence = persistence;
+      d_persistence_channel = first_channel;
+    }
+
+    void
+    scope_sink_f_impl::set_roll_mode(bool en)
+    {
+      gr::thread::scoped_lock lock(d_setlock);
+      d_roll_mode = en;
+      d_last_time = 0;
+
+      _reset();
+    }
+
+    bool
+    scope_sink_f_impl::roll_mode() const
+    {
+      return d_roll_mode;
+    }
+
     void
     scope_sink_f_impl::set_samp_rate(const double samp_rate)
     {
@@ -268,10 +310,15 @@ namespace adiscope {
       int n=0, idx=0;
       const float *in;
 
+      TRACE_SCOPE(d_trace_cat, "scope_sink");
+
       _npoints_resize();
 
       gr::thread::scoped_lock lock(d_setlock);
 
+      if (d_roll_mode)
+        return _work_roll(noutput_items, input_items);
+
       int nfill = d_end - d_index;                 // how much room left in buffers
       int nitems = std::min(noutput_items, nfill); // num items we can put in buffers
 
@@ -309,13 +356,24 @@ namespace adiscope {
           volk_32f_convert_64f(d_buffers[n], &d_fbuffers[n][d_start], d_size);
         }
 
+        // Keep every triggered frame, even the ones that are not plotted
+        if (d_history)
+          d_history->store(d_fbuffers, d_start, d_tags,
+                           gr::high_res_timer_now());
+
+        if (d_persistence)
+          d_persistence->pushFrame(d_fbuffers, d_start, d_size,
+                                   d_persistence_channel);
+
         // Plot if we are able to update
         if(gr::high_res_timer_now() - d_last_time > d_update_time) {
           d_last_time = gr::high_res_timer_now();
           if (d_qApplication)
 		d_qApplication->postEvent(this->plot,
 				    new IdentifiableTimeUpdateEvent(d_buffers, d_size, d_tags, d_name));
-	}
+	} else {
+          Tracer::instant(d_trace_cat, "dropped_frame");
+        }
 
         // We've plotting, so reset the state
         _reset();
@@ -329,4 +387,44 @@ namespace adiscope {
       return nitems;
     }
 
+    /*
+     * Roll mode: the samples are accumulated as they arrive and whatever
+     * was gathered is sent to the plot once per update period, or as soon
+     * as a whole window is pending. The plot appends them to its own ring
+     * buffer, so the cost of an update only depends on the new samples.
+     */
+    int
+    scope_sink_f_impl::_work_roll(int noutput_items,
+                                  gr_vector_const_void_star &input_items)
+    {
+      if (d_size == 0)
+        return noutput_items;
+
+      int nitems = std::min(noutput_items, d_buffer_size - d_index);
+
+      for(int n = 0; n < d_nconnections; n++) {
+        const float *in = (const float*)input_items[n];
+        memcpy(&d_fbuffers[n][d_index], in, nitems*sizeof(float));
+      }
+      d_index += nitems;
+
+      gr::high_res_timer_type now = gr::high_res_timer_now();
+
+      if(d_index >= d_size || (d_index > 0 &&
+                               now - d_last_time > d_update_time)) {
+        d_last_time = now;
+
+        for(int n = 0; n < d_nconnections; n++)
+          volk_32f_convert_64f(d_buffers[n], d_fbuffers[n], d_index);
+
+        if (d_qApplication)
+          d_qApplication->postEvent(this->plot,
+                                    new RollUpdateEvent(d_buffers, d_index,
+                                                        d_size, d_name));
+        d_index = 0;
+      }
+
+      return nitems;
+    }
+
 } /* namespace gr */
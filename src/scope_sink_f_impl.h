@@ -39,6 +39,7 @@ namespace adiscope {
       int d_size, d_buffer_size;
       double d_samp_rate;
       std::string d_name;
+      const char *d_trace_cat;
       int d_nconnections;
 
       int d_index, d_start, d_end;
@@ -56,11 +57,18 @@ namespace adiscope {
       int d_trigger_channel;
       pmt::pmt_t d_trigger_tag_key;
       bool d_triggered;
+      bool d_roll_mode;
+
+      std::shared_ptr<WaveformHistory> d_history;
+      std::shared_ptr<PersistenceAccumulator> d_persistence;
+      unsigned int d_persistence_channel;
 
       void _reset();
       void _npoints_resize();
       void _adjust_tags(int adj);
       void _test_trigger_tags(int nitems);
+      int _work_roll(int noutput_items,
+                     gr_vector_const_void_star &input_items);
 
     public:
       scope_sink_f_impl(int size, double samp_rate,
@@ -78,6 +86,11 @@ namespace adiscope {
       void set_samp_rate(const double samp_rate);
       void set_trigger_mode(trigger_mode mode, int channel,
 			    const std::string &tag_key="");
+      void set_history(std::shared_ptr<WaveformHistory> history);
+      void set_persistence(std::shared_ptr<PersistenceAccumulator> persistence,
+                           unsigned int first_channel);
+      void set_roll_mode(bool en);
+      bool roll_mode() const;
 
       int nsamps() const;
       std::string name() const;
@@ -18,6 +18,7 @@
  */
 
 #include "dynamicWidget.hpp"
+#include "math_expr_f.hpp"
 #include "signal_generator.hpp"
 #include "spinbox_a.hpp"
 #include "ui_signal_generator.h"
@@ -40,7 +41,6 @@
 #include <gnuradio/blocks/skiphead.h>
 #include <gnuradio/blocks/vector_sink_s.h>
 #include <gnuradio/iio/device_sink.h>
-#include <gnuradio/iio/math.h>
 
 #include <iio.h>
 
@@ -644,8 +644,9 @@ gr::basic_block_sptr SignalGenerator::getSource(QWidget *obj,
 		if (!ptr->function.isEmpty()) {
 			auto str = ptr->function.toStdString();
 
-			return iio::iio_math_gen::make(samp_rate,
-					ptr->math_freq, str);
+			return gnuradio::get_initial_sptr(
+					new math_expr_gen_f(samp_rate,
+						ptr->math_freq, str));
 		}
 	default:
 		break;
@@ -0,0 +1,712 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sim_iiod.hpp"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+#define IIOD_PORT 30431
+#define IIOD_VERSION "0.10.simiiod"
+#define POLL_MS 100
+#define WAIT_SLICE_US 10000
+
+using namespace adiscope;
+
+SimIiod *SimIiod::m_instance = nullptr;
+
+/* CPU time of the calling thread, in ns */
+static uint64_t threadCpuTime()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+
+	if (!clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+		return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+	return 0;
+}
+
+static void appendBe32(QByteArray& out, int32_t value)
+{
+	const uint32_t v = (uint32_t)value;
+
+	out.append((char)(v >> 24));
+	out.append((char)(v >> 16));
+	out.append((char)(v >> 8));
+	out.append((char)v);
+}
+
+class SimIiod::Server : public QTcpServer
+{
+public:
+	explicit Server(SimIiod *sim) : sim(sim) {}
+
+protected:
+	void incomingConnection(qintptr fd) override
+	{
+		sim->serve(fd);
+	}
+
+private:
+	SimIiod *sim;
+};
+
+class SimIiod::Listener : public QThread
+{
+public:
+	explicit Listener(SimIiod *sim) : sim(sim), listening(false) {}
+
+	/* Blocks until the port is bound, or failed to */
+	bool waitListening()
+	{
+		ready.acquire();
+		return listening;
+	}
+
+protected:
+	void run() override
+	{
+		Server server(sim);
+
+		listening = server.listen(QHostAddress::LocalHost, IIOD_PORT);
+		ready.release();
+
+		while (listening && !sim->stopping)
+			server.waitForNewConnection(POLL_MS);
+	}
+
+private:
+	SimIiod *sim;
+	QSemaphore ready;
+	bool listening;
+};
+
+class SimIiod::Session : public QThread
+{
+public:
+	Session(SimIiod *sim, qintptr fd) : sim(sim), fd(fd),
+		socket(nullptr), cpu_ns(0) {}
+
+protected:
+	void run() override;
+
+private:
+	SimIiod *sim;
+	qintptr fd;
+	QTcpSocket *socket;
+	uint64_t cpu_ns;
+	std::vector<char> buffer;
+
+	bool alive() const;
+	bool readLine(QByteArray& line);
+	bool readData(QByteArray& data, int len);
+	bool send(const QByteArray& data);
+	bool reply(long long value);
+	bool pause(double s);
+	void account();
+
+	bool command(const QList<QByteArray>& args);
+	bool readAttr(const QList<QByteArray>& args);
+	bool writeAttr(const QList<QByteArray>& args);
+	bool readBuf(const std::string& dev, long long bytes);
+	bool writeBuf(const std::string& dev, long long bytes);
+};
+
+void SimIiod::Session::run()
+{
+	QTcpSocket sock;
+
+	if (!sock.setSocketDescriptor(fd))
+		return;
+
+	socket = &sock;
+	cpu_ns = threadCpuTime();
+
+	QByteArray line;
+	while (readLine(line)) {
+		QList<QByteArray> args;
+
+		for (const QByteArray& arg : line.split(' '))
+			if (!arg.isEmpty())
+				args.append(arg);
+
+		bool ok = args.isEmpty() || command(args);
+		account();
+		if (!ok)
+			break;
+	}
+
+	sock.disconnectFromHost();
+	account();
+	socket = nullptr;
+}
+
+bool SimIiod::Session::alive() const
+{
+	return !sim->stopping &&
+		socket->state() == QAbstractSocket::ConnectedState;
+}
+
+void SimIiod::Session::account()
+{
+	const uint64_t now = threadCpuTime();
+
+	sim->cpu_ns += now - cpu_ns;
+	cpu_ns = now;
+}
+
+bool SimIiod::Session::readLine(QByteArray& line)
+{
+	while (!socket->canReadLine()) {
+		if (!socket->waitForReadyRead(POLL_MS) && !alive())
+			return false;
+	}
+
+	line = socket->readLine().trimmed();
+	return true;
+}
+
+bool SimIiod::Session::readData(QByteArray& data, int len)
+{
+	while (socket->bytesAvailable() < len) {
+		if (!socket->waitForReadyRead(POLL_MS) && !alive())
+			return false;
+	}
+
+	data = socket->read(len);
+	return true;
+}
+
+bool SimIiod::Session::send(const QByteArray& data)
+{
+	socket->write(data);
+
+	while (socket->bytesToWrite()) {
+		if (!socket->waitForBytesWritten(POLL_MS) && !alive())
+			return false;
+	}
+
+	return true;
+}
+
+bool SimIiod::Session::reply(long long value)
+{
+	return send(QByteArray::number(value) + '\n');
+}
+
+/* Sleeps while watching for the client to go away */
+bool SimIiod::Session::pause(double s)
+{
+	using namespace std::chrono;
+
+	const auto end = steady_clock::now() +
+		duration_cast<steady_clock::duration>(duration<double>(s));
+
+	for (;;) {
+		socket->waitForReadyRead(0);
+		if (!alive())
+			return false;
+
+		const auto left = duration_cast<microseconds>(
+				end - steady_clock::now());
+		if (left.count() <= 0)
+			return true;
+
+		std::this_thread::sleep_for(std::min(left,
+					microseconds(WAIT_SLICE_US)));
+	}
+}
+
+bool SimIiod::Session::command(const QList<QByteArray>& args)
+{
+	const QByteArray& cmd = args[0];
+	SimM2k& m2k = sim->m2k;
+
+	if (cmd == "VERSION") {
+		return send(IIOD_VERSION "\n");
+	} else if (cmd == "PRINT") {
+		const QByteArray xml = QByteArray::fromStdString(m2k.xml());
+
+		return send(QByteArray::number(xml.size()) + '\n' + xml + '\n');
+	} else if (cmd == "EXIT") {
+		return false;
+	} else if (cmd == "TIMEOUT") {
+		return reply(0);
+	} else if (cmd == "READ") {
+		return readAttr(args);
+	} else if (cmd == "WRITE") {
+		return writeAttr(args);
+	} else if (args.size() < 2) {
+		return reply(-EINVAL);
+	}
+
+	const std::string dev = args[1].toStdString();
+
+	if (cmd == "OPEN" && args.size() >= 4) {
+		const QByteArray& str = args[3];
+		std::vector<uint32_t> mask;
+
+		for (int i = str.size(); i > 0; i -= 8) {
+			const int pos = std::max(0, i - 8);
+			mask.push_back(str.mid(pos, i - pos).toUInt(nullptr, 16));
+		}
+
+		return reply(m2k.open(dev, args[2].toULongLong(), mask,
+				args.size() > 4 && args[4] == "CYCLIC"));
+	} else if (cmd == "CLOSE") {
+		return reply(m2k.close(dev));
+	} else if (cmd == "READBUF" && args.size() >= 3) {
+		return readBuf(dev, args[2].toLongLong());
+	} else if (cmd == "WRITEBUF" && args.size() >= 3) {
+		return writeBuf(dev, args[2].toLongLong());
+	} else if (cmd == "SET") {
+		return reply(0);
+	} else if (cmd == "GETTRIG") {
+		return reply(-ENOENT);
+	} else if (cmd == "SETTRIG") {
+		return reply(0);
+	}
+
+	return reply(-EINVAL);
+}
+
+/*
+ * READ <dev> [INPUT|OUTPUT <chn>|DEBUG] [attr]
+ * Without an attribute, all of them are read at once, each as a big
+ * endian length followed by the value padded to 4 bytes.
+ */
+bool SimIiod::Session::readAttr(const QList<QByteArray>& args)
+{
+	if (args.size() < 2)
+		return reply(-EINVAL);
+
+	const std::string dev = args[1].toStdString();
+	std::string chn, attr;
+	bool output = false, debug = false;
+	int pos = 2;
+
+	if (pos < args.size() && (args[pos] == "INPUT" ||
+				args[pos] == "OUTPUT")) {
+		output = args[pos] == "OUTPUT";
+		if (pos + 1 >= args.size())
+			return reply(-EINVAL);
+		chn = args[pos + 1].toStdString();
+		pos += 2;
+	} else if (pos < args.size() && args[pos] == "DEBUG") {
+		debug = true;
+		pos++;
+	} else if (pos < args.size() && args[pos] == "BUFFER") {
+		return reply(-ENOENT);
+	}
+
+	if (pos < args.size())
+		attr = args[pos].toStdString();
+
+	QByteArray data;
+	std::string value;
+
+	if (!attr.empty()) {
+		int ret = sim->m2k.read(dev, chn, output, debug, attr, value);
+		if (ret < 0)
+			return reply(ret);
+
+		data = QByteArray(value.c_str(), value.size() + 1);
+	} else {
+		std::vector<std::string> names;
+
+		int ret = sim->m2k.attrs(dev, chn, output, debug, names);
+		if (ret < 0)
+			return reply(ret);
+
+		for (const std::string& name : names) {
+			ret = sim->m2k.read(dev, chn, output, debug, name,
+					value);
+			if (ret < 0) {
+				appendBe32(data, ret);
+				continue;
+			}
+
+			appendBe32(data, value.size() + 1);
+			data.append(value.c_str(), value.size() + 1);
+			while (data.size() & 3)
+				data.append('\0');
+		}
+	}
+
+	return send(QByteArray::number(data.size()) + '\n' + data + '\n');
+}
+
+/*
+ * WRITE <dev> [INPUT|OUTPUT <chn>|DEBUG] [attr] <len>, followed by the
+ * value, in the format of READ
+ */
+bool SimIiod::Session::writeAttr(const QList<QByteArray>& args)
+{
+	if (args.size() < 3)
+		return reply(-EINVAL);
+
+	const std::string dev = args[1].toStdString();
+	const int len = args.last().toInt();
+	const int end = args.size() - 1;
+	std::string chn, attr;
+	bool output = false, debug = false;
+	int pos = 2;
+
+	QByteArray data;
+	if (len < 0 || !readData(data, len))
+		return false;
+
+	if (pos < end && (args[pos] == "INPUT" || args[pos] == "OUTPUT")) {
+		output = args[pos] == "OUTPUT";
+		if (pos + 1 >= end)
+			return reply(-EINVAL);
+		chn = args[pos + 1].toStdString();
+		pos += 2;
+	} else if (pos < end && args[pos] == "DEBUG") {
+		debug = true;
+		pos++;
+	} else if (pos < end && args[pos] == "BUFFER") {
+		return reply(-ENOENT);
+	}
+
+	if (pos < end)
+		attr = args[pos].toStdString();
+
+	if (!attr.empty()) {
+		int ret = sim->m2k.write(dev, chn, output, debug, attr,
+				data.toStdString());
+		return reply(ret < 0 ? ret : len);
+	}
+
+	std::vector<std::string> names;
+	int ret = sim->m2k.attrs(dev, chn, output, debug, names);
+	if (ret < 0)
+		return reply(ret);
+
+	int offset = 0;
+	for (const std::string& name : names) {
+		if (offset + 4 > data.size())
+			break;
+
+		const uchar *ptr = (const uchar *)data.constData() + offset;
+		const int32_t size = (int32_t)((ptr[0] << 24) | (ptr[1] << 16) |
+				(ptr[2] << 8) | ptr[3]);
+		offset += 4;
+
+		if (size <= 0)
+			continue;
+
+		sim->m2k.write(dev, chn, output, debug, name,
+				data.mid(offset, size).toStdString());
+		offset += (size + 3) & ~3;
+	}
+
+	return reply(len);
+}
+
+/*
+ * READBUF <dev> <bytes>: the number of bytes, the mask of the buffer as
+ * hex words, most significant first, then the samples
+ */
+bool SimIiod::Session::readBuf(const std::string& dev, long long bytes)
+{
+	if (bytes <= 0)
+		return reply(-EINVAL);
+
+	buffer.resize(bytes);
+
+	const ssize_t ret = sim->m2k.capture(dev, buffer.data(), bytes,
+			[this](double s) { return pause(s); });
+	if (ret < 0)
+		return ret == -EPIPE ? false : reply(ret);
+
+	std::vector<uint32_t> mask;
+	sim->m2k.mask(dev, mask);
+
+	QByteArray header = QByteArray::number((qlonglong)ret) + '\n';
+	for (size_t i = mask.size(); i > 0; i--)
+		header += QByteArray::number(mask[i - 1], 16)
+			.rightJustified(8, '0');
+	header += '\n';
+
+	if (!send(header) || !send(QByteArray::fromRawData(buffer.data(),
+					ret)))
+		return false;
+
+	/* The client waits for more until it got all it asked for */
+	return ret == bytes || reply(0);
+}
+
+/* WRITEBUF <dev> <bytes>: acknowledged once, then once received */
+bool SimIiod::Session::writeBuf(const std::string& dev, long long bytes)
+{
+	QByteArray data;
+
+	if (bytes <= 0 || bytes > INT32_MAX)
+		return reply(-EINVAL);
+
+	if (!reply(bytes) || !readData(data, bytes))
+		return false;
+
+	return reply(sim->m2k.push(dev, data.constData(), data.size()));
+}
+
+SimIiod::SimIiod() :
+	api(new SimIiod_API(this)),
+	listener(nullptr),
+	stopping(false),
+	cpu_ns(0)
+{
+	api->setObjectName("sim");
+	m_instance = this;
+}
+
+SimIiod::~SimIiod()
+{
+	stopping = true;
+
+	if (listener) {
+		listener->wait();
+		delete listener;
+	}
+
+	for (Session *session : sessions) {
+		session->wait();
+		delete session;
+	}
+
+	delete api;
+
+	if (m_instance == this)
+		m_instance = nullptr;
+}
+
+bool SimIiod::start()
+{
+	if (listener)
+		return true;
+
+	listener = new Listener(this);
+	listener->start();
+
+	if (!listener->waitListening()) {
+		listener->wait();
+		delete listener;
+		listener = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+QString SimIiod::uri() const
+{
+	return "ip:127.0.0.1";
+}
+
+SimM2k *SimIiod::model()
+{
+	return &m2k;
+}
+
+double SimIiod::cpuTime() const
+{
+	return cpu_ns * 1e-9;
+}
+
+void SimIiod::js_register(QJSEngine *engine)
+{
+	api->js_register(engine);
+}
+
+SimIiod *SimIiod::instance()
+{
+	return m_instance;
+}
+
+void SimIiod::serve(qintptr fd)
+{
+	std::lock_guard<std::mutex> guard(sessions_lock);
+
+	/* Reap the sessions of the clients that went away */
+	for (auto it = sessions.begin(); it != sessions.end();) {
+		if ((*it)->isFinished()) {
+			delete *it;
+			it = sessions.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	Session *session = new Session(this, fd);
+	sessions.push_back(session);
+	session->start();
+}
+
+QList<double> SimIiod_API::get(double SimM2k::Signal::*field) const
+{
+	QList<double> list;
+
+	for (unsigned int i = 0; i < 2; i++)
+		list.append(sim->m2k.signal(i).*field);
+
+	return list;
+}
+
+void SimIiod_API::set(double SimM2k::Signal::*field,
+		const QList<double>& list)
+{
+	for (int i = 0; i < list.size() && i < 2; i++) {
+		SimM2k::Signal signal = sim->m2k.signal(i);
+
+		signal.*field = list.at(i);
+		sim->m2k.setSignal(i, signal);
+	}
+}
+
+QList<int> SimIiod_API::getWaveformType() const
+{
+	QList<int> list;
+
+	for (unsigned int i = 0; i < 2; i++)
+		list.append(sim->m2k.signal(i).type);
+
+	return list;
+}
+
+void SimIiod_API::setWaveformType(const QList<int>& list)
+{
+	for (int i = 0; i < list.size() && i < 2; i++) {
+		SimM2k::Signal signal = sim->m2k.signal(i);
+
+		if (list.at(i) < SimM2k::SINE || list.at(i) > SimM2k::DC)
+			continue;
+
+		signal.type = static_cast<SimM2k::Waveform>(list.at(i));
+		sim->m2k.setSignal(i, signal);
+	}
+}
+
+QList<double> SimIiod_API::getWaveformFreq() const
+{
+	return get(&SimM2k::Signal::frequency);
+}
+
+void SimIiod_API::setWaveformFreq(const QList<double>& list)
+{
+	set(&SimM2k::Signal::frequency, list);
+}
+
+QList<double> SimIiod_API::getWaveformAmpl() const
+{
+	return get(&SimM2k::Signal::amplitude);
+}
+
+void SimIiod_API::setWaveformAmpl(const QList<double>& list)
+{
+	set(&SimM2k::Signal::amplitude, list);
+}
+
+QList<double> SimIiod_API::getWaveformOfft() const
+{
+	return get(&SimM2k::Signal::offset);
+}
+
+void SimIiod_API::setWaveformOfft(const QList<double>& list)
+{
+	set(&SimM2k::Signal::offset, list);
+}
+
+QList<double> SimIiod_API::getNoise() const
+{
+	return get(&SimM2k::Signal::noise);
+}
+
+void SimIiod_API::setNoise(const QList<double>& list)
+{
+	set(&SimM2k::Signal::noise, list);
+}
+
+bool SimIiod_API::loopback() const
+{
+	return sim->m2k.loopback();
+}
+
+void SimIiod_API::setLoopback(bool en)
+{
+	sim->m2k.setLoopback(en);
+}
+
+double SimIiod_API::dutCutoff() const
+{
+	return sim->m2k.dutCutoff();
+}
+
+void SimIiod_API::setDutCutoff(double hz)
+{
+	sim->m2k.setDutCutoff(hz);
+}
+
+bool SimIiod_API::realtime() const
+{
+	return sim->m2k.realtime();
+}
+
+void SimIiod_API::setRealtime(bool en)
+{
+	sim->m2k.setRealtime(en);
+}
+
+int SimIiod_API::uartBaudRate() const
+{
+	return sim->m2k.uartBaudRate();
+}
+
+void SimIiod_API::setUartBaudRate(int baud)
+{
+	if (baud > 0)
+		sim->m2k.setUartBaudRate(baud);
+}
+
+QString SimIiod_API::uartText() const
+{
+	return QString::fromStdString(sim->m2k.uartText());
+}
+
+void SimIiod_API::setUartText(const QString& text)
+{
+	sim->m2k.setUartText(text.toStdString());
+}
+
+double SimIiod_API::cpuTime() const
+{
+	return sim->cpuTime();
+}
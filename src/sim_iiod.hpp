@@ -0,0 +1,168 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef SIM_IIOD_HPP
+#define SIM_IIOD_HPP
+
+#include "apiObject.hpp"
+#include "sim_m2k.hpp"
+
+#include <QList>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class QJSEngine;
+
+namespace adiscope {
+	class SimIiod_API;
+
+	/*
+	 * Serves a simulated M2K over the iiod network protocol on the
+	 * loopback interface, so that the tools reach it through the
+	 * unchanged network backend of libiio, buffers included, at
+	 * ip:127.0.0.1.
+	 *
+	 * Every connection is served by a thread of its own with blocking
+	 * sockets, as libiio opens one connection per buffer and blocks on
+	 * each of them.
+	 */
+	class SimIiod
+	{
+		friend class SimIiod_API;
+
+	public:
+		SimIiod();
+		~SimIiod();
+
+		/* Returns false if the iiod port is taken */
+		bool start();
+		QString uri() const;
+
+		SimM2k *model();
+
+		/* CPU time spent serving the simulated device, in seconds */
+		double cpuTime() const;
+
+		void js_register(QJSEngine *engine);
+
+		static SimIiod *instance();
+
+	private:
+		class Server;
+		class Listener;
+		class Session;
+
+		static SimIiod *m_instance;
+
+		SimM2k m2k;
+		SimIiod_API *api;
+		Listener *listener;
+
+		std::atomic<bool> stopping;
+		std::atomic<uint64_t> cpu_ns;
+
+		std::mutex sessions_lock;
+		std::vector<Session *> sessions;
+
+		void serve(qintptr fd);
+	};
+
+	class SimIiod_API : public ApiObject
+	{
+		Q_OBJECT
+
+		Q_PROPERTY(QList<int> waveform_type
+				READ getWaveformType WRITE setWaveformType
+				STORED false);
+		Q_PROPERTY(QList<double> waveform_frequency
+				READ getWaveformFreq WRITE setWaveformFreq
+				STORED false);
+		Q_PROPERTY(QList<double> waveform_amplitude
+				READ getWaveformAmpl WRITE setWaveformAmpl
+				STORED false);
+		Q_PROPERTY(QList<double> waveform_offset
+				READ getWaveformOfft WRITE setWaveformOfft
+				STORED false);
+		Q_PROPERTY(QList<double> noise
+				READ getNoise WRITE setNoise STORED false);
+
+		Q_PROPERTY(bool loopback READ loopback WRITE setLoopback
+				STORED false);
+		Q_PROPERTY(double dut_cutoff READ dutCutoff WRITE setDutCutoff
+				STORED false);
+		Q_PROPERTY(bool realtime READ realtime WRITE setRealtime
+				STORED false);
+
+		Q_PROPERTY(int uart_baudrate READ uartBaudRate
+				WRITE setUartBaudRate STORED false);
+		Q_PROPERTY(QString uart_text READ uartText WRITE setUartText
+				STORED false);
+
+		Q_PROPERTY(double cpu_time READ cpuTime STORED false);
+
+	public:
+		explicit SimIiod_API(SimIiod *sim) : ApiObject(), sim(sim) {}
+		~SimIiod_API() {}
+
+		QList<int> getWaveformType() const;
+		void setWaveformType(const QList<int>& list);
+
+		QList<double> getWaveformFreq() const;
+		void setWaveformFreq(const QList<double>& list);
+
+		QList<double> getWaveformAmpl() const;
+		void setWaveformAmpl(const QList<double>& list);
+
+		QList<double> getWaveformOfft() const;
+		void setWaveformOfft(const QList<double>& list);
+
+		QList<double> getNoise() const;
+		void setNoise(const QList<double>& list);
+
+		bool loopback() const;
+		void setLoopback(bool en);
+
+		double dutCutoff() const;
+		void setDutCutoff(double hz);
+
+		bool realtime() const;
+		void setRealtime(bool en);
+
+		int uartBaudRate() const;
+		void setUartBaudRate(int baud);
+
+		QString uartText() const;
+		void setUartText(const QString& text);
+
+		double cpuTime() const;
+
+	private:
+		SimIiod *sim;
+
+		QList<double> get(double SimM2k::Signal::*field) const;
+		void set(double SimM2k::Signal::*field,
+				const QList<double>& list);
+	};
+}
+
+#endif /* SIM_IIOD_HPP */
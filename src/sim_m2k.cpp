@@ -0,0 +1,1275 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sim_m2k.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+/* How the front-end maps the input voltage to ADC codes, see M2kAdc */
+#define ADC_CODES_PER_VOLT (2048 * 1.3 / 0.78)
+#define ADC_MIN_CODE -2048
+#define ADC_MAX_CODE 2047
+#define LOW_GAIN 0.02
+#define HIGH_GAIN 0.212
+
+/* ADC codes added by one LSB of the ad5625 offset DACs */
+#define ADC_OFFSET_CODES_PER_LSB (2048 * 2.693 * 1.2 / (4096 * 0.78))
+#define DAC_OFFSET_VOLTS_PER_LSB 0.002658
+#define OFFSET_DAC_MID 2048
+
+/* The DAC samples are 12 bit left aligned, inverted by the output stage */
+#define DAC_VOLTS_PER_LSB (5.0 / 2048)
+
+/* The references of the calibration paths */
+#define ADC_REF1_VOLTS 0.4615
+#define DAC_LOOPBACK_DIVIDER 9.06
+
+/* The ad5627 supply DACs, and the ad9963 ADC reading them back */
+#define POS_SUPPLY_VOLTS_PER_LSB (5.02 * 1.2 / 4095)
+#define NEG_SUPPLY_VOLTS_PER_LSB (-5.1 * 1.2 / 4095)
+#define POS_READBACK_LSB_PER_VOLT (4095 / 6.4)
+#define NEG_READBACK_LSB_PER_VOLT (4095 / -6.4)
+
+/* The digital stimulus: a UART on DIO0 and a counter on DIO1-7 */
+#define UART_DEFAULT_BAUD 115200
+#define UART_DEFAULT_TEXT "Scopy\r\n"
+#define UART_IDLE_BITS 20
+#define COUNTER_RATE 2000.0
+#define COUNTER_BITS 7
+#define DIO_CHANNELS 16
+
+#define DEFAULT_DUT_CUTOFF 10000.0
+#define NOISE_SEED 0x2545f4914f6cdd1dULL
+
+/* How finely one period of the trigger source is searched */
+#define TRIGGER_SEARCH_STEPS 4096
+#define TRIGGER_SEARCH_MAX_STEPS (1 << 20)
+#define TRIGGER_POLL_S 0.01
+
+using namespace adiscope;
+
+struct SimM2k::Playback {
+	double start;	/* s */
+	double rate;
+	std::vector<float> volts;	/* DACs */
+	std::vector<float> filtered;	/* DACs, through the DUT */
+	std::vector<uint16_t> pins;	/* pattern generator */
+	uint16_t mask;
+
+	size_t size() const
+	{
+		return pins.empty() ? volts.size() : pins.size();
+	}
+
+	/* The sample being played at the time t; buffers are cyclic */
+	size_t at(double t) const
+	{
+		double pos = std::fmod(std::floor((t - start) * rate),
+				(double)size());
+		if (pos < 0)
+			pos += size();
+
+		return std::min((size_t)pos, size() - 1);
+	}
+};
+
+/* What a capture sees, copied so it can be generated without the lock */
+struct SimM2k::Inputs {
+	enum Calibration {
+		CAL_NONE,
+		CAL_ADC_GND,
+		CAL_ADC_REF1,
+		CAL_DAC,
+	};
+
+	enum Trigger {
+		FREE_RUNNING,
+		ANALOG,
+		DIGITAL,
+		NEVER,
+	};
+
+	bool digital;
+	double rate;
+	double delay;	/* samples, negative before the trigger */
+	std::vector<unsigned int> chns;
+
+	Signal signals[2];
+	std::shared_ptr<const Playback> dacs[2];
+	bool loopback;
+	Calibration calibration;
+	double gain[2];		/* codes per V */
+	double offset[2];	/* codes */
+	double dac_offset[2];	/* V */
+
+	uint16_t dio_out, dio_value;
+	std::shared_ptr<const Playback> pattern;
+	unsigned int baud;
+	std::string text;
+
+	Trigger trigger;
+	unsigned int trigger_chn;
+	std::string condition;
+	double level;		/* codes */
+	uint16_t rising, falling, any, low, high;
+	bool all;
+
+	double dacVolts(unsigned int chn, double t, bool filtered) const;
+	double volts(unsigned int chn, double t) const;
+	double code(unsigned int chn, double t) const
+	{
+		return volts(chn, t) * gain[chn] + offset[chn];
+	}
+	uint16_t pins(double t) const;
+
+	/* Whether the trigger condition is met going from time a to b */
+	bool holds(double a, double b) const;
+	double period() const;
+	double resolution() const;
+	bool findTrigger(double from, double& t) const;
+
+	void fill(char *data, size_t samples, double start) const;
+};
+
+static uint64_t ticks(double t, double rate)
+{
+	return t > 0 ? (uint64_t)(t * rate) : 0;
+}
+
+static double waveform(const SimM2k::Signal& s, double t)
+{
+	double phase = s.frequency * t;
+	double v = 0.0;
+
+	phase -= std::floor(phase);
+
+	switch (s.type) {
+	case SimM2k::SINE:
+		v = std::sin(2 * M_PI * phase);
+		break;
+	case SimM2k::SQUARE:
+		v = phase < 0.5 ? 1.0 : -1.0;
+		break;
+	case SimM2k::TRIANGLE:
+		v = phase < 0.5 ? 4 * phase - 1 : 3 - 4 * phase;
+		break;
+	case SimM2k::SAWTOOTH:
+		v = 2 * phase - 1;
+		break;
+	case SimM2k::DC:
+		break;
+	}
+
+	return s.offset + s.amplitude * v;
+}
+
+/* The attenuation the M2kAdc filter compensation table undoes */
+static double filterGain(double rate)
+{
+	static const double rates[] = { 1e8, 1e7, 1e6, 1e5, 1e4, 1e3 };
+	static const double comp[] = { 1.00, 1.05, 1.10, 1.15, 1.20, 1.26 };
+
+	for (unsigned int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+		if (std::fabs(rate - rates[i]) < 0.5)
+			return 1.0 / comp[i];
+
+	return 1.0;
+}
+
+static inline uint64_t xorshift(uint64_t& s)
+{
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+/* Irwin-Hall: close enough to a normal distribution of variance 1 */
+static inline double gaussian(uint64_t& s)
+{
+	double sum = 0.0;
+
+	for (unsigned int i = 0; i < 4; i++)
+		sum += (xorshift(s) >> 11) * (1.0 / 9007199254740992.0);
+
+	return (sum - 2.0) * std::sqrt(3.0);
+}
+
+static void put16(char *ptr, uint16_t value)
+{
+	ptr[0] = (char)(value & 0xff);
+	ptr[1] = (char)(value >> 8);
+}
+
+static std::string escape(const std::string& str)
+{
+	std::string out;
+
+	for (char c : str) {
+		switch (c) {
+		case '&': out += "&amp;"; break;
+		case '<': out += "&lt;"; break;
+		case '>': out += "&gt;"; break;
+		case '"': out += "&quot;"; break;
+		case '\'': out += "&apos;"; break;
+		default: out += c; break;
+		}
+	}
+
+	return out;
+}
+
+double SimM2k::Inputs::dacVolts(unsigned int chn, double t,
+		bool filtered) const
+{
+	const Playback *p = dacs[chn].get();
+	double v = dac_offset[chn];
+
+	if (p && p->size())
+		v += filtered ? p->filtered[p->at(t)] : p->volts[p->at(t)];
+
+	return v;
+}
+
+double SimM2k::Inputs::volts(unsigned int chn, double t) const
+{
+	switch (calibration) {
+	case CAL_ADC_GND:
+		return 0.0;
+	case CAL_ADC_REF1:
+		return ADC_REF1_VOLTS;
+	case CAL_DAC:
+		return dacVolts(chn, t, false) / DAC_LOOPBACK_DIVIDER;
+	case CAL_NONE:
+		break;
+	}
+
+	if (loopback && dacs[chn])
+		return dacVolts(chn, t, chn == 1);
+
+	return waveform(signals[chn], t);
+}
+
+uint16_t SimM2k::Inputs::pins(double t) const
+{
+	uint16_t value = 0;
+
+	/* 8N1, least significant bit first, idle high */
+	if (baud && !text.empty()) {
+		const uint64_t bits = text.size() * 10;
+		const uint64_t bit = ticks(t, baud) % (bits + UART_IDLE_BITS);
+		bool level = true;
+
+		if (bit < bits) {
+			unsigned int pos = bit % 10;
+			uint8_t c = (uint8_t)text[bit / 10];
+
+			if (pos == 0)
+				level = false;
+			else if (pos <= 8)
+				level = (c >> (pos - 1)) & 1;
+		}
+
+		value |= level;
+	}
+
+	value |= (ticks(t, COUNTER_RATE) & ((1 << COUNTER_BITS) - 1)) << 1;
+
+	value = (value & ~dio_out) | (dio_value & dio_out);
+
+	if (pattern && pattern->size()) {
+		value = (value & ~pattern->mask) |
+			(pattern->pins[pattern->at(t)] & pattern->mask);
+	}
+
+	return value;
+}
+
+bool SimM2k::Inputs::holds(double a, double b) const
+{
+	if (digital) {
+		const uint16_t prev = pins(a), cur = pins(b);
+		const uint16_t rise = ~prev & cur, fall = prev & ~cur;
+		const uint16_t used = rising | falling | any | low | high;
+		const uint16_t met = (rise & rising) | (fall & falling) |
+			((rise | fall) & any) | (~cur & low) | (cur & high);
+
+		return all ? (met & used) == used : (met & used) != 0;
+	}
+
+	const double prev = code(trigger_chn, a);
+	const double cur = code(trigger_chn, b);
+
+	if (condition == "edge-rising")
+		return prev < level && cur >= level;
+	else if (condition == "edge-falling")
+		return prev > level && cur <= level;
+	else if (condition == "level-low")
+		return cur < level;
+	else if (condition == "level-high")
+		return cur > level;
+
+	return false;
+}
+
+double SimM2k::Inputs::period() const
+{
+	if (digital) {
+		double period = (1 << COUNTER_BITS) / COUNTER_RATE;
+
+		if (baud && !text.empty())
+			period = std::max(period, (text.size() * 10 +
+					UART_IDLE_BITS) / (double)baud);
+		if (pattern && pattern->size())
+			period = std::max(period,
+					pattern->size() / pattern->rate);
+
+		return period;
+	}
+
+	const unsigned int chn = trigger_chn;
+
+	if (calibration == CAL_DAC || (calibration == CAL_NONE &&
+				loopback && dacs[chn])) {
+		const Playback *p = dacs[chn].get();
+		return p && p->size() ? p->size() / p->rate : 0.0;
+	}
+
+	if (calibration != CAL_NONE || signals[chn].type == SimM2k::DC ||
+			signals[chn].frequency <= 0)
+		return 0.0;
+
+	return 1.0 / signals[chn].frequency;
+}
+
+double SimM2k::Inputs::resolution() const
+{
+	if (!digital)
+		return period() / TRIGGER_SEARCH_STEPS;
+
+	double res = 1.0 / COUNTER_RATE;
+
+	if (baud && !text.empty())
+		res = std::min(res, 1.0 / baud);
+	if (pattern && pattern->size())
+		res = std::min(res, 1.0 / pattern->rate);
+
+	return res / 2;
+}
+
+/*
+ * Walks one period of the trigger source from the time from on, then
+ * narrows the step in which the condition started to hold down to a
+ * sample.
+ */
+bool SimM2k::Inputs::findTrigger(double from, double& t) const
+{
+	if (holds(from, from)) {
+		t = from;
+		return true;
+	}
+
+	const double span = period();
+	if (span <= 0)
+		return false;
+
+	const double step = std::max(std::max(resolution(), 1.0 / rate),
+			span / TRIGGER_SEARCH_MAX_STEPS);
+	const uint64_t steps = (uint64_t)std::ceil(span / step) + 1;
+
+	for (uint64_t i = 1; i <= steps; i++) {
+		double a = from + (i - 1) * step;
+		double b = from + i * step;
+
+		if (!holds(a, b))
+			continue;
+
+		const double base = a;
+		while (b - a > 1.0 / rate) {
+			double m = (a + b) / 2;
+
+			if (holds(base, m))
+				b = m;
+			else
+				a = m;
+		}
+
+		t = b;
+		return true;
+	}
+
+	return false;
+}
+
+void SimM2k::Inputs::fill(char *data, size_t samples, double start) const
+{
+	if (digital) {
+		for (size_t i = 0; i < samples; i++, data += 2)
+			put16(data, pins(start + i / rate));
+		return;
+	}
+
+	uint64_t seed = ((uint64_t)std::llround(start * rate) *
+			0x9e3779b97f4a7c15ULL) ^ NOISE_SEED;
+	double noise[2];
+
+	for (unsigned int chn = 0; chn < 2; chn++)
+		noise[chn] = calibration == CAL_NONE ?
+			signals[chn].noise * gain[chn] : 0.0;
+
+	for (size_t i = 0; i < samples; i++) {
+		const double t = start + i / rate;
+
+		for (unsigned int chn : chns) {
+			double code = this->code(chn, t);
+
+			if (noise[chn] != 0.0)
+				code += noise[chn] * gaussian(seed);
+
+			long c = std::lround(code);
+			c = std::min(std::max(c, (long)ADC_MIN_CODE),
+					(long)ADC_MAX_CODE);
+
+			put16(data, (uint16_t)(int16_t)c);
+			data += 2;
+		}
+	}
+}
+
+SimM2k::SimM2k() :
+	epoch(clock()),
+	loopback_en(false), realtime_en(true),
+	dut_cutoff(DEFAULT_DUT_CUTOFF),
+	uart_baud(UART_DEFAULT_BAUD), uart_text(UART_DEFAULT_TEXT)
+{
+	signals[0] = { SINE, 1000.0, 1.0, 0.0, 0.001 };
+	signals[1] = { SQUARE, 5000.0, 0.5, 0.0, 0.001 };
+
+	context_attrs["hw_model"] = "Analog Devices M2k Rev.C (Z7010)";
+	context_attrs["hw_serial"] = "simulated";
+	context_attrs["fw_version"] = "v0.24";
+
+	Device& xadc = addDevice("xadc", false);
+	Channel& temp = addChannel(xadc, "temp0", false);
+	temp.attrs["raw"] = "2450";
+	temp.attrs["offset"] = "-2219";
+	temp.attrs["scale"] = "123.040771484";
+
+	Device& fabric = addDevice("m2k-fabric", false);
+	fabric.attrs["calibration_mode"] = "none";
+	fabric.attrs["calibration_mode_available"] =
+		"adc_gnd adc_ref1 dac none";
+	for (const char *id : { "voltage0", "voltage1" }) {
+		Channel& in = addChannel(fabric, id, false);
+		in.attrs["gain"] = "low";
+		in.attrs["gain_available"] = "low high";
+		in.attrs["powerdown"] = "0";
+
+		Channel& out = addChannel(fabric, id, true);
+		out.attrs["powerdown"] = "0";
+	}
+
+	Device& ad5625 = addDevice("ad5625", false);
+	for (const char *id : { "voltage0", "voltage1", "voltage2",
+			"voltage3" }) {
+		Channel& out = addChannel(ad5625, id, true);
+		out.attrs["raw"] = "2048";
+		out.attrs["powerdown"] = "0";
+	}
+
+	Device& ad5627 = addDevice("ad5627", false);
+	for (const char *id : { "voltage0", "voltage1" }) {
+		Channel& out = addChannel(ad5627, id, true);
+		out.attrs["raw"] = "0";
+		out.attrs["powerdown"] = "1";
+	}
+
+	Device& ad9963 = addDevice("ad9963", false);
+	for (const char *id : { "voltage0", "voltage1", "voltage2" }) {
+		Channel& in = addChannel(ad9963, id, false);
+		in.attrs["raw"] = "0";
+	}
+	ad9963.debug_attrs["direct_reg_access"] = "0x0";
+
+	Device& trigger = addDevice("m2k-adc-trigger", false);
+	Channel& delay = addChannel(trigger, "trigger", false);
+	delay.attrs["logic_mode"] = "a";
+	delay.attrs["delay"] = "0";
+	for (const char *id : { "voltage0", "voltage1" }) {
+		Channel& chn = addChannel(trigger, id, false);
+		chn.attrs["trigger"] = "edge-rising";
+		chn.attrs["trigger_level"] = "0";
+		chn.attrs["trigger_hysteresis"] = "0";
+	}
+	for (const char *id : { "voltage2", "voltage3" }) {
+		Channel& chn = addChannel(trigger, id, false);
+		chn.attrs["trigger"] = "edge-rising";
+	}
+	for (const char *id : { "voltage4", "voltage5" }) {
+		Channel& chn = addChannel(trigger, id, false);
+		chn.attrs["mode"] = "always";
+	}
+
+	Device& adc = addDevice("m2k-adc", false);
+	addChannel(adc, "voltage0", false, 0, "le:S12/16>>0");
+	addChannel(adc, "voltage1", false, 1, "le:S12/16>>0");
+	adc.attrs["sampling_frequency"] = "100000000";
+	adc.attrs["sampling_frequency_available"] =
+		"1000 10000 100000 1000000 10000000 100000000";
+	adc.attrs["oversampling_ratio"] = "1";
+
+	for (const char *name : { "m2k-dac-a", "m2k-dac-b" }) {
+		Device& dac = addDevice(name, true);
+		addChannel(dac, "voltage0", true, 0, "le:S16/16>>0");
+		dac.attrs["sampling_frequency"] = "75000000";
+		dac.attrs["sampling_frequency_available"] =
+			"750 7500 75000 750000 7500000 75000000";
+		dac.attrs["oversampling_ratio"] = "1";
+		dac.attrs["dma_sync"] = "0";
+	}
+
+	Device& dio = addDevice("m2k-logic-analyzer", false);
+	for (unsigned int i = 0; i < DIO_CHANNELS; i++) {
+		Channel& chn = addChannel(dio, "voltage" + std::to_string(i),
+				false);
+		chn.attrs["direction"] = "in";
+		chn.attrs["raw"] = "0";
+		chn.attrs["outputmode"] = "push-pull";
+	}
+	dio.attrs["sampling_frequency"] = "100000000";
+
+	Device& rx = addDevice("m2k-logic-analyzer-rx", false);
+	Device& tx = addDevice("m2k-logic-analyzer-tx", true);
+	for (unsigned int i = 0; i < DIO_CHANNELS; i++) {
+		const std::string id = "voltage" + std::to_string(i);
+		const std::string format = "le:U1/16>>" + std::to_string(i);
+
+		Channel& in = addChannel(rx, id, false, 0, format);
+		in.attrs["trigger"] = "none";
+		if (i == 0) {
+			in.attrs["trigger_delay"] = "0";
+			in.attrs["trigger_logic_mode"] = "or";
+		}
+
+		addChannel(tx, id, true, 0, format);
+	}
+	rx.attrs["sampling_frequency"] = "100000000";
+	tx.attrs["sampling_frequency"] = "100000000";
+}
+
+SimM2k::~SimM2k()
+{
+}
+
+double SimM2k::clock()
+{
+	using namespace std::chrono;
+
+	return duration<double>(steady_clock::now().time_since_epoch())
+		.count();
+}
+
+double SimM2k::now() const
+{
+	return clock() - epoch;
+}
+
+SimM2k::Device& SimM2k::addDevice(const std::string& name, bool output)
+{
+	Device dev;
+
+	dev.id = "iio:device" + std::to_string(devices.size());
+	dev.name = name;
+	dev.output = output;
+	dev.open = false;
+	dev.cyclic = false;
+	dev.samples = 0;
+	dev.clock = 0.0;
+
+	devices.push_back(dev);
+	return devices.back();
+}
+
+SimM2k::Channel& SimM2k::addChannel(Device& dev, const std::string& id,
+		bool output, int index, const std::string& format)
+{
+	Channel chn;
+
+	chn.id = id;
+	chn.output = output;
+	chn.index = index;
+	chn.format = format;
+	chn.bytes = 2;
+
+	/* libiio numbers the scan elements first, by index */
+	auto it = dev.channels.end();
+	if (index >= 0) {
+		it = std::find_if(dev.channels.begin(), dev.channels.end(),
+			[=](const Channel& c) {
+				return c.index < 0 || c.index > index;
+			});
+	}
+
+	return *dev.channels.insert(it, chn);
+}
+
+SimM2k::Device *SimM2k::findDevice(const std::string& name)
+{
+	for (Device& dev : devices)
+		if (dev.id == name || dev.name == name)
+			return &dev;
+
+	return nullptr;
+}
+
+const SimM2k::Device *SimM2k::findDevice(const std::string& name) const
+{
+	return const_cast<SimM2k *>(this)->findDevice(name);
+}
+
+std::map<std::string, std::string> *SimM2k::findAttrs(Device& dev,
+		const std::string& chn, bool output, bool debug)
+{
+	if (debug)
+		return &dev.debug_attrs;
+	if (chn.empty())
+		return &dev.attrs;
+
+	for (Channel& c : dev.channels)
+		if (c.id == chn && c.output == output)
+			return &c.attrs;
+
+	return nullptr;
+}
+
+const std::map<std::string, std::string> *SimM2k::findAttrs(
+		const Device& dev, const std::string& chn, bool output,
+		bool debug) const
+{
+	return const_cast<SimM2k *>(this)->findAttrs(
+			const_cast<Device&>(dev), chn, output, debug);
+}
+
+std::string SimM2k::attr(const std::string& name, const std::string& chn,
+		bool output, const std::string& attr) const
+{
+	const Device *dev = findDevice(name);
+	if (!dev)
+		return "";
+
+	auto attrs = findAttrs(*dev, chn, output, false);
+	if (!attrs)
+		return "";
+
+	auto it = attrs->find(attr);
+	return it != attrs->end() ? it->second : "";
+}
+
+double SimM2k::number(const std::string& dev, const std::string& chn,
+		bool output, const std::string& attr) const
+{
+	return std::strtod(this->attr(dev, chn, output, attr).c_str(),
+			nullptr);
+}
+
+size_t SimM2k::sampleSize(const Device& dev)
+{
+	size_t size = 0;
+	int last = -1;
+
+	for (size_t i = 0; i < dev.channels.size(); i++) {
+		const Channel& chn = dev.channels[i];
+
+		if (i / 32 >= dev.mask.size() ||
+				!(dev.mask[i / 32] & (1u << (i % 32))))
+			continue;
+		if (chn.index < 0 || chn.index == last)
+			continue;
+
+		if (size % chn.bytes)
+			size += chn.bytes - size % chn.bytes;
+		size += chn.bytes;
+		last = chn.index;
+	}
+
+	return size;
+}
+
+double SimM2k::sampleRate(const Device& dev) const
+{
+	double rate = number(dev.name, "", false, "sampling_frequency");
+	double ratio = number(dev.name, "", false, "oversampling_ratio");
+
+	if (ratio > 0)
+		rate /= ratio;
+
+	return rate > 0 ? rate : 1.0;
+}
+
+std::string SimM2k::xml() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	std::string xml =
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<!DOCTYPE context ["
+		"<!ELEMENT context (device | context-attribute)*>"
+		"<!ELEMENT context-attribute EMPTY>"
+		"<!ELEMENT device (channel | attribute | debug-attribute | "
+		"buffer-attribute)*>"
+		"<!ELEMENT channel (scan-element?, attribute*)>"
+		"<!ELEMENT attribute EMPTY>"
+		"<!ELEMENT scan-element EMPTY>"
+		"<!ELEMENT debug-attribute EMPTY>"
+		"<!ELEMENT buffer-attribute EMPTY>"
+		"<!ATTLIST context name CDATA #REQUIRED "
+		"description CDATA #IMPLIED>"
+		"<!ATTLIST context-attribute name CDATA #REQUIRED "
+		"value CDATA #REQUIRED>"
+		"<!ATTLIST device id CDATA #REQUIRED name CDATA #IMPLIED>"
+		"<!ATTLIST channel id CDATA #REQUIRED "
+		"type (input|output) #REQUIRED name CDATA #IMPLIED>"
+		"<!ATTLIST scan-element index CDATA #REQUIRED "
+		"format CDATA #REQUIRED scale CDATA #IMPLIED>"
+		"<!ATTLIST attribute name CDATA #REQUIRED "
+		"filename CDATA #IMPLIED>"
+		"<!ATTLIST debug-attribute name CDATA #REQUIRED>"
+		"<!ATTLIST buffer-attribute name CDATA #REQUIRED>"
+		"]>"
+		"<context name=\"network\" "
+		"description=\"Simulated ADALM2000\" >";
+
+	for (const auto& attr : context_attrs)
+		xml += "<context-attribute name=\"" + escape(attr.first) +
+			"\" value=\"" + escape(attr.second) + "\" />";
+
+	for (const Device& dev : devices) {
+		xml += "<device id=\"" + dev.id + "\" name=\"" +
+			escape(dev.name) + "\" >";
+
+		for (const Channel& chn : dev.channels) {
+			xml += "<channel id=\"" + chn.id + "\" type=\"" +
+				(chn.output ? "output" : "input") + "\" >";
+			if (chn.index >= 0)
+				xml += "<scan-element index=\"" +
+					std::to_string(chn.index) +
+					"\" format=\"" + escape(chn.format) +
+					"\" />";
+			for (const auto& attr : chn.attrs)
+				xml += "<attribute name=\"" +
+					escape(attr.first) + "\" />";
+			xml += "</channel>";
+		}
+
+		for (const auto& attr : dev.attrs)
+			xml += "<attribute name=\"" + escape(attr.first) +
+				"\" />";
+		for (const auto& attr : dev.debug_attrs)
+			xml += "<debug-attribute name=\"" +
+				escape(attr.first) + "\" />";
+
+		xml += "</device>";
+	}
+
+	return xml + "</context>";
+}
+
+int SimM2k::attrs(const std::string& name, const std::string& chn,
+		bool output, bool debug, std::vector<std::string>& names) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	const Device *dev = findDevice(name);
+	if (!dev)
+		return -ENODEV;
+
+	auto attrs = findAttrs(*dev, chn, output, debug);
+	if (!attrs)
+		return -ENOENT;
+
+	names.clear();
+	for (const auto& attr : *attrs)
+		names.push_back(attr.first);
+
+	return 0;
+}
+
+int SimM2k::read(const std::string& name, const std::string& chn,
+		bool output, bool debug, const std::string& attr,
+		std::string& value) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	const Device *dev = findDevice(name);
+	if (!dev)
+		return -ENODEV;
+
+	auto attrs = findAttrs(*dev, chn, output, debug);
+	if (!attrs)
+		return -ENOENT;
+
+	auto it = attrs->find(attr);
+	if (it == attrs->end())
+		return -ENOENT;
+
+	value = measure(*dev, chn, output, attr, it->second);
+	return 0;
+}
+
+/* The attributes the hardware measures rather than stores */
+std::string SimM2k::measure(const Device& dev, const std::string& chn,
+		bool output, const std::string& attr,
+		const std::string& value) const
+{
+	if (dev.name == "ad9963" && attr == "raw") {
+		const bool pos = chn == "voltage2";
+
+		if (!pos && chn != "voltage1")
+			return value;
+
+		const std::string supply = pos ? "voltage0" : "voltage1";
+		double volts = 0.0;
+
+		if (number("ad5627", supply, true, "powerdown") == 0)
+			volts = number("ad5627", supply, true, "raw") * (pos ?
+				POS_SUPPLY_VOLTS_PER_LSB :
+				NEG_SUPPLY_VOLTS_PER_LSB);
+
+		return std::to_string(std::lround(volts * (pos ?
+				POS_READBACK_LSB_PER_VOLT :
+				NEG_READBACK_LSB_PER_VOLT)));
+	}
+
+	if (dev.name == "m2k-logic-analyzer" && attr == "raw" && !output &&
+			this->attr(dev.name, chn, false, "direction") != "out") {
+		const Device *rx = findDevice("m2k-logic-analyzer-rx");
+		const unsigned int bit = std::atoi(chn.c_str() + 7);
+
+		return (inputs(*rx).pins(now()) >> bit) & 1 ? "1" : "0";
+	}
+
+	return value;
+}
+
+int SimM2k::write(const std::string& name, const std::string& chn,
+		bool output, bool debug, const std::string& attr,
+		const std::string& value)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	Device *dev = findDevice(name);
+	if (!dev)
+		return -ENODEV;
+
+	auto attrs = findAttrs(*dev, chn, output, debug);
+	if (!attrs)
+		return -ENOENT;
+
+	auto it = attrs->find(attr);
+	if (it == attrs->end())
+		return -ENOENT;
+
+	std::string val = value.substr(0, value.find('\0'));
+	while (!val.empty() && (val.back() == '\n' || val.back() == ' '))
+		val.pop_back();
+
+	it->second = val;
+	return 0;
+}
+
+int SimM2k::open(const std::string& name, size_t samples,
+		const std::vector<uint32_t>& mask, bool cyclic)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	Device *dev = findDevice(name);
+	if (!dev)
+		return -ENODEV;
+	if (mask.size() != (dev->channels.size() + 31) / 32 || !samples)
+		return -EINVAL;
+
+	dev->mask = mask;
+	if (!sampleSize(*dev)) {
+		dev->mask.clear();
+		return -EINVAL;
+	}
+
+	dev->open = true;
+	dev->cyclic = cyclic;
+	dev->samples = samples;
+	dev->clock = std::max(dev->clock, now());
+
+	return 0;
+}
+
+int SimM2k::close(const std::string& name)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	Device *dev = findDevice(name);
+	if (!dev)
+		return -ENODEV;
+
+	dev->open = false;
+	if (dev->output)
+		dev->playback.reset();
+
+	return 0;
+}
+
+int SimM2k::mask(const std::string& name, std::vector<uint32_t>& mask) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	const Device *dev = findDevice(name);
+	if (!dev)
+		return -ENODEV;
+
+	mask = dev->mask;
+	return 0;
+}
+
+SimM2k::Inputs SimM2k::inputs(const Device& dev) const
+{
+	Inputs in;
+
+	in.digital = dev.name == "m2k-logic-analyzer-rx";
+	in.rate = sampleRate(dev);
+
+	for (unsigned int i = 0; !in.digital && i < 2 &&
+			i < dev.channels.size(); i++)
+		if (!dev.mask.empty() && (dev.mask[0] & (1u << i)))
+			in.chns.push_back(i);
+
+	in.loopback = loopback_en;
+	in.dacs[0] = findDevice("m2k-dac-a")->playback;
+	in.dacs[1] = findDevice("m2k-dac-b")->playback;
+
+	const std::string mode = attr("m2k-fabric", "", false,
+			"calibration_mode");
+	if (mode == "adc_gnd")
+		in.calibration = Inputs::CAL_ADC_GND;
+	else if (mode == "adc_ref1")
+		in.calibration = Inputs::CAL_ADC_REF1;
+	else if (mode == "dac")
+		in.calibration = Inputs::CAL_DAC;
+	else
+		in.calibration = Inputs::CAL_NONE;
+
+	const double rate = sampleRate(*findDevice("m2k-adc"));
+
+	for (unsigned int chn = 0; chn < 2; chn++) {
+		const std::string id = "voltage" + std::to_string(chn);
+		const std::string offset_id = "voltage" +
+			std::to_string(chn + 2);
+
+		in.signals[chn] = signals[chn];
+		in.gain[chn] = ADC_CODES_PER_VOLT;
+		if (in.calibration == Inputs::CAL_NONE)
+			in.gain[chn] *= (attr("m2k-fabric", id, false,
+					"gain") == "high" ? HIGH_GAIN :
+					LOW_GAIN) * filterGain(rate);
+		in.offset[chn] = (number("ad5625", offset_id, true, "raw") -
+				OFFSET_DAC_MID) * ADC_OFFSET_CODES_PER_LSB;
+		in.dac_offset[chn] = (number("ad5625", id, true, "raw") -
+				OFFSET_DAC_MID) * DAC_OFFSET_VOLTS_PER_LSB;
+	}
+
+	in.dio_out = in.dio_value = 0;
+	for (unsigned int i = 0; i < DIO_CHANNELS; i++) {
+		const std::string id = "voltage" + std::to_string(i);
+
+		if (attr("m2k-logic-analyzer", id, false, "direction") == "out")
+			in.dio_out |= 1 << i;
+		if (number("m2k-logic-analyzer", id, false, "raw") != 0)
+			in.dio_value |= 1 << i;
+	}
+
+	in.pattern = findDevice("m2k-logic-analyzer-tx")->playback;
+	in.baud = uart_baud;
+	in.text = uart_text;
+
+	in.rising = in.falling = in.any = in.low = in.high = 0;
+	in.all = false;
+	in.trigger_chn = 0;
+	in.level = 0.0;
+
+	if (in.digital) {
+		for (const Channel& chn : dev.channels) {
+			const std::string& cond = chn.attrs.at("trigger");
+			const uint16_t bit = 1 << std::atoi(chn.id.c_str() + 7);
+
+			if (cond == "edge-rising")
+				in.rising |= bit;
+			else if (cond == "edge-falling")
+				in.falling |= bit;
+			else if (cond == "edge-any")
+				in.any |= bit;
+			else if (cond == "level-low")
+				in.low |= bit;
+			else if (cond == "level-high")
+				in.high |= bit;
+		}
+
+		in.trigger = (in.rising | in.falling | in.any | in.low |
+				in.high) ? Inputs::DIGITAL :
+			Inputs::FREE_RUNNING;
+		in.delay = number(dev.name, "voltage0", false,
+				"trigger_delay");
+		in.all = attr(dev.name, "voltage0", false,
+				"trigger_logic_mode") == "and";
+	} else {
+		const std::string trig = "m2k-adc-trigger";
+		const std::string source = attr(trig, "trigger", false,
+				"logic_mode");
+
+		in.trigger_chn = !source.empty() && source[0] == 'b';
+
+		const std::string id = "voltage" +
+			std::to_string(in.trigger_chn);
+		const std::string mode = attr(trig, "voltage" +
+				std::to_string(in.trigger_chn + 4), false,
+				"mode");
+
+		if (mode == "always")
+			in.trigger = Inputs::FREE_RUNNING;
+		else if (mode.find("analog") != std::string::npos)
+			in.trigger = Inputs::ANALOG;
+		else
+			in.trigger = Inputs::NEVER;
+
+		in.condition = attr(trig, id, false, "trigger");
+		in.level = number(trig, id, false, "trigger_level");
+		in.delay = number(trig, "trigger", false, "delay");
+	}
+
+	return in;
+}
+
+ssize_t SimM2k::capture(const std::string& name, char *data, size_t bytes,
+		const Wait& wait)
+{
+	Inputs in;
+	size_t sample_size;
+	double start;
+
+	for (;;) {
+		double from;
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			const Device *dev = findDevice(name);
+			if (!dev)
+				return -ENODEV;
+			if (!dev->open || dev->output)
+				return -EBADF;
+
+			in = inputs(*dev);
+			sample_size = sampleSize(*dev);
+			from = realtime_en ? std::max(dev->clock, now()) :
+				dev->clock;
+		}
+
+		if (in.trigger == Inputs::FREE_RUNNING) {
+			start = from;
+			break;
+		}
+
+		/* The capture starts delay samples after the trigger */
+		double t;
+		if (in.trigger != Inputs::NEVER &&
+				in.findTrigger(from - in.delay / in.rate, t)) {
+			start = t + in.delay / in.rate;
+			break;
+		}
+
+		if (!wait(TRIGGER_POLL_S))
+			return -EPIPE;
+	}
+
+	const size_t samples = bytes / sample_size;
+	const double end = start + samples / in.rate;
+
+	in.fill(data, samples, start);
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		Device *dev = findDevice(name);
+		dev->clock = std::max(dev->clock, end);
+	}
+
+	if (realtime_en && end > now() && !wait(end - now()))
+		return -EPIPE;
+
+	return samples * sample_size;
+}
+
+/* The response of a first order low-pass to a periodic input, in steady
+ * state: a second pass starts from where the first one ended */
+static std::vector<float> lowpass(const std::vector<float>& in, double rate,
+		double cutoff)
+{
+	std::vector<float> out(in.size());
+	const double alpha = 1.0 - std::exp(-2 * M_PI * cutoff / rate);
+	double y = in.empty() ? 0.0 : in.back();
+
+	for (unsigned int pass = 0; pass < 2; pass++) {
+		for (size_t i = 0; i < in.size(); i++) {
+			y += alpha * (in[i] - y);
+			out[i] = y;
+		}
+	}
+
+	return out;
+}
+
+ssize_t SimM2k::push(const std::string& name, const char *data, size_t bytes)
+{
+	auto p = std::make_shared<Playback>();
+	bool dac;
+	size_t sample_size;
+	double cutoff;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		const Device *dev = findDevice(name);
+		if (!dev)
+			return -ENODEV;
+		if (!dev->open || !dev->output)
+			return -EBADF;
+
+		dac = dev->name != "m2k-logic-analyzer-tx";
+		sample_size = sampleSize(*dev);
+		p->rate = sampleRate(*dev);
+		p->mask = dev->mask.empty() ? 0 : dev->mask[0] & 0xffff;
+		cutoff = dev->name == "m2k-dac-b" && loopback_en ?
+			dut_cutoff : 0.0;
+	}
+
+	const size_t samples = bytes / sample_size;
+	const uint8_t *ptr = (const uint8_t *)data;
+
+	for (size_t i = 0; i < samples; i++, ptr += sample_size) {
+		const uint16_t raw = ptr[0] | (ptr[1] << 8);
+
+		if (dac)
+			p->volts.push_back(-((int16_t)raw / 16) *
+					DAC_VOLTS_PER_LSB);
+		else
+			p->pins.push_back(raw);
+	}
+
+	if (dac)
+		p->filtered = cutoff > 0 ? lowpass(p->volts, p->rate, cutoff) :
+			p->volts;
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	Device *dev = findDevice(name);
+	if (!dev->open)
+		return -EBADF;
+
+	p->start = now();
+	dev->playback = p;
+
+	return samples * sample_size;
+}
+
+SimM2k::Signal SimM2k::signal(unsigned int chn) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return signals[std::min(chn, 1u)];
+}
+
+void SimM2k::setSignal(unsigned int chn, const Signal& signal)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (chn < 2)
+		signals[chn] = signal;
+}
+
+bool SimM2k::loopback() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return loopback_en;
+}
+
+void SimM2k::setLoopback(bool en)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	loopback_en = en;
+}
+
+double SimM2k::dutCutoff() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return dut_cutoff;
+}
+
+void SimM2k::setDutCutoff(double hz)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (hz > 0)
+		dut_cutoff = hz;
+}
+
+bool SimM2k::realtime() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return realtime_en;
+}
+
+void SimM2k::setRealtime(bool en)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	realtime_en = en;
+}
+
+unsigned int SimM2k::uartBaudRate() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return uart_baud;
+}
+
+void SimM2k::setUartBaudRate(unsigned int baud)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	uart_baud = baud;
+}
+
+std::string SimM2k::uartText() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return uart_text;
+}
+
+void SimM2k::setUartText(const std::string& text)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	uart_text = text;
+}
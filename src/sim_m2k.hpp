@@ -0,0 +1,193 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef SIM_M2K_HPP
+#define SIM_M2K_HPP
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace adiscope {
+	/*
+	 * A model of the M2K as its IIO devices, for running the tools
+	 * without the hardware.
+	 *
+	 * The devices, channels and attributes are the ones the tools use,
+	 * and the attributes that the hardware measures or computes (the
+	 * supply readbacks, the DIO levels) are computed from the model.
+	 * The ADC sees either the configured waveforms, the DACs through a
+	 * loopback or one of the calibration paths, scaled the way the
+	 * front-end scales them, and the logic analyzer sees a UART and a
+	 * counter on the first pins, overridden by the DIO outputs and the
+	 * pattern generator. Both honour their hardware triggers.
+	 *
+	 * The sample clocks follow the wall clock when realtime is set,
+	 * otherwise captures follow each other without waiting, which makes
+	 * them as fast as the host can generate them.
+	 *
+	 * Every method is thread-safe and returns a negative errno code on
+	 * failure, like the drivers do.
+	 */
+	class SimM2k
+	{
+	public:
+		enum Waveform {
+			SINE,
+			SQUARE,
+			TRIANGLE,
+			SAWTOOTH,
+			DC,
+		};
+
+		struct Signal {
+			Waveform type;
+			double frequency;
+			double amplitude;	/* V, peak */
+			double offset;		/* V */
+			double noise;		/* V rms */
+		};
+
+		/* Waits for the given number of seconds; returns false when the
+		 * capture should be abandoned */
+		typedef std::function<bool (double)> Wait;
+
+		SimM2k();
+		~SimM2k();
+
+		/* The description of the context, as iiod reports it */
+		std::string xml() const;
+
+		/* Attributes of a device when chn is empty, of one of its
+		 * channels or debug attributes */
+		int attrs(const std::string& dev, const std::string& chn,
+				bool output, bool debug,
+				std::vector<std::string>& names) const;
+		int read(const std::string& dev, const std::string& chn,
+				bool output, bool debug, const std::string& attr,
+				std::string& value) const;
+		int write(const std::string& dev, const std::string& chn,
+				bool output, bool debug, const std::string& attr,
+				const std::string& value);
+
+		/* Buffers; the mask has one bit per channel, in the order of
+		 * the description, least significant word first */
+		int open(const std::string& dev, size_t samples,
+				const std::vector<uint32_t>& mask, bool cyclic);
+		int close(const std::string& dev);
+		int mask(const std::string& dev,
+				std::vector<uint32_t>& mask) const;
+
+		ssize_t capture(const std::string& dev, char *data,
+				size_t bytes, const Wait& wait);
+		ssize_t push(const std::string& dev, const char *data,
+				size_t bytes);
+
+		Signal signal(unsigned int chn) const;
+		void setSignal(unsigned int chn, const Signal& signal);
+
+		/* Feeds DAC A to channel 1 and DAC B to channel 2, through a
+		 * first order low-pass as the device under test */
+		bool loopback() const;
+		void setLoopback(bool en);
+		double dutCutoff() const;
+		void setDutCutoff(double hz);
+
+		bool realtime() const;
+		void setRealtime(bool en);
+
+		unsigned int uartBaudRate() const;
+		void setUartBaudRate(unsigned int baud);
+		std::string uartText() const;
+		void setUartText(const std::string& text);
+
+	private:
+		struct Channel {
+			std::string id;
+			bool output;
+			int index;	/* -1 unless it is a scan element */
+			std::string format;
+			unsigned int bytes;
+			std::map<std::string, std::string> attrs;
+		};
+
+		struct Playback;
+		struct Inputs;
+
+		struct Device {
+			std::string id, name;
+			bool output;
+			std::vector<Channel> channels;
+			std::map<std::string, std::string> attrs, debug_attrs;
+
+			bool open, cyclic;
+			size_t samples;
+			std::vector<uint32_t> mask;
+			double clock;	/* s, where the next capture starts */
+			std::shared_ptr<const Playback> playback;
+		};
+
+		mutable std::mutex lock;
+		std::vector<Device> devices;
+		std::map<std::string, std::string> context_attrs;
+		double epoch;
+
+		Signal signals[2];
+		bool loopback_en, realtime_en;
+		double dut_cutoff;
+		unsigned int uart_baud;
+		std::string uart_text;
+
+		static double clock();
+		double now() const;
+
+		Device& addDevice(const std::string& name, bool output);
+		Channel& addChannel(Device& dev, const std::string& id,
+				bool output, int index = -1,
+				const std::string& format = "");
+
+		Device *findDevice(const std::string& dev);
+		const Device *findDevice(const std::string& dev) const;
+		const std::map<std::string, std::string> *findAttrs(
+				const Device& dev, const std::string& chn,
+				bool output, bool debug) const;
+		std::map<std::string, std::string> *findAttrs(
+				Device& dev, const std::string& chn,
+				bool output, bool debug);
+		std::string attr(const std::string& dev,
+				const std::string& chn, bool output,
+				const std::string& attr) const;
+		double number(const std::string& dev, const std::string& chn,
+				bool output, const std::string& attr) const;
+
+		static size_t sampleSize(const Device& dev);
+		double sampleRate(const Device& dev) const;
+		std::string measure(const Device& dev, const std::string& chn,
+				bool output, const std::string& attr,
+				const std::string& value) const;
+		Inputs inputs(const Device& dev) const;
+	};
+}
+
+#endif /* SIM_M2K_HPP */
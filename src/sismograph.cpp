@@ -18,14 +18,17 @@
  */
 
 #include "sismograph.hpp"
+#include "render_scheduler.hpp"
 
 #include <qwt_plot_layout.h>
 #include <qwt_scale_engine.h>
 
+#include <algorithm>
+
 using namespace adiscope;
 
 Sismograph::Sismograph(QWidget *parent) : QwtPlot(parent),
-	curve("data"), sampleRate(10.0)
+	curve("data"), sampleRate(10.0), next(0), shown(0)
 {
 	enableAxis(QwtPlot::xBottom, false);
 	enableAxis(QwtPlot::xTop, true);
@@ -65,15 +68,32 @@ Sismograph::~Sismograph()
 
 void Sismograph::plot(double sample)
 {
-	if (xdata.size() == numSamples + 1)
-		xdata.pop();
+	append(&sample, 1);
+}
 
-	xdata.push(sample);
-	scaler->setValue(sample);
+void Sismograph::append(const double *samples, int count)
+{
+	const int capacity = numSamples + 1;
 
-	curve.setRawSamples(xdata.data(), ydata.data() + (ydata.size() -
-				xdata.size()), xdata.size());
-	replot();
+	/* Older samples would scroll out right away */
+	if (count > capacity) {
+		samples += count - capacity;
+		count = capacity;
+	}
+
+	for (int i = 0; i < count; i++) {
+		xdata[next] = xdata[next + capacity] = samples[i];
+		next = (next + 1) % capacity;
+
+		scaler->setValue(samples[i]);
+	}
+
+	shown = std::min(shown + count, capacity);
+
+	const int first = (next - shown + capacity) % capacity;
+	curve.setRawSamples(xdata.data() + first,
+			ydata.data() + (capacity - shown), shown);
+	RenderScheduler::instance()->schedule(this);
 }
 
 int Sismograph::getNumSamples() const
@@ -87,7 +107,7 @@ void Sismograph::setNumSamples(int num)
 
 	reset();
 	ydata.resize(numSamples + 1);
-	xdata.reserve(numSamples + 1);
+	xdata.resize(2 * (numSamples + 1));
 
 	setAxisScale(QwtPlot::yLeft, (double) numSamples / sampleRate, 0.0);
 
@@ -112,7 +132,11 @@ void Sismograph::setSampleRate(double rate)
 
 void Sismograph::reset()
 {
-	xdata.clear();
+	/* A scheduled replot must not read the freed samples */
+	curve.setRawSamples(nullptr, nullptr, 0);
+
+	next = 0;
+	shown = 0;
 	scaler->startTimer();
 }
 
@@ -27,9 +27,13 @@
 #include <qwt_plot_curve.h>
 
 #include "autoScaler.hpp"
-#include "customFifo.hpp"
 
 namespace adiscope {
+	/*
+	 * A strip chart of the last numSamples + 1 samples, the newest
+	 * one at the top. As every sample moves the whole trace, a block
+	 * of samples is appended at once and replotted on the next frame.
+	 */
 	class Sismograph : public QwtPlot
 	{
 		Q_OBJECT
@@ -54,6 +58,8 @@ namespace adiscope {
 		double getSampleRate() const;
 		void setSampleRate(double rate);
 
+		void append(const double *samples, int count);
+
 	public Q_SLOTS:
 		void plot(double sample);
 		void reset();
@@ -67,7 +73,11 @@ namespace adiscope {
 		AutoScaler *scaler;
 
 		QVector<double> ydata;
-		CustomFifo<double> xdata;
+
+		/* A ring of the samples, written twice so that the shown
+		 * ones are always contiguous */
+		QVector<double> xdata;
+		int next, shown;
 	};
 }
 
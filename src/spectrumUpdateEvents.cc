@@ -24,6 +24,9 @@
 #define SPECTRUM_UPDATE_EVENTS_C
 
 #include "spectrumUpdateEvents.h"
+#include "trace.hpp"
+
+#include <algorithm>
 
 SpectrumUpdateEvent::SpectrumUpdateEvent(const float* fftPoints,
 					 const uint64_t numFFTDataPoints,
@@ -260,7 +263,8 @@ IdentifiableTimeUpdateEvent::IdentifiableTimeUpdateEvent(const std::vector<doubl
 				 const std::vector< std::vector<gr::tag_t> > tags,
 				 const std::string senderName)
   : TimeUpdateEvent(timeDomainPoints, numTimeDomainDataPoints, tags),
-    _senderName(senderName)
+    _senderName(senderName),
+    _postTime(adiscope::Tracer::enabled() ? adiscope::Tracer::now() : 0)
 {
 }
 
@@ -273,6 +277,62 @@ IdentifiableTimeUpdateEvent::IdentifiableTimeUpdateEvent(const std::vector<doubl
 	 return _senderName;
  }
 
+ uint64_t IdentifiableTimeUpdateEvent::postTime() const
+ {
+	 return _postTime;
+ }
+
+
+/***************************************************************************/
+
+
+RollUpdateEvent::RollUpdateEvent(const std::vector<double*> dataPoints,
+				 const uint64_t numDataPoints,
+				 const uint64_t windowSize,
+				 const std::string senderName)
+  : QEvent(QEvent::Type(RollUpdateEventType)),
+    _numDataPoints(numDataPoints),
+    _windowSize(windowSize),
+    _senderName(senderName)
+{
+  _nplots = dataPoints.size();
+  for(size_t i = 0; i < _nplots; i++) {
+    _dataPoints.push_back(new double[std::max<uint64_t>(_numDataPoints, 1)]);
+    memcpy(_dataPoints[i], dataPoints[i], _numDataPoints*sizeof(double));
+  }
+}
+
+RollUpdateEvent::~RollUpdateEvent()
+{
+  for(size_t i = 0; i < _nplots; i++) {
+    delete[] _dataPoints[i];
+  }
+}
+
+const std::vector<double*>
+RollUpdateEvent::getDataPoints() const
+{
+  return _dataPoints;
+}
+
+uint64_t
+RollUpdateEvent::getNumDataPoints() const
+{
+  return _numDataPoints;
+}
+
+uint64_t
+RollUpdateEvent::getWindowSize() const
+{
+  return _windowSize;
+}
+
+std::string
+RollUpdateEvent::senderName() const
+{
+  return _senderName;
+}
+
 
 /***************************************************************************/
 
@@ -498,22 +558,28 @@ TimeRasterUpdateEvent::getNumDataPoints() const
 /***************************************************************************/
 
 
-HistogramUpdateEvent::HistogramUpdateEvent(const std::vector<double*> points,
-                                           const uint64_t npoints)
-  : QEvent(QEvent::Type(SpectrumUpdateEventType))
+HistogramUpdateEvent::HistogramUpdateEvent(const std::vector<double*> bins,
+                                           const uint64_t nbins,
+                                           const double binLeft,
+                                           const double binWidth,
+                                           const double dataMin,
+                                           const double dataMax)
+  : QEvent(QEvent::Type(SpectrumUpdateEventType)),
+    _binLeft(binLeft), _binWidth(binWidth),
+    _dataMin(dataMin), _dataMax(dataMax)
 {
-  if(npoints < 1) {
-    _npoints = 1;
+  if(nbins < 1) {
+    _nbins = 1;
   }
   else {
-    _npoints = npoints;
+    _nbins = nbins;
   }
 
-  _nplots = points.size();
+  _nplots = bins.size();
   for(size_t i = 0; i < _nplots; i++) {
-    _points.push_back(new double[_npoints]);
-    if(npoints > 0) {
-      memcpy(_points[i], points[i], _npoints*sizeof(double));
+    _bins.push_back(new double[_nbins]);
+    if(nbins > 0) {
+      memcpy(_bins[i], bins[i], _nbins*sizeof(double));
     }
   }
 }
@@ -521,20 +587,44 @@ HistogramUpdateEvent::HistogramUpdateEvent(const std::vector<double*> points,
 HistogramUpdateEvent::~HistogramUpdateEvent()
 {
   for(size_t i = 0; i < _nplots; i++) {
-    delete[] _points[i];
+    delete[] _bins[i];
   }
 }
 
 const std::vector<double*>
-HistogramUpdateEvent::getDataPoints() const
+HistogramUpdateEvent::getBins() const
 {
-  return _points;
+  return _bins;
 }
 
 uint64_t
-HistogramUpdateEvent::getNumDataPoints() const
+HistogramUpdateEvent::getNumBins() const
+{
+  return _nbins;
+}
+
+double
+HistogramUpdateEvent::getBinLeft() const
+{
+  return _binLeft;
+}
+
+double
+HistogramUpdateEvent::getBinWidth() const
+{
+  return _binWidth;
+}
+
+double
+HistogramUpdateEvent::getDataMin() const
+{
+  return _dataMin;
+}
+
+double
+HistogramUpdateEvent::getDataMax() const
 {
-  return _npoints;
+  return _dataMax;
 }
 
 
@@ -35,6 +35,7 @@ static const int SpectrumUpdateEventType = 10005;
 static const int SpectrumWindowCaptionEventType = 10008;
 static const int SpectrumWindowResetEventType = 10009;
 static const int SpectrumFrequencyRangeEventType = 10010;
+static const int RollUpdateEventType = 10011;
 
 class SpectrumUpdateEvent:public QEvent{
 
@@ -162,10 +163,46 @@ public:
 
   std::string senderName();
 
+  // When the event was posted, in Tracer time, or 0 if not tracing
+  uint64_t postTime() const;
+
 protected:
 
 private:
   std::string _senderName;
+  uint64_t _postTime;
+};
+
+
+/********************************************************************/
+
+
+/* New samples streamed by a scope sink in roll mode. The plot appends
+ * them to the window of windowSize samples it is currently showing. */
+class RollUpdateEvent: public QEvent
+{
+public:
+  RollUpdateEvent(const std::vector<double*> dataPoints,
+		  const uint64_t numDataPoints,
+		  const uint64_t windowSize,
+		  const std::string senderName);
+
+  ~RollUpdateEvent();
+
+  const std::vector<double*> getDataPoints() const;
+  uint64_t getNumDataPoints() const;
+  uint64_t getWindowSize() const;
+  std::string senderName() const;
+
+  static QEvent::Type Type()
+      { return QEvent::Type(RollUpdateEventType); }
+
+private:
+  size_t _nplots;
+  std::vector<double*> _dataPoints;
+  uint64_t _numDataPoints;
+  uint64_t _windowSize;
+  std::string _senderName;
 };
 
 
@@ -305,18 +342,25 @@ private:
 /********************************************************************/
 
 
+/* Bin counts computed by the histogram sink. Bin i of every channel is
+ * centered on binLeft + i * binWidth. */
 class HistogramUpdateEvent: public QEvent
 {
 public:
-  HistogramUpdateEvent(const std::vector<double*> points,
-                       const uint64_t npoints);
+  HistogramUpdateEvent(const std::vector<double*> bins,
+                       const uint64_t nbins,
+                       const double binLeft, const double binWidth,
+                       const double dataMin, const double dataMax);
 
   ~HistogramUpdateEvent();
 
   int which() const;
-  const std::vector<double*> getDataPoints() const;
-  uint64_t getNumDataPoints() const;
-  bool getRepeatDataFlag() const;
+  const std::vector<double*> getBins() const;
+  uint64_t getNumBins() const;
+  double getBinLeft() const;
+  double getBinWidth() const;
+  double getDataMin() const;
+  double getDataMax() const;
 
   static QEvent::Type Type()
   { return QEvent::Type(SpectrumUpdateEventType); }
@@ -325,8 +369,10 @@ protected:
 
 private:
   size_t _nplots;
-  std::vector<double*> _points;
-  uint64_t _npoints;
+  std::vector<double*> _bins;
+  uint64_t _nbins;
+  double _binLeft, _binWidth;
+  double _dataMin, _dataMax;
 };
 
 
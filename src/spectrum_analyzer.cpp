@@ -40,6 +40,7 @@
 #include "dynamicWidget.hpp"
 #include "spinbox_a.hpp"
 #include "hardware_trigger.hpp"
+#include "trace_overlay.hpp"
 
 /* Generated UI */
 #include "ui_spectrum_analyzer.h"
@@ -81,7 +82,7 @@ SpectrumAnalyzer::win_types = {
 
 SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 	std::shared_ptr<GenericAdc> adc, QPushButton *runButton,
-	ToolLauncher *parent):
+	QJSEngine *engine, ToolLauncher *parent):
 	Tool(ctx, runButton, new SpectrumAnalyzer_API(this), parent),
 	ui(new Ui::SpectrumAnalyzer),
 	fft_plot(nullptr),
@@ -212,6 +213,14 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 	else
 		build_gnuradio_block_chain_no_ctx();
 
+	auto overlay = new TraceOverlay(fft_plot);
+	overlay->setFrames(fft_sink->name());
+	overlay->setRefills(adc_name);
+	overlay->addStage("Conversion", "gr", "adc_sample_conv");
+	overlay->addStage("Sink", fft_sink->name(), "scope_sink");
+	overlay->addStage("Delivery", fft_sink->name(), "event_delivery");
+	overlay->addStage("Plot", fft_sink->name(), "plot");
+
 	connect(ui->run_button, SIGNAL(toggled(bool)), this,
 		SLOT(runStopToggled(bool)));
 	connect(ui->run_button, SIGNAL(toggled(bool)), runButton,
@@ -233,6 +242,10 @@ SpectrumAnalyzer::SpectrumAnalyzer(struct iio_context *ctx, Filter *filt,
 	ui->stackedWidget->setVisible(false);
 	ui->start_freq->setValue(0);
 	ui->stop_freq->setValue(50e6);
+
+	api->setObjectName(QString::fromStdString(Filter::tool_name(
+			TOOL_SPECTRUM_ANALYZER)));
+	api->js_register(engine);
 }
 
 SpectrumAnalyzer::~SpectrumAnalyzer()
@@ -485,7 +498,7 @@ void SpectrumAnalyzer::onChannelSelected(bool en)
 	fft_plot->setPeakVisible(crt_channel_id, crt_peak, true);
 
 	if (!ui->run_button->isChecked()) {
-			fft_plot->replot();
+			fft_plot->scheduleReplot();
 	}
 }
 
@@ -534,7 +547,7 @@ void SpectrumAnalyzer::onStartStopChanged()
 
 	// Configure plot
 	fft_plot->setAxisScale(QwtPlot::xBottom, start, stop);
-	fft_plot->replot();
+	fft_plot->scheduleReplot();
 }
 
 void SpectrumAnalyzer::onCenterSpanChanged()
@@ -579,7 +592,7 @@ void SpectrumAnalyzer::onCenterSpanChanged()
 
 	// Configure plot
 	fft_plot->setAxisScale(QwtPlot::xBottom, start, stop);
-	fft_plot->replot();
+	fft_plot->scheduleReplot();
 }
 
 void SpectrumAnalyzer::writeAllSettingsToHardware()
@@ -621,7 +634,7 @@ void SpectrumAnalyzer::on_btnLeftPeak_clicked()
 		fft_plot->setPeakVisible(crt_channel_id, --crt_peak, true);
 
 		if (!ui->run_button->isChecked()) {
-			fft_plot->replot();
+			fft_plot->scheduleReplot();
 		}
 	}
 }
@@ -633,7 +646,7 @@ void SpectrumAnalyzer::on_btnRightPeak_clicked()
 		fft_plot->setPeakVisible(crt_channel_id, ++crt_peak, true);
 
 		if (!ui->run_button->isChecked()) {
-			fft_plot->replot();
+			fft_plot->scheduleReplot();
 		}
 	}
 }
@@ -646,7 +659,7 @@ void SpectrumAnalyzer::on_btnMaxPeak_clicked()
 		fft_plot->setPeakVisible(crt_channel_id, crt_peak, true);
 
 		if (!ui->run_button->isChecked()) {
-			fft_plot->replot();
+			fft_plot->scheduleReplot();
 		}
 	}
 }
@@ -758,7 +771,7 @@ void SpectrumChannel::onEnableBoxToggled(bool en)
 	} else {
 		m_plot->DetachCurve(m_id);
 	}
-	m_plot->replot();
+	m_plot->scheduleReplot();
 
 	Q_EMIT enabled(en);
 }
@@ -798,3 +811,13 @@ std::vector<float> SpectrumChannel::build_win(SpectrumAnalyzer::FftWinType type,
 			return v;
 	}
 }
+
+bool SpectrumAnalyzer_API::running() const
+{
+	return sp->ui->run_button->isChecked();
+}
+
+void SpectrumAnalyzer_API::run(bool en)
+{
+	sp->ui->run_button->setChecked(en);
+}
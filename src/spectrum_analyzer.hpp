@@ -54,6 +54,7 @@ namespace adiscope {
 
 class QPushButton;
 class QButtonGroup;
+class QJSEngine;
 
 namespace adiscope {
 class SpectrumAnalyzer_API;
@@ -81,7 +82,7 @@ public:
 
 	explicit SpectrumAnalyzer(struct iio_context *iio, Filter *filt,
 		std::shared_ptr<GenericAdc> adc, QPushButton *runButton,
-		ToolLauncher *parent);
+		QJSEngine *engine, ToolLauncher *parent);
 	~SpectrumAnalyzer();
 
 private Q_SLOTS:
@@ -201,11 +202,16 @@ class SpectrumAnalyzer_API : public ApiObject
 {
 	Q_OBJECT
 
+	Q_PROPERTY(bool running READ running WRITE run STORED false);
+
 public:
 	explicit SpectrumAnalyzer_API(SpectrumAnalyzer *sp) :
 		ApiObject(), sp(sp) {}
 	~SpectrumAnalyzer_API() {}
 
+	bool running() const;
+	void run(bool en);
+
 private:
 	SpectrumAnalyzer *sp;
 };
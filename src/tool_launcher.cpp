@@ -24,7 +24,13 @@
 #include "oscilloscope.hpp"
 #include "spectrum_analyzer.hpp"
 #include "tool_launcher.hpp"
+#include "iio_attr_cache.hpp"
 #include "qtjs.hpp"
+#include "trace_api.hpp"
+
+#ifdef ENABLE_SIMULATOR
+#include "sim_iiod.hpp"
+#endif
 
 #include "ui_device.h"
 #include "ui_tool_launcher.h"
@@ -33,6 +39,7 @@
 #include <QtConcurrentRun>
 #include <QSignalTransition>
 #include <QMessageBox>
+#include <QSet>
 #include <QTimer>
 #include <QSettings>
 
@@ -40,6 +47,7 @@
 
 #define TIMER_TIMEOUT_MS 5000
 #define ALIVE_TIMER_TIMEOUT_MS 5000
+#define HOTPLUG_SETTLE_MS 500
 
 using namespace adiscope;
 
@@ -51,7 +59,8 @@ ToolLauncher::ToolLauncher(QWidget *parent) :
 	logic_analyzer(nullptr), pattern_generator(nullptr), dio(nullptr),
 	network_analyzer(nullptr), spectrum_analyzer(nullptr),
 	tl_api(new ToolLauncher_API(this)),
-	notifier(STDIN_FILENO, QSocketNotifier::Read)
+	notifier(STDIN_FILENO, QSocketNotifier::Read),
+	calibrationCache(true)
 {
 	if (!isatty(STDIN_FILENO))
 		notifier.setEnabled(false);
@@ -105,6 +114,22 @@ ToolLauncher::ToolLauncher(QWidget *parent) :
 		SLOT(setButtonBackground(bool)));
 	ui->btnHome->toggle();
 
+	/* Tools that are created on first use come to life when their run
+	 * button is pressed, before it toggles, so they still see it */
+	connect(ui->stopDIO, &QPushButton::pressed,
+		[=]() { getTool(TOOL_DIGITALIO); });
+	connect(ui->stopPowerControl, &QPushButton::pressed,
+		[=]() { getTool(TOOL_POWER_CONTROLLER); });
+	connect(ui->stopLogicAnalyzer, &QPushButton::pressed,
+		[=]() { getTool(TOOL_LOGIC_ANALYZER); });
+	connect(ui->stopPatternGenerator, &QPushButton::pressed,
+		[=]() { getTool(TOOL_PATTERN_GENERATOR); });
+	connect(ui->stopNetworkAnalyzer, &QPushButton::pressed,
+		[=]() { getTool(TOOL_NETWORK_ANALYZER); });
+
+	connect(&decoders_watcher, SIGNAL(finished()),
+		this, SLOT(decodersLoaded()));
+
 
 
 	loadToolTips(false);
@@ -115,12 +140,22 @@ ToolLauncher::ToolLauncher(QWidget *parent) :
 	QtJs *js_object = new QtJs(&js_engine);
 	tl_api->js_register(&js_engine);
 
+	Tracer_API *trace_api = new Tracer_API(&js_engine);
+	trace_api->js_register(&js_engine);
+
+#ifdef ENABLE_SIMULATOR
+	if (SimIiod::instance())
+		SimIiod::instance()->js_register(&js_engine);
+#endif
+
 	connect(&notifier, SIGNAL(activated(int)), this, SLOT(hasText()));
 
 	search_timer = new QTimer();
+	search_timer->setSingleShot(true);
 	connect(search_timer, SIGNAL(timeout()), this, SLOT(search()));
 	connect(&watcher, SIGNAL(finished()), this, SLOT(update()));
-	search_timer->start(TIMER_TIMEOUT_MS);
+	connect(&hotplug_monitor, SIGNAL(changed()), this, SLOT(hotplug()));
+	scheduleSearch();
 
 	alive_timer = new QTimer();
 	connect(alive_timer, SIGNAL(timeout()), this, SLOT(ping()));
@@ -172,6 +207,22 @@ void ToolLauncher::search()
 	watcher.setFuture(future);
 }
 
+void ToolLauncher::scheduleSearch()
+{
+	/* Without hotplug events the USB bus has to be polled */
+	if (!hotplug_monitor.isActive())
+		search_timer->start(TIMER_TIMEOUT_MS);
+}
+
+void ToolLauncher::hotplug()
+{
+	/* Devices are not searched for while connected, as with polling.
+	 * A burst of events results in a single scan, once the device
+	 * had some time to come up. */
+	if (!ctx)
+		search_timer->start(HOTPLUG_SETTLE_MS);
+}
+
 QVector<QString> ToolLauncher::searchDevices()
 {
 	struct iio_context_info **info;
@@ -205,12 +256,15 @@ out_destroy_context:
 
 void ToolLauncher::updateListOfDevices(const QVector<QString>& uris)
 {
+	const QSet<QString> found = QSet<QString>::fromList(uris.toList());
+	QSet<QString> known;
+
 	//Delete devices that are in the devices list but not found anymore when scanning
 
 	for (auto it = devices.begin(); it != devices.end();) {
 		QString uri = (*it)->second.btn->property("uri").toString();
 
-		if (uri.startsWith("usb:") && !uris.contains(uri)) {
+		if (uri.startsWith("usb:") && !found.contains(uri)) {
 			if ((*it)->second.btn->isChecked()){
 				(*it)->second.btn->click();
 				return;
@@ -218,31 +272,21 @@ void ToolLauncher::updateListOfDevices(const QVector<QString>& uris)
 			delete *it;
 			it = devices.erase(it);
 		} else {
+			known.insert(uri);
 			++it;
 		}
 	}
 
-	for (const QString& uri : uris) {
-		if (!uri.startsWith("usb:"))
-			continue;
-
-		bool found = false;
-
-		for (const auto each : devices) {
-			QString str = each->second.btn->property("uri")
-				.toString();
+	//Only add the devices that are new, the others keep their widgets
 
-			if (str == uri) {
-				found = true;
-				break;
-			}
-		}
-
-		if (!found)
+	for (const QString& uri : uris) {
+		if (uri.startsWith("usb:") && !known.contains(uri)) {
 			addContext(uri);
+			known.insert(uri);
+		}
 	}
 
-	search_timer->start(TIMER_TIMEOUT_MS);
+	scheduleSearch();
 }
 
 void ToolLauncher::loadToolTips(bool connected){
@@ -380,22 +424,22 @@ void ToolLauncher::on_btnDMM_clicked()
 
 void ToolLauncher::on_btnPowerControl_clicked()
 {
-	swapMenu(static_cast<QWidget *>(power_control));
+	swapMenu(getTool(TOOL_POWER_CONTROLLER));
 }
 
 void ToolLauncher::on_btnLogicAnalyzer_clicked()
 {
-	swapMenu(static_cast<QWidget *>(logic_analyzer));
+	swapMenu(getTool(TOOL_LOGIC_ANALYZER));
 }
 
 void adiscope::ToolLauncher::on_btnPatternGenerator_clicked()
 {
-	swapMenu(static_cast<QWidget *>(pattern_generator));
+	swapMenu(getTool(TOOL_PATTERN_GENERATOR));
 }
 
 void adiscope::ToolLauncher::on_btnNetworkAnalyzer_clicked()
 {
-	swapMenu(static_cast<QWidget *>(network_analyzer));
+	swapMenu(getTool(TOOL_NETWORK_ANALYZER));
 }
 
 void adiscope::ToolLauncher::on_btnSpectrumAnalyzer_clicked()
@@ -405,7 +449,7 @@ void adiscope::ToolLauncher::on_btnSpectrumAnalyzer_clicked()
 
 void adiscope::ToolLauncher::on_btnDigitalIO_clicked()
 {
-	swapMenu(static_cast<QWidget *>(dio));
+	swapMenu(getTool(TOOL_DIGITALIO));
 }
 
 void adiscope::ToolLauncher::on_btnHome_clicked()
@@ -469,7 +513,7 @@ void adiscope::ToolLauncher::disconnect()
 		destroyContext();
 		loadToolTips(false);
 		resetStylesheets();
-		search_timer->start(TIMER_TIMEOUT_MS);
+		scheduleSearch();
 	}
 
 	/* Update the list of devices now */
@@ -527,6 +571,17 @@ void adiscope::ToolLauncher::on_btnConnect_clicked(bool pressed)
 
 void adiscope::ToolLauncher::destroyContext()
 {
+	/* The decoders may still be loading for the previous device */
+	decoders.waitForFinished();
+
+	/* Disable the tools that were never opened, the others do it
+	 * themselves when they are destroyed */
+	ui->stopDIO->parentWidget()->setDisabled(true);
+	ui->stopPowerControl->parentWidget()->setDisabled(true);
+	ui->stopLogicAnalyzer->parentWidget()->setDisabled(true);
+	ui->stopPatternGenerator->parentWidget()->setDisabled(true);
+	ui->stopNetworkAnalyzer->parentWidget()->setDisabled(true);
+
 	if (dio) {
 		delete dio;
 		dio = nullptr;
@@ -622,10 +677,19 @@ void adiscope::ToolLauncher::calibrate()
 
 	Calibration calib(ctx);
 
+	/* The settings object of the GUI thread can't be shared, open the
+	 * same file again */
+	QSettings cache(settings->fileName(), QSettings::IniFormat);
+
 	calib.initialize();
-	calib.calibrateAll();
+	if (!(calibrationCache && calib.loadFromCache(cache)) &&
+			calib.calibrateAll())
+		calib.storeInCache(cache);
 	calib.restoreTriggerSetup();
 
+	/* Calibration talks to the hardware directly */
+	IioAttrCache::get_instance(ctx)->invalidate();
+
 	auto m2k_adc = std::dynamic_pointer_cast<M2kAdc>(adc);
 	if (m2k_adc) {
 		m2k_adc->setChnCorrectionOffset(0, calib.adcOffsetChannel0());
@@ -659,7 +723,7 @@ void adiscope::ToolLauncher::enableAdcBasedTools()
 
 	if (filter->compatible(TOOL_SPECTRUM_ANALYZER)) {
 		spectrum_analyzer = new SpectrumAnalyzer(ctx, filter, adc,
-			ui->stopSpectrumAnalyzer, this);
+			ui->stopSpectrumAnalyzer, &js_engine, this);
 		adc_users_group.addButton(ui->stopSpectrumAnalyzer);
 	}
 
@@ -733,51 +797,157 @@ bool adiscope::ToolLauncher::switchContext(const QString& uri)
 
 	}
 
+	/* Loading the decoders starts Python, which takes a while, so it
+	 * is done in the background while the user picks a tool */
 	if (filter->compatible(TOOL_LOGIC_ANALYZER)
 	    || filter->compatible(TOOL_PATTERN_GENERATOR)) {
-		bool success = loadDecoders(QCoreApplication::applicationDirPath() +
-					"/decoders");
+		decoders = QtConcurrent::run(this, &ToolLauncher::loadDecoders,
+				QCoreApplication::applicationDirPath() +
+				"/decoders");
+		decoders_watcher.setFuture(decoders);
+	}
 
-		if (!success) {
-			search_timer->stop();
+	/* The digital tools and the power supply are only created when
+	 * they are first opened, enable their menu entries meanwhile */
+	if (filter->compatible(TOOL_DIGITALIO))
+		ui->stopDIO->parentWidget()->setDisabled(false);
 
-			QMessageBox error(this);
-			error.setText("There was a problem initializing libsigrokdecode. Some features may be missing");
-			error.exec();
-		}
-	}
+	if (filter->compatible(TOOL_POWER_CONTROLLER))
+		ui->stopPowerControl->parentWidget()->setDisabled(false);
 
-	if (filter->compatible(TOOL_DIGITALIO)) {
-		dio = new DigitalIO(ctx, filter, ui->stopDIO, dioManager, &js_engine, this);
-	}
+	if (filter->compatible(TOOL_LOGIC_ANALYZER))
+		ui->stopLogicAnalyzer->parentWidget()->setDisabled(false);
 
+	if (filter->compatible(TOOL_PATTERN_GENERATOR))
+		ui->stopPatternGenerator->parentWidget()->setDisabled(false);
 
-	if (filter->compatible(TOOL_POWER_CONTROLLER)) {
-		power_control = new PowerController(ctx,
-		                                    ui->stopPowerControl, &js_engine, this);
-	}
+	if (filter->compatible(TOOL_NETWORK_ANALYZER))
+		ui->stopNetworkAnalyzer->parentWidget()->setDisabled(false);
 
-	if (filter->compatible(TOOL_LOGIC_ANALYZER)) {
-		logic_analyzer = new LogicAnalyzer(ctx, filter,
-		                                   ui->stopLogicAnalyzer, &js_engine, this);
-	}
+	registerPendingTools();
 
+	loadToolTips(true);
+	QtConcurrent::run(std::bind(&ToolLauncher::calibrate, this));
 
-	if (filter->compatible((TOOL_PATTERN_GENERATOR))) {
-		pattern_generator = new PatternGenerator(ctx, filter,
-		                ui->stopPatternGenerator, &js_engine,dioManager, this);
+	return true;
+}
+
+QWidget *adiscope::ToolLauncher::getTool(enum tool tool)
+{
+	if (!ctx || !filter->compatible(tool))
+		return nullptr;
+
+	switch (tool) {
+	case TOOL_DIGITALIO:
+		if (!dio)
+			dio = new DigitalIO(ctx, filter, ui->stopDIO,
+					dioManager, &js_engine, this);
+		return dio;
+
+	case TOOL_POWER_CONTROLLER:
+		if (!power_control)
+			power_control = new PowerController(ctx,
+					ui->stopPowerControl, &js_engine, this);
+		return power_control;
+
+	case TOOL_LOGIC_ANALYZER:
+		if (!logic_analyzer) {
+			decoders.waitForFinished();
+			logic_analyzer = new LogicAnalyzer(ctx, filter,
+					ui->stopLogicAnalyzer, &js_engine, this);
+
+			/* The DIO streams through the logic analyzer */
+			if (dioManager)
+				connect(ui->stopLogicAnalyzer,
+						SIGNAL(toggled(bool)),
+						dioManager, SLOT(setBusy(bool)));
+		}
+		return logic_analyzer;
+
+	case TOOL_PATTERN_GENERATOR:
+		if (!pattern_generator) {
+			decoders.waitForFinished();
+			pattern_generator = new PatternGenerator(ctx, filter,
+					ui->stopPatternGenerator, &js_engine,
+					dioManager, this);
+		}
+		return pattern_generator;
+
+	case TOOL_NETWORK_ANALYZER:
+		if (!network_analyzer)
+			network_analyzer = new NetworkAnalyzer(ctx, filter,
+					ui->stopNetworkAnalyzer, &js_engine, this);
+		return network_analyzer;
+
+	default:
+		return nullptr;
 	}
+}
 
+void adiscope::ToolLauncher::createPendingTools()
+{
+	getTool(TOOL_DIGITALIO);
+	getTool(TOOL_POWER_CONTROLLER);
+	getTool(TOOL_LOGIC_ANALYZER);
+	getTool(TOOL_PATTERN_GENERATOR);
+	getTool(TOOL_NETWORK_ANALYZER);
+}
 
-	if (filter->compatible((TOOL_NETWORK_ANALYZER))) {
-		network_analyzer = new NetworkAnalyzer(ctx, filter,
-		                                       ui->stopNetworkAnalyzer, &js_engine, this);
+/*
+ * Scripts see the tools created on first use as soon as the device is
+ * connected: each of them is stood in for by a global accessor that
+ * creates the tool when it is first read. The tool then registers its
+ * own API object in place of the accessor.
+ */
+void adiscope::ToolLauncher::registerPendingTools()
+{
+	static const enum tool pending[] = {
+		TOOL_DIGITALIO,
+		TOOL_POWER_CONTROLLER,
+		TOOL_LOGIC_ANALYZER,
+		TOOL_PATTERN_GENERATOR,
+		TOOL_NETWORK_ANALYZER,
+	};
+
+	QJSValue global = js_engine.globalObject();
+	QJSValue launcher = global.property(tl_api->objectName());
+	QJSValue define = js_engine.evaluate(
+		"(function(global, launcher, name) {"
+		"	Object.defineProperty(global, name, {"
+		"		configurable: true,"
+		"		get: function() {"
+		"			delete global[name];"
+		"			launcher.createTool(name);"
+		"			return global[name];"
+		"		}"
+		"	});"
+		"})");
+
+	for (unsigned int i = 0; i < sizeof(pending) / sizeof(pending[0]); i++) {
+		if (!filter->compatible(pending[i]))
+			continue;
+
+		QString name = QString::fromStdString(
+				Filter::tool_name(pending[i]));
+		QJSValue val = define.call(QJSValueList() << global
+				<< launcher << name);
+
+		if (val.isError())
+			qDebug() << "Unable to register" << name
+				<< val.toString();
 	}
+}
 
-	loadToolTips(true);
-	QtConcurrent::run(std::bind(&ToolLauncher::calibrate, this));
+void adiscope::ToolLauncher::decodersLoaded()
+{
+	if (!ctx || decoders.result())
+		return;
 
-	return true;
+	search_timer->stop();
+
+	QMessageBox error(this);
+	error.setText("There was a problem initializing libsigrokdecode. Some features may be missing");
+	error.exec();
 }
 
 void ToolLauncher::hasText()
@@ -901,6 +1071,11 @@ bool ToolLauncher_API::connect(const QString& uri)
 		QCoreApplication::processEvents();
 		QThread::msleep(10);
 	} while (!done);
+
+	/* Scripts expect every tool to be reachable once connected */
+	if (did_connect)
+		tl->createPendingTools();
+
 	return did_connect;
 }
 
@@ -909,6 +1084,11 @@ void ToolLauncher_API::disconnect()
 	tl->disconnect();
 }
 
+void ToolLauncher_API::clearCalibrationCache()
+{
+	Calibration::clearCache(*tl->settings);
+}
+
 void ToolLauncher_API::addIp(const QString& ip)
 {
 	if (!ip.isEmpty()) {
@@ -916,10 +1096,24 @@ void ToolLauncher_API::addIp(const QString& ip)
 	}
 }
 
+bool ToolLauncher_API::createTool(const QString& name)
+{
+	for (int i = 0; i < TOOL_LAUNCHER; i++) {
+		enum tool tool = static_cast<enum tool>(i);
+
+		if (name.toStdString() == Filter::tool_name(tool))
+			return tl->getTool(tool) != nullptr;
+	}
+
+	return false;
+}
+
 void ToolLauncher_API::load(const QString& file)
 {
 	QSettings settings(file, QSettings::IniFormat);
 
+	tl->createPendingTools();
+
 	this->ApiObject::load(settings);
 
 	if (tl->oscilloscope)
@@ -946,6 +1140,8 @@ void ToolLauncher_API::save(const QString& file)
 {
 	QSettings settings(file, QSettings::IniFormat);
 
+	tl->createPendingTools();
+
 	this->ApiObject::save(settings);
 
 	if (tl->oscilloscope)
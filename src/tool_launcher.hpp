@@ -41,6 +41,7 @@
 #include "pattern_generator.hpp"
 #include "network_analyzer.hpp"
 #include "digitalio.hpp"
+#include "hotplug_monitor.hpp"
 
 extern "C" {
 	struct iio_context;
@@ -79,6 +80,7 @@ Q_SIGNALS:
 private Q_SLOTS:
 	void search();
 	void update();
+	void hotplug();
 	void ping();
 
 	void on_btnOscilloscope_clicked();
@@ -107,6 +109,8 @@ private Q_SLOTS:
 
 	void toolDetached(bool detached);
 
+	void decodersLoaded();
+
 private:
 	Ui::ToolLauncher *ui;
 	struct iio_context *ctx;
@@ -114,8 +118,11 @@ private:
 	QVector<QPair<QWidget, Ui::Device> *> devices;
 
 	QTimer *search_timer, *alive_timer;
+	HotplugMonitor hotplug_monitor;
 	QFutureWatcher<QVector<QString>> watcher;
 	QFuture<QVector<QString>> future;
+	QFuture<bool> decoders;
+	QFutureWatcher<bool> decoders_watcher;
 
 	DMM *dmm;
 	PowerController *power_control;
@@ -141,13 +148,18 @@ private:
 	QString js_cmd;
 	QSocketNotifier notifier;
 	QString previousIp;
+	bool calibrationCache;
 
 	void loadToolTips(bool connected);
 	QVector<QString> searchDevices();
+	void scheduleSearch();
 	void swapMenu(QWidget *menu);
 	void destroyContext();
 	bool loadDecoders(QString path);
 	bool switchContext(const QString& uri);
+	QWidget *getTool(enum tool tool);
+	void createPendingTools();
+	void registerPendingTools();
 	void resetStylesheets();
 	void calibrate();
 	void checkIp(const QString& ip);
@@ -172,6 +184,11 @@ class ToolLauncher_API: public ApiObject
 
 	Q_PROPERTY(bool maximized READ maximized WRITE setMaximized);
 
+	/* When false, the device is calibrated again on every connect
+	 * instead of using the cached results */
+	Q_PROPERTY(bool calibration_cache READ calibrationCache
+	           WRITE setCalibrationCache);
+
 public:
 	explicit ToolLauncher_API(ToolLauncher *tl) : ApiObject(), tl(tl) {}
 	~ToolLauncher_API() {}
@@ -201,12 +218,27 @@ public:
 		}
 	}
 
+	bool calibrationCache() const
+	{
+		return tl->calibrationCache;
+	}
+	void setCalibrationCache(bool en)
+	{
+		tl->calibrationCache = en;
+	}
+
 	Q_INVOKABLE bool connect(const QString& uri);
 	Q_INVOKABLE void disconnect();
 
+	/* Forgets the cached calibration results of all the devices */
+	Q_INVOKABLE void clearCalibrationCache();
+
 	Q_INVOKABLE void load(const QString& file);
 	Q_INVOKABLE void save(const QString& file);
 
+	/* Creates a tool that is only created on first use, by name */
+	Q_INVOKABLE bool createTool(const QString& name);
+
 private:
 	ToolLauncher *tl;
 };
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trace.hpp"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <set>
+
+/* Events kept per thread, a power of two */
+#define TRACE_RING_SIZE 0x4000
+
+using namespace adiscope;
+
+std::atomic<bool> Tracer::m_enabled(false);
+
+namespace {
+	struct Ring {
+		std::atomic<uint64_t> head;
+		Tracer::Event events[TRACE_RING_SIZE];
+
+		Ring() : head(0) {}
+	};
+
+	/* Rings are never freed: a thread that exits hands its ring over
+	 * to the next thread, as GNU Radio starts new ones every time a
+	 * flowgraph starts */
+	std::mutex rings_mutex;
+	std::vector<Ring *> rings, free_rings;
+	uint32_t next_tid = 1;
+
+	std::mutex interned_mutex;
+	std::set<std::string> interned;
+
+	const std::chrono::steady_clock::time_point epoch =
+		std::chrono::steady_clock::now();
+
+	struct ThreadRing {
+		Ring *ring;
+		uint32_t tid;
+
+		ThreadRing()
+		{
+			std::lock_guard<std::mutex> lock(rings_mutex);
+
+			if (free_rings.empty()) {
+				ring = new Ring;
+				rings.push_back(ring);
+			} else {
+				ring = free_rings.back();
+				free_rings.pop_back();
+			}
+
+			tid = next_tid++;
+		}
+
+		~ThreadRing()
+		{
+			std::lock_guard<std::mutex> lock(rings_mutex);
+			free_rings.push_back(ring);
+		}
+	};
+
+	thread_local ThreadRing thread_ring;
+
+	/* Copies the events of a ring that were not overwritten */
+	void copyRing(const Ring *ring, uint64_t since,
+			std::vector<Tracer::Event> &out)
+	{
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+		uint64_t first = head > TRACE_RING_SIZE ?
+			head - TRACE_RING_SIZE : 0;
+		size_t start = out.size();
+
+		for (uint64_t i = first; i < head; i++)
+			out.push_back(ring->events[i % TRACE_RING_SIZE]);
+
+		/* The writer may have lapped the oldest events meanwhile,
+		 * plus the slot it was writing */
+		uint64_t now = ring->head.load(std::memory_order_acquire);
+		uint64_t lost = now - head + 1;
+		if (first + TRACE_RING_SIZE < head + lost) {
+			uint64_t drop = std::min<uint64_t>(head - first,
+					head + lost - first - TRACE_RING_SIZE);
+			out.erase(out.begin() + start,
+					out.begin() + start + drop);
+		}
+
+		out.erase(std::remove_if(out.begin() + start, out.end(),
+				[since](const Tracer::Event &e) {
+					return e.ts + e.dur < since;
+				}), out.end());
+	}
+
+	void writeString(QTextStream &stream, const char *str)
+	{
+		stream << '"';
+		for (; *str; str++) {
+			if (*str == '"' || *str == '\\')
+				stream << '\\';
+			stream << *str;
+		}
+		stream << '"';
+	}
+}
+
+void Tracer::setEnabled(bool enable)
+{
+	m_enabled.store(enable, std::memory_order_relaxed);
+}
+
+uint64_t Tracer::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - epoch).count();
+}
+
+const char *Tracer::intern(const std::string &str)
+{
+	std::lock_guard<std::mutex> lock(interned_mutex);
+
+	return interned.insert(str).first->c_str();
+}
+
+void Tracer::record(const Event &event)
+{
+	Ring *ring = thread_ring.ring;
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+
+	ring->events[head % TRACE_RING_SIZE] = event;
+	ring->events[head % TRACE_RING_SIZE].tid = thread_ring.tid;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::complete(const char *cat, const char *name,
+		uint64_t start, uint64_t end)
+{
+	if (!enabled())
+		return;
+
+	record({ cat, name, start, end - start, 0.0, 0, 'X' });
+}
+
+void Tracer::instant(const char *cat, const char *name)
+{
+	if (!enabled())
+		return;
+
+	record({ cat, name, now(), 0, 0.0, 0, 'i' });
+}
+
+void Tracer::counter(const char *cat, const char *name, double value)
+{
+	if (!enabled())
+		return;
+
+	record({ cat, name, now(), 0, value, 0, 'C' });
+}
+
+std::vector<Tracer::Event> Tracer::snapshot(double window_s)
+{
+	std::vector<Event> events;
+	uint64_t window = window_s * 1e9;
+	uint64_t t = now();
+	uint64_t since = t > window ? t - window : 0;
+
+	{
+		std::lock_guard<std::mutex> lock(rings_mutex);
+
+		for (const Ring *ring : rings)
+			copyRing(ring, since, events);
+	}
+
+	std::stable_sort(events.begin(), events.end(),
+			[](const Event &a, const Event &b) {
+				return a.ts < b.ts;
+			});
+	return events;
+}
+
+Tracer::Stats Tracer::stats(const std::vector<Event> &events,
+		const char *cat, const char *name)
+{
+	Stats stats = { 0, 0.0, 0.0, 0.0 };
+
+	for (const Event &e : events) {
+		if (strcmp(e.name, name) || (cat && strcmp(e.cat, cat)))
+			continue;
+
+		double ms = e.dur / 1e6;
+
+		stats.count++;
+		stats.total_ms += ms;
+		stats.max_ms = std::max(stats.max_ms, ms);
+		stats.last_value = e.value;
+	}
+
+	return stats;
+}
+
+bool Tracer::exportChrome(const QString &path)
+{
+	QFile file(path);
+
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+		return false;
+
+	std::vector<Event> events = snapshot(now() / 1e9 + 1.0);
+	QTextStream stream(&file);
+
+	stream.setRealNumberNotation(QTextStream::FixedNotation);
+	stream.setRealNumberPrecision(3);
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	for (size_t i = 0; i < events.size(); i++) {
+		const Event &e = events[i];
+
+		stream << (i ? ",\n" : "\n") << "{\"name\":";
+		writeString(stream, e.name);
+		stream << ",\"cat\":";
+		writeString(stream, e.cat);
+		stream << ",\"ph\":\"" << e.phase << "\",\"pid\":1,\"tid\":"
+			<< e.tid << ",\"ts\":" << e.ts / 1e3;
+
+		if (e.phase == 'X')
+			stream << ",\"dur\":" << e.dur / 1e3;
+		else if (e.phase == 'i')
+			stream << ",\"s\":\"t\"";
+		else
+			stream << ",\"args\":{\"value\":" << e.value << "}";
+
+		stream << "}";
+	}
+
+	stream << "\n]}\n";
+	stream.flush();
+	return file.error() == QFile::NoError;
+}
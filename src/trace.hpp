@@ -0,0 +1,130 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace adiscope {
+	/*
+	 * Timing of the acquisition and display pipeline.
+	 *
+	 * Every thread records its events into a ring buffer of its own, so
+	 * recording takes no lock and only ever touches memory of the
+	 * calling thread; readers copy the rings and drop what was
+	 * overwritten while they copied. When tracing is disabled,
+	 * recording costs a relaxed atomic load, so the trace points stay
+	 * compiled in.
+	 *
+	 * Names and categories are not copied: they have to be string
+	 * literals or come from intern().
+	 */
+	class Tracer
+	{
+	public:
+		struct Event {
+			const char *cat;
+			const char *name;
+			uint64_t ts;	/* ns since the tracer started */
+			uint64_t dur;	/* ns, for complete events */
+			double value;	/* for counters */
+			uint32_t tid;
+			char phase;	/* 'X' complete, 'i' instant, 'C' counter */
+		};
+
+		struct Stats {
+			unsigned int count;
+			double total_ms;
+			double max_ms;
+			double last_value;
+		};
+
+		static bool enabled()
+		{
+			return m_enabled.load(std::memory_order_relaxed);
+		}
+
+		static void setEnabled(bool enable);
+
+		static uint64_t now();
+
+		static const char *intern(const std::string &str);
+
+		static void complete(const char *cat, const char *name,
+				uint64_t start, uint64_t end);
+		static void instant(const char *cat, const char *name);
+		static void counter(const char *cat, const char *name,
+				double value);
+
+		/* The events of all the threads from the last window_s
+		 * seconds, oldest first */
+		static std::vector<Event> snapshot(double window_s);
+
+		/* Summarizes the events matching the name, and the category
+		 * unless cat is null */
+		static Stats stats(const std::vector<Event> &events,
+				const char *cat, const char *name);
+
+		/* Writes everything still in the rings in the Chrome
+		 * trace event format, for chrome://tracing or Perfetto */
+		static bool exportChrome(const QString &path);
+
+	private:
+		static std::atomic<bool> m_enabled;
+
+		static void record(const Event &event);
+	};
+
+	/* Records the lifetime of the object as a complete event */
+	class TraceScope
+	{
+	public:
+		TraceScope(const char *cat, const char *name) :
+			cat(cat), name(name),
+			start(Tracer::enabled() ? Tracer::now() : 0)
+		{
+		}
+
+		~TraceScope()
+		{
+			if (start)
+				Tracer::complete(cat, name, start,
+						Tracer::now());
+		}
+
+	private:
+		const char *cat, *name;
+		uint64_t start;
+	};
+}
+
+#define TRACE_CONCAT_(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/* Times the rest of the enclosing block */
+#define TRACE_SCOPE(cat, name) \
+	adiscope::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(cat, name)
+
+#endif /* TRACE_HPP */
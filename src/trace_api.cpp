@@ -0,0 +1,89 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trace_api.hpp"
+#include "trace.hpp"
+#include "render_scheduler.hpp"
+
+#include <ctime>
+
+using namespace adiscope;
+
+Tracer_API::Tracer_API(QObject *parent) : ApiObject()
+{
+	setObjectName("trace");
+	setParent(parent);
+}
+
+bool Tracer_API::enabled() const
+{
+	return Tracer::enabled();
+}
+
+void Tracer_API::setEnabled(bool en)
+{
+	Tracer::setEnabled(en);
+}
+
+QVariantMap Tracer_API::stats(const QString& cat, const QString& name,
+		double window_s)
+{
+	const std::string cat_str = cat.toStdString();
+	const std::string name_str = name.toStdString();
+	const Tracer::Stats stats = Tracer::stats(Tracer::snapshot(window_s),
+			cat.isEmpty() ? nullptr : cat_str.c_str(),
+			name_str.c_str());
+	QVariantMap map;
+
+	map["count"] = stats.count;
+	map["total_ms"] = stats.total_ms;
+	map["max_ms"] = stats.max_ms;
+
+	return map;
+}
+
+double Tracer_API::cpuTime() const
+{
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+	struct timespec ts;
+
+	if (!clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts))
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+	return (double)std::clock() / CLOCKS_PER_SEC;
+}
+
+bool Tracer_API::exportChrome(const QString& path)
+{
+	return Tracer::exportChrome(path);
+}
+
+QVariantMap Tracer_API::renderStats() const
+{
+	const RenderScheduler::Stats stats =
+		RenderScheduler::instance()->stats();
+	QVariantMap map;
+
+	map["rendered"] = stats.rendered;
+	map["appended"] = stats.appended;
+	map["coalesced"] = stats.coalesced;
+	map["hidden"] = stats.hidden;
+
+	return map;
+}
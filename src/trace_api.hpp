@@ -0,0 +1,62 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef TRACE_API_HPP
+#define TRACE_API_HPP
+
+#include "apiObject.hpp"
+
+#include <QString>
+#include <QVariantMap>
+
+namespace adiscope {
+	/* The tracer, for scripts that measure the tools */
+	class Tracer_API : public ApiObject
+	{
+		Q_OBJECT
+
+		Q_PROPERTY(bool enabled READ enabled WRITE setEnabled
+				STORED false);
+
+	public:
+		explicit Tracer_API(QObject *parent = nullptr);
+		~Tracer_API() {}
+
+		bool enabled() const;
+		void setEnabled(bool en);
+
+		/* Count, total_ms and max_ms of the events named name over
+		 * the last window_s seconds, of any category if cat is
+		 * empty */
+		Q_INVOKABLE QVariantMap stats(const QString& cat,
+				const QString& name, double window_s);
+
+		/* CPU time used by the process so far, in seconds */
+		Q_INVOKABLE double cpuTime() const;
+
+		Q_INVOKABLE bool exportChrome(const QString& path);
+
+		/* Replots rendered, incremental draws, and replots
+		 * coalesced and skipped while hidden since the start,
+		 * counted even when tracing is off */
+		Q_INVOKABLE QVariantMap renderStats() const;
+	};
+}
+
+#endif /* TRACE_API_HPP */
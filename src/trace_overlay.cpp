@@ -0,0 +1,125 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trace_overlay.hpp"
+#include "trace.hpp"
+
+/* The statistics cover this much time, in seconds */
+#define TRACE_OVERLAY_WINDOW 1.0
+
+#define TRACE_OVERLAY_REFRESH_MS 500
+
+using namespace adiscope;
+
+TraceOverlay::TraceOverlay(QWidget *parent) :
+	QLabel(parent),
+	frames_cat(nullptr),
+	refills_cat(nullptr)
+{
+	setAttribute(Qt::WA_TransparentForMouseEvents);
+	setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 160);"
+			"color: white; font-family: monospace;"
+			"padding: 4px; }");
+	hide();
+
+	connect(&timer, SIGNAL(timeout()), this, SLOT(refresh()));
+	timer.start(TRACE_OVERLAY_REFRESH_MS);
+}
+
+TraceOverlay::~TraceOverlay()
+{
+}
+
+void TraceOverlay::setFrames(const std::string &sink)
+{
+	frames_cat = Tracer::intern(sink);
+}
+
+void TraceOverlay::setRefills(const std::string &device)
+{
+	refills_cat = Tracer::intern(device);
+}
+
+void TraceOverlay::addStage(const QString &label, const std::string &cat,
+		const char *name)
+{
+	stages.push_back({ label, cat.empty() ? nullptr :
+			Tracer::intern(cat), name });
+}
+
+void TraceOverlay::refresh()
+{
+	if (!Tracer::enabled() || !parentWidget()->isVisible()) {
+		hide();
+		return;
+	}
+
+	auto events = Tracer::snapshot(TRACE_OVERLAY_WINDOW);
+	QStringList lines;
+
+	if (frames_cat) {
+		auto frames = Tracer::stats(events, frames_cat, "plot");
+		auto dropped = Tracer::stats(events, frames_cat,
+				"dropped_frame");
+
+		lines << QString("%1 frames/s, %2 dropped/s")
+			.arg(frames.count / TRACE_OVERLAY_WINDOW, 0, 'f', 1)
+			.arg(dropped.count / TRACE_OVERLAY_WINDOW, 0, 'f', 1);
+	}
+
+	auto rendered = Tracer::stats(events, "render", "rendered");
+	auto appended = Tracer::stats(events, "render", "appended");
+	auto coalesced = Tracer::stats(events, "render", "coalesced");
+	auto hidden = Tracer::stats(events, "render", "hidden");
+
+	lines << QString("%1 replots/s, %2 appends/s, %3 skipped/s")
+		.arg(rendered.count / TRACE_OVERLAY_WINDOW, 0, 'f', 1)
+		.arg(appended.count / TRACE_OVERLAY_WINDOW, 0, 'f', 1)
+		.arg((coalesced.count + hidden.count) / TRACE_OVERLAY_WINDOW,
+				0, 'f', 1);
+
+	if (refills_cat) {
+		auto refills = Tracer::stats(events, refills_cat, "refill");
+		auto dead = Tracer::stats(events, refills_cat,
+				"refill_dead_time");
+
+		lines << QString("%1 refills/s, dead %2 ms/s")
+			.arg(refills.count / TRACE_OVERLAY_WINDOW, 0, 'f', 1)
+			.arg(dead.total_ms / TRACE_OVERLAY_WINDOW, 0, 'f', 1);
+	}
+
+	for (const stage &s : stages) {
+		auto stats = Tracer::stats(events, s.cat, s.name);
+
+		if (!stats.count) {
+			lines << QString("%1: -").arg(s.label);
+			continue;
+		}
+
+		lines << QString("%1: %2 ms avg, %3 ms max").arg(s.label)
+			.arg(stats.total_ms / stats.count, 0, 'f', 3)
+			.arg(stats.max_ms, 0, 'f', 3);
+	}
+
+	setText(lines.join("\n"));
+	adjustSize();
+	move(parentWidget()->width() - width() - 8, 8);
+	raise();
+	show();
+}
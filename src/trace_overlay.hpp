@@ -0,0 +1,75 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef TRACE_OVERLAY_HPP
+#define TRACE_OVERLAY_HPP
+
+#include <QLabel>
+#include <QTimer>
+#include <QVector>
+
+#include <string>
+
+namespace adiscope {
+	/*
+	 * Shows the pipeline timing of a tool over its plot while tracing
+	 * is enabled: the plotted and dropped frames per second, the time
+	 * per second the device was not streaming between refills, the
+	 * replots and incremental draws per second of all the plots and
+	 * the replots the RenderScheduler skipped, and the latency of each
+	 * stage over the last second.
+	 */
+	class TraceOverlay : public QLabel
+	{
+		Q_OBJECT
+
+	public:
+		explicit TraceOverlay(QWidget *parent);
+		~TraceOverlay();
+
+		/* The frames are the "plot" and "dropped_frame" events of
+		 * the sink with this name */
+		void setFrames(const std::string &sink);
+
+		/* The refills are those of the iio_manager of this device */
+		void setRefills(const std::string &device);
+
+		/* Shows the latency of the events with this name, and this
+		 * category unless it is empty */
+		void addStage(const QString &label, const std::string &cat,
+				const char *name);
+
+	private Q_SLOTS:
+		void refresh();
+
+	private:
+		struct stage {
+			QString label;
+			const char *cat;
+			const char *name;
+		};
+
+		QTimer timer;
+		const char *frames_cat;
+		const char *refills_cat;
+		QVector<stage> stages;
+	};
+}
+
+#endif /* TRACE_OVERLAY_HPP */
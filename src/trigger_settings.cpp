@@ -48,7 +48,8 @@ TriggerSettings::TriggerSettings(std::shared_ptr<GenericAdc> adc,
 	trigger(adc->getTrigger()),
 	current_channel(0),
 	temporarily_disabled(false),
-	adc_running(false)
+	adc_running(false),
+	streaming_mode(false)
 {
 	ui->setupUi(this);
 
@@ -386,6 +387,22 @@ void TriggerSettings::setAdcRunningState(bool on)
 	}
 }
 
+/*
+ * While streaming (roll mode) the hardware must capture continuously, so the
+ * trigger is kept in ALWAYS mode with no delay. The UI settings are left
+ * untouched and written back when streaming stops.
+ */
+void TriggerSettings::setStreamingMode(bool en)
+{
+	if (streaming_mode == en)
+		return;
+
+	streaming_mode = en;
+
+	if (adc_running)
+		write_ui_settings_to_hawrdware();
+}
+
 void TriggerSettings::write_ui_settings_to_hawrdware()
 {
 	source_hw_write(ui->cmb_source->currentIndex());
@@ -400,6 +417,9 @@ void TriggerSettings::write_ui_settings_to_hawrdware()
 
 void TriggerSettings:: delay_hw_write(long long raw_delay)
 {
+	if (streaming_mode)
+		raw_delay = 0;
+
 	if (adc_running) {
 		try {
 			trigger->setDelay(raw_delay);
@@ -472,6 +492,9 @@ void TriggerSettings:: digital_cond_hw_write(int cond)
 
 void TriggerSettings:: mode_hw_write(int mode)
 {
+	if (streaming_mode)
+		mode = HardwareTrigger::ALWAYS;
+
 	if (adc_running) {
 		try {
 			trigger->setTriggerMode(current_channel,
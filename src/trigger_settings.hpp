@@ -89,6 +89,7 @@ namespace adiscope {
 		void autoTriggerEnable();
 		void updateHwVoltLevels(int chnIdx);
 		void setAdcRunningState(bool on);
+		void setStreamingMode(bool en);
 
 	private Q_SLOTS:
 		void on_cmb_source_currentIndexChanged(int);
@@ -129,6 +130,7 @@ namespace adiscope {
 		bool trigger_auto_mode;
 		long long trigger_raw_delay;
 		bool adc_running;
+		bool streaming_mode;
 	};
 
 }
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "waveform_history.hpp"
+
+#include <string.h>
+#include <volk/volk.h>
+
+using namespace adiscope;
+
+WaveformHistory::WaveformHistory(unsigned int nb_channels) :
+	nb_channels(nb_channels),
+	segment_count(0),
+	segment_size(0),
+	overwrite_en(true),
+	arena(nullptr),
+	first(0), used(0)
+{
+}
+
+WaveformHistory::~WaveformHistory()
+{
+	if (arena)
+		volk_free(arena);
+}
+
+void WaveformHistory::setSegmentCount(unsigned int count)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (count == segment_count)
+		return;
+
+	segment_count = count;
+	reallocate();
+}
+
+void WaveformHistory::setSegmentSize(unsigned int size)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (size == segment_size)
+		return;
+
+	segment_size = size;
+	reallocate();
+}
+
+void WaveformHistory::setOverwrite(bool en)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	overwrite_en = en;
+}
+
+unsigned int WaveformHistory::segmentCount() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return segment_count;
+}
+
+unsigned int WaveformHistory::segmentSize() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return segment_size;
+}
+
+unsigned int WaveformHistory::count() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return used;
+}
+
+bool WaveformHistory::full() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return segment_count && used == segment_count;
+}
+
+bool WaveformHistory::overwrite() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return overwrite_en;
+}
+
+void WaveformHistory::clear()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	for (auto it = info.begin(); it != info.end(); ++it)
+		it->tags.clear();
+	first = 0;
+	used = 0;
+}
+
+void WaveformHistory::reallocate()
+{
+	if (arena) {
+		volk_free(arena);
+		arena = nullptr;
+	}
+
+	size_t total = (size_t)segment_count * nb_channels * segment_size;
+	if (total)
+		arena = (float *)volk_malloc(total * sizeof(float),
+				volk_get_alignment());
+
+	info = std::vector<segment_info>(segment_count);
+	first = 0;
+	used = 0;
+}
+
+unsigned int WaveformHistory::slot(unsigned int index) const
+{
+	return (first + index) % segment_count;
+}
+
+float * WaveformHistory::channelData(unsigned int slot, unsigned int chn) const
+{
+	return arena + ((size_t)slot * nb_channels + chn) * segment_size;
+}
+
+bool WaveformHistory::store(const std::vector<float *>& buffers, int offset,
+		const std::vector< std::vector<gr::tag_t> >& tags,
+		gr::high_res_timer_type timestamp)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (!arena || buffers.size() < nb_channels)
+		return false;
+
+	unsigned int dst;
+
+	if (used < segment_count) {
+		dst = slot(used);
+		used++;
+	} else if (overwrite_en) {
+		dst = first;
+		first = (first + 1) % segment_count;
+	} else {
+		return false;
+	}
+
+	for (unsigned int i = 0; i < nb_channels; i++)
+		memcpy(channelData(dst, i), &buffers[i][offset],
+				segment_size * sizeof(float));
+
+	info[dst].timestamp = timestamp;
+	info[dst].tags = tags;
+
+	return true;
+}
+
+bool WaveformHistory::read(unsigned int index,
+		const std::vector<double *>& buffers,
+		std::vector< std::vector<gr::tag_t> > *tags,
+		gr::high_res_timer_type *timestamp) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (index >= used || buffers.size() < nb_channels)
+		return false;
+
+	unsigned int src = slot(index);
+
+	for (unsigned int i = 0; i < nb_channels; i++)
+		volk_32f_convert_64f(buffers[i], channelData(src, i),
+				segment_size);
+
+	if (tags)
+		*tags = info[src].tags;
+	if (timestamp)
+		*timestamp = info[src].timestamp;
+
+	return true;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2016 Analog Devices, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file LICENSE.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef WAVEFORM_HISTORY_HPP
+#define WAVEFORM_HISTORY_HPP
+
+#include <mutex>
+#include <vector>
+
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/tags.h>
+
+namespace adiscope {
+
+	/*
+	 * Segmented memory for triggered captures.
+	 *
+	 * All segments live back to back in a single arena that is allocated
+	 * when the segment size or count changes (from the GUI thread), so
+	 * storing a frame from a GNU Radio work() call is just a copy.
+	 * Segments are addressed by age: 0 is the oldest stored frame and
+	 * count() - 1 the most recent one.
+	 */
+	class WaveformHistory
+	{
+	public:
+		explicit WaveformHistory(unsigned int nb_channels);
+		~WaveformHistory();
+
+		void setSegmentCount(unsigned int count);
+		void setSegmentSize(unsigned int size);
+
+		/* When disabled, the history stops accepting frames once
+		 * every segment is used (segmented acquisition). Otherwise
+		 * the oldest frame is overwritten. */
+		void setOverwrite(bool en);
+
+		unsigned int segmentCount() const;
+		unsigned int segmentSize() const;
+		unsigned int count() const;
+		bool full() const;
+		bool overwrite() const;
+
+		void clear();
+
+		bool store(const std::vector<float *>& buffers, int offset,
+			const std::vector< std::vector<gr::tag_t> >& tags,
+			gr::high_res_timer_type timestamp);
+
+		/* Converts the channels of a stored frame into the given
+		 * buffers, each one able to hold segmentSize() doubles. */
+		bool read(unsigned int index,
+			const std::vector<double *>& buffers,
+			std::vector< std::vector<gr::tag_t> > *tags = nullptr,
+			gr::high_res_timer_type *timestamp = nullptr) const;
+
+	private:
+		struct segment_info {
+			gr::high_res_timer_type timestamp;
+			std::vector< std::vector<gr::tag_t> > tags;
+		};
+
+		void reallocate();
+		unsigned int slot(unsigned int index) const;
+		float *channelData(unsigned int slot, unsigned int chn) const;
+
+		mutable std::mutex lock;
+
+		unsigned int nb_channels;
+		unsigned int segment_count;
+		unsigned int segment_size;
+		bool overwrite_en;
+
+		float *arena;
+		std::vector<segment_info> info;
+		unsigned int first, used;
+	};
+}
+
+#endif /* WAVEFORM_HISTORY_HPP */